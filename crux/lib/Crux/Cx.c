@@ -3,6 +3,7 @@
 #ifdef CxmHaveMallopt
 #include <malloc.h>
 #endif
+#include <sys/time.h>
 
 unsigned CxNcpus = 1;
 
@@ -64,3 +65,11 @@ void
 CxThreaded(void) {
     pthread_once(&CxpThreadedOnce, CxpThreaded);
 }
+
+double
+CxTime(void) {
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1.0e-6;
+}
@@ -108,6 +108,10 @@ CxInit(void);
 void
 CxThreaded(void);
 
+// Return the wall clock time, in seconds.
+double
+CxTime(void);
+
 #ifndef CxmUseInlines
 int
 CxCmp2Richcmp(int cmp, int op);
@@ -3,4 +3,5 @@ cdef extern from "Cx.h":
 
     cdef void CxInit()
     cdef void CxThreaded()
+    cdef double CxTime()
     cdef inline int CxCmp2Richcmp(int cmp, int op)
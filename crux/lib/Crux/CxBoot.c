@@ -0,0 +1,51 @@
+#include "CxBoot.h"
+
+bool
+CxBootNew(CxtBoot *aBoot, const unsigned *aFreqs, uint32_t aNchars) {
+    uint64_t nsites;
+    uint32_t i, j, k;
+
+    nsites = 0;
+    for (j = 0; j < aNchars; j++) {
+	nsites += aFreqs[j];
+    }
+    if (nsites > 0xffffffffU) {
+	return true;
+    }
+
+    aBoot->site2col = NULL;
+    if (nsites > 0) {
+	aBoot->site2col = (uint32_t *)malloc(nsites * sizeof(uint32_t));
+	if (aBoot->site2col == NULL) {
+	    return true;
+	}
+    }
+    for (i = j = 0; j < aNchars; j++) {
+	for (k = 0; k < aFreqs[j]; k++) {
+	    aBoot->site2col[i] = j;
+	    i++;
+	}
+    }
+    aBoot->nsites = (uint32_t)nsites;
+    aBoot->nchars = aNchars;
+
+    return false;
+}
+
+void
+CxBootDelete(CxtBoot *aBoot) {
+    if (aBoot->site2col != NULL) {
+	free(aBoot->site2col);
+	aBoot->site2col = NULL;
+    }
+}
+
+void
+CxBootWeights(CxtBoot *aBoot, sfmt_t *aPrng, unsigned *rWeights) {
+    uint32_t i;
+
+    memset(rWeights, 0, aBoot->nchars * sizeof(unsigned));
+    for (i = 0; i < aBoot->nsites; i++) {
+	rWeights[aBoot->site2col[gen_rand32_range(aPrng, aBoot->nsites)]]++;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef CxBoot_h
+#define CxBoot_h
+
+#include "Cx.h"
+#include "../SFMT/SFMT.h"
+
+// Nonparametric bootstrap resampling of alignment columns.  Rather than
+// creating a resampled copy of the alignment, each replicate is represented by
+// a vector of column weights, which can be passed anywhere that an
+// Alignment's freqs can (e.g. CxDistPack()).
+//
+// The original alignment has nsites = sum(aFreqs) sites, where column j
+// represents aFreqs[j] identical sites.  A replicate draws nsites sites
+// uniformly with replacement, so the weights are a multinomial draw over the
+// columns, with probabilities proportional to aFreqs.
+
+typedef struct {
+    // Column that each site belongs to.
+    uint32_t *site2col;
+    uint32_t nsites;
+    uint32_t nchars;
+} CxtBoot;
+
+// Initialize aBoot for an aNchars-column alignment with column frequencies
+// aFreqs.  Return true on error.
+bool
+CxBootNew(CxtBoot *aBoot, const unsigned *aFreqs, uint32_t aNchars);
+
+// Discard aBoot.
+void
+CxBootDelete(CxtBoot *aBoot);
+
+// Store the column weights for a bootstrap replicate in rWeights[0..nchars),
+// using aPrng as the source of randomness.
+void
+CxBootWeights(CxtBoot *aBoot, sfmt_t *aPrng, unsigned *rWeights);
+
+#endif // CxBoot_h
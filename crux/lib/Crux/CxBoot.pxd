@@ -0,0 +1,11 @@
+from libc cimport uint32_t
+from SFMT cimport sfmt_t
+
+cdef extern from "CxBoot.h":
+    ctypedef struct CxtBoot:
+        uint32_t nsites
+        uint32_t nchars
+
+    cdef bint CxBootNew(CxtBoot *aBoot, unsigned *aFreqs, uint32_t aNchars)
+    cdef void CxBootDelete(CxtBoot *aBoot)
+    cdef void CxBootWeights(CxtBoot *aBoot, sfmt_t *aPrng, unsigned *rWeights)
@@ -0,0 +1,312 @@
+#include "CxDist.h"
+#include "CxJobs.h"
+#include "CxMat.h"
+
+#include <float.h>
+
+// Target number of bytes of packed row data per tile dimension.
+#define CxmDistTileBytes (64 * 1024)
+
+// Context for CxDistPackBatch() jobs.
+typedef struct {
+    const CxtPack *pack;
+    unsigned *const *freqs;
+    bool scoreGaps;
+    CxeDist method;
+    float *const *dists;
+
+    // Tiles are tileRows x tileRows blocks of row pairs.  Jobs are numbered
+    // row by row through the upper triangle (including the diagonal) of the
+    // ntiles x ntiles matrix of tiles, and each matrix has njobs jobs.
+    uint32_t tileRows;
+    uint32_t ntiles;
+    unsigned njobs;
+} CxtDistCtx;
+
+// Same as nxy2i() in Crux.DistMatrix, for aX < aY.
+CxmpInline uint64_t
+CxpDistNxy2i(uint64_t aN, uint64_t aX, uint64_t aY) {
+    return aN*aX + aY - (((aX+3)*aX) >> 1) - 1;
+}
+
+static float
+CxpDistPct(const double *aA) {
+    float fident;
+    unsigned nvalid;
+    double sum;
+    unsigned i;
+
+    sum = 0.0;
+    for (i = 0; i < 16; i++) {
+	sum += aA[i];
+    }
+    fident = (float)(aA[0] + aA[5] + aA[10] + aA[15]);
+    nvalid = (unsigned)round(sum);
+
+    if (nvalid == 0) {
+	return 1.0;
+    }
+    return 1.0 - (fident / (float)nvalid);
+}
+
+// Jukes-Cantor distance, computed using Tajima's (1993) series.
+static float
+CxpDistJukes(const double *aA) {
+    float fident, k, b, d, t;
+    unsigned n, x, i;
+    double sum;
+
+    sum = 0.0;
+    for (i = 0; i < 16; i++) {
+	sum += aA[i];
+    }
+    fident = (float)(aA[0] + aA[5] + aA[10] + aA[15]);
+    n = (unsigned)round(sum);
+    if (n == 0) {
+	return NAN;
+    }
+
+    b = 3.0 / 4.0;
+    k = (float)n - fident;
+    d = 0.0;
+    t = b;
+    for (x = 1; x <= (unsigned)k; x++) {
+	t *= (k / (float)(x * n)) / b;
+	d += t;
+	if (t < FLT_EPSILON) {
+	    // Terms in the summation monotonically decrease, so there's no
+	    // point in continuing.
+	    break;
+	}
+    }
+
+    return d;
+}
+
+//                           ^
+// Compute the first term of d, which can be factored as:
+//
+//     k
+//  ------          max
+//  \               ------   (i-j)    j   j
+//   \      i!      \      kv        2  ks
+//    >   ------- *  >     ------- * ------
+//   /         i    /      (i-j)!    j!
+//  /     2 i n     ------
+//  ------          j=min
+//   i=1
+static double
+CxpDistK2p1(unsigned aN, unsigned aKs, unsigned aKv) {
+    double ret, t, u;
+    unsigned h, i, j, k, min, max;
+
+    ret = 0.0;
+    k = aKs + aKv;
+    for (i = 1; i <= k; i++) {
+	t = 0.5 / (double)i;
+	for (h = 1; h <= i; h++) {
+	    t *= (double)h / (double)aN;
+	}
+
+	min = (i < aKv) ? 0 : i - aKv;
+	max = (i < aKs) ? i : aKs;
+	// Compute first iteration.
+	j = min;
+	for (h = 1; h <= i - j; h++) {
+	    t *= (double)aKv;
+	    t /= (double)h;
+	}
+	u = 2.0 * (double)aKs;
+	for (h = 1; h <= j; h++) {
+	    t *= u;
+	    t /= (double)h;
+	}
+	ret += t;
+
+	// Compute remaining iterations based on previous.
+	u = (2.0 / (double)aKv) * (double)aKs;
+	for (j = j + 1; j <= max; j++) {
+	    t *= u;
+	    if (i - j > 0) {
+		t /= (double)(i - j);
+	    }
+	    t /= (double)j;
+	    ret += t;
+	}
+    }
+
+    return ret;
+}
+
+//                            ^
+// Compute the second term of d, which can be factored as:
+//
+//        kv
+//      ----   i   i
+//   1  \     2  kv
+//  ---  >    ------
+//   4  /        i
+//      ----  i n
+//      i=1
+static double
+CxpDistK2p2(unsigned aN, unsigned aKv) {
+    double ret, t, u;
+    unsigned i;
+
+    ret = 0.0;
+    // Compute first iteration.
+    t = 0.5;
+    t *= (double)aKv;
+    t /= (double)aN;
+    ret += t;
+
+    // Compute remaining iterations based on previous.
+    u = 2.0 / (double)aN * (double)aKv;
+    for (i = 2; i < aKv; i++) {
+	t *= u;
+	ret += t / (double)i;
+    }
+
+    return ret;
+}
+
+// Kimura two-parameter distance, computed using Tajima's (1993) Taylor
+// expansion method.
+static float
+CxpDistK2p(const double *aA) {
+    double n, ks, kv, k;
+    unsigned rN, rKs, rKv;
+
+    //    A C G T
+    //  /--------  /------------
+    // A| - v s v  |  0  1  2  3
+    // C| v - v s  |  4  5  6  7
+    // G| s v - v  |  8  9 10 11
+    // T| v s v -  | 12 13 14 15
+    ks = aA[2] + aA[7] + aA[8] + aA[13];
+    kv = aA[1] + aA[3] + aA[4] + aA[6] + aA[9] + aA[11] + aA[12] + aA[14];
+    k = ks + kv;
+    n = k + aA[0] + aA[5] + aA[10] + aA[15];
+
+    // Tajima's Taylor expansion method for computing corrected distances
+    // requires integer values.  Note that care is taken to do even rounding
+    // for ks and kv such that they sum to the rounded k.
+    rN = (unsigned)round(n);
+    rKs = (unsigned)round(ks);
+    rKv = (unsigned)round(k - ks);
+    if (rN == 0) {
+	return NAN;
+    }
+
+    return CxpDistK2p1(rN, rKs, rKv) + CxpDistK2p2(rN, rKv);
+}
+
+// LogDet/paralinear distance, scaled to substitutions per site.  aA is
+// destroyed.
+static float
+CxpDistLogDet(double *aA) {
+    double sum;
+    unsigned i;
+
+    sum = 0.0;
+    for (i = 0; i < 16; i++) {
+	sum += aA[i];
+    }
+    if (sum == 0.0) {
+	return NAN;
+    }
+
+    return CxMatLogDet(4, aA) / 4.0;
+}
+
+static void
+CxpDistJob(void *aArg, unsigned aJob) {
+    CxtDistCtx *ctx = (CxtDistCtx *)aArg;
+    uint32_t ntaxa, ti, tj, i, iLim, j, j0, jLim;
+    const unsigned *freqs;
+    float *dists;
+    double A[16];
+    float d;
+
+    // Convert the job number to a matrix and tile coordinates.
+    freqs = ctx->freqs[aJob / ctx->njobs];
+    dists = ctx->dists[aJob / ctx->njobs];
+    tj = aJob % ctx->njobs;
+    for (ti = 0; tj >= ctx->ntiles - ti; ti++) {
+	tj -= ctx->ntiles - ti;
+    }
+    tj += ti;
+
+    ntaxa = ctx->pack->ntaxa;
+    i = ti * ctx->tileRows;
+    iLim = i + ctx->tileRows;
+    if (iLim > ntaxa) {
+	iLim = ntaxa;
+    }
+    j0 = tj * ctx->tileRows;
+    jLim = j0 + ctx->tileRows;
+    if (jLim > ntaxa) {
+	jLim = ntaxa;
+    }
+
+    for (; i < iLim; i++) {
+	for (j = (j0 > i) ? j0 : i + 1; j < jLim; j++) {
+	    CxPackStats(ctx->pack, i, j, freqs, ctx->scoreGaps, A);
+	    switch (ctx->method) {
+		case CxeDistPct:
+		    d = CxpDistPct(A);
+		    break;
+		case CxeDistJukes:
+		    d = CxpDistJukes(A);
+		    break;
+		case CxeDistK2p:
+		    d = CxpDistK2p(A);
+		    break;
+		case CxeDistLogDet:
+		    d = CxpDistLogDet(A);
+		    break;
+		default:
+		    CxmNotReached();
+		    d = NAN;
+	    }
+	    dists[CxpDistNxy2i(ntaxa, i, j)] = d;
+	}
+    }
+}
+
+void
+CxDistPack(const CxtPack *aPack, const unsigned *aFreqs, bool aScoreGaps,
+  CxeDist aMethod, float *rDists) {
+    CxDistPackBatch(aPack, (unsigned *const *)&aFreqs, aScoreGaps, aMethod,
+      &rDists, 1);
+}
+
+void
+CxDistPackBatch(const CxtPack *aPack, unsigned *const *aFreqs,
+  bool aScoreGaps, CxeDist aMethod, float *const *rDists, unsigned aNmats) {
+    CxtDistCtx ctx;
+    uint64_t rowBytes;
+
+    if (aPack->ntaxa < 2 || aNmats == 0) {
+	return;
+    }
+
+    ctx.pack = aPack;
+    ctx.freqs = aFreqs;
+    ctx.scoreGaps = aScoreGaps;
+    ctx.method = aMethod;
+    ctx.dists = rDists;
+
+    // Choose the tile size such that two tiles' worth of rows fit in cache.
+    rowBytes = (uint64_t)aPack->nwords * sizeof(uint64_t);
+    ctx.tileRows = (uint32_t)(CxmDistTileBytes / (rowBytes + 1));
+    if (ctx.tileRows < 4) {
+	ctx.tileRows = 4;
+    } else if (ctx.tileRows > 256) {
+	ctx.tileRows = 256;
+    }
+
+    ctx.ntiles = (aPack->ntaxa + ctx.tileRows - 1) / ctx.tileRows;
+    ctx.njobs = (unsigned)(((uint64_t)ctx.ntiles * (ctx.ntiles + 1)) >> 1);
+    CxJobsExecute(CxpDistJob, &ctx, ctx.njobs * aNmats);
+}
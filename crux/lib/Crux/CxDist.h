@@ -0,0 +1,36 @@
+#ifndef CxDist_h
+#define CxDist_h
+
+#include "Cx.h"
+#include "CxPack.h"
+
+// Pairwise distance computation for packed nucleotide matrices.
+
+typedef enum {
+    CxeDistPct,   // Uncorrected (Alignment.dists()).
+    CxeDistJukes, // Jukes-Cantor (Alignment.jukesDists()).
+    CxeDistK2p,   // Kimura two-parameter (Alignment.kimuraDists()).
+    CxeDistLogDet // LogDet/paralinear (Alignment.logdetDists()).
+} CxeDist;
+
+// Compute aMethod distances between all pairs of rows in aPack, and store them
+// in rDists, which is in the upper-triangle order used by Crux.DistMatrix.
+// aFreqs and aScoreGaps are as for CxPackStats().  Distances that cannot be
+// computed are NaN.  The matrix is processed as square tiles of row pairs, so
+// that the rows being compared stay cache-resident, and tiles are distributed
+// among threads via CxJobsExecute().
+void
+CxDistPack(const CxtPack *aPack, const unsigned *aFreqs, bool aScoreGaps,
+  CxeDist aMethod, float *rDists);
+
+// Same as CxDistPack(), but compute aNmats matrices at once, where matrix i
+// uses column weights aFreqs[i] (which may be NULL, as for CxPackStats()) and
+// is stored in rDists[i].  The tiles of all matrices are distributed among
+// threads together, which keeps all threads busy even when individual
+// matrices are too small to be worth splitting up (e.g. bootstrap
+// replicates).
+void
+CxDistPackBatch(const CxtPack *aPack, unsigned *const *aFreqs,
+  bool aScoreGaps, CxeDist aMethod, float *const *rDists, unsigned aNmats);
+
+#endif // CxDist_h
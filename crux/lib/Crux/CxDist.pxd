@@ -0,0 +1,13 @@
+from CxPack cimport CxtPack
+
+cdef extern from "CxDist.h":
+    ctypedef enum CxeDist:
+        CxeDistPct
+        CxeDistJukes
+        CxeDistK2p
+        CxeDistLogDet
+
+    cdef void CxDistPack(CxtPack *aPack, unsigned *aFreqs, bint aScoreGaps, \
+      CxeDist aMethod, float *rDists)
+    cdef void CxDistPackBatch(CxtPack *aPack, unsigned **aFreqs, \
+      bint aScoreGaps, CxeDist aMethod, float **rDists, unsigned aNmats)
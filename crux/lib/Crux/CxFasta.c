@@ -0,0 +1,302 @@
+#include "CxFasta.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Initial number of rows/label bytes for which space is allocated.
+#define CxmFastaMaxMin 64
+
+typedef enum {
+    CxeFastaStateStart, // No rows yet.
+    CxeFastaStateDescr, // Description line, but no character lines yet.
+    CxeFastaStateChars  // At least one character line for the current row.
+} CxeFastaState;
+
+CxmpInline bool
+CxpFastaIsSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'
+      || c == '\v');
+}
+
+// Record an error, and copy the offending line if there is one.
+static void
+CxpFastaError(CxtFasta *aFasta, CxeFastaErr aErr, unsigned aLine,
+  const char *aTok, size_t aTokLen) {
+    aFasta->err = aErr;
+    aFasta->errLine = aLine;
+    if (aFasta->errTok != NULL) {
+	free(aFasta->errTok);
+	aFasta->errTok = NULL;
+    }
+    aFasta->errTokLen = 0;
+    if (aTokLen != 0) {
+	aFasta->errTok = (char *)malloc(aTokLen);
+	if (aFasta->errTok != NULL) {
+	    memcpy(aFasta->errTok, aTok, aTokLen);
+	    aFasta->errTokLen = aTokLen;
+	}
+    }
+}
+
+// Make room for at least aNChars more characters.
+static bool
+CxpFastaCharsReserve(CxtFasta *aFasta, uint64_t aNChars) {
+    uint64_t maxChars;
+    char *chars;
+
+    if (aFasta->nchars + aNChars <= aFasta->maxChars) {
+	return false;
+    }
+    maxChars = aFasta->maxChars << 1;
+    if (maxChars < aFasta->nchars + aNChars) {
+	maxChars = aFasta->nchars + aNChars;
+    }
+    chars = (char *)realloc(aFasta->chars, maxChars);
+    if (chars == NULL) {
+	return true;
+    }
+    aFasta->chars = chars;
+    aFasta->maxChars = maxChars;
+
+    return false;
+}
+
+// Make room for a row, plus aLabelLen label bytes.
+static bool
+CxpFastaRowReserve(CxtFasta *aFasta, size_t aLabelLen) {
+    if (aFasta->nrows + 1 == aFasta->maxRows) {
+	uint64_t maxRows, *rowOffs, *labelOffs;
+
+	maxRows = aFasta->maxRows << 1;
+	rowOffs = (uint64_t *)realloc(aFasta->rowOffs,
+	  maxRows * sizeof(uint64_t));
+	if (rowOffs == NULL) {
+	    return true;
+	}
+	aFasta->rowOffs = rowOffs;
+	labelOffs = (uint64_t *)realloc(aFasta->labelOffs,
+	  maxRows * sizeof(uint64_t));
+	if (labelOffs == NULL) {
+	    return true;
+	}
+	aFasta->labelOffs = labelOffs;
+	aFasta->maxRows = maxRows;
+    }
+    if (aFasta->labelsLen + aLabelLen > aFasta->maxLabels) {
+	uint64_t maxLabels;
+	char *labels;
+
+	maxLabels = aFasta->maxLabels << 1;
+	if (maxLabels < aFasta->labelsLen + aLabelLen) {
+	    maxLabels = aFasta->labelsLen + aLabelLen;
+	}
+	labels = (char *)realloc(aFasta->labels, maxLabels);
+	if (labels == NULL) {
+	    return true;
+	}
+	aFasta->labels = labels;
+	aFasta->maxLabels = maxLabels;
+    }
+
+    return false;
+}
+
+bool
+CxFastaNew(CxtFasta *aFasta, const char *aCodes, unsigned aNCodes) {
+    unsigned i;
+
+    memset(aFasta, 0, sizeof(CxtFasta));
+    for (i = 0; i < aNCodes; i++) {
+	aFasta->valid[(unsigned char)aCodes[i]] = true;
+    }
+
+    if ((aFasta->rowOffs = (uint64_t *)malloc(CxmFastaMaxMin
+      * sizeof(uint64_t))) == NULL
+      || (aFasta->labelOffs = (uint64_t *)malloc(CxmFastaMaxMin
+      * sizeof(uint64_t))) == NULL
+      || (aFasta->labels = (char *)malloc(CxmFastaMaxMin)) == NULL) {
+	CxFastaDelete(aFasta);
+	return true;
+    }
+    aFasta->maxRows = CxmFastaMaxMin;
+    aFasta->rowOffs[0] = 0;
+    aFasta->labelOffs[0] = 0;
+    aFasta->maxLabels = CxmFastaMaxMin;
+
+    return false;
+}
+
+void
+CxFastaDelete(CxtFasta *aFasta) {
+    if (aFasta->chars != NULL) {
+	free(aFasta->chars);
+    }
+    if (aFasta->rowOffs != NULL) {
+	free(aFasta->rowOffs);
+    }
+    if (aFasta->labels != NULL) {
+	free(aFasta->labels);
+    }
+    if (aFasta->labelOffs != NULL) {
+	free(aFasta->labelOffs);
+    }
+    if (aFasta->errTok != NULL) {
+	free(aFasta->errTok);
+    }
+    memset(aFasta, 0, sizeof(CxtFasta));
+}
+
+// Scan aBuf[0..aLen) into aFasta, for which sufficient character buffer space
+// has already been reserved.  Return true on error, in which case rows may have
+// been partially added.
+static bool
+CxpFastaScan(CxtFasta *aFasta, const char *aBuf, size_t aLen, unsigned aLine) {
+    const char *p, *end, *eol, *q;
+    CxeFastaState state;
+    unsigned line;
+    char *chars;
+    uint64_t n;
+
+    p = aBuf;
+    end = aBuf + aLen;
+    line = aLine;
+    state = CxeFastaStateStart;
+    while (p < end) {
+	eol = (const char *)memchr(p, '\n', end - p);
+	eol = (eol != NULL) ? eol + 1 : end;
+
+	if (*p == '>') {
+	    // Description.
+	    if (eol - p < 2 || CxpFastaIsSpace(p[1])) {
+		CxpFastaError(aFasta, CxeFastaErrToken, line, NULL, 0);
+		return true;
+	    }
+	    if (state == CxeFastaStateDescr) {
+		CxpFastaError(aFasta, CxeFastaErrDescr, line, p, eol - p);
+		return true;
+	    }
+	    for (q = p + 1; q < eol && CxpFastaIsSpace(*q) == false; q++) {
+		// Do nothing.
+	    }
+	    if (CxpFastaRowReserve(aFasta, q - (p + 1))) {
+		CxpFastaError(aFasta, CxeFastaErrMem, line, NULL, 0);
+		return true;
+	    }
+	    for (q = p + 1; q < eol && CxpFastaIsSpace(*q) == false; q++) {
+		aFasta->labels[aFasta->labelsLen++] = (*q == '_') ? ' ' : *q;
+	    }
+	    aFasta->nrows++;
+	    aFasta->rowOffs[aFasta->nrows] = aFasta->nchars;
+	    aFasta->labelOffs[aFasta->nrows] = aFasta->labelsLen;
+	    state = CxeFastaStateDescr;
+	} else {
+	    // Characters or whitespace.  Copy speculatively, and validate as
+	    // characters are copied.
+	    chars = &aFasta->chars[aFasta->nchars];
+	    n = 0;
+	    for (q = p; q < eol; q++) {
+		if (aFasta->valid[(unsigned char)*q]) {
+		    chars[n++] = *q;
+		} else if (CxpFastaIsSpace(*q) == false) {
+		    CxpFastaError(aFasta, CxeFastaErrToken, line, NULL, 0);
+		    return true;
+		}
+	    }
+	    if (n != 0) {
+		if (state == CxeFastaStateStart) {
+		    CxpFastaError(aFasta, CxeFastaErrChars, line, p, eol - p);
+		    return true;
+		}
+		aFasta->nchars += n;
+		aFasta->rowOffs[aFasta->nrows] = aFasta->nchars;
+		state = CxeFastaStateChars;
+	    }
+	}
+
+	p = eol;
+	line++;
+    }
+    if (state != CxeFastaStateChars) {
+	CxpFastaError(aFasta, CxeFastaErrEnd, line, NULL, 0);
+	return true;
+    }
+
+
+    return false;
+}
+
+bool
+CxFastaParse(CxtFasta *aFasta, const char *aBuf, size_t aLen, unsigned aLine) {
+    uint64_t nrows0, nchars0, labelsLen0;
+
+    aFasta->err = CxeFastaErrNone;
+    nrows0 = aFasta->nrows;
+    nchars0 = aFasta->nchars;
+    labelsLen0 = aFasta->labelsLen;
+
+    // The input can contain no more characters than bytes, so reserve enough
+    // space up front to avoid reallocation during scanning.
+    if (CxpFastaCharsReserve(aFasta, aLen)) {
+	CxpFastaError(aFasta, CxeFastaErrMem, aLine, NULL, 0);
+	return true;
+    }
+
+    if (CxpFastaScan(aFasta, aBuf, aLen, aLine)) {
+	aFasta->nrows = nrows0;
+	aFasta->nchars = nchars0;
+	aFasta->labelsLen = labelsLen0;
+	return true;
+    }
+
+    return false;
+}
+
+bool
+CxFastaParseFd(CxtFasta *aFasta, int aFd, uint64_t aOff, unsigned aLine) {
+    struct stat st;
+    char *map;
+    size_t mapLen;
+    bool ret;
+
+    if (fstat(aFd, &st) == -1 || S_ISREG(st.st_mode) == 0) {
+	CxpFastaError(aFasta, CxeFastaErrIo, aLine, NULL, 0);
+	return true;
+    }
+    mapLen = (size_t)st.st_size;
+    if (aOff >= mapLen) {
+	return CxFastaParse(aFasta, "", 0, aLine);
+    }
+    map = (char *)mmap(NULL, mapLen, PROT_READ, MAP_SHARED, aFd, 0);
+    if (map == (char *)MAP_FAILED) {
+	CxpFastaError(aFasta, CxeFastaErrIo, aLine, NULL, 0);
+	return true;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, mapLen, MADV_SEQUENTIAL);
+#endif
+
+    ret = CxFastaParse(aFasta, &map[aOff], mapLen - aOff, aLine);
+    munmap(map, mapLen);
+
+    return ret;
+}
+
+char *
+CxFastaCharsTake(CxtFasta *aFasta) {
+    char *ret;
+
+    if (aFasta->nchars == 0) {
+	return NULL;
+    }
+    ret = (char *)realloc(aFasta->chars, aFasta->nchars);
+    if (ret == NULL) {
+	return NULL;
+    }
+    aFasta->chars = NULL;
+    aFasta->nchars = 0;
+    aFasta->maxChars = 0;
+    aFasta->nrows = 0;
+    aFasta->labelsLen = 0;
+
+    return ret;
+}
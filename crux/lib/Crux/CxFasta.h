@@ -0,0 +1,77 @@
+#ifndef CxFasta_h
+#define CxFasta_h
+
+#include "Cx.h"
+
+// Native FASTA scanner.  Input is scanned line by line, character lines are
+// validated against a table of character codes, and character data are
+// appended (sans whitespace) to a single buffer, so that an aligned input is
+// scanned directly into row-major matrix order.  The accepted grammar is the
+// same as that of Crux.Fasta.Parser (which see).
+
+typedef enum {
+    CxeFastaErrNone,
+    CxeFastaErrMem,   // Memory allocation failure.
+    CxeFastaErrIo,    // The file could not be memory-mapped.
+    CxeFastaErrToken, // Invalid token on line errLine.
+    CxeFastaErrDescr, // Unexpected description line; see errTok.
+    CxeFastaErrChars, // Unexpected character line; see errTok.
+    CxeFastaErrEnd    // Unexpected end of input.
+} CxeFastaErr;
+
+typedef struct {
+    // valid[c] is true if c is a character code.
+    bool valid[256];
+
+    // Character data for all rows.  Row i is chars[rowOffs[i]..rowOffs[i+1]).
+    // rowOffs has (nrows+1) valid elements.
+    char *chars;
+    uint64_t nchars;
+    uint64_t maxChars;
+    uint64_t *rowOffs;
+    uint64_t nrows;
+    uint64_t maxRows;
+
+    // Row labels, after '_'-->' ' conversion.  Row i's label is
+    // labels[labelOffs[i]..labelOffs[i+1]).
+    char *labels;
+    uint64_t labelsLen;
+    uint64_t maxLabels;
+    uint64_t *labelOffs;
+
+    // Description of the most recent error.  errTok is an owned copy of the
+    // offending line (including its terminating newline, if any).
+    CxeFastaErr err;
+    unsigned errLine;
+    char *errTok;
+    size_t errTokLen;
+} CxtFasta;
+
+// Initialize an empty scanner that accepts the character codes in aCodes
+// (aNCodes bytes).  Return true on error.
+bool
+CxFastaNew(CxtFasta *aFasta, const char *aCodes, unsigned aNCodes);
+
+// Discard aFasta.
+void
+CxFastaDelete(CxtFasta *aFasta);
+
+// Scan aBuf[0..aLen), which must contain a complete FASTA matrix.  aLine is
+// the line number of the beginning of aBuf, for error reporting.  Return true
+// on error, in which case no rows are added.
+bool
+CxFastaParse(CxtFasta *aFasta, const char *aBuf, size_t aLen, unsigned aLine);
+
+// Memory-map the regular file open on aFd, and scan it from offset aOff via
+// CxFastaParse().  Return true on error; err is CxeFastaErrIo if the file
+// could not be mapped, in which case the caller may fall back to reading it.
+bool
+CxFastaParseFd(CxtFasta *aFasta, int aFd, uint64_t aOff, unsigned aLine);
+
+// Transfer ownership of the character buffer, trimmed to nchars bytes, to the
+// caller.  The scanner is left without rows.  Return NULL on error (or if
+// there are no characters).
+char *
+CxFastaCharsTake(CxtFasta *aFasta);
+
+#endif // CxFasta_h
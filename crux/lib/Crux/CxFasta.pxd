@@ -0,0 +1,30 @@
+from libc cimport uint64_t
+
+cdef extern from "CxFasta.h":
+    ctypedef enum CxeFastaErr:
+        CxeFastaErrNone
+        CxeFastaErrMem
+        CxeFastaErrIo
+        CxeFastaErrToken
+        CxeFastaErrDescr
+        CxeFastaErrChars
+        CxeFastaErrEnd
+    ctypedef struct CxtFasta:
+        char *chars
+        uint64_t nchars
+        uint64_t *rowOffs
+        uint64_t nrows
+        char *labels
+        uint64_t *labelOffs
+        CxeFastaErr err
+        unsigned errLine
+        char *errTok
+        size_t errTokLen
+
+    cdef bint CxFastaNew(CxtFasta *aFasta, char *aCodes, unsigned aNCodes)
+    cdef void CxFastaDelete(CxtFasta *aFasta)
+    cdef bint CxFastaParse(CxtFasta *aFasta, char *aBuf, size_t aLen, \
+      unsigned aLine)
+    cdef bint CxFastaParseFd(CxtFasta *aFasta, int aFd, uint64_t aOff, \
+      unsigned aLine)
+    cdef char *CxFastaCharsTake(CxtFasta *aFasta)
@@ -0,0 +1,355 @@
+#include "CxFmt.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Maximum length of a number formatted by snprintf(): up to 309 integer
+// digits, a sign, a decimal point, and CxmFmtPrecMax fraction digits.
+#define CxmFmtDoubleMax 340
+
+static const double CxpFmtPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+    1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool
+CxFmtNew(CxtFmt *aFmt, size_t aMax) {
+    aFmt->buf = (char *)malloc(aMax);
+    if (aFmt->buf == NULL) {
+	return true;
+    }
+    aFmt->len = 0;
+    aFmt->max = aMax;
+
+    return false;
+}
+
+void
+CxFmtDelete(CxtFmt *aFmt) {
+    if (aFmt->buf != NULL) {
+	free(aFmt->buf);
+	aFmt->buf = NULL;
+    }
+}
+
+bool
+CxFmtReserve(CxtFmt *aFmt, size_t aLen) {
+    size_t max;
+    char *buf;
+
+    if (aFmt->len + aLen <= aFmt->max) {
+	return false;
+    }
+    max = aFmt->max << 1;
+    if (max < aFmt->len + aLen) {
+	max = aFmt->len + aLen;
+    }
+    buf = (char *)realloc(aFmt->buf, max);
+    if (buf == NULL) {
+	return true;
+    }
+    aFmt->buf = buf;
+    aFmt->max = max;
+
+    return false;
+}
+
+bool
+CxFmtStr(CxtFmt *aFmt, const char *aS, size_t aLen) {
+    if (CxFmtReserve(aFmt, aLen)) {
+	return true;
+    }
+    memcpy(&aFmt->buf[aFmt->len], aS, aLen);
+    aFmt->len += aLen;
+
+    return false;
+}
+
+bool
+CxFmtSpaces(CxtFmt *aFmt, size_t aLen) {
+    if (CxFmtReserve(aFmt, aLen)) {
+	return true;
+    }
+    memset(&aFmt->buf[aFmt->len], ' ', aLen);
+    aFmt->len += aLen;
+
+    return false;
+}
+
+bool
+CxFmtStrPad(CxtFmt *aFmt, const char *aS, size_t aLen, size_t aWidth) {
+    if (CxFmtStr(aFmt, aS, aLen)) {
+	return true;
+    }
+    if (aLen < aWidth) {
+	return CxFmtSpaces(aFmt, aWidth - aLen);
+    }
+
+    return false;
+}
+
+// Write the aNDigits least significant decimal digits of aU (zero-padded) to
+// aS.
+CxmpInline void
+CxpFmtDigits(char *aS, uint64_t aU, unsigned aNDigits) {
+    unsigned i;
+
+    for (i = aNDigits; i > 0; i--) {
+	aS[i - 1] = '0' + (char)(aU % 10);
+	aU /= 10;
+    }
+}
+
+CxmpInline unsigned
+CxpFmtNDigits(uint64_t aU) {
+    unsigned ret;
+
+    for (ret = 1; aU >= 10; ret++) {
+	aU /= 10;
+    }
+
+    return ret;
+}
+
+bool
+CxFmtUint(CxtFmt *aFmt, uint64_t aU) {
+    unsigned ndigits;
+
+    ndigits = CxpFmtNDigits(aU);
+    if (CxFmtReserve(aFmt, ndigits)) {
+	return true;
+    }
+    CxpFmtDigits(&aFmt->buf[aFmt->len], aU, ndigits);
+    aFmt->len += ndigits;
+
+    return false;
+}
+
+bool
+CxFmtLabel(CxtFmt *aFmt, const char *aS, size_t aLen) {
+    size_t i;
+    char *s;
+    bool quote;
+
+    quote = false;
+    for (i = 0; i < aLen; i++) {
+	switch (aS[i]) {
+	    case '_': case '(': case ')': case '[': case ']': case '\'':
+	    case ':': case ';': case ',': {
+		quote = true;
+		break;
+	    } default: {
+		break;
+	    }
+	}
+    }
+
+    // Quoting at most doubles the length of the label.
+    if (CxFmtReserve(aFmt, (aLen << 1) + 2)) {
+	return true;
+    }
+    s = &aFmt->buf[aFmt->len];
+    if (quote) {
+	*s++ = '\'';
+	for (i = 0; i < aLen; i++) {
+	    if (aS[i] == '\'') {
+		*s++ = '\'';
+	    }
+	    *s++ = aS[i];
+	}
+	*s++ = '\'';
+    } else {
+	for (i = 0; i < aLen; i++) {
+	    *s++ = (aS[i] == ' ') ? '_' : aS[i];
+	}
+    }
+    aFmt->len = s - aFmt->buf;
+
+    return false;
+}
+
+bool
+CxFmtSpecParse(CxtFmtSpec *rSpec, const char *aFormat) {
+    const char *p;
+    unsigned prec;
+
+    if (aFormat[0] != '%' || aFormat[1] != '.') {
+	return true;
+    }
+    prec = 0;
+    for (p = &aFormat[2]; *p >= '0' && *p <= '9'; p++) {
+	prec = prec * 10 + (*p - '0');
+	if (prec > CxmFmtPrecMax) {
+	    return true;
+	}
+    }
+    if (p == &aFormat[2] || (*p != 'f' && *p != 'e') || p[1] != '\0') {
+	return true;
+    }
+    rSpec->conv = *p;
+    rSpec->prec = prec;
+
+    return false;
+}
+
+// Round aScaled, which is within half an ulp of an exact (non-negative) value,
+// to the nearest integer.  Return true if the result may differ from rounding
+// the exact value, which is the case if aScaled is close to halfway between
+// two integers, or too large for its fractional part to be meaningful.
+CxmpInline bool
+CxpFmtRound(double aScaled, uint64_t *rR) {
+    double fl, frac;
+
+    if ((aScaled < 4503599627370496.0) == false) { // 2^52.
+	return true;
+    }
+    fl = floor(aScaled);
+    frac = aScaled - fl;
+    if (fabs(frac - 0.5) <= aScaled * 0x1p-51) {
+	return true;
+    }
+    *rR = (uint64_t)fl + (frac > 0.5);
+
+    return false;
+}
+
+// Format aA (finite and non-negative) in %f format to aS, and return the
+// number of bytes written, or 0 if the fast path does not apply.
+static size_t
+CxpFmtF(char *aS, unsigned aPrec, double aA) {
+    uint64_t r, p10, ip;
+    unsigned ndigits;
+    size_t len;
+
+    if (CxpFmtRound(aA * CxpFmtPow10[aPrec], &r)) {
+	return 0;
+    }
+    p10 = (uint64_t)CxpFmtPow10[aPrec];
+    ip = r / p10;
+
+    ndigits = CxpFmtNDigits(ip);
+    CxpFmtDigits(aS, ip, ndigits);
+    len = ndigits;
+    if (aPrec > 0) {
+	aS[len++] = '.';
+	CxpFmtDigits(&aS[len], r - ip * p10, aPrec);
+	len += aPrec;
+    }
+
+    return len;
+}
+
+// Format aA (finite and positive) in %e format to aS, and return the number of
+// bytes written, or 0 if the fast path does not apply.
+static size_t
+CxpFmtE(char *aS, unsigned aPrec, double aA) {
+    uint64_t r, lo, hi;
+    int e2, e10, k, i;
+    unsigned ndigits;
+    size_t len;
+
+    lo = (uint64_t)CxpFmtPow10[aPrec];
+    hi = lo * 10;
+
+    // Estimate the decimal exponent from the binary exponent.  The estimate
+    // may be one too low, and rounding may carry into an extra digit, so
+    // adjust the exponent until the rounded significand has (aPrec + 1)
+    // digits.
+    frexp(aA, &e2);
+    e10 = (int)floor((e2 - 1) * 0.30102999566398120);
+    for (i = 0; i < 3; i++) {
+	k = (int)aPrec - e10;
+	if (k < -22 || k > 22) {
+	    return 0;
+	}
+	if (CxpFmtRound((k >= 0) ? aA * CxpFmtPow10[k] : aA / CxpFmtPow10[-k],
+	  &r)) {
+	    return 0;
+	}
+	if (r >= hi) {
+	    e10++;
+	} else if (r < lo) {
+	    e10--;
+	} else {
+	    break;
+	}
+    }
+    if (i == 3) {
+	return 0;
+    }
+
+    CxpFmtDigits(aS, r / lo, 1);
+    len = 1;
+    if (aPrec > 0) {
+	aS[len++] = '.';
+	CxpFmtDigits(&aS[len], r % lo, aPrec);
+	len += aPrec;
+    }
+    aS[len++] = 'e';
+    if (e10 < 0) {
+	aS[len++] = '-';
+	e10 = -e10;
+    } else {
+	aS[len++] = '+';
+    }
+    ndigits = CxpFmtNDigits((uint64_t)e10);
+    if (ndigits < 2) {
+	ndigits = 2;
+    }
+    CxpFmtDigits(&aS[len], (uint64_t)e10, ndigits);
+    len += ndigits;
+
+    return len;
+}
+
+bool
+CxFmtDouble(CxtFmt *aFmt, const CxtFmtSpec *aSpec, double aV) {
+    char *s;
+    size_t len;
+    double a;
+    int r;
+
+    if (CxFmtReserve(aFmt, CxmFmtDoubleMax)) {
+	return true;
+    }
+    s = &aFmt->buf[aFmt->len];
+
+    if (isnan(aV)) {
+	// Python omits the sign of NaNs, whereas printf() does not.
+	memcpy(s, "nan", 3);
+	aFmt->len += 3;
+	return false;
+    }
+
+    len = 0;
+    if (isinf(aV) == false) {
+	if (signbit(aV)) {
+	    *s++ = '-';
+	    len = 1;
+	}
+	a = fabs(aV);
+	if (aSpec->conv == 'f') {
+	    r = CxpFmtF(s, aSpec->prec, a);
+	} else if (a == 0.0) {
+	    // The significand is all zeros.
+	    r = CxpFmtF(s, aSpec->prec, 0.0);
+	    memcpy(&s[r], "e+00", 4);
+	    r += 4;
+	} else {
+	    r = CxpFmtE(s, aSpec->prec, a);
+	}
+	if (r != 0) {
+	    aFmt->len += len + r;
+	    return false;
+	}
+	s -= len;
+    }
+
+    // Slow path.
+    r = snprintf(s, CxmFmtDoubleMax, (aSpec->conv == 'f') ? "%.*f" : "%.*e",
+      (int)aSpec->prec, aV);
+    CxmAssert(r > 0 && r < CxmFmtDoubleMax);
+    aFmt->len += r;
+
+    return false;
+}
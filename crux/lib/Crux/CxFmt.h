@@ -0,0 +1,75 @@
+#ifndef CxFmt_h
+#define CxFmt_h
+
+#include "Cx.h"
+
+// Output formatting into a growable buffer, for bulk writers such as
+// DistMatrix.render() and Tree.render(), which would otherwise create a Python
+// string for every distance or Newick fragment.  Callers accumulate output,
+// and periodically write buf[0..len) and reset len to 0.
+//
+// Floating point numbers are formatted with fixed precision, in the same
+// "%.<prec>f" or "%.<prec>e" format as printf(), with the same (correctly
+// rounded) results.  The common case is computed directly by scaling to an
+// integer, and the rare cases that the fast path cannot round reliably (near
+// rounding ties, and large magnitudes) fall back to snprintf().
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t max;
+} CxtFmt;
+
+// Conversion specification, as parsed by CxFmtSpecParse().
+typedef struct {
+    char conv; // 'f' or 'e'.
+    unsigned prec;
+} CxtFmtSpec;
+
+// Initialize aFmt with an aMax-byte buffer.  Return true on error.
+bool
+CxFmtNew(CxtFmt *aFmt, size_t aMax);
+
+// Discard aFmt.
+void
+CxFmtDelete(CxtFmt *aFmt);
+
+// Make room for aLen more bytes.  Return true on error.
+bool
+CxFmtReserve(CxtFmt *aFmt, size_t aLen);
+
+// Append aS[0..aLen).  Return true on error.
+bool
+CxFmtStr(CxtFmt *aFmt, const char *aS, size_t aLen);
+
+// Append aS[0..aLen), left-justified in a field of aWidth bytes (same as
+// "%-<aWidth>s").  Return true on error.
+bool
+CxFmtStrPad(CxtFmt *aFmt, const char *aS, size_t aLen, size_t aWidth);
+
+// Append aLen spaces.  Return true on error.
+bool
+CxFmtSpaces(CxtFmt *aFmt, size_t aLen);
+
+// Append the decimal representation of aU.  Return true on error.
+bool
+CxFmtUint(CxtFmt *aFmt, uint64_t aU);
+
+// Append the taxon label aS[0..aLen) as a Newick label: labels that contain
+// any of "_()[]':;," are quoted (with embedded quotes doubled), and spaces
+// in other labels are converted to '_'.  Return true on error.
+bool
+CxFmtLabel(CxtFmt *aFmt, const char *aS, size_t aLen);
+
+// Parse aFormat, which must be of the form "%.<prec>f" or "%.<prec>e", with
+// prec in [0..CxmFmtPrecMax].  Return true if aFormat is not of this form, in
+// which case the caller must do its own formatting.
+#define CxmFmtPrecMax 17
+bool
+CxFmtSpecParse(CxtFmtSpec *rSpec, const char *aFormat);
+
+// Append aV, formatted according to aSpec.  Return true on error.
+bool
+CxFmtDouble(CxtFmt *aFmt, const CxtFmtSpec *aSpec, double aV);
+
+#endif // CxFmt_h
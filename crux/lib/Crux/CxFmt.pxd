@@ -0,0 +1,19 @@
+from libc cimport uint64_t
+
+cdef extern from "CxFmt.h":
+    ctypedef struct CxtFmt:
+        char *buf
+        size_t len
+    ctypedef struct CxtFmtSpec:
+        char conv
+        unsigned prec
+
+    cdef bint CxFmtNew(CxtFmt *aFmt, size_t aMax)
+    cdef void CxFmtDelete(CxtFmt *aFmt)
+    cdef bint CxFmtStr(CxtFmt *aFmt, char *aS, size_t aLen)
+    cdef bint CxFmtStrPad(CxtFmt *aFmt, char *aS, size_t aLen, size_t aWidth)
+    cdef bint CxFmtSpaces(CxtFmt *aFmt, size_t aLen)
+    cdef bint CxFmtUint(CxtFmt *aFmt, uint64_t aU)
+    cdef bint CxFmtLabel(CxtFmt *aFmt, char *aS, size_t aLen)
+    cdef bint CxFmtSpecParse(CxtFmtSpec *rSpec, char *aFormat)
+    cdef bint CxFmtDouble(CxtFmt *aFmt, CxtFmtSpec *aSpec, double aV)
@@ -0,0 +1,206 @@
+#include "CxJobs.h"
+#include "CxMq.h"
+
+// Worker thread context.
+typedef struct {
+    unsigned id;
+    pthread_t pthread;
+} CxtJobsWorkerCtx;
+
+// A batch of jobs, as submitted via CxJobsExecute().  The batch structure
+// lives on the submitting thread's stack, and a pointer to it is passed
+// through CxpJobsTodoMq once for each worker thread that is recruited to help
+// with the batch.  Each participating thread repeatedly claims the next
+// unclaimed job until none remain.
+typedef struct {
+    CxtJobsFunc *func;
+    void *arg;
+    unsigned njobs;
+
+    // Index of the next unclaimed job.
+    unsigned next;
+
+    // Number of recruited worker threads that may still reference the batch.
+    unsigned nactive;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t cnd;
+} CxtJobsBatch;
+
+// Thread initialization control variable.
+static pthread_once_t CxpJobsOnce = PTHREAD_ONCE_INIT;
+
+// Set to non-zero if threading is enabled, and initialization has occurred.
+static unsigned CxpJobsNThreads = 0;
+
+// Array of CxpJobsNThreads extant thread contexts.
+static CxtJobsWorkerCtx *CxpJobsThreads;
+
+// Thread-specific data key that is non-NULL only for worker threads.  This is
+// used to serialize nested calls to CxJobsExecute(), which would otherwise be
+// able to deadlock the worker pool.
+static pthread_key_t CxpJobsWorkerKey;
+
+// Message queue, used to recruit worker threads.
+static CxtMq CxpJobsTodoMq;
+
+// Run jobs until none remain unclaimed.
+static void
+CxpJobsRun(CxtJobsBatch *aBatch) {
+    unsigned job;
+
+    while (true) {
+	pthread_mutex_lock(&aBatch->mtx);
+	job = aBatch->next;
+	if (job < aBatch->njobs) {
+	    aBatch->next++;
+	}
+	pthread_mutex_unlock(&aBatch->mtx);
+
+	if (job >= aBatch->njobs) {
+	    break;
+	}
+	aBatch->func(aBatch->arg, job);
+    }
+}
+
+// Worker thread entry function.
+static void *
+CxpJobsWorker(void *arg) {
+    CxtJobsBatch *batch;
+
+    pthread_setspecific(CxpJobsWorkerKey, arg);
+
+    // Iteratively get a batch, help complete it, then indicate that the batch
+    // is no longer referenced by this thread.
+    while (CxMqGet(&CxpJobsTodoMq, &batch) == false) {
+	CxpJobsRun(batch);
+
+	pthread_mutex_lock(&batch->mtx);
+	CxmAssert(batch->nactive > 0);
+	batch->nactive--;
+	if (batch->nactive == 0) {
+	    pthread_cond_signal(&batch->cnd);
+	}
+	pthread_mutex_unlock(&batch->mtx);
+    }
+
+    return NULL;
+}
+
+// Perform worker thread pool cleanup.
+static void
+CxpJobsAtexit(void) {
+    void *result;
+
+    CxMqGetStop(&CxpJobsTodoMq);
+    for (unsigned i = 0; i < CxpJobsNThreads; i++) {
+	pthread_join(CxpJobsThreads[i].pthread, &result);
+    }
+    free(CxpJobsThreads);
+    CxpJobsThreads = NULL;
+}
+
+// Initialize the worker thread pool.  Since no errors are propagated from this
+// function, perform initialization in an order that allows correct function
+// (though degraded performance) even if an error occurs.
+static void
+CxpJobsThreaded(void) {
+    if (pthread_key_create(&CxpJobsWorkerKey, NULL)) {
+	return;
+    }
+
+    CxpJobsThreads = (CxtJobsWorkerCtx *)malloc(CxNcpus *
+      sizeof(CxtJobsWorkerCtx));
+    if (CxpJobsThreads == NULL) {
+	return;
+    }
+
+    atexit(CxpJobsAtexit);
+
+    // Properly set the minimum number of message slots, so that the CxMq code
+    // will never suffer from allocation failures after CxMqNew().
+    if (CxMqNew(&CxpJobsTodoMq, sizeof(CxtJobsBatch *),
+      CxNcpus * CxmJobsMqMult)) {
+	return;
+    }
+
+    // The calling thread always participates in its own batches, so one
+    // fewer worker than CPUs suffices.
+    for (unsigned i = 0; i < CxNcpus - 1; i++) {
+	CxpJobsThreads[i].id = i;
+	int err = pthread_create(&CxpJobsThreads[i].pthread, NULL,
+	  CxpJobsWorker, (void *)&CxpJobsThreads[i]);
+	if (err) {
+	    return;
+	}
+	CxpJobsNThreads++;
+    }
+}
+
+void
+CxJobsExecute(CxtJobsFunc *aFunc, void *aArg, unsigned aNjobs) {
+    CxtJobsBatch batch;
+    unsigned nhelpers;
+
+    if (CxNcpus > 1 && aNjobs > 1) {
+	pthread_once(&CxpJobsOnce, CxpJobsThreaded);
+    }
+
+    if (CxpJobsNThreads == 0 || aNjobs <= 1
+      || pthread_getspecific(CxpJobsWorkerKey) != NULL) {
+	// No worker threads available; do all jobs in the calling thread.
+	for (unsigned job = 0; job < aNjobs; job++) {
+	    aFunc(aArg, job);
+	}
+	return;
+    }
+
+    batch.func = aFunc;
+    batch.arg = aArg;
+    batch.njobs = aNjobs;
+    batch.next = 0;
+    nhelpers = (aNjobs - 1 < CxpJobsNThreads) ? aNjobs - 1 : CxpJobsNThreads;
+    batch.nactive = nhelpers;
+    if (pthread_mutex_init(&batch.mtx, NULL)) {
+	CxmError("Error initializing mutex");
+    }
+    if (pthread_cond_init(&batch.cnd, NULL)) {
+	CxmError("Error initializing condition variable");
+    }
+
+    // Recruit helpers, then pitch in.
+    for (unsigned i = 0; i < nhelpers; i++) {
+	CxMqPut(&CxpJobsTodoMq, &batch);
+    }
+    CxpJobsRun(&batch);
+
+    // Wait for the helpers to finish, since batch is about to go out of scope.
+    pthread_mutex_lock(&batch.mtx);
+    while (batch.nactive > 0) {
+	pthread_cond_wait(&batch.cnd, &batch.mtx);
+    }
+    pthread_mutex_unlock(&batch.mtx);
+
+    pthread_cond_destroy(&batch.cnd);
+    pthread_mutex_destroy(&batch.mtx);
+}
+
+unsigned
+CxJobsCount(uint64_t aNelms, uint64_t aMinElms) {
+    uint64_t njobs, maxJobs;
+
+    if (aMinElms == 0) {
+	aMinElms = 1;
+    }
+    njobs = (aNelms + aMinElms - 1) / aMinElms;
+    maxJobs = (uint64_t)CxNcpus * 8;
+    if (njobs > maxJobs) {
+	njobs = maxJobs;
+    }
+    if (njobs == 0) {
+	njobs = 1;
+    }
+
+    return (unsigned)njobs;
+}
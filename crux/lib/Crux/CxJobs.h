@@ -0,0 +1,30 @@
+#ifndef CxJobs_h
+#define CxJobs_h
+
+#include "Cx.h"
+
+// Job function.  aJob is in [0..aNjobs), as passed to CxJobsExecute().  Job
+// functions are called concurrently from multiple threads, so they must not
+// touch any Python objects, nor modify any state that is shared with other
+// jobs.
+typedef void CxtJobsFunc(void *aArg, unsigned aJob);
+
+// Use message queues that have CxNcpus * CxmJobsMqMult slots to communicate
+// with worker threads.
+#define CxmJobsMqMult 2
+
+// Call aFunc(aArg, job) once for each job in [0..aNjobs), and return once all
+// jobs have completed.  If thread parallelism is enabled (see CxThreaded()),
+// jobs are distributed among a pool of worker threads (one thread per CPU);
+// the calling thread participates as well.  Otherwise, or if called from
+// within a job function, all jobs are run sequentially in the calling thread.
+void
+CxJobsExecute(CxtJobsFunc *aFunc, void *aArg, unsigned aNjobs);
+
+// Compute a reasonable number of jobs for aNelms independently processable
+// elements, such that each job processes at least aMinElms elements, and such
+// that there are enough jobs to balance load among the worker threads.
+unsigned
+CxJobsCount(uint64_t aNelms, uint64_t aMinElms);
+
+#endif // CxJobs_h
@@ -0,0 +1,9 @@
+from libc cimport uint64_t
+
+cdef extern from "CxJobs.h":
+    ctypedef void CxtJobsFunc(void *aArg, unsigned aJob)
+
+    cdef unsigned CxmJobsMqMult
+
+    cdef void CxJobsExecute(CxtJobsFunc *aFunc, void *aArg, unsigned aNjobs)
+    cdef unsigned CxJobsCount(uint64_t aNelms, uint64_t aMinElms)
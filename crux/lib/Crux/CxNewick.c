@@ -0,0 +1,829 @@
+#include "CxNewick.h"
+#include "Tree/CxBipart.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Initial number of nodes/trees/labels for which space is allocated.
+#define CxmNewickMaxMin 64
+
+typedef enum {
+    CxeNewickTokEnd,
+    CxeNewickTokInvalid,
+    CxeNewickTokLparen,
+    CxeNewickTokRparen,
+    CxeNewickTokComma,
+    CxeNewickTokColon,
+    CxeNewickTokSemicolon,
+    CxeNewickTokBranchLength,
+    CxeNewickTokUnquotedLabel,
+    CxeNewickTokQuotedLabel
+} CxeNewickTok;
+
+// Scanner state.  The current token is [s..s+len).
+typedef struct {
+    const char *p;
+    const char *end;
+    unsigned line;
+    CxeNewickTok tok;
+    const char *s;
+    size_t len;
+} CxtNewickScan;
+
+// Split, as sorted by CxNewickSplitsCompute().
+typedef struct {
+    const uint64_t *words;
+    unsigned nWords;
+    uint64_t hash;
+    double len;
+} CxtNewickSplit;
+
+CxmpInline bool
+CxpNewickIsSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'
+      || c == '\v');
+}
+
+// Return true if c can be part of an unquoted label (or branch length).
+CxmpInline bool
+CxpNewickIsLabelChar(char c) {
+    return (CxpNewickIsSpace(c) == false && c != '(' && c != ')' && c != '['
+      && c != ']' && c != '\'' && c != ':' && c != ';' && c != ',');
+}
+
+CxmpInline bool
+CxpNewickIsDigit(char c) {
+    return (c >= '0' && c <= '9');
+}
+
+// Return true if aS[0..aLen) completely matches the lexer's branch length
+// pattern:
+//
+//   [-+]?[0-9]+([.][0-9]+)?([eE][-+]?[0-9]+)?
+static bool
+CxpNewickIsNumber(const char *aS, size_t aLen) {
+    const char *p, *end;
+
+    p = aS;
+    end = aS + aLen;
+    if (p < end && (*p == '-' || *p == '+')) {
+	p++;
+    }
+    if (p == end || CxpNewickIsDigit(*p) == false) {
+	return false;
+    }
+    while (p < end && CxpNewickIsDigit(*p)) {
+	p++;
+    }
+    if (p < end && *p == '.') {
+	p++;
+	if (p == end || CxpNewickIsDigit(*p) == false) {
+	    return false;
+	}
+	while (p < end && CxpNewickIsDigit(*p)) {
+	    p++;
+	}
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+	p++;
+	if (p < end && (*p == '-' || *p == '+')) {
+	    p++;
+	}
+	if (p == end || CxpNewickIsDigit(*p) == false) {
+	    return false;
+	}
+	while (p < end && CxpNewickIsDigit(*p)) {
+	    p++;
+	}
+    }
+
+    return (p == end);
+}
+
+// Scan the next token, skipping whitespace and comments.
+static void
+CxpNewickLex(CxtNewickScan *aScan) {
+    const char *p, *end;
+
+    p = aScan->p;
+    end = aScan->end;
+    while (p < end) {
+	if (*p == '\n') {
+	    aScan->line++;
+	    p++;
+	} else if (CxpNewickIsSpace(*p)) {
+	    p++;
+	} else if (*p == '[') {
+	    const char *s;
+	    unsigned depth, line;
+
+	    // Comments nest.
+	    s = p;
+	    line = aScan->line;
+	    depth = 1;
+	    for (p++; depth > 0; p++) {
+		if (p == end) {
+		    // Unterminated comment.  Report the opening '[' as an
+		    // invalid token, rather than reaching the end of input.
+		    aScan->line = line;
+		    aScan->s = s;
+		    aScan->tok = CxeNewickTokInvalid;
+		    aScan->len = 1;
+		    aScan->p = s + 1;
+		    return;
+		} else if (*p == '[') {
+		    depth++;
+		} else if (*p == ']') {
+		    depth--;
+		} else if (*p == '\n') {
+		    aScan->line++;
+		}
+	    }
+	} else {
+	    break;
+	}
+    }
+
+    aScan->s = p;
+    if (p == end) {
+	aScan->tok = CxeNewickTokEnd;
+    } else if (*p == '(') {
+	aScan->tok = CxeNewickTokLparen;
+	p++;
+    } else if (*p == ')') {
+	aScan->tok = CxeNewickTokRparen;
+	p++;
+    } else if (*p == ',') {
+	aScan->tok = CxeNewickTokComma;
+	p++;
+    } else if (*p == ':') {
+	aScan->tok = CxeNewickTokColon;
+	p++;
+    } else if (*p == ';') {
+	aScan->tok = CxeNewickTokSemicolon;
+	p++;
+    } else if (*p == '\'') {
+	// '(''|[^'])*'
+	for (p++; p < end; p++) {
+	    if (*p == '\'') {
+		if (p + 1 < end && p[1] == '\'') {
+		    p++;
+		} else {
+		    break;
+		}
+	    }
+	}
+	if (p == end) {
+	    aScan->tok = CxeNewickTokInvalid;
+	    p = aScan->s + 1;
+	} else {
+	    aScan->tok = CxeNewickTokQuotedLabel;
+	    p++;
+	}
+    } else if (CxpNewickIsLabelChar(*p)) {
+	while (p < end && CxpNewickIsLabelChar(*p)) {
+	    p++;
+	}
+	aScan->tok = CxpNewickIsNumber(aScan->s, p - aScan->s)
+	  ? CxeNewickTokBranchLength : CxeNewickTokUnquotedLabel;
+    } else {
+	// Unmatched ']'.
+	aScan->tok = CxeNewickTokInvalid;
+	p++;
+    }
+    aScan->len = p - aScan->s;
+    aScan->p = p;
+}
+
+// Make sure that aSet->buf has room for at least aLen+1 bytes.  Return true on
+// memory allocation failure.
+static bool
+CxpNewickBufReserve(CxtNewickSet *aSet, size_t aLen) {
+    if (aLen + 1 > aSet->bufLen) {
+	size_t bufLen;
+	char *buf;
+
+	bufLen = (aSet->bufLen == 0) ? CxmNewickMaxMin : aSet->bufLen;
+	while (bufLen < aLen + 1) {
+	    bufLen <<= 1;
+	}
+	buf = (char *)realloc(aSet->buf, bufLen);
+	if (buf == NULL) {
+	    return true;
+	}
+	aSet->buf = buf;
+	aSet->bufLen = bufLen;
+    }
+
+    return false;
+}
+
+// FNV-1a.
+CxmpInline uint32_t
+CxpNewickLabelHash(const char *aS, uint32_t aLen) {
+    uint64_t h;
+    uint32_t i;
+
+    h = 0xcbf29ce484222325ULL;
+    for (i = 0; i < aLen; i++) {
+	h ^= (unsigned char)aS[i];
+	h *= 0x100000001b3ULL;
+    }
+
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+// Double the size of the label table, and rehash.  Return true on memory
+// allocation failure.
+static bool
+CxpNewickLabelTabGrow(CxtNewickSet *aSet) {
+    uint32_t *tab, tabLen, mask, i, l, h;
+
+    tabLen = (aSet->labelTabLen == 0) ? CxmNewickMaxMin
+      : aSet->labelTabLen << 1;
+    tab = (uint32_t *)malloc(tabLen * sizeof(uint32_t));
+    if (tab == NULL) {
+	return true;
+    }
+    memset(tab, 0xff, tabLen * sizeof(uint32_t));
+    mask = tabLen - 1;
+    for (l = 0; l < aSet->nlabels; l++) {
+	h = CxpNewickLabelHash(aSet->labelStrs[l], aSet->labelLens[l]);
+	for (i = h & mask; tab[i] != CxmNewickNone; i = (i + 1) & mask) {
+	    // Empty.
+	}
+	tab[i] = l;
+    }
+    if (aSet->labelTab != NULL) {
+	free(aSet->labelTab);
+    }
+    aSet->labelTab = tab;
+    aSet->labelTabLen = tabLen;
+
+    return false;
+}
+
+// Intern the label aS[0..aLen), and store its index in *rLabel.  Return true
+// on memory allocation failure.
+static bool
+CxpNewickLabelIntern(CxtNewickSet *aSet, const char *aS, size_t aLen,
+  uint32_t *rLabel) {
+    uint32_t mask, i, h, l;
+    char *str;
+
+    if (aLen >= CxmNewickNone) {
+	return true;
+    }
+    // Keep the load factor at or below 1/2.
+    if ((aSet->nlabels + 1) << 1 > aSet->labelTabLen
+      && CxpNewickLabelTabGrow(aSet)) {
+	return true;
+    }
+
+    h = CxpNewickLabelHash(aS, (uint32_t)aLen);
+    mask = aSet->labelTabLen - 1;
+    for (i = h & mask; (l = aSet->labelTab[i]) != CxmNewickNone;
+      i = (i + 1) & mask) {
+	if (aSet->labelLens[l] == aLen
+	  && memcmp(aSet->labelStrs[l], aS, aLen) == 0) {
+	    *rLabel = l;
+	    return false;
+	}
+    }
+
+    if (aSet->nlabels == aSet->maxLabels) {
+	uint32_t maxLabels, *labelLens;
+	char **labelStrs;
+
+	if (aSet->maxLabels >= (CxmNewickNone >> 1)) {
+	    return true;
+	}
+	maxLabels = (aSet->maxLabels == 0) ? CxmNewickMaxMin
+	  : aSet->maxLabels << 1;
+	labelStrs = (char **)realloc(aSet->labelStrs,
+	  maxLabels * sizeof(char *));
+	if (labelStrs == NULL) {
+	    return true;
+	}
+	aSet->labelStrs = labelStrs;
+	labelLens = (uint32_t *)realloc(aSet->labelLens,
+	  maxLabels * sizeof(uint32_t));
+	if (labelLens == NULL) {
+	    return true;
+	}
+	aSet->labelLens = labelLens;
+	aSet->maxLabels = maxLabels;
+    }
+    str = (char *)malloc(aLen + 1);
+    if (str == NULL) {
+	return true;
+    }
+    memcpy(str, aS, aLen);
+    str[aLen] = '\0';
+
+    l = aSet->nlabels;
+    aSet->labelStrs[l] = str;
+    aSet->labelLens[l] = (uint32_t)aLen;
+    aSet->labelTab[i] = l;
+    aSet->nlabels++;
+    *rLabel = l;
+
+    return false;
+}
+
+// Convert the label token in aScan as Crux.Newick.Parser.parseLabel() does,
+// and intern the result.  Return true on memory allocation failure.
+static bool
+CxpNewickLabel(CxtNewickSet *aSet, const CxtNewickScan *aScan,
+  uint32_t *rLabel) {
+    const char *s;
+    size_t len, i, j;
+
+    s = aScan->s;
+    len = aScan->len;
+    if (aScan->tok == CxeNewickTokUnquotedLabel) {
+	// Convert '_' to ' '.
+	if (memchr(s, '_', len) != NULL) {
+	    if (CxpNewickBufReserve(aSet, len)) {
+		return true;
+	    }
+	    for (i = 0; i < len; i++) {
+		aSet->buf[i] = (s[i] == '_') ? ' ' : s[i];
+	    }
+	    s = aSet->buf;
+	}
+    } else if (aScan->tok == CxeNewickTokQuotedLabel) {
+	// Strip the enclosing '...', and convert '' to '.
+	if (CxpNewickBufReserve(aSet, len)) {
+	    return true;
+	}
+	for (i = 1, j = 0; i < len - 1; i++, j++) {
+	    aSet->buf[j] = s[i];
+	    if (s[i] == '\'') {
+		i++;
+	    }
+	}
+	s = aSet->buf;
+	len = j;
+    }
+
+    return CxpNewickLabelIntern(aSet, s, len, rLabel);
+}
+
+// Append a node to the tree that begins at node aOff, and store its
+// tree-relative index in *rNode.  Return true on memory allocation failure.
+static bool
+CxpNewickNodeNew(CxtNewickSet *aSet, uint64_t aOff, uint32_t aParent,
+  uint32_t *rNode) {
+    if (aSet->nnodes - aOff >= CxmNewickNone) {
+	return true;
+    }
+    if (aSet->nnodes == aSet->maxNodes) {
+	uint64_t maxNodes;
+	uint32_t *parents, *labels;
+	double *lengths;
+
+	maxNodes = (aSet->maxNodes == 0) ? CxmNewickMaxMin
+	  : aSet->maxNodes << 1;
+	parents = (uint32_t *)realloc(aSet->parents,
+	  maxNodes * sizeof(uint32_t));
+	if (parents == NULL) {
+	    return true;
+	}
+	aSet->parents = parents;
+	lengths = (double *)realloc(aSet->lengths, maxNodes * sizeof(double));
+	if (lengths == NULL) {
+	    return true;
+	}
+	aSet->lengths = lengths;
+	labels = (uint32_t *)realloc(aSet->labels,
+	  maxNodes * sizeof(uint32_t));
+	if (labels == NULL) {
+	    return true;
+	}
+	aSet->labels = labels;
+	aSet->maxNodes = maxNodes;
+    }
+
+    aSet->parents[aSet->nnodes] = aParent;
+    aSet->lengths[aSet->nnodes] = 0.0;
+    aSet->labels[aSet->nnodes] = CxmNewickNone;
+    *rNode = (uint32_t)(aSet->nnodes - aOff);
+    aSet->nnodes++;
+
+    return false;
+}
+
+// Record a syntax error for the current token.
+static void
+CxpNewickSyntaxError(CxtNewickSet *aSet, const CxtNewickScan *aScan) {
+    if (aScan->tok == CxeNewickTokEnd) {
+	aSet->errMsg = "End of input reached";
+    } else if (aScan->tok == CxeNewickTokInvalid) {
+	aSet->errMsg = "Invalid token";
+    } else {
+	aSet->errMsg = "Unexpected token";
+    }
+    aSet->errLine = aScan->line;
+    aSet->errTok = aScan->s;
+    aSet->errTokLen = aScan->len;
+}
+
+bool
+CxNewickSetNew(CxtNewickSet *aSet) {
+    memset(aSet, 0, sizeof(CxtNewickSet));
+
+    aSet->offs = (uint64_t *)malloc(CxmNewickMaxMin * sizeof(uint64_t));
+    if (aSet->offs == NULL) {
+	return true;
+    }
+    aSet->offs[0] = 0;
+    aSet->maxTrees = CxmNewickMaxMin - 1;
+
+    return false;
+}
+
+void
+CxNewickSetDelete(CxtNewickSet *aSet) {
+    uint32_t l;
+
+    if (aSet->parents != NULL) {
+	free(aSet->parents);
+    }
+    if (aSet->lengths != NULL) {
+	free(aSet->lengths);
+    }
+    if (aSet->labels != NULL) {
+	free(aSet->labels);
+    }
+    if (aSet->offs != NULL) {
+	free(aSet->offs);
+    }
+    for (l = 0; l < aSet->nlabels; l++) {
+	free(aSet->labelStrs[l]);
+    }
+    if (aSet->labelStrs != NULL) {
+	free(aSet->labelStrs);
+    }
+    if (aSet->labelLens != NULL) {
+	free(aSet->labelLens);
+    }
+    if (aSet->labelTab != NULL) {
+	free(aSet->labelTab);
+    }
+    if (aSet->buf != NULL) {
+	free(aSet->buf);
+    }
+    memset(aSet, 0, sizeof(CxtNewickSet));
+}
+
+bool
+CxNewickSetParse(CxtNewickSet *aSet, const char *aBuf, size_t aLen,
+  unsigned aLine) {
+    CxtNewickScan scan;
+    uint64_t ntrees, off;
+    uint32_t *stack, depth, maxDepth, node;
+    bool done, hasLabel, hasLength;
+
+    scan.p = aBuf;
+    scan.end = aBuf + aLen;
+    scan.line = aLine;
+    ntrees = aSet->ntrees;
+    aSet->errMsg = NULL;
+
+    // Stack of nodes with open descendant lists.
+    maxDepth = CxmNewickMaxMin;
+    stack = (uint32_t *)malloc(maxDepth * sizeof(uint32_t));
+    if (stack == NULL) {
+	goto ERROR;
+    }
+
+    // Parse trees, without recursion, so that deep trees cannot exhaust the
+    // C stack.
+    for (CxpNewickLex(&scan); scan.tok != CxeNewickTokEnd;
+      CxpNewickLex(&scan)) {
+	if (aSet->ntrees == aSet->maxTrees) {
+	    uint64_t maxTrees, *offs;
+
+	    maxTrees = ((aSet->maxTrees + 1) << 1) - 1;
+	    offs = (uint64_t *)realloc(aSet->offs,
+	      (maxTrees + 1) * sizeof(uint64_t));
+	    if (offs == NULL) {
+		goto ERROR;
+	    }
+	    aSet->offs = offs;
+	    aSet->maxTrees = maxTrees;
+	}
+	off = aSet->offs[aSet->ntrees];
+	depth = 0;
+
+	done = false;
+	while (done == false) {
+	    // Begin a subtree; scan holds its first token.
+	    if (CxpNewickNodeNew(aSet, off,
+	      (depth == 0) ? CxmNewickNone : stack[depth - 1], &node)) {
+		goto ERROR;
+	    }
+	    if (scan.tok == CxeNewickTokLparen) {
+		if (depth == maxDepth) {
+		    uint32_t *s;
+
+		    maxDepth <<= 1;
+		    s = (uint32_t *)realloc(stack, maxDepth * sizeof(uint32_t));
+		    if (s == NULL) {
+			goto ERROR;
+		    }
+		    stack = s;
+		}
+		stack[depth] = node;
+		depth++;
+		CxpNewickLex(&scan);
+		continue;
+	    }
+
+	    // Complete subtrees until another subtree begins, or the tree ends.
+	    while (true) {
+		hasLabel = hasLength = false;
+		if (scan.tok == CxeNewickTokUnquotedLabel
+		  || scan.tok == CxeNewickTokQuotedLabel
+		  || scan.tok == CxeNewickTokBranchLength) {
+		    if (CxpNewickLabel(aSet, &scan,
+		      &aSet->labels[off + node])) {
+			goto ERROR;
+		    }
+		    hasLabel = true;
+		    CxpNewickLex(&scan);
+		}
+		if (scan.tok == CxeNewickTokColon) {
+		    CxpNewickLex(&scan);
+		    if (scan.tok != CxeNewickTokBranchLength) {
+			CxpNewickSyntaxError(aSet, &scan);
+			goto ERROR;
+		    }
+		    if (CxpNewickBufReserve(aSet, scan.len)) {
+			goto ERROR;
+		    }
+		    memcpy(aSet->buf, scan.s, scan.len);
+		    aSet->buf[scan.len] = '\0';
+		    aSet->lengths[off + node] = strtod(aSet->buf, NULL);
+		    hasLength = true;
+		    CxpNewickLex(&scan);
+		}
+
+		if (depth == 0) {
+		    if (scan.tok != CxeNewickTokSemicolon) {
+			CxpNewickSyntaxError(aSet, &scan);
+			goto ERROR;
+		    }
+		    if (aSet->nnodes - off == 1 && hasLabel == false
+		      && hasLength == false) {
+			// Empty tree.
+			aSet->nnodes = off;
+		    }
+		    done = true;
+		    break;
+		} else if (scan.tok == CxeNewickTokComma) {
+		    CxpNewickLex(&scan);
+		    break;
+		} else if (scan.tok == CxeNewickTokRparen) {
+		    depth--;
+		    node = stack[depth];
+		    CxpNewickLex(&scan);
+		} else {
+		    CxpNewickSyntaxError(aSet, &scan);
+		    goto ERROR;
+		}
+	    }
+	}
+
+	if (aSet->nnodes - off > aSet->maxTreeNodes) {
+	    aSet->maxTreeNodes = (uint32_t)(aSet->nnodes - off);
+	}
+	aSet->ntrees++;
+	aSet->offs[aSet->ntrees] = aSet->nnodes;
+    }
+
+    free(stack);
+    return false;
+    ERROR:
+    if (stack != NULL) {
+	free(stack);
+    }
+    aSet->ntrees = ntrees;
+    aSet->nnodes = aSet->offs[ntrees];
+    return true;
+}
+
+bool
+CxNewickSetParseFd(CxtNewickSet *aSet, int aFd, unsigned aLine) {
+    struct stat st;
+    char *map;
+    size_t mapLen;
+    bool ret;
+
+    aSet->errMsg = NULL;
+    if (fstat(aFd, &st) == -1) {
+	return true;
+    }
+    mapLen = (size_t)st.st_size;
+    if (mapLen == 0) {
+	return CxNewickSetParse(aSet, "", 0, aLine);
+    }
+    map = (char *)mmap(NULL, mapLen, PROT_READ, MAP_SHARED, aFd, 0);
+    if (map == (char *)MAP_FAILED) {
+	return true;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(map, mapLen, MADV_SEQUENTIAL);
+#endif
+
+    ret = CxNewickSetParse(aSet, map, mapLen, aLine);
+    munmap(map, mapLen);
+
+    return ret;
+}
+
+bool
+CxNewickSplitsNew(CxtNewickSplits *aSplits, const CxtNewickSet *aSet,
+  unsigned aNBits) {
+    uint32_t maxNodes;
+
+    memset(aSplits, 0, sizeof(CxtNewickSplits));
+    aSplits->nBits = aNBits;
+    aSplits->nWords = CxmBipartNWords(aNBits);
+    aSplits->keysAll = CxBipartKeysAll(aNBits);
+
+    // Allocate at least one element of everything, so that allocation
+    // failure is unambiguous.
+    maxNodes = (aSet->maxTreeNodes > 0) ? aSet->maxTreeNodes : 1;
+    aSplits->maxNodes = maxNodes;
+    aSplits->words = (uint64_t *)malloc(maxNodes * (aSplits->nWords + 1)
+      * sizeof(uint64_t));
+    aSplits->hashes = (uint64_t *)malloc(maxNodes * sizeof(uint64_t));
+    aSplits->lens = (double *)malloc(maxNodes * sizeof(double));
+    aSplits->nodeWords = (uint64_t *)malloc(maxNodes * (aSplits->nWords + 1)
+      * sizeof(uint64_t));
+    aSplits->nodeHashes = (uint64_t *)malloc(maxNodes * sizeof(uint64_t));
+    aSplits->nodeBits = (uint32_t *)malloc(maxNodes * sizeof(uint32_t));
+    aSplits->nchildren = (uint32_t *)malloc(maxNodes * sizeof(uint32_t));
+    aSplits->order = malloc(maxNodes * sizeof(CxtNewickSplit));
+    if (aSplits->words == NULL || aSplits->hashes == NULL
+      || aSplits->lens == NULL || aSplits->nodeWords == NULL
+      || aSplits->nodeHashes == NULL || aSplits->nodeBits == NULL
+      || aSplits->nchildren == NULL
+      || aSplits->order == NULL) {
+	CxNewickSplitsDelete(aSplits);
+	return true;
+    }
+
+    return false;
+}
+
+void
+CxNewickSplitsDelete(CxtNewickSplits *aSplits) {
+    if (aSplits->words != NULL) {
+	free(aSplits->words);
+    }
+    if (aSplits->hashes != NULL) {
+	free(aSplits->hashes);
+    }
+    if (aSplits->lens != NULL) {
+	free(aSplits->lens);
+    }
+    if (aSplits->nodeWords != NULL) {
+	free(aSplits->nodeWords);
+    }
+    if (aSplits->nodeHashes != NULL) {
+	free(aSplits->nodeHashes);
+    }
+    if (aSplits->nodeBits != NULL) {
+	free(aSplits->nodeBits);
+    }
+    if (aSplits->nchildren != NULL) {
+	free(aSplits->nchildren);
+    }
+    if (aSplits->order != NULL) {
+	free(aSplits->order);
+    }
+    memset(aSplits, 0, sizeof(CxtNewickSplits));
+}
+
+static int
+CxpNewickSplitCmp(const void *aA, const void *aB) {
+    const CxtNewickSplit *a = (const CxtNewickSplit *)aA;
+    const CxtNewickSplit *b = (const CxtNewickSplit *)aB;
+
+    return CxBipartCmp(a->words, b->words, a->nWords);
+}
+
+// Append the split for node aNode's subtree to aSplits->order, normalized so
+// that bit 0 is clear.
+CxmpInline void
+CxpNewickSplitAdd(CxtNewickSplits *aSplits, uint32_t aNode, double aLen) {
+    CxtNewickSplit *split;
+    uint64_t *words;
+
+    words = &aSplits->nodeWords[aNode * aSplits->nWords];
+    CxBipartNormalize(words, &aSplits->nodeHashes[aNode], aSplits->nBits,
+      aSplits->keysAll);
+
+    split = &((CxtNewickSplit *)aSplits->order)[aSplits->nsplits];
+    split->words = words;
+    split->nWords = aSplits->nWords;
+    split->hash = aSplits->nodeHashes[aNode];
+    split->len = aLen;
+    aSplits->nsplits++;
+}
+
+bool
+CxNewickSplitsCompute(CxtNewickSplits *aSplits, const CxtNewickSet *aSet,
+  uint64_t aTree, const uint32_t *aBits) {
+    const uint32_t *parents, *labels;
+    const double *lengths;
+    const CxtNewickSplit *order;
+    uint32_t n, i, x, y;
+    unsigned nWords, ntop;
+    bool splice;
+
+    CxmAssert(aTree < aSet->ntrees);
+
+    nWords = aSplits->nWords;
+    parents = &aSet->parents[aSet->offs[aTree]];
+    lengths = &aSet->lengths[aSet->offs[aTree]];
+    labels = &aSet->labels[aSet->offs[aTree]];
+    n = (uint32_t)(aSet->offs[aTree + 1] - aSet->offs[aTree]);
+    CxmAssert(n <= aSplits->maxNodes);
+
+    aSplits->nsplits = 0;
+    aSplits->fp[0] = aSplits->fp[1] = 0;
+    aSplits->ntaxa = 0;
+    if (n == 0) {
+	return false;
+    }
+
+    memset(aSplits->nchildren, 0, n * sizeof(uint32_t));
+    for (i = 1; i < n; i++) {
+	aSplits->nchildren[parents[i]]++;
+    }
+
+    // Tree.deroot() discards the implicit root, and if that leaves the
+    // top-level node with only two children, x and y, it splices the node
+    // out, so that x (the tree base) and y are directly connected.  The top
+    // node's label is discarded along with it.
+    ntop = aSplits->nchildren[0];
+    splice = (ntop == 2);
+    x = y = CxmNewickNone;
+    if (splice) {
+	x = 1;
+	for (y = x + 1; parents[y] != 0; y++) {
+	    // Empty.
+	}
+    }
+
+    // Translate labels to bit indices, and accumulate subtree bit vectors.
+    for (i = 0; i < n; i++) {
+	if (labels[i] != CxmNewickNone && (splice == false || i != 0)) {
+	    aSplits->nodeBits[i] = aBits[labels[i]];
+	    CxmAssert(aSplits->nodeBits[i] < aSplits->nBits);
+	    aSplits->ntaxa++;
+	} else if (aSplits->nchildren[i] == 0 && i != 0 && i != x) {
+	    // Bipart requires all leaves (other than the base) to be labeled.
+	    return true;
+	} else {
+	    aSplits->nodeBits[i] = CxmBipartNone;
+	}
+    }
+    CxBipartSubtrees(n, parents, aSplits->nodeBits, nWords,
+      aSplits->nodeWords, aSplits->nodeHashes);
+
+    // Enumerate one split per unrooted edge, except for the edge that is
+    // adjacent to a base of degree 1, if that edge is internal.
+    for (i = 1; i < n; i++) {
+	if (splice && (i == x || i == y)) {
+	    continue;
+	}
+	if (ntop == 1 && parents[i] == 0 && aSplits->nchildren[i] != 0) {
+	    continue;
+	}
+	CxpNewickSplitAdd(aSplits, i, lengths[i]);
+    }
+    if (splice && (aSplits->nchildren[x] != 0
+      || aSplits->nchildren[y] == 0)) {
+	// Tree.deroot() accumulates the removed length in single precision.
+	CxpNewickSplitAdd(aSplits, y, lengths[y] + (double)(float)lengths[x]);
+    }
+
+    // Sort, and store the splits.
+    order = (const CxtNewickSplit *)aSplits->order;
+    qsort(aSplits->order, aSplits->nsplits, sizeof(CxtNewickSplit),
+      CxpNewickSplitCmp);
+    for (i = 0; i < aSplits->nsplits; i++) {
+	memcpy(&aSplits->words[i * nWords], order[i].words,
+	  nWords * sizeof(uint64_t));
+	aSplits->hashes[i] = order[i].hash;
+	aSplits->lens[i] = order[i].len;
+	CxBipartFpAdd(aSplits->fp, order[i].hash);
+    }
+
+    return false;
+}
@@ -0,0 +1,130 @@
+#ifndef CxNewick_h
+#define CxNewick_h
+
+#include "Cx.h"
+
+// Native bulk Newick parser.  Trees are parsed directly into a compact set
+// representation, rather than into Tree/Node/Edge/Ring instances, so that
+// large tree samples can be summarized without materializing Python objects.
+// The accepted grammar is the same as that of Crux.Newick.Parser (which see),
+// except that comments may span lines.
+
+// Index value that means "no node" or "no label".
+#define CxmNewickNone 0xffffffffU
+
+// Compact set of trees.  The nodes of each tree are stored in preorder, with
+// children in input order, so a node's parent always precedes it, and the
+// top-level node (the node attached to the implicit root) is first.
+// Unspecified branch lengths are stored as 0.0, which is also the default
+// Edge length.  Trees that consist of only a ';' have no nodes.
+typedef struct {
+    // Node vectors, shared by all trees.  parents[i] is the tree-relative
+    // index of node i's parent, lengths[i] is the length of the edge that
+    // connects node i to its parent (or to the implicit root), and labels[i]
+    // is an index into labelStrs.
+    uint32_t *parents;
+    double *lengths;
+    uint32_t *labels;
+    uint64_t nnodes;
+    uint64_t maxNodes;
+
+    // Tree i consists of nodes [offs[i]..offs[i+1]).  offs has (ntrees+1)
+    // valid elements.
+    uint64_t *offs;
+    uint64_t ntrees;
+    uint64_t maxTrees;
+    uint32_t maxTreeNodes; // Maximum number of nodes in any tree.
+
+    // Interned labels, after unquoting and '_'-->' ' conversion.  Strings are
+    // NUL-terminated, but labels may also contain NUL bytes, so labelLens
+    // is authoritative.
+    char **labelStrs;
+    uint32_t *labelLens;
+    uint32_t nlabels;
+    uint32_t maxLabels;
+    uint32_t *labelTab; // Open addressing; CxmNewickNone for empty slots.
+    uint32_t labelTabLen; // Power of 2.
+
+    // Scratch buffer for label conversion.
+    char *buf;
+    size_t bufLen;
+
+    // Description of the most recent syntax error.  errMsg is NULL if the
+    // most recent error was not a syntax error (memory allocation or I/O
+    // failure).  errTok/errTokLen describe the offending token if errMsg is
+    // "Unexpected token".
+    const char *errMsg;
+    unsigned errLine;
+    const char *errTok;
+    size_t errTokLen;
+} CxtNewickSet;
+
+// Initialize an empty tree set.  Return true on error.
+bool
+CxNewickSetNew(CxtNewickSet *aSet);
+
+// Discard aSet.
+void
+CxNewickSetDelete(CxtNewickSet *aSet);
+
+// Parse all ';'-terminated trees in aBuf[0..aLen), and append them to aSet.
+// Trailing whitespace and comments are permitted.  aLine is the line number
+// of the beginning of aBuf, for error reporting.  Return true on error, in
+// which case none of the trees in aBuf are appended.
+bool
+CxNewickSetParse(CxtNewickSet *aSet, const char *aBuf, size_t aLen,
+  unsigned aLine);
+
+// Memory-map the file open on aFd, and parse it via CxNewickSetParse().
+// Return true on error.
+bool
+CxNewickSetParseFd(CxtNewickSet *aSet, int aFd, unsigned aLine);
+
+// Split computation context.  Splits are computed for the unrooted tree that
+// Tree.deroot() would produce, precisely as Bipart would compute them: one
+// split per edge (leaf edges included), with bit 0 always clear, in
+// CxBipartCmp() order.
+typedef struct {
+    unsigned nBits;
+    unsigned nWords;
+    uint64_t keysAll; // CxBipartKeysAll(nBits).
+
+    // Splits of the most recently processed tree.  Split i's bit vector is
+    // words[i*nWords..(i+1)*nWords), its Zobrist hash is hashes[i], and its
+    // branch length is lens[i].  fp is the topology fingerprint (see
+    // CxBipartFpAdd()), and ntaxa is the number of labeled nodes in the
+    // unrooted tree.
+    uint64_t *words;
+    uint64_t *hashes;
+    double *lens;
+    uint32_t nsplits;
+    uint64_t fp[2];
+    unsigned ntaxa;
+
+    // Scratch space, sized for the largest tree in the set at
+    // initialization time.
+    uint32_t maxNodes;
+    uint64_t *nodeWords;
+    uint64_t *nodeHashes;
+    uint32_t *nodeBits;
+    uint32_t *nchildren;
+    void *order;
+} CxtNewickSplits;
+
+// Initialize a split computation context for the trees in aSet, which are
+// on aNBits taxa.  Return true on error.
+bool
+CxNewickSplitsNew(CxtNewickSplits *aSplits, const CxtNewickSet *aSet,
+  unsigned aNBits);
+
+// Discard aSplits.
+void
+CxNewickSplitsDelete(CxtNewickSplits *aSplits);
+
+// Compute the splits of tree aTree in aSet, where aBits[l] is the bit index
+// of the taxon with label l.  Return true if the tree has an unlabeled leaf.
+bool
+CxNewickSplitsCompute(CxtNewickSplits *aSplits, const CxtNewickSet *aSet,
+  uint64_t aTree, const uint32_t *aBits);
+
+#endif // CxNewick_h
@@ -0,0 +1,44 @@
+from libc cimport uint32_t, uint64_t
+
+cdef extern from "CxNewick.h":
+    cdef enum:
+        CxmNewickNone
+    ctypedef struct CxtNewickSet:
+        uint32_t *parents
+        double *lengths
+        uint32_t *labels
+        uint64_t nnodes
+        uint64_t maxNodes
+        uint64_t *offs
+        uint64_t ntrees
+        uint64_t maxTrees
+        uint32_t maxTreeNodes
+        char **labelStrs
+        uint32_t *labelLens
+        uint32_t nlabels
+        char *errMsg
+        unsigned errLine
+        char *errTok
+        size_t errTokLen
+
+    cdef bint CxNewickSetNew(CxtNewickSet *aSet)
+    cdef void CxNewickSetDelete(CxtNewickSet *aSet)
+    cdef bint CxNewickSetParse(CxtNewickSet *aSet, char *aBuf, size_t aLen, \
+      unsigned aLine)
+    cdef bint CxNewickSetParseFd(CxtNewickSet *aSet, int aFd, unsigned aLine)
+
+    ctypedef struct CxtNewickSplits:
+        unsigned nBits
+        unsigned nWords
+        uint64_t *words
+        uint64_t *hashes
+        double *lens
+        uint32_t nsplits
+        uint64_t fp[2]
+        unsigned ntaxa
+
+    cdef bint CxNewickSplitsNew(CxtNewickSplits *aSplits, CxtNewickSet *aSet, \
+      unsigned aNBits)
+    cdef void CxNewickSplitsDelete(CxtNewickSplits *aSplits)
+    cdef bint CxNewickSplitsCompute(CxtNewickSplits *aSplits, \
+      CxtNewickSet *aSet, uint64_t aTree, uint32_t *aBits)
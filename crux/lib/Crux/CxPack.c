@@ -0,0 +1,485 @@
+#include "CxPack.h"
+
+// Initial number of exceptions for which space is allocated.
+#define CxmPackMaxExcMin 64
+
+// Number of cells unpacked at a time by CxpPackStatsWeighted().
+#define CxmPackBlock 256
+
+#define CxmPackLo4 0x1111111111111111ULL
+#define CxmPackLo2 0x5555555555555555ULL
+
+// Number of states in each state set.
+static const uint8_t CxpPackPop[16] = {
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+CxmpInline unsigned
+CxpPackPopcount(uint64_t aX) {
+#ifdef __GNUC__
+    return __builtin_popcountll(aX);
+#else
+    aX = aX - ((aX >> 1) & 0x5555555555555555ULL);
+    aX = (aX & 0x3333333333333333ULL) + ((aX >> 2) & 0x3333333333333333ULL);
+    aX = (aX + (aX >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned)((aX * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Number of cells per word.
+CxmpInline unsigned
+CxpPackCpw(const CxtPack *aPack) {
+    return 64 / aPack->bits;
+}
+
+// Get the raw packed bits for cell (aRow,aCol).
+CxmpInline unsigned
+CxpPackRaw(const CxtPack *aPack, uint32_t aRow, uint32_t aCol) {
+    unsigned cpw = CxpPackCpw(aPack);
+
+    return (unsigned)(aPack->words[(uint64_t)aRow * aPack->nwords
+      + (aCol / cpw)] >> ((aCol % cpw) * aPack->bits))
+      & ((1U << aPack->bits) - 1);
+}
+
+// Set the raw packed bits for cell (aRow,aCol).
+CxmpInline void
+CxpPackRawSet(CxtPack *aPack, uint32_t aRow, uint32_t aCol, unsigned aRaw) {
+    unsigned cpw = CxpPackCpw(aPack);
+    unsigned shift = (aCol % cpw) * aPack->bits;
+    uint64_t *word, mask;
+
+    word = &aPack->words[(uint64_t)aRow * aPack->nwords + (aCol / cpw)];
+    mask = (uint64_t)((1U << aPack->bits) - 1) << shift;
+    *word = (*word & ~mask) | ((uint64_t)aRaw << shift);
+}
+
+// Make room for at least aNExc exceptions in total.
+static bool
+CxpPackExcReserve(CxtPack *aPack, uint64_t aNExc) {
+    uint64_t maxExc;
+    uint32_t *excCols;
+    uint8_t *excVals;
+
+    if (aNExc <= aPack->maxExc) {
+	return false;
+    }
+    maxExc = (aPack->maxExc != 0) ? aPack->maxExc << 1 : CxmPackMaxExcMin;
+    if (maxExc < aNExc) {
+	maxExc = aNExc;
+    }
+    excCols = (uint32_t *)realloc(aPack->excCols, maxExc * sizeof(uint32_t));
+    if (excCols == NULL) {
+	return true;
+    }
+    aPack->excCols = excCols;
+    excVals = (uint8_t *)realloc(aPack->excVals, maxExc);
+    if (excVals == NULL) {
+	return true;
+    }
+    aPack->excVals = excVals;
+    aPack->maxExc = maxExc;
+
+    return false;
+}
+
+// Find the first exception in aRow with column >= aCol, and store its index
+// in *rInd.  Return true if its column is aCol.
+static bool
+CxpPackExcFind(const CxtPack *aPack, uint32_t aRow, uint32_t aCol,
+  uint64_t *rInd) {
+    uint64_t lo, hi, mid;
+
+    lo = aPack->excOffs[aRow];
+    hi = aPack->excOffs[aRow + 1];
+    while (lo < hi) {
+	mid = lo + ((hi - lo) >> 1);
+	if (aPack->excCols[mid] < aCol) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+    *rInd = lo;
+
+    return (lo < aPack->excOffs[aRow + 1] && aPack->excCols[lo] == aCol);
+}
+
+bool
+CxPackNew(CxtPack *aPack, unsigned aBits, uint32_t aNTaxa, uint32_t aNChars,
+  const char *aCells, uint64_t aRowStride, uint64_t aColStride,
+  const uint8_t *aCode2Val) {
+    uint32_t i, j;
+    uint64_t nexc;
+    uint8_t val;
+
+    CxmAssert(aBits == 2 || aBits == 4);
+
+    memset(aPack, 0, sizeof(CxtPack));
+    aPack->bits = aBits;
+    aPack->ntaxa = aNTaxa;
+    aPack->nchars = aNChars;
+    aPack->nwords = (aNChars + CxpPackCpw(aPack) - 1) / CxpPackCpw(aPack);
+
+    if ((aPack->words = (uint64_t *)calloc((uint64_t)aNTaxa * aPack->nwords,
+      sizeof(uint64_t))) == NULL
+      || (aBits == 2 && (aPack->excOffs = (uint64_t *)malloc((aNTaxa + 1)
+      * sizeof(uint64_t))) == NULL)) {
+	CxPackDelete(aPack);
+	return true;
+    }
+
+    nexc = 0;
+    for (i = 0; i < aNTaxa; i++) {
+	if (aBits == 2) {
+	    aPack->excOffs[i] = nexc;
+	}
+	for (j = 0; j < aNChars; j++) {
+	    val = aCode2Val[(unsigned char)aCells[i * aRowStride
+	      + j * aColStride]];
+	    CxmAssert(val < 16);
+	    if (aBits == 4) {
+		CxpPackRawSet(aPack, i, j, val);
+	    } else if (CxpPackPop[val] == 1) {
+		CxpPackRawSet(aPack, i, j, ffs(val) - 1);
+	    } else {
+		// The cell is left as 0.
+		if (CxpPackExcReserve(aPack, nexc + 1)) {
+		    CxPackDelete(aPack);
+		    return true;
+		}
+		aPack->excCols[nexc] = j;
+		aPack->excVals[nexc] = val;
+		nexc++;
+	    }
+	}
+    }
+    if (aBits == 2) {
+	aPack->excOffs[aNTaxa] = nexc;
+    }
+
+    return false;
+}
+
+void
+CxPackDelete(CxtPack *aPack) {
+    if (aPack->words != NULL) {
+	free(aPack->words);
+    }
+    if (aPack->excOffs != NULL) {
+	free(aPack->excOffs);
+    }
+    if (aPack->excCols != NULL) {
+	free(aPack->excCols);
+    }
+    if (aPack->excVals != NULL) {
+	free(aPack->excVals);
+    }
+    memset(aPack, 0, sizeof(CxtPack));
+}
+
+uint8_t
+CxPackGet(const CxtPack *aPack, uint32_t aRow, uint32_t aCol) {
+    uint64_t ind;
+
+    CxmAssert(aRow < aPack->ntaxa);
+    CxmAssert(aCol < aPack->nchars);
+
+    if (aPack->bits == 4) {
+	return CxpPackRaw(aPack, aRow, aCol);
+    }
+    if (CxpPackExcFind(aPack, aRow, aCol, &ind)) {
+	return aPack->excVals[ind];
+    }
+    return 1U << CxpPackRaw(aPack, aRow, aCol);
+}
+
+void
+CxPackRowGet(const CxtPack *aPack, uint32_t aRow, uint32_t aCol, uint32_t aN,
+  uint8_t *rVals) {
+    uint32_t j;
+    uint64_t ind, lim;
+
+    CxmAssert(aRow < aPack->ntaxa);
+    CxmAssert(aCol + aN <= aPack->nchars);
+
+    if (aPack->bits == 4) {
+	for (j = 0; j < aN; j++) {
+	    rVals[j] = CxpPackRaw(aPack, aRow, aCol + j);
+	}
+    } else {
+	for (j = 0; j < aN; j++) {
+	    rVals[j] = 1U << CxpPackRaw(aPack, aRow, aCol + j);
+	}
+	CxpPackExcFind(aPack, aRow, aCol, &ind);
+	lim = aPack->excOffs[aRow + 1];
+	for (; ind < lim && aPack->excCols[ind] < aCol + aN; ind++) {
+	    rVals[aPack->excCols[ind] - aCol] = aPack->excVals[ind];
+	}
+    }
+}
+
+bool
+CxPackSet(CxtPack *aPack, uint32_t aRow, uint32_t aCol, uint8_t aVal) {
+    uint64_t ind, nexc;
+    uint32_t i;
+    bool found;
+
+    CxmAssert(aRow < aPack->ntaxa);
+    CxmAssert(aCol < aPack->nchars);
+    CxmAssert(aVal < 16);
+
+    if (aPack->bits == 4) {
+	CxpPackRawSet(aPack, aRow, aCol, aVal);
+	return false;
+    }
+
+    found = CxpPackExcFind(aPack, aRow, aCol, &ind);
+    nexc = aPack->excOffs[aPack->ntaxa];
+    if (CxpPackPop[aVal] == 1) {
+	CxpPackRawSet(aPack, aRow, aCol, ffs(aVal) - 1);
+	if (found) {
+	    // Remove the exception.
+	    memmove(&aPack->excCols[ind], &aPack->excCols[ind + 1],
+	      (nexc - ind - 1) * sizeof(uint32_t));
+	    memmove(&aPack->excVals[ind], &aPack->excVals[ind + 1],
+	      nexc - ind - 1);
+	    for (i = aRow + 1; i <= aPack->ntaxa; i++) {
+		aPack->excOffs[i]--;
+	    }
+	}
+    } else {
+	CxpPackRawSet(aPack, aRow, aCol, 0);
+	if (found) {
+	    aPack->excVals[ind] = aVal;
+	} else {
+	    // Insert an exception.
+	    if (CxpPackExcReserve(aPack, nexc + 1)) {
+		return true;
+	    }
+	    memmove(&aPack->excCols[ind + 1], &aPack->excCols[ind],
+	      (nexc - ind) * sizeof(uint32_t));
+	    memmove(&aPack->excVals[ind + 1], &aPack->excVals[ind],
+	      nexc - ind);
+	    aPack->excCols[ind] = aCol;
+	    aPack->excVals[ind] = aVal;
+	    for (i = aRow + 1; i <= aPack->ntaxa; i++) {
+		aPack->excOffs[i]++;
+	    }
+	}
+    }
+
+    return false;
+}
+
+// Add the contribution of one pair of cells to rA.
+CxmpInline void
+CxpPackStatsCell(unsigned aAVal, unsigned aBVal, double aWeight,
+  bool aScoreGaps, double *rA) {
+    unsigned aPop, bPop, i, j;
+    double p;
+
+    if (aAVal == 0 || aBVal == 0) {
+	if (aScoreGaps == false) {
+	    // Ignore this pair.
+	    return;
+	}
+	// Translate gaps to mean "any character".
+	if (aAVal == 0) {
+	    aAVal = 0xf;
+	}
+	if (aBVal == 0) {
+	    aBVal = 0xf;
+	}
+    }
+
+    aPop = CxpPackPop[aAVal];
+    bPop = CxpPackPop[aBVal];
+    if (aPop == 1 && bPop == 1) {
+	rA[((ffs(aAVal) - 1) << 2) + (ffs(aBVal) - 1)] += aWeight;
+	return;
+    }
+
+    // Each possible state combination is assigned an equal probability.
+    p = aWeight / (double)(aPop * bPop);
+    for (i = 0; i < 4; i++) {
+	if (aAVal & (1U << i)) {
+	    for (j = 0; j < 4; j++) {
+		if (aBVal & (1U << j)) {
+		    rA[(i << 2) + j] += p;
+		}
+	    }
+	}
+    }
+}
+
+// Compute a mask of the low bits of all valid cells in word aWord of a row.
+CxmpInline uint64_t
+CxpPackValid(const CxtPack *aPack, uint32_t aWord) {
+    uint64_t lo;
+    unsigned n;
+
+    lo = (aPack->bits == 4) ? CxmPackLo4 : CxmPackLo2;
+    if (aWord + 1 < aPack->nwords) {
+	return lo;
+    }
+    n = aPack->nchars - (aWord * CxpPackCpw(aPack));
+    if (n == CxpPackCpw(aPack)) {
+	return lo;
+    }
+    return lo & ((1ULL << (n * aPack->bits)) - 1);
+}
+
+// Compute a mask with the low bit of each 4-bit cell in aX set if the cell
+// equals aVal.
+CxmpInline uint64_t
+CxpPackEq4(uint64_t aX, unsigned aVal) {
+    uint64_t t;
+
+    t = ~(aX ^ (aVal * CxmPackLo4));
+    t &= t >> 1;
+    t &= t >> 2;
+    return t & CxmPackLo4;
+}
+
+// Compute a mask with the low bit of each 2-bit cell in aX set if the cell
+// equals aVal.
+CxmpInline uint64_t
+CxpPackEq2(uint64_t aX, unsigned aVal) {
+    uint64_t t;
+
+    t = ~(aX ^ (aVal * CxmPackLo2));
+    t &= t >> 1;
+    return t & CxmPackLo2;
+}
+
+// 4-bit mode, unit frequencies.  Pairs of unambiguous cells are counted
+// word-parallel, and the remaining cells are handled individually.
+static void
+CxpPackStats4(const CxtPack *aPack, uint32_t aA, uint32_t aB,
+  bool aScoreGaps, double *rA) {
+    const uint64_t *aWords, *bWords;
+    uint64_t counts[16], ea[4], eb[4], x, y, valid, rest;
+    uint32_t w;
+    unsigned s, t, bit;
+
+    aWords = &aPack->words[(uint64_t)aA * aPack->nwords];
+    bWords = &aPack->words[(uint64_t)aB * aPack->nwords];
+    memset(counts, 0, sizeof(counts));
+    for (w = 0; w < aPack->nwords; w++) {
+	x = aWords[w];
+	y = bWords[w];
+	valid = CxpPackValid(aPack, w);
+	for (s = 0; s < 4; s++) {
+	    ea[s] = CxpPackEq4(x, 1U << s) & valid;
+	    eb[s] = CxpPackEq4(y, 1U << s) & valid;
+	}
+	for (s = 0; s < 4; s++) {
+	    for (t = 0; t < 4; t++) {
+		counts[(s << 2) + t] += CxpPackPopcount(ea[s] & eb[t]);
+	    }
+	}
+
+	rest = valid & ~((ea[0] | ea[1] | ea[2] | ea[3])
+	  & (eb[0] | eb[1] | eb[2] | eb[3]));
+	while (rest != 0) {
+	    bit = __builtin_ctzll(rest);
+	    rest &= rest - 1;
+	    CxpPackStatsCell((unsigned)(x >> bit) & 0xf,
+	      (unsigned)(y >> bit) & 0xf, 1.0, aScoreGaps, rA);
+	}
+    }
+    for (s = 0; s < 16; s++) {
+	rA[s] += (double)counts[s];
+    }
+}
+
+// 2-bit mode, unit frequencies.  All packed cells are counted word-parallel,
+// then the counts are corrected for exceptions in either row.
+static void
+CxpPackStats2(const CxtPack *aPack, uint32_t aA, uint32_t aB,
+  bool aScoreGaps, double *rA) {
+    const uint64_t *aWords, *bWords;
+    uint64_t counts[16], ea[4], eb[4], x, y, valid;
+    uint64_t ia, iaLim, ib, ibLim;
+    uint32_t w, aCol, bCol, col;
+    unsigned s, t, aVal, bVal;
+
+    aWords = &aPack->words[(uint64_t)aA * aPack->nwords];
+    bWords = &aPack->words[(uint64_t)aB * aPack->nwords];
+    memset(counts, 0, sizeof(counts));
+    for (w = 0; w < aPack->nwords; w++) {
+	x = aWords[w];
+	y = bWords[w];
+	valid = CxpPackValid(aPack, w);
+	for (s = 0; s < 4; s++) {
+	    ea[s] = CxpPackEq2(x, s) & valid;
+	    eb[s] = CxpPackEq2(y, s) & valid;
+	}
+	for (s = 0; s < 4; s++) {
+	    for (t = 0; t < 4; t++) {
+		counts[(s << 2) + t] += CxpPackPopcount(ea[s] & eb[t]);
+	    }
+	}
+    }
+
+    // Merge the exception lists, and replace the packed contribution of each
+    // affected column with its actual contribution.
+    ia = aPack->excOffs[aA];
+    iaLim = aPack->excOffs[aA + 1];
+    ib = aPack->excOffs[aB];
+    ibLim = aPack->excOffs[aB + 1];
+    while (ia < iaLim || ib < ibLim) {
+	aCol = (ia < iaLim) ? aPack->excCols[ia] : UINT32_MAX;
+	bCol = (ib < ibLim) ? aPack->excCols[ib] : UINT32_MAX;
+	col = (aCol < bCol) ? aCol : bCol;
+
+	s = CxpPackRaw(aPack, aA, col);
+	t = CxpPackRaw(aPack, aB, col);
+	counts[(s << 2) + t]--;
+
+	aVal = (aCol == col) ? aPack->excVals[ia++] : 1U << s;
+	bVal = (bCol == col) ? aPack->excVals[ib++] : 1U << t;
+	CxpPackStatsCell(aVal, bVal, 1.0, aScoreGaps, rA);
+    }
+    for (s = 0; s < 16; s++) {
+	rA[s] += (double)counts[s];
+    }
+}
+
+// Arbitrary frequencies.  Unpack a block at a time and weight each cell.
+static void
+CxpPackStatsWeighted(const CxtPack *aPack, uint32_t aA, uint32_t aB,
+  const unsigned *aFreqs, bool aScoreGaps, double *rA) {
+    uint8_t aVals[CxmPackBlock], bVals[CxmPackBlock];
+    uint32_t j, k, n;
+
+    for (j = 0; j < aPack->nchars; j += CxmPackBlock) {
+	n = aPack->nchars - j;
+	if (n > CxmPackBlock) {
+	    n = CxmPackBlock;
+	}
+	CxPackRowGet(aPack, aA, j, n, aVals);
+	CxPackRowGet(aPack, aB, j, n, bVals);
+	for (k = 0; k < n; k++) {
+	    CxpPackStatsCell(aVals[k], bVals[k], (double)aFreqs[j + k],
+	      aScoreGaps, rA);
+	}
+    }
+}
+
+void
+CxPackStats(const CxtPack *aPack, uint32_t aA, uint32_t aB,
+  const unsigned *aFreqs, bool aScoreGaps, double *rA) {
+    CxmAssert(aA < aPack->ntaxa);
+    CxmAssert(aB < aPack->ntaxa);
+
+    memset(rA, 0, 16 * sizeof(double));
+    if (aFreqs != NULL) {
+	CxpPackStatsWeighted(aPack, aA, aB, aFreqs, aScoreGaps, rA);
+    } else if (aPack->bits == 4) {
+	CxpPackStats4(aPack, aA, aB, aScoreGaps, rA);
+    } else {
+	CxpPackStats2(aPack, aA, aB, aScoreGaps, rA);
+    }
+}
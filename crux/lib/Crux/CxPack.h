@@ -0,0 +1,76 @@
+#ifndef CxPack_h
+#define CxPack_h
+
+#include "Cx.h"
+
+// Bit-packed nucleotide matrices.  Cell values are state sets (A=1, C=2, G=4,
+// T=8, ambiguities are unions, and a gap is 0), the same as the values used
+// by Crux.Character.Dna.
+//
+// Rows are stored as vectors of 64-bit words, with cell j of a row in word
+// (j / cpw) at bit offset ((j % cpw) * bits), where cpw is the number of cells
+// per word.  Trailing bits in the last word of each row are always clear.
+//
+// In 4-bit mode each cell stores its state set directly.  In 2-bit mode each
+// cell stores a state index (A=0, C=1, G=2, T=3); cells that are not a single
+// state (gaps and ambiguity codes) are stored as 0, and their actual values are
+// recorded in per-row sorted exception lists.  2-bit mode is only compact for
+// data that are mostly unambiguous.
+
+typedef struct {
+    unsigned bits; // 2 or 4.
+    uint32_t ntaxa;
+    uint32_t nchars;
+
+    // Row i is words[i*nwords..(i+1)*nwords).
+    uint32_t nwords;
+    uint64_t *words;
+
+    // Exceptions (2-bit mode only).  Row i's exceptions are
+    // excCols[excOffs[i]..excOffs[i+1]) and the corresponding excVals, in
+    // increasing column order.  excOffs has (ntaxa+1) elements.
+    uint64_t *excOffs;
+    uint32_t *excCols;
+    uint8_t *excVals;
+    uint64_t maxExc;
+} CxtPack;
+
+// Pack a matrix of character codes, where cell (i,j) is
+// aCells[i*aRowStride + j*aColStride], so that either row-major or
+// column-major input can be packed.  aCode2Val maps character codes to state
+// sets.  Return true on error.
+bool
+CxPackNew(CxtPack *aPack, unsigned aBits, uint32_t aNTaxa, uint32_t aNChars,
+  const char *aCells, uint64_t aRowStride, uint64_t aColStride,
+  const uint8_t *aCode2Val);
+
+// Discard aPack.
+void
+CxPackDelete(CxtPack *aPack);
+
+// Get the state set for cell (aRow,aCol).
+uint8_t
+CxPackGet(const CxtPack *aPack, uint32_t aRow, uint32_t aCol);
+
+// Get the state sets for cells (aRow,aCol..aCol+aN) in rVals.
+void
+CxPackRowGet(const CxtPack *aPack, uint32_t aRow, uint32_t aCol, uint32_t aN,
+  uint8_t *rVals);
+
+// Set the state set for cell (aRow,aCol).  Return true on error (only possible
+// in 2-bit mode, when an exception is added).
+bool
+CxPackSet(CxtPack *aPack, uint32_t aRow, uint32_t aCol, uint8_t aVal);
+
+// Compute the 4x4 matrix of state pairs for rows aA and aB in rA (rA[i*4 + j]
+// counts state i in aA vs. state j in aB).  Ambiguous cells contribute equally
+// to all the state pairs they could resolve to, so that each cell contributes
+// its frequency in total.  Gaps are ignored, unless aScoreGaps is true, in
+// which case they are treated as fully ambiguous.  aFreqs contains per-column
+// frequencies, or is NULL if all frequencies are 1, in which case word-parallel
+// comparison is used.
+void
+CxPackStats(const CxtPack *aPack, uint32_t aA, uint32_t aB,
+  const unsigned *aFreqs, bool aScoreGaps, double *rA);
+
+#endif // CxPack_h
@@ -0,0 +1,22 @@
+from libc cimport uint8_t, uint32_t, uint64_t
+
+cdef extern from "CxPack.h":
+    ctypedef struct CxtPack:
+        unsigned bits
+        uint32_t ntaxa
+        uint32_t nchars
+        uint32_t nwords
+        uint64_t *words
+        uint64_t *excOffs
+
+    cdef bint CxPackNew(CxtPack *aPack, unsigned aBits, uint32_t aNTaxa, \
+      uint32_t aNChars, char *aCells, uint64_t aRowStride, \
+      uint64_t aColStride, uint8_t *aCode2Val)
+    cdef void CxPackDelete(CxtPack *aPack)
+    cdef uint8_t CxPackGet(CxtPack *aPack, uint32_t aRow, uint32_t aCol)
+    cdef void CxPackRowGet(CxtPack *aPack, uint32_t aRow, uint32_t aCol, \
+      uint32_t aN, uint8_t *rVals)
+    cdef bint CxPackSet(CxtPack *aPack, uint32_t aRow, uint32_t aCol, \
+      uint8_t aVal)
+    cdef void CxPackStats(CxtPack *aPack, uint32_t aA, uint32_t aB, \
+      unsigned *aFreqs, bint aScoreGaps, double *rA)
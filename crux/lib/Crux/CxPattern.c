@@ -0,0 +1,355 @@
+#include "CxPattern.h"
+#include "CxJobs.h"
+
+// Minimum number of columns per job.
+#define CxmPatternJobMin 4096
+
+// Empty table entry marker.
+#define CxmPatternNone 0xffffffffU
+
+typedef struct {
+    uint64_t hash;
+    uint32_t col; // First column with this pattern, or CxmPatternNone.
+    unsigned freq;
+} CxtPatternEnt;
+
+// Open-addressing hash table with linear probing.  Tables are sized up front
+// to be at most half full, so they never need to grow.
+typedef struct {
+    CxtPatternEnt *ents;
+    uint64_t nents; // Power of 2.
+    uint32_t count;
+} CxtPatternTab;
+
+// Context for CxPatternCompact() jobs.
+typedef struct {
+    const char *cols;
+    uint32_t ntaxa;
+    uint32_t nchars;
+    const unsigned *freqs;
+    uint64_t *hashes;
+    CxtPatternTab *tabs; // One per job.
+    unsigned njobs;
+} CxtPatternCtx;
+
+// Hash aLen bytes, 8 at a time.
+CxmpInline uint64_t
+CxpPatternHash(const char *aBuf, uint32_t aLen) {
+    uint64_t h, w;
+    uint32_t i;
+
+    h = 0x9e3779b97f4a7c15ULL ^ aLen;
+    for (i = 0; i + 8 <= aLen; i += 8) {
+	memcpy(&w, &aBuf[i], 8);
+	h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 31;
+    }
+    if (i < aLen) {
+	w = 0;
+	memcpy(&w, &aBuf[i], aLen - i);
+	h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 31;
+    }
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+
+    return h ^ (h >> 31);
+}
+
+static bool
+CxpPatternTabNew(CxtPatternTab *aTab, uint64_t aMaxCount) {
+    uint64_t i;
+
+    for (aTab->nents = 16; aTab->nents < (aMaxCount << 1);
+      aTab->nents <<= 1) {
+	// Do nothing.
+    }
+    aTab->ents = (CxtPatternEnt *)malloc(aTab->nents * sizeof(CxtPatternEnt));
+    if (aTab->ents == NULL) {
+	return true;
+    }
+    for (i = 0; i < aTab->nents; i++) {
+	aTab->ents[i].col = CxmPatternNone;
+    }
+    aTab->count = 0;
+
+    return false;
+}
+
+static void
+CxpPatternTabDelete(CxtPatternTab *aTab) {
+    if (aTab->ents != NULL) {
+	free(aTab->ents);
+	aTab->ents = NULL;
+    }
+}
+
+// Add aFreq to the entry for column aCol, creating it if necessary.
+CxmpInline void
+CxpPatternTabAdd(CxtPatternTab *aTab, const char *aCols, uint32_t aNTaxa,
+  uint64_t aHash, uint32_t aCol, unsigned aFreq) {
+    CxtPatternEnt *ent;
+    uint64_t mask, i;
+
+    mask = aTab->nents - 1;
+    for (i = aHash & mask;; i = (i + 1) & mask) {
+	ent = &aTab->ents[i];
+	if (ent->col == CxmPatternNone) {
+	    ent->hash = aHash;
+	    ent->col = aCol;
+	    ent->freq = aFreq;
+	    aTab->count++;
+	    return;
+	}
+	if (ent->hash == aHash && memcmp(&aCols[(uint64_t)ent->col * aNTaxa],
+	  &aCols[(uint64_t)aCol * aNTaxa], aNTaxa) == 0) {
+	    ent->freq += aFreq;
+	    return;
+	}
+    }
+}
+
+// Deduplicate one block of columns.
+static void
+CxpPatternJob(void *aArg, unsigned aJob) {
+    CxtPatternCtx *ctx = (CxtPatternCtx *)aArg;
+    uint32_t j, lim;
+    uint64_t hash;
+
+    j = (uint32_t)(((uint64_t)ctx->nchars * aJob) / ctx->njobs);
+    lim = (uint32_t)(((uint64_t)ctx->nchars * (aJob + 1)) / ctx->njobs);
+    for (; j < lim; j++) {
+	hash = CxpPatternHash(&ctx->cols[(uint64_t)j * ctx->ntaxa],
+	  ctx->ntaxa);
+	CxpPatternTabAdd(&ctx->tabs[aJob], ctx->cols, ctx->ntaxa, hash, j,
+	  ctx->freqs[j]);
+    }
+}
+
+// Stable merge sort of patterns, in lexical order of their columns.  aTPats
+// and aTFreqs are temporary space for aN elements.
+static void
+CxpPatternSort(const char *aCols, uint32_t aNTaxa, uint32_t *aPats,
+  unsigned *aFreqs, uint32_t aN, uint32_t *aTPats, unsigned *aTFreqs) {
+    uint32_t *sPats, *dPats, *tPats;
+    unsigned *sFreqs, *dFreqs, *tFreqs;
+    uint32_t width, lo, mid, hi, a, b, k;
+
+    sPats = aPats;
+    sFreqs = aFreqs;
+    dPats = aTPats;
+    dFreqs = aTFreqs;
+    for (width = 1; width < aN; width <<= 1) {
+	for (lo = 0; lo < aN; lo += width << 1) {
+	    mid = (lo + width < aN) ? lo + width : aN;
+	    hi = (mid + width < aN) ? mid + width : aN;
+	    a = lo;
+	    b = mid;
+	    for (k = lo; k < hi; k++) {
+		if (a < mid && (b == hi
+		  || memcmp(&aCols[(uint64_t)sPats[a] * aNTaxa],
+		  &aCols[(uint64_t)sPats[b] * aNTaxa], aNTaxa) <= 0)) {
+		    dPats[k] = sPats[a];
+		    dFreqs[k] = sFreqs[a];
+		    a++;
+		} else {
+		    dPats[k] = sPats[b];
+		    dFreqs[k] = sFreqs[b];
+		    b++;
+		}
+	    }
+	}
+	tPats = sPats;
+	sPats = dPats;
+	dPats = tPats;
+	tFreqs = sFreqs;
+	sFreqs = dFreqs;
+	dFreqs = tFreqs;
+    }
+    if (sPats != aPats) {
+	memcpy(aPats, sPats, aN * sizeof(uint32_t));
+	memcpy(aFreqs, sFreqs, aN * sizeof(unsigned));
+    }
+}
+
+// Merge the per-job tables into a single table (unless there is only one), and
+// store its entries in rPats/rFreqs.
+static bool
+CxpPatternMerge(CxtPatternCtx *aCtx, uint32_t *rPats, unsigned *rFreqs,
+  uint32_t *rNPats) {
+    CxtPatternTab merged, *tab;
+    CxtPatternEnt *ent;
+    uint64_t maxCount, i;
+    uint32_t n;
+    unsigned k;
+
+    if (aCtx->njobs == 1) {
+	tab = &aCtx->tabs[0];
+    } else {
+	maxCount = 0;
+	for (k = 0; k < aCtx->njobs; k++) {
+	    maxCount += aCtx->tabs[k].count;
+	}
+	if (CxpPatternTabNew(&merged, maxCount)) {
+	    return true;
+	}
+	// Merge in job order, so that each pattern is represented by its first
+	// column.
+	for (k = 0; k < aCtx->njobs; k++) {
+	    for (i = 0; i < aCtx->tabs[k].nents; i++) {
+		ent = &aCtx->tabs[k].ents[i];
+		if (ent->col != CxmPatternNone) {
+		    CxpPatternTabAdd(&merged, aCtx->cols, aCtx->ntaxa,
+		      ent->hash, ent->col, ent->freq);
+		}
+	    }
+	}
+	tab = &merged;
+    }
+
+    n = 0;
+    for (i = 0; i < tab->nents; i++) {
+	if (tab->ents[i].col != CxmPatternNone) {
+	    rPats[n] = tab->ents[i].col;
+	    rFreqs[n] = tab->ents[i].freq;
+	    n++;
+	}
+    }
+    *rNPats = n;
+
+    if (tab == &merged) {
+	CxpPatternTabDelete(&merged);
+    }
+
+    return false;
+}
+
+bool
+CxPatternCompact(const char *aCols, uint32_t aNTaxa, uint32_t aNChars,
+  const unsigned *aFreqs, uint32_t *rPats, unsigned *rFreqs,
+  uint32_t *rNPats) {
+    CxtPatternCtx ctx;
+    uint32_t *tPats;
+    unsigned *tFreqs, k;
+    bool ret;
+
+    ctx.cols = aCols;
+    ctx.ntaxa = aNTaxa;
+    ctx.nchars = aNChars;
+    ctx.freqs = aFreqs;
+    ctx.njobs = CxJobsCount(aNChars, CxmPatternJobMin);
+    ctx.tabs = (CxtPatternTab *)calloc(ctx.njobs, sizeof(CxtPatternTab));
+    if (ctx.tabs == NULL) {
+	return true;
+    }
+
+    ret = false;
+    for (k = 0; k < ctx.njobs; k++) {
+	if (CxpPatternTabNew(&ctx.tabs[k], ((uint64_t)aNChars / ctx.njobs)
+	  + 1)) {
+	    ret = true;
+	    break;
+	}
+    }
+    if (ret == false) {
+	CxJobsExecute(CxpPatternJob, &ctx, ctx.njobs);
+	ret = CxpPatternMerge(&ctx, rPats, rFreqs, rNPats);
+    }
+    for (k = 0; k < ctx.njobs; k++) {
+	CxpPatternTabDelete(&ctx.tabs[k]);
+    }
+    free(ctx.tabs);
+    if (ret) {
+	return true;
+    }
+
+    tPats = (uint32_t *)malloc((*rNPats) * sizeof(uint32_t) + 1);
+    tFreqs = (unsigned *)malloc((*rNPats) * sizeof(unsigned) + 1);
+    if (tPats == NULL || tFreqs == NULL) {
+	ret = true;
+    } else {
+	CxpPatternSort(aCols, aNTaxa, rPats, rFreqs, *rNPats, tPats, tFreqs);
+    }
+    if (tPats != NULL) {
+	free(tPats);
+    }
+    if (tFreqs != NULL) {
+	free(tFreqs);
+    }
+
+    return ret;
+}
+
+// Return true if the pattern in aCol is parsimony-informative.  If not, and
+// the pattern is variable, set *rVariable.
+static bool
+CxpPatternInformative(const char *aCol, uint32_t aNTaxa, const int *aCode2Val,
+  unsigned aNStates, bool *rVariable) {
+    unsigned freqs[sizeof(int) << 3];
+    unsigned fSeen, fMult, bit, s;
+    uint32_t i;
+    int val;
+
+    memset(freqs, 0, aNStates * sizeof(unsigned));
+    fSeen = 0;
+    *rVariable = false;
+    for (i = 0; i < aNTaxa; i++) {
+	val = aCode2Val[(unsigned char)aCol[i]];
+	while (val != 0) {
+	    bit = ffs(val) - 1;
+	    val ^= 1 << bit;
+	    freqs[bit]++;
+	    if (freqs[bit] == 1) {
+		fSeen++;
+		if (fSeen > 2) {
+		    return true;
+		}
+	    }
+	}
+    }
+    if (fSeen == 2) {
+	// This site is actually informative if both states occur more than
+	// once.
+	fMult = 0;
+	for (s = 0; s < aNStates; s++) {
+	    if (freqs[s] != 0) {
+		if (freqs[s] == 1) {
+		    break;
+		}
+		fMult++;
+	    }
+	}
+	if (fMult == 2) {
+	    return true;
+	}
+	*rVariable = true;
+    }
+
+    return false;
+}
+
+uint64_t
+CxPatternFitch(const char *aCols, uint32_t aNTaxa, const int *aCode2Val,
+  unsigned aNStates, uint32_t *arPats, unsigned *arFreqs, uint32_t *arNPats) {
+    uint64_t ret;
+    uint32_t j, n;
+    bool variable;
+
+    CxmAssert(aNStates <= (sizeof(int) << 3));
+
+    ret = 0;
+    n = 0;
+    for (j = 0; j < *arNPats; j++) {
+	if (CxpPatternInformative(&aCols[(uint64_t)arPats[j] * aNTaxa], aNTaxa,
+	  aCode2Val, aNStates, &variable)) {
+	    arPats[n] = arPats[j];
+	    arFreqs[n] = arFreqs[j];
+	    n++;
+	} else if (variable) {
+	    // Count one change per multiple of the site frequency.
+	    ret += arFreqs[j];
+	}
+    }
+    *arNPats = n;
+
+    return ret;
+}
@@ -0,0 +1,30 @@
+#ifndef CxPattern_h
+#define CxPattern_h
+
+#include "Cx.h"
+
+// Site pattern compression for column-major character matrices, in which
+// column j is aCols[j*aNTaxa..(j+1)*aNTaxa).
+
+// Find the distinct columns (site patterns) among the aNChars columns of aCols,
+// and sum the frequencies (aFreqs) of identical columns.  On success, store
+// the number of patterns in *rNPats, and for each pattern k, the index of a
+// column with that pattern in rPats[k] and its total frequency in rFreqs[k].
+// Patterns are sorted in lexical order of their character codes.  rPats and
+// rFreqs must have room for aNChars elements.  Columns are hashed and
+// deduplicated in parallel blocks (see CxJobsExecute()), and the per-block
+// results are then merged.  Return true on error.
+bool
+CxPatternCompact(const char *aCols, uint32_t aNTaxa, uint32_t aNChars,
+  const unsigned *aFreqs, uint32_t *rPats, unsigned *rFreqs,
+  uint32_t *rNPats);
+
+// Discard parsimony-uninformative patterns from the output of
+// CxPatternCompact(), in place.  aCode2Val maps character codes to state sets
+// of up to aNStates states.  Return the number of changes that the discarded
+// variable patterns account for, weighted by frequency.
+uint64_t
+CxPatternFitch(const char *aCols, uint32_t aNTaxa, const int *aCode2Val,
+  unsigned aNStates, uint32_t *arPats, unsigned *arFreqs, uint32_t *arNPats);
+
+#endif // CxPattern_h
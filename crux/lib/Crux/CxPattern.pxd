@@ -0,0 +1,8 @@
+from libc cimport uint32_t, uint64_t
+
+cdef extern from "CxPattern.h":
+    cdef bint CxPatternCompact(char *aCols, uint32_t aNTaxa, uint32_t aNChars, \
+      unsigned *aFreqs, uint32_t *rPats, unsigned *rFreqs, uint32_t *rNPats)
+    cdef uint64_t CxPatternFitch(char *aCols, uint32_t aNTaxa, int *aCode2Val, \
+      unsigned aNStates, uint32_t *arPats, unsigned *arFreqs, \
+      uint32_t *arNPats)
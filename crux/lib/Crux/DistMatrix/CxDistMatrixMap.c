@@ -0,0 +1,268 @@
+#include "CxDistMatrixMap.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Minimum number of bytes to release at a time.
+#define CxmDistMatrixMapReleaseMin (1024 * 1024)
+
+CxmpInline uint64_t
+CxpDistMatrixMapDistsLen(uint64_t aNTaxa) {
+    return ((aNTaxa * (aNTaxa - 1)) >> 1) * sizeof(float);
+}
+
+// Map the first aLen bytes of the file open on aMap->fd.
+static CxeDistMatrixMapErr
+CxpDistMatrixMapMap(CxtDistMatrixMap *aMap, uint64_t aLen, int aProt,
+  int aFlags) {
+    aMap->len = aLen;
+    aMap->base = (char *)mmap(NULL, (size_t)aLen, aProt, aFlags, aMap->fd, 0);
+    if (aMap->base == (char *)MAP_FAILED) {
+	aMap->errNo = errno;
+	aMap->base = NULL;
+	return CxeDistMatrixMapErrIo;
+    }
+    aMap->header = (CxtDistMatrixMapHeader *)aMap->base;
+
+    return CxeDistMatrixMapErrNone;
+}
+
+static void
+CxpDistMatrixMapInit(CxtDistMatrixMap *aMap) {
+    aMap->fd = -1;
+    aMap->base = NULL;
+    aMap->len = 0;
+    aMap->header = NULL;
+    aMap->dists = NULL;
+    aMap->labels = NULL;
+    aMap->released = 0;
+    aMap->errNo = 0;
+}
+
+void
+CxDistMatrixMapHeaderInit(CxtDistMatrixMapHeader *aHeader, uint64_t aNTaxa,
+  uint64_t aLabelsLen) {
+    memset(aHeader, 0, sizeof(CxtDistMatrixMapHeader));
+    memcpy(aHeader->magic, CxmDistMatrixMapMagic, sizeof(aHeader->magic));
+    aHeader->bom = CxmDistMatrixMapBom;
+    aHeader->version = CxmDistMatrixMapVersion;
+    aHeader->ntaxa = aNTaxa;
+    aHeader->distsOff = CxmDistMatrixMapAlign;
+    aHeader->labelsOff = CxmDistMatrixMapAlign
+      + CxpDistMatrixMapDistsLen(aNTaxa);
+    aHeader->labelsLen = aLabelsLen;
+}
+
+CxeDistMatrixMapErr
+CxDistMatrixMapCreate(CxtDistMatrixMap *aMap, const char *aPath,
+  uint64_t aNTaxa) {
+    CxeDistMatrixMapErr err;
+    uint64_t len;
+
+    CxmAssert(sizeof(CxtDistMatrixMapHeader) == 64);
+    CxmAssert(aNTaxa > 1);
+
+    CxpDistMatrixMapInit(aMap);
+    aMap->fd = open(aPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (aMap->fd == -1) {
+	aMap->errNo = errno;
+	return CxeDistMatrixMapErrIo;
+    }
+    len = CxmDistMatrixMapAlign + CxpDistMatrixMapDistsLen(aNTaxa);
+    if (ftruncate(aMap->fd, (off_t)len) == -1) {
+	aMap->errNo = errno;
+	CxDistMatrixMapClose(aMap);
+	return CxeDistMatrixMapErrIo;
+    }
+    err = CxpDistMatrixMapMap(aMap, len, PROT_READ | PROT_WRITE, MAP_SHARED);
+    if (err != CxeDistMatrixMapErrNone) {
+	CxDistMatrixMapClose(aMap);
+	return err;
+    }
+
+    CxDistMatrixMapHeaderInit(aMap->header, aNTaxa, 0);
+    aMap->dists = (float *)&aMap->base[aMap->header->distsOff];
+
+    return CxeDistMatrixMapErrNone;
+}
+
+// Validate the header of the file open on aMap->fd, read the labels, and map
+// the header and distances.
+static CxeDistMatrixMapErr
+CxpDistMatrixMapLoad(CxtDistMatrixMap *aMap, int aFlags) {
+    CxtDistMatrixMapHeader header;
+    CxeDistMatrixMapErr err;
+    struct stat st;
+    ssize_t nread;
+
+    if (fstat(aMap->fd, &st) == -1) {
+	aMap->errNo = errno;
+	return CxeDistMatrixMapErrIo;
+    }
+
+    // Validate the header.
+    nread = pread(aMap->fd, &header, sizeof(header), 0);
+    if (nread != sizeof(header)
+      || memcmp(header.magic, CxmDistMatrixMapMagic, sizeof(header.magic)) != 0
+      || header.bom != CxmDistMatrixMapBom
+      || header.version != CxmDistMatrixMapVersion
+      || header.ntaxa < 2
+      || header.ntaxa > 0xffffffffU
+      || header.distsOff % CxmDistMatrixMapAlign != 0
+      || header.labelsOff != header.distsOff
+      + CxpDistMatrixMapDistsLen(header.ntaxa)
+      || header.labelsOff + header.labelsLen > (uint64_t)st.st_size) {
+	if (nread == -1) {
+	    aMap->errNo = errno;
+	    return CxeDistMatrixMapErrIo;
+	}
+	return CxeDistMatrixMapErrFormat;
+    }
+
+    // Read the labels.
+    aMap->labels = (char *)malloc(header.labelsLen + 1);
+    if (aMap->labels == NULL) {
+	aMap->errNo = ENOMEM;
+	return CxeDistMatrixMapErrIo;
+    }
+    nread = pread(aMap->fd, aMap->labels, header.labelsLen,
+      (off_t)header.labelsOff);
+    if (nread != (ssize_t)header.labelsLen) {
+	aMap->errNo = (nread == -1) ? errno : EIO;
+	return CxeDistMatrixMapErrIo;
+    }
+    aMap->labels[header.labelsLen] = '\0';
+
+    err = CxpDistMatrixMapMap(aMap, header.labelsOff, PROT_READ | PROT_WRITE,
+      aFlags);
+    if (err != CxeDistMatrixMapErrNone) {
+	return err;
+    }
+    aMap->dists = (float *)&aMap->base[header.distsOff];
+
+    return CxeDistMatrixMapErrNone;
+}
+
+CxeDistMatrixMapErr
+CxDistMatrixMapOpen(CxtDistMatrixMap *aMap, const char *aPath) {
+    CxeDistMatrixMapErr err;
+    int flags;
+
+    CxpDistMatrixMapInit(aMap);
+    flags = MAP_SHARED;
+    aMap->fd = open(aPath, O_RDWR);
+    if (aMap->fd == -1 && (errno == EACCES || errno == EROFS)) {
+	aMap->fd = open(aPath, O_RDONLY);
+	flags = MAP_PRIVATE;
+    }
+    if (aMap->fd == -1) {
+	aMap->errNo = errno;
+	return CxeDistMatrixMapErrIo;
+    }
+
+    err = CxpDistMatrixMapLoad(aMap, flags);
+    if (err != CxeDistMatrixMapErrNone) {
+	CxDistMatrixMapClose(aMap);
+    }
+    return err;
+}
+
+bool
+CxDistMatrixMapSniff(int aFd, uint64_t aOff) {
+    char magic[sizeof(CxmDistMatrixMapMagic) - 1];
+
+    return (aOff == 0 && pread(aFd, magic, sizeof(magic), 0) == sizeof(magic)
+      && memcmp(magic, CxmDistMatrixMapMagic, sizeof(magic)) == 0);
+}
+
+CxeDistMatrixMapErr
+CxDistMatrixMapFdOpen(CxtDistMatrixMap *aMap, int aFd) {
+    CxeDistMatrixMapErr err;
+
+    CxpDistMatrixMapInit(aMap);
+    aMap->fd = dup(aFd);
+    if (aMap->fd == -1) {
+	aMap->errNo = errno;
+	return CxeDistMatrixMapErrIo;
+    }
+
+    err = CxpDistMatrixMapLoad(aMap, MAP_PRIVATE);
+    if (err != CxeDistMatrixMapErrNone) {
+	CxDistMatrixMapClose(aMap);
+    }
+    return err;
+}
+
+CxeDistMatrixMapErr
+CxDistMatrixMapLabelsSet(CxtDistMatrixMap *aMap, const char *aLabels,
+  uint64_t aLen) {
+    uint64_t off;
+    ssize_t nwritten;
+
+    off = 0;
+    while (off < aLen) {
+	nwritten = pwrite(aMap->fd, &aLabels[off], aLen - off,
+	  (off_t)(aMap->header->labelsOff + off));
+	if (nwritten == -1) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    aMap->errNo = errno;
+	    return CxeDistMatrixMapErrIo;
+	}
+	off += nwritten;
+    }
+    aMap->header->labelsLen = aLen;
+
+    return CxeDistMatrixMapErrNone;
+}
+
+void
+CxDistMatrixMapClose(CxtDistMatrixMap *aMap) {
+    if (aMap->base != NULL) {
+	munmap(aMap->base, (size_t)aMap->len);
+	aMap->base = NULL;
+	aMap->header = NULL;
+	aMap->dists = NULL;
+    }
+    if (aMap->labels != NULL) {
+	free(aMap->labels);
+	aMap->labels = NULL;
+    }
+    if (aMap->fd != -1) {
+	close(aMap->fd);
+	aMap->fd = -1;
+    }
+}
+
+void
+CxDistMatrixMapInvalidate(CxtDistMatrixMap *aMap) {
+    memset(aMap->header->magic, 0, sizeof(aMap->header->magic));
+    msync(aMap->base, CxmDistMatrixMapAlign, MS_SYNC);
+}
+
+void
+CxDistMatrixMapRelease(CxtDistMatrixMap *aMap, const float *aD) {
+    uint64_t end;
+    char *beg;
+
+    CxmAssert(aD >= aMap->dists);
+
+    end = (uint64_t)((const char *)aD - (const char *)aMap->dists);
+    end -= end % CxmDistMatrixMapAlign;
+    if (end < aMap->released + CxmDistMatrixMapReleaseMin) {
+	return;
+    }
+
+    beg = &((char *)aMap->dists)[aMap->released];
+#ifdef MADV_REMOVE
+    // Free the backing store as well, which avoids writing back dead rows.
+    if (madvise(beg, end - aMap->released, MADV_REMOVE) == -1)
+#endif
+    {
+	madvise(beg, end - aMap->released, MADV_DONTNEED);
+    }
+    aMap->released = end;
+}
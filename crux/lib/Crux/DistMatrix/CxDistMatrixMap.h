@@ -0,0 +1,111 @@
+#ifndef CxDistMatrixMap_h
+#define CxDistMatrixMap_h
+
+#include "../Cx.h"
+
+// Memory-mapped distance matrix files, which allow Crux.DistMatrix to operate
+// on matrices that are larger than physical memory.  Files are laid out as
+// follows, in native byte order:
+//
+//   Offset    Size        Contents
+//   0         64          CxtDistMatrixMapHeader
+//   distsOff  4*n(n-1)/2  Distances, in Crux.DistMatrix upper-triangle order.
+//   labelsOff labelsLen   Taxon labels, each terminated by '\0'.
+//
+// distsOff is a multiple of CxmDistMatrixMapAlign, so that distances are
+// page-aligned.  Labels follow the distances, so that a matrix can be created
+// (and its distances written incrementally) before the labels are known.
+
+#define CxmDistMatrixMapMagic "CxDistMx"
+#define CxmDistMatrixMapBom 0x01020304U
+#define CxmDistMatrixMapVersion 1
+#define CxmDistMatrixMapAlign 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t bom; // Byte order mark.
+    uint32_t version;
+    uint64_t ntaxa;
+    uint64_t distsOff;
+    uint64_t labelsOff;
+    uint64_t labelsLen;
+    uint64_t reserved[2];
+} CxtDistMatrixMapHeader;
+
+typedef enum {
+    CxeDistMatrixMapErrNone,
+    CxeDistMatrixMapErrIo,    // System call failure; see errNo.
+    CxeDistMatrixMapErrFormat // Not a valid (or compatible) matrix file.
+} CxeDistMatrixMapErr;
+
+typedef struct {
+    int fd;
+    char *base;
+    uint64_t len; // Length of mapping, which covers the header and distances.
+    CxtDistMatrixMapHeader *header;
+    float *dists;
+
+    // Labels, as read by CxDistMatrixMapOpen().  NULL for new matrices.
+    char *labels;
+
+    // Bytes of distances that CxDistMatrixMapRelease() has released.
+    uint64_t released;
+
+    int errNo;
+} CxtDistMatrixMap;
+
+// Initialize aHeader for an aNTaxa-taxon matrix with aLabelsLen bytes of
+// labels.  This is for writers that stream matrix files rather than creating
+// them via CxDistMatrixMapCreate().
+void
+CxDistMatrixMapHeaderInit(CxtDistMatrixMapHeader *aHeader, uint64_t aNTaxa,
+  uint64_t aLabelsLen);
+
+// Create (or truncate) the file at aPath, sized for an aNTaxa-taxon matrix,
+// and map it.  Distances are initially zero.  The file is sparse, so disk
+// space is only consumed as distances are written.
+CxeDistMatrixMapErr
+CxDistMatrixMapCreate(CxtDistMatrixMap *aMap, const char *aPath,
+  uint64_t aNTaxa);
+
+// Map the existing matrix file at aPath, and read its labels.  If the file is
+// not writable, it is mapped privately, so that changes are not written back.
+CxeDistMatrixMapErr
+CxDistMatrixMapOpen(CxtDistMatrixMap *aMap, const char *aPath);
+
+// Return true if the file open on aFd, which is positioned at offset aOff,
+// is a matrix file.  Matrix files are only recognized at offset 0.
+bool
+CxDistMatrixMapSniff(int aFd, uint64_t aOff);
+
+// Same as CxDistMatrixMapOpen(), but for the file open on aFd, which is mapped
+// privately regardless of whether it is writable.  aFd is duplicated, so the
+// caller may close it.
+CxeDistMatrixMapErr
+CxDistMatrixMapFdOpen(CxtDistMatrixMap *aMap, int aFd);
+
+// Write the labels (aLen bytes, each label terminated by '\0') to the end of
+// aMap's file.
+CxeDistMatrixMapErr
+CxDistMatrixMapLabelsSet(CxtDistMatrixMap *aMap, const char *aLabels,
+  uint64_t aLen);
+
+// Unmap and close aMap.
+void
+CxDistMatrixMapClose(CxtDistMatrixMap *aMap);
+
+// Clear the magic in aMap's header, so that the file is no longer recognized
+// as a matrix file.  This is for use by NJ/RNJ, which destroy the matrix as
+// they join nodes.  The header is synchronously written back, so that the file
+// never has a valid header over discarded distances, even after a crash.
+void
+CxDistMatrixMapInvalidate(CxtDistMatrixMap *aMap);
+
+// Release (without writing back) the pages that lie entirely before aD, which
+// points into aMap's distances.  This is for use by NJ/RNJ, which discard
+// rows from the front of the matrix as nodes are joined, so that the page
+// cache only needs to hold the live portion of the matrix.
+void
+CxDistMatrixMapRelease(CxtDistMatrixMap *aMap, const float *aD);
+
+#endif // CxDistMatrixMap_h
@@ -0,0 +1,35 @@
+from libc cimport uint64_t
+
+cdef extern from "CxDistMatrixMap.h":
+    cdef enum:
+        CxmDistMatrixMapAlign
+
+    ctypedef struct CxtDistMatrixMapHeader:
+        uint64_t ntaxa
+        uint64_t labelsLen
+
+    ctypedef enum CxeDistMatrixMapErr:
+        CxeDistMatrixMapErrNone
+        CxeDistMatrixMapErrIo
+        CxeDistMatrixMapErrFormat
+
+    ctypedef struct CxtDistMatrixMap:
+        CxtDistMatrixMapHeader *header
+        float *dists
+        char *labels
+        int errNo
+
+    cdef void CxDistMatrixMapHeaderInit(CxtDistMatrixMapHeader *aHeader, \
+      uint64_t aNTaxa, uint64_t aLabelsLen)
+    cdef CxeDistMatrixMapErr CxDistMatrixMapCreate(CxtDistMatrixMap *aMap, \
+      char *aPath, uint64_t aNTaxa)
+    cdef CxeDistMatrixMapErr CxDistMatrixMapOpen(CxtDistMatrixMap *aMap, \
+      char *aPath)
+    cdef bint CxDistMatrixMapSniff(int aFd, uint64_t aOff)
+    cdef CxeDistMatrixMapErr CxDistMatrixMapFdOpen(CxtDistMatrixMap *aMap, \
+      int aFd)
+    cdef CxeDistMatrixMapErr CxDistMatrixMapLabelsSet(CxtDistMatrixMap *aMap, \
+      char *aLabels, uint64_t aLen)
+    cdef void CxDistMatrixMapClose(CxtDistMatrixMap *aMap)
+    cdef void CxDistMatrixMapInvalidate(CxtDistMatrixMap *aMap)
+    cdef void CxDistMatrixMapRelease(CxtDistMatrixMap *aMap, float *aD)
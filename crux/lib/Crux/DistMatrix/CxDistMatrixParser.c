@@ -0,0 +1,597 @@
+#include "CxDistMatrixParser.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Initial number of label bytes for which space is allocated.
+#define CxmDistMatrixParserMaxMin 64
+
+// Empty labelTab slot.
+#define CxmDistMatrixParserNone 0xffffffffffffffffULL
+
+typedef enum {
+    CxeDistMatrixParserTokEnd,
+    CxeDistMatrixParserTokInt,
+    CxeDistMatrixParserTokDist,
+    CxeDistMatrixParserTokLabel,
+    CxeDistMatrixParserTokError
+} CxeDistMatrixParserTok;
+
+typedef enum {
+    CxeDistMatrixParserFormatUninitialized,
+    CxeDistMatrixParserFormatUnknown,
+    CxeDistMatrixParserFormatFull,
+    CxeDistMatrixParserFormatUpper,
+    CxeDistMatrixParserFormatLower
+} CxeDistMatrixParserFormat;
+
+// Token scanned by CxpDistMatrixParserTok().
+typedef struct {
+    const char *s;
+    size_t len;
+    float dist;
+} CxtDistMatrixParserTok;
+
+CxmpInline bool
+CxpDistMatrixParserIsDigit(char c) {
+    return (c >= '0' && c <= '9');
+}
+
+CxmpInline bool
+CxpDistMatrixParserIsLabelBeg(char c) {
+    return ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_');
+}
+
+CxmpInline bool
+CxpDistMatrixParserIsLabel(char c) {
+    return (CxpDistMatrixParserIsLabelBeg(c) || CxpDistMatrixParserIsDigit(c)
+      || c == '-' || c == '.' || c == '/');
+}
+
+// Whitespace other than '\n'.
+CxmpInline bool
+CxpDistMatrixParserIsBlank(char c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v');
+}
+
+// Same as nxy2i() in Crux/DistMatrix/__init__.pxd, but aX must be less than
+// aY.
+CxmpInline size_t
+CxpDistMatrixParserNxy2i(size_t aN, size_t aX, size_t aY) {
+    CxmAssert(aX < aY);
+    CxmAssert(aY < aN);
+
+    return aN * aX + aY - (((aX + 3) * aX) >> 1) - 1;
+}
+
+static bool
+CxpDistMatrixParserError(CxtDistMatrixParser *aParser,
+  CxeDistMatrixParseErr aErr) {
+    aParser->err = aErr;
+    aParser->errLine = aParser->line;
+
+    return true;
+}
+
+// Convert the number aTok[0..aLen) to a float via strtof().  The number is
+// copied, both because the input is not NUL-terminated, and because strtof()
+// accepts a superset of the token syntax (hexadecimal, for example).  Return
+// true if the number is out of range.
+static bool
+CxpDistMatrixParserDistSlow(const char *aTok, size_t aLen, float *rDist) {
+    char buf[64], *s, *end;
+    bool ret;
+
+    if (aLen < sizeof(buf)) {
+	s = buf;
+    } else {
+	s = (char *)malloc(aLen + 1);
+	if (s == NULL) {
+	    return true;
+	}
+    }
+    memcpy(s, aTok, aLen);
+    s[aLen] = '\0';
+
+    errno = 0;
+    *rDist = strtof(s, &end);
+    ret = (end != &s[aLen] || errno != 0);
+
+    if (s != buf) {
+	free(s);
+    }
+    return ret;
+}
+
+// Convert a number with decimal significand aMant and exponent aExp10 to a
+// float.  If aMant and 10^|aExp10| are exactly representable as doubles, the
+// double product/quotient is correctly rounded, and rounding it to float gives
+// the same result as strtof() unless it lies exactly halfway between two
+// floats.  Return true if the fast path does not apply, in which case the
+// caller must fall back to CxpDistMatrixParserDistSlow().
+static bool
+CxpDistMatrixParserDistFast(uint64_t aMant, int aExp10, bool aNeg,
+  float *rDist) {
+    static const double pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+	1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    union {
+	double d;
+	uint64_t u;
+    } u;
+    float f;
+
+    if (aMant > (1ULL << 53) || aExp10 < -22 || aExp10 > 22) {
+	return true;
+    }
+    if (aMant == 0) {
+	*rDist = aNeg ? -0.0f : 0.0f;
+	return false;
+    }
+    u.d = (aExp10 < 0) ? (double)aMant / pow10[-aExp10]
+      : (double)aMant * pow10[aExp10];
+    // Reject float rounding ties, and results that strtof() would consider
+    // out of range (overflow, underflow, or denormal).
+    if ((u.u & 0x1fffffffULL) == 0x10000000ULL) {
+	return true;
+    }
+    f = (float)u.d;
+    if (f > 3.40282346638528859812e+38F || f < 1.17549435082228750797e-38F) {
+	return true;
+    }
+    *rDist = aNeg ? -f : f;
+    return false;
+}
+
+// Scan the next token.  Tokens are matched as follows, where the longest match
+// wins, and Int takes precedence over Dist for matches of equal length:
+//
+//   Int:   [1-9][0-9]*
+//   Dist:  [-+]?[0-9]+([.][0-9]+)?([eE][-+]?[0-9]+)?
+//   Label: [A-Za-z_][A-Za-z0-9_\-./]*([ \t\r\f\v]+[A-Za-z_][A-Za-z0-9_\-./]*)*
+static CxeDistMatrixParserTok
+CxpDistMatrixParserTok(CxtDistMatrixParser *aParser,
+  CxtDistMatrixParserTok *rTok) {
+    const char *p, *q, *end;
+    bool isInt;
+
+    p = aParser->p;
+    end = aParser->end;
+
+    // Skip whitespace.
+    for (; p < end; p++) {
+	if (*p == '\n') {
+	    aParser->line++;
+	} else if (CxpDistMatrixParserIsBlank(*p) == false) {
+	    break;
+	}
+    }
+    if (p == end) {
+	aParser->p = p;
+	return CxeDistMatrixParserTokEnd;
+    }
+    rTok->s = p;
+
+    if (CxpDistMatrixParserIsDigit(*p) || *p == '-' || *p == '+') {
+	uint64_t mant;
+	unsigned ndigits;
+	int exp10, exp;
+	bool neg, expNeg;
+
+	isInt = (*p >= '1' && *p <= '9');
+	neg = (*p == '-');
+	if (*p == '-' || *p == '+') {
+	    p++;
+	    if (p == end || CxpDistMatrixParserIsDigit(*p) == false) {
+		aParser->p = p;
+		return CxeDistMatrixParserTokError;
+	    }
+	}
+	// Accumulate the significand as the digits are scanned.  ndigits counts
+	// significant digits, and once it exceeds 19, mant may have overflowed
+	// and the fast conversion path is not used.
+	mant = 0;
+	ndigits = 0;
+	exp10 = 0;
+	for (; p < end && CxpDistMatrixParserIsDigit(*p); p++) {
+	    mant = mant * 10 + (*p - '0');
+	    ndigits += (mant != 0);
+	}
+	// Fraction.
+	if (p + 1 < end && *p == '.' && CxpDistMatrixParserIsDigit(p[1])) {
+	    isInt = false;
+	    for (p++; p < end && CxpDistMatrixParserIsDigit(*p); p++) {
+		mant = mant * 10 + (*p - '0');
+		ndigits += (mant != 0);
+		exp10--;
+	    }
+	}
+	// Exponent.
+	if (p < end && (*p == 'e' || *p == 'E')) {
+	    q = p + 1;
+	    expNeg = false;
+	    if (q < end && (*q == '-' || *q == '+')) {
+		expNeg = (*q == '-');
+		q++;
+	    }
+	    if (q < end && CxpDistMatrixParserIsDigit(*q)) {
+		isInt = false;
+		exp = 0;
+		for (p = q; p < end && CxpDistMatrixParserIsDigit(*p); p++) {
+		    if (exp < 1000) {
+			exp = exp * 10 + (*p - '0');
+		    }
+		}
+		exp10 += expNeg ? -exp : exp;
+	    }
+	}
+	rTok->len = p - rTok->s;
+	aParser->p = p;
+	if ((ndigits > 19 || CxpDistMatrixParserDistFast(mant, exp10, neg,
+	  &rTok->dist))
+	  && CxpDistMatrixParserDistSlow(rTok->s, rTok->len, &rTok->dist)) {
+	    return CxeDistMatrixParserTokError;
+	}
+	return (isInt ? CxeDistMatrixParserTokInt : CxeDistMatrixParserTokDist);
+    } else if (CxpDistMatrixParserIsLabelBeg(*p)) {
+	for (p++; p < end && CxpDistMatrixParserIsLabel(*p); p++) {
+	    // Do nothing.
+	}
+	// Labels may contain embedded (non-newline) whitespace.
+	while (true) {
+	    for (q = p; q < end && CxpDistMatrixParserIsBlank(*q); q++) {
+		// Do nothing.
+	    }
+	    if (q == p || q == end || CxpDistMatrixParserIsLabelBeg(*q)
+	      == false) {
+		break;
+	    }
+	    for (p = q + 1; p < end && CxpDistMatrixParserIsLabel(*p); p++) {
+		// Do nothing.
+	    }
+	}
+	rTok->len = p - rTok->s;
+	aParser->p = p;
+	return CxeDistMatrixParserTokLabel;
+    }
+
+    aParser->p = p;
+    return CxeDistMatrixParserTokError;
+}
+
+void
+CxDistMatrixParserNew(CxtDistMatrixParser *aParser) {
+    memset(aParser, 0, sizeof(CxtDistMatrixParser));
+}
+
+void
+CxDistMatrixParserDelete(CxtDistMatrixParser *aParser) {
+    if (aParser->map != NULL) {
+	munmap(aParser->map, aParser->mapLen);
+    }
+    if (aParser->labels != NULL) {
+	free(aParser->labels);
+    }
+    if (aParser->labelTab != NULL) {
+	free(aParser->labelTab);
+    }
+    memset(aParser, 0, sizeof(CxtDistMatrixParser));
+}
+
+bool
+CxDistMatrixParseBegin(CxtDistMatrixParser *aParser, const char *aBuf,
+  size_t aLen, unsigned aLine) {
+    CxtDistMatrixParserTok tok;
+    uint64_t ntaxa;
+    size_t i;
+
+    aParser->p = aBuf;
+    aParser->end = aBuf + aLen;
+    aParser->line = aLine;
+    aParser->ntaxa = 0;
+    aParser->err = CxeDistMatrixParseErrNone;
+
+    switch (CxpDistMatrixParserTok(aParser, &tok)) {
+	case CxeDistMatrixParserTokEnd: {
+	    return false;
+	} case CxeDistMatrixParserTokInt: {
+	    break;
+	} case CxeDistMatrixParserTokError: {
+	    return CxpDistMatrixParserError(aParser,
+	      CxeDistMatrixParseErrToken);
+	} default: {
+	    return CxpDistMatrixParserError(aParser,
+	      CxeDistMatrixParseErrNTaxa);
+	}
+    }
+
+    // The input is not NUL-terminated, so convert the digits here rather than
+    // via strtoul().
+    ntaxa = 0;
+    for (i = 0; i < tok.len; i++) {
+	ntaxa = ntaxa * 10 + (tok.s[i] - '0');
+	if (ntaxa > 0xffffffffU) {
+	    break;
+	}
+    }
+    if (ntaxa < 2 || ntaxa > 0xffffffffU) {
+	return CxpDistMatrixParserError(aParser,
+	  CxeDistMatrixParseErrNTaxaRange);
+    }
+    aParser->ntaxa = (size_t)ntaxa;
+
+    return false;
+}
+
+bool
+CxDistMatrixParseFdBegin(CxtDistMatrixParser *aParser, int aFd, uint64_t aOff,
+  unsigned aLine) {
+    struct stat st;
+
+    if (fstat(aFd, &st) == -1 || S_ISREG(st.st_mode) == 0) {
+	aParser->line = aLine;
+	return CxpDistMatrixParserError(aParser, CxeDistMatrixParseErrIo);
+    }
+    aParser->mapLen = (size_t)st.st_size;
+    if (aOff >= aParser->mapLen) {
+	aParser->mapLen = 0;
+	return CxDistMatrixParseBegin(aParser, "", 0, aLine);
+    }
+    aParser->map = (char *)mmap(NULL, aParser->mapLen, PROT_READ, MAP_SHARED,
+      aFd, 0);
+    if (aParser->map == (char *)MAP_FAILED) {
+	aParser->map = NULL;
+	aParser->line = aLine;
+	return CxpDistMatrixParserError(aParser, CxeDistMatrixParseErrIo);
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(aParser->map, aParser->mapLen, MADV_SEQUENTIAL);
+#endif
+
+    return CxDistMatrixParseBegin(aParser, &aParser->map[aOff],
+      aParser->mapLen - aOff, aLine);
+}
+
+CxmpInline uint64_t
+CxpDistMatrixParserHash(const char *aS, size_t aLen) {
+    uint64_t h;
+    size_t i;
+
+    // FNV-1a.
+    h = 0xcbf29ce484222325ULL;
+    for (i = 0; i < aLen; i++) {
+	h ^= (unsigned char)aS[i];
+	h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+// Append the label aS[0..aLen) to labels.  Return true if the label is a
+// duplicate of one that has already been inserted into labelTab, and insert it
+// otherwise.
+static bool
+CxpDistMatrixParserLabel(CxtDistMatrixParser *aParser, const char *aS,
+  size_t aLen) {
+    uint64_t off, mask, i;
+
+    if (aParser->labelsLen + aLen + 1 > aParser->maxLabels) {
+	uint64_t maxLabels;
+	char *labels;
+
+	maxLabels = aParser->maxLabels << 1;
+	if (maxLabels < aParser->labelsLen + aLen + 1) {
+	    maxLabels = aParser->labelsLen + aLen + 1;
+	}
+	labels = (char *)realloc(aParser->labels, maxLabels);
+	if (labels == NULL) {
+	    return CxpDistMatrixParserError(aParser, CxeDistMatrixParseErrMem);
+	}
+	aParser->labels = labels;
+	aParser->maxLabels = maxLabels;
+    }
+    off = aParser->labelsLen;
+    memcpy(&aParser->labels[off], aS, aLen);
+    aParser->labels[off + aLen] = '\0';
+    aParser->labelsLen += aLen + 1;
+    aParser->nlabels++;
+
+    mask = aParser->labelTabLen - 1;
+    for (i = CxpDistMatrixParserHash(aS, aLen) & mask;
+      aParser->labelTab[i] != CxmDistMatrixParserNone; i = (i + 1) & mask) {
+	if (strcmp(&aParser->labels[aParser->labelTab[i]],
+	  &aParser->labels[off]) == 0) {
+	    return CxpDistMatrixParserError(aParser,
+	      CxeDistMatrixParseErrLabelDup);
+	}
+    }
+    aParser->labelTab[i] = off;
+
+    return false;
+}
+
+bool
+CxDistMatrixParseRows(CxtDistMatrixParser *aParser, float *aDists) {
+    CxtDistMatrixParserTok tok;
+    CxeDistMatrixParserTok tokType;
+    CxeDistMatrixParserFormat format;
+    size_t n, i, j, k;
+    uint64_t t;
+
+    n = aParser->ntaxa;
+    aParser->labelsLen = 0;
+    aParser->nlabels = 0;
+
+    // Size the label table such that it is at most half full, even if there is
+    // an excess taxon.
+    for (aParser->labelTabLen = 1; aParser->labelTabLen < 2 * (n + 1);
+      aParser->labelTabLen <<= 1) {
+	// Do nothing.
+    }
+    if (aParser->labels == NULL) {
+	aParser->labels = (char *)malloc(CxmDistMatrixParserMaxMin);
+	if (aParser->labels == NULL) {
+	    return CxpDistMatrixParserError(aParser, CxeDistMatrixParseErrMem);
+	}
+	aParser->maxLabels = CxmDistMatrixParserMaxMin;
+    }
+    if (aParser->labelTab != NULL) {
+	free(aParser->labelTab);
+    }
+    aParser->labelTab = (uint64_t *)malloc(aParser->labelTabLen
+      * sizeof(uint64_t));
+    if (aParser->labelTab == NULL) {
+	return CxpDistMatrixParserError(aParser, CxeDistMatrixParseErrMem);
+    }
+    for (t = 0; t < aParser->labelTabLen; t++) {
+	aParser->labelTab[t] = CxmDistMatrixParserNone;
+    }
+
+    format = CxeDistMatrixParserFormatUninitialized;
+    i = j = 0;
+    while (true) {
+	tokType = CxpDistMatrixParserTok(aParser, &tok);
+	if (tokType == CxeDistMatrixParserTokInt
+	  || tokType == CxeDistMatrixParserTokDist) {
+	    switch (format) {
+		case CxeDistMatrixParserFormatUninitialized: {
+		    return CxpDistMatrixParserError(aParser,
+		      CxeDistMatrixParseErrDist);
+		} case CxeDistMatrixParserFormatUnknown: {
+		    if (j < n) {
+			aDists[CxpDistMatrixParserNxy2i(n, i, j)] = tok.dist;
+			break;
+		    }
+		    // This is the last distance for the first row of a full
+		    // matrix.  Up to now the matrix was assumed to be in upper
+		    // format, so discard the diagonal and shift the distances
+		    // down one element.
+		    format = CxeDistMatrixParserFormatFull;
+		    if (aDists[CxpDistMatrixParserNxy2i(n, 0, 1)] != 0.0) {
+			return CxpDistMatrixParserError(aParser,
+			  CxeDistMatrixParseErrDiagonal);
+		    }
+		    for (k = 1; k < j - 1; k++) {
+			aDists[CxpDistMatrixParserNxy2i(n, 0, k)] =
+			  aDists[CxpDistMatrixParserNxy2i(n, 0, k + 1)];
+		    }
+		    j--;
+		    aDists[CxpDistMatrixParserNxy2i(n, i, j)] = tok.dist;
+		    break;
+		} case CxeDistMatrixParserFormatFull: {
+		    if (j < i) {
+			if (tok.dist != aDists[CxpDistMatrixParserNxy2i(n, j,
+			  i)]) {
+			    aParser->errX = j;
+			    aParser->errY = i;
+			    return CxpDistMatrixParserError(aParser,
+			      CxeDistMatrixParseErrAsymmetric);
+			}
+		    } else if (j == i) {
+			if (tok.dist != 0.0) {
+			    return CxpDistMatrixParserError(aParser,
+			      CxeDistMatrixParseErrDiagonal);
+			}
+		    } else if (j == n) {
+			return CxpDistMatrixParserError(aParser,
+			  CxeDistMatrixParseErrDistsExcess);
+		    } else {
+			aDists[CxpDistMatrixParserNxy2i(n, i, j)] = tok.dist;
+		    }
+		    break;
+		} case CxeDistMatrixParserFormatUpper: {
+		    if (j == n) {
+			return CxpDistMatrixParserError(aParser,
+			  CxeDistMatrixParseErrDistsExcess);
+		    }
+		    aDists[CxpDistMatrixParserNxy2i(n, i, j)] = tok.dist;
+		    break;
+		} case CxeDistMatrixParserFormatLower: {
+		    if (j == i) {
+			return CxpDistMatrixParserError(aParser,
+			  CxeDistMatrixParseErrDistsExcess);
+		    }
+		    aDists[CxpDistMatrixParserNxy2i(n, j, i)] = tok.dist;
+		    break;
+		} default: {
+		    CxmNotReached();
+		}
+	    }
+	    j++;
+	    continue;
+	} else if (tokType == CxeDistMatrixParserTokError) {
+	    return CxpDistMatrixParserError(aParser,
+	      CxeDistMatrixParseErrToken);
+	}
+
+	// Label or end of input; either way, the current row is complete.
+	switch (format) {
+	    case CxeDistMatrixParserFormatUninitialized: {
+		format = CxeDistMatrixParserFormatUnknown;
+		i = 0;
+		j = 1;
+		break;
+	    } case CxeDistMatrixParserFormatUnknown: {
+		CxmAssert(i == 0);
+		if (j == n) {
+		    format = CxeDistMatrixParserFormatUpper;
+		    i = 1;
+		    j = 2;
+		} else if (j == 1) {
+		    format = CxeDistMatrixParserFormatLower;
+		    i = 1;
+		    j = 0;
+		} else {
+		    return CxpDistMatrixParserError(aParser,
+		      CxeDistMatrixParseErrDistsCount);
+		}
+		break;
+	    } case CxeDistMatrixParserFormatFull: {
+		if (j != n) {
+		    return CxpDistMatrixParserError(aParser,
+		      CxeDistMatrixParseErrDistsCount);
+		}
+		i++;
+		j = 0;
+		break;
+	    } case CxeDistMatrixParserFormatUpper: {
+		if (j != n) {
+		    return CxpDistMatrixParserError(aParser,
+		      CxeDistMatrixParseErrDistsCount);
+		}
+		i++;
+		j = i + 1;
+		break;
+	    } case CxeDistMatrixParserFormatLower: {
+		if (j != i) {
+		    return CxpDistMatrixParserError(aParser,
+		      CxeDistMatrixParseErrDistsCount);
+		}
+		i++;
+		j = 0;
+		break;
+	    } default: {
+		CxmNotReached();
+	    }
+	}
+	if (tokType == CxeDistMatrixParserTokEnd) {
+	    break;
+	}
+
+	if (CxpDistMatrixParserLabel(aParser, tok.s, tok.len)) {
+	    return true;
+	}
+	if (aParser->nlabels > n) {
+	    return CxpDistMatrixParserError(aParser,
+	      CxeDistMatrixParseErrTaxaExcess);
+	}
+    }
+    if (aParser->nlabels != n) {
+	return CxpDistMatrixParserError(aParser,
+	  CxeDistMatrixParseErrTaxaShort);
+    }
+
+    return false;
+}
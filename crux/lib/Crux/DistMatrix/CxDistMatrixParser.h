@@ -0,0 +1,100 @@
+#ifndef CxDistMatrixParser_h
+#define CxDistMatrixParser_h
+
+#include "../Cx.h"
+
+// Native PHYLIP-style distance matrix parser.  The input is scanned directly
+// into Crux.DistMatrix's upper-triangle storage, and full/upper/lower format
+// detection is done by a state machine that only changes state at row
+// boundaries.  The accepted format is described in
+// Crux/DistMatrix/__init__.pyx.
+//
+// Parsing happens in two phases, so that the caller can allocate storage for
+// the matrix (possibly as a memory-mapped file) once the number of taxa is
+// known:
+//
+//   CxDistMatrixParseBegin() (or CxDistMatrixParseFdBegin())
+//   [caller allocates an ntaxa-taxon matrix]
+//   CxDistMatrixParseRows()
+
+typedef enum {
+    CxeDistMatrixParseErrNone,
+    CxeDistMatrixParseErrMem,        // Memory allocation failure.
+    CxeDistMatrixParseErrIo,         // The file could not be memory-mapped.
+    CxeDistMatrixParseErrToken,      // Invalid character.
+    CxeDistMatrixParseErrNTaxa,      // Number of taxa expected.
+    CxeDistMatrixParseErrNTaxaRange, // Number of taxa out of range.
+    CxeDistMatrixParseErrDist,       // Unexpected distance.
+    CxeDistMatrixParseErrDiagonal,   // Non-zero distance on diagonal.
+    CxeDistMatrixParseErrAsymmetric, // Non-symmetric distance; see errX/errY.
+    CxeDistMatrixParseErrDistsExcess,// Too many distances.
+    CxeDistMatrixParseErrDistsCount, // Incorrect number of distances.
+    CxeDistMatrixParseErrLabelDup,   // Duplicate taxon label (the last label).
+    CxeDistMatrixParseErrTaxaExcess, // Excess taxon (the last label).
+    CxeDistMatrixParseErrTaxaShort   // Insufficient taxa.
+} CxeDistMatrixParseErr;
+
+typedef struct {
+    // Unconsumed input.
+    const char *p;
+    const char *end;
+    unsigned line;
+
+    // File mapping, if input came from CxDistMatrixParseFdBegin().
+    char *map;
+    size_t mapLen;
+
+    // Number of taxa, as specified at the beginning of the input.  0 if the
+    // input is empty.
+    size_t ntaxa;
+
+    // Taxon labels, each terminated by '\0', in row order.  If err is
+    // CxeDistMatrixParseErrLabelDup or CxeDistMatrixParseErrTaxaExcess, the
+    // offending label is last.
+    char *labels;
+    uint64_t labelsLen;
+    uint64_t maxLabels;
+    uint64_t nlabels;
+
+    // Open addressing hash table of label offsets, for duplicate detection.
+    uint64_t *labelTab;
+    uint64_t labelTabLen; // Power of 2.
+
+    // Description of the most recent error.  errX and errY are label indices
+    // for CxeDistMatrixParseErrAsymmetric.
+    CxeDistMatrixParseErr err;
+    unsigned errLine;
+    size_t errX;
+    size_t errY;
+} CxtDistMatrixParser;
+
+// Initialize aParser.
+void
+CxDistMatrixParserNew(CxtDistMatrixParser *aParser);
+
+// Discard aParser.
+void
+CxDistMatrixParserDelete(CxtDistMatrixParser *aParser);
+
+// Begin parsing aBuf[0..aLen), which must remain valid until parsing is
+// complete, and scan the number of taxa into ntaxa.  aLine is the line number
+// of the beginning of aBuf, for error reporting.  Return true on error.
+bool
+CxDistMatrixParseBegin(CxtDistMatrixParser *aParser, const char *aBuf,
+  size_t aLen, unsigned aLine);
+
+// Memory-map the regular file open on aFd, and begin parsing it from offset
+// aOff via CxDistMatrixParseBegin().  Return true on error; err is
+// CxeDistMatrixParseErrIo if the file could not be mapped, in which case the
+// caller may fall back to reading it.
+bool
+CxDistMatrixParseFdBegin(CxtDistMatrixParser *aParser, int aFd, uint64_t aOff,
+  unsigned aLine);
+
+// Parse the remainder of the input into aDists, which is an
+// ntaxa-taxon upper-triangle matrix (NULL if ntaxa is 0).  Return true on
+// error.
+bool
+CxDistMatrixParseRows(CxtDistMatrixParser *aParser, float *aDists);
+
+#endif // CxDistMatrixParser_h
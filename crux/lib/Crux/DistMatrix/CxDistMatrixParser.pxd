@@ -0,0 +1,35 @@
+from libc cimport uint64_t
+
+cdef extern from "CxDistMatrixParser.h":
+    ctypedef enum CxeDistMatrixParseErr:
+        CxeDistMatrixParseErrNone
+        CxeDistMatrixParseErrMem
+        CxeDistMatrixParseErrIo
+        CxeDistMatrixParseErrToken
+        CxeDistMatrixParseErrNTaxa
+        CxeDistMatrixParseErrNTaxaRange
+        CxeDistMatrixParseErrDist
+        CxeDistMatrixParseErrDiagonal
+        CxeDistMatrixParseErrAsymmetric
+        CxeDistMatrixParseErrDistsExcess
+        CxeDistMatrixParseErrDistsCount
+        CxeDistMatrixParseErrLabelDup
+        CxeDistMatrixParseErrTaxaExcess
+        CxeDistMatrixParseErrTaxaShort
+    ctypedef struct CxtDistMatrixParser:
+        size_t ntaxa
+        char *labels
+        uint64_t labelsLen
+        CxeDistMatrixParseErr err
+        unsigned errLine
+        size_t errX
+        size_t errY
+
+    cdef void CxDistMatrixParserNew(CxtDistMatrixParser *aParser)
+    cdef void CxDistMatrixParserDelete(CxtDistMatrixParser *aParser)
+    cdef bint CxDistMatrixParseBegin(CxtDistMatrixParser *aParser, char *aBuf, \
+      size_t aLen, unsigned aLine)
+    cdef bint CxDistMatrixParseFdBegin(CxtDistMatrixParser *aParser, int aFd, \
+      uint64_t aOff, unsigned aLine)
+    cdef bint CxDistMatrixParseRows(CxtDistMatrixParser *aParser, \
+      float *aDists)
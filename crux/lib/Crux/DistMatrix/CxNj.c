@@ -0,0 +1,552 @@
+#include "CxNj.h"
+#include "../CxJobs.h"
+
+#include <math.h>
+
+#ifdef CxmCpuAmd64
+#  include <emmintrin.h>
+#endif
+
+// Minimum number of matrix elements per job.
+#define CxmNjJobMin 16384
+
+// Maximum number of jobs per search, which bounds the size of CxtNjCtx.
+#define CxmNjJobsMax 256
+
+// Per-job search results.
+typedef struct {
+    float min;
+    size_t xMin;
+    size_t yMin;
+    uint64_t nties;
+} CxtNjBlock;
+
+// Context for CxNjMinFind() and CxNjRandomMinFind() jobs.
+typedef struct {
+    const float *d;
+    const float *rScaled;
+    size_t n;
+    float thresh; // Largest transformed distance that ties the minimum.
+    unsigned njobs;
+    CxtNjBlock blocks[CxmNjJobsMax];
+} CxtNjCtx;
+
+// Compute the transformed distance for (aX,aY), where aRow points to the first
+// element of row aX.
+CxmpInline float
+CxpNjTrans(const float *aRow, const float *aRScaled, float aRScaledX,
+  size_t aX, size_t aY) {
+    return aRow[aY - aX - 1] - (aRScaledX + aRScaled[aY]);
+}
+
+// Return the largest float that is no more than aUlps above aF, using the same
+// lexicographic integer mapping as distEq() in Nj.pyx.
+static float
+CxpNjUlpsAbove(float aF, int32_t aUlps) {
+    union {
+	float f;
+	int32_t i;
+    } u;
+    int32_t lex;
+
+    u.f = aF;
+    lex = (u.i < 0) ? (int32_t)(0x80000000U - (uint32_t)u.i) : u.i;
+    lex += aUlps;
+    u.i = (lex < 0) ? (int32_t)(0x80000000U - (uint32_t)lex) : lex;
+
+    return u.f;
+}
+
+// Compute the range of rows [*rXBeg..*rXEnd) that job aJob of aNJobs is
+// responsible for, and the offset in the aN x aN matrix of the first element of
+// row *rXBeg.  Rows are assigned
+// such that each job gets roughly the same number of matrix elements.
+static void
+CxpNjBlockRows(size_t aN, unsigned aNJobs, unsigned aJob, size_t *rXBeg,
+  size_t *rXEnd, uint64_t *rI) {
+    uint64_t nelms, beg, end, i;
+    size_t x;
+
+    nelms = ((uint64_t)aN * (aN - 1)) >> 1;
+    beg = (nelms * aJob) / aNJobs;
+    end = (nelms * (aJob + 1)) / aNJobs;
+
+    i = 0;
+    for (x = 0; x < aN && i < beg; x++) {
+	i += aN - 1 - x;
+    }
+    *rXBeg = x;
+    *rI = i;
+    for (; x < aN && i < end; x++) {
+	i += aN - 1 - x;
+    }
+    *rXEnd = x;
+}
+
+// Return the minimum transformed distance in row aX.  NaNs are ignored.
+static float
+CxpNjRowMin(const float *aRow, const float *aRScaled, size_t aN, size_t aX) {
+    float rScaledX, min, t;
+    size_t y;
+
+    rScaledX = aRScaled[aX];
+    min = HUGE_VALF;
+    y = aX + 1;
+#ifdef CxmCpuAmd64
+    {
+	__m128 vRScaledX, vMin, vT;
+	float mins[4];
+	unsigned k;
+
+	vRScaledX = _mm_set1_ps(rScaledX);
+	vMin = _mm_set1_ps(HUGE_VALF);
+	for (; y + 4 <= aN; y += 4) {
+	    vT = _mm_sub_ps(_mm_loadu_ps(&aRow[y - aX - 1]),
+	      _mm_add_ps(vRScaledX, _mm_loadu_ps(&aRScaled[y])));
+	    // _mm_min_ps() returns its second operand if either is NaN.
+	    vMin = _mm_min_ps(vT, vMin);
+	}
+	_mm_storeu_ps(mins, vMin);
+	for (k = 0; k < 4; k++) {
+	    if (mins[k] < min) {
+		min = mins[k];
+	    }
+	}
+    }
+#endif
+    for (; y < aN; y++) {
+	t = CxpNjTrans(aRow, aRScaled, rScaledX, aX, y);
+	if (t < min) {
+	    min = t;
+	}
+    }
+
+    return min;
+}
+
+// Return the number of transformed distances in row aX that are <= aThresh.
+static uint64_t
+CxpNjRowCount(const float *aRow, const float *aRScaled, size_t aN, size_t aX,
+  float aThresh) {
+    float rScaledX;
+    uint64_t ret;
+    size_t y;
+
+    ret = 0;
+    rScaledX = aRScaled[aX];
+    y = aX + 1;
+#ifdef CxmCpuAmd64
+    {
+	__m128 vRScaledX, vThresh, vT;
+
+	vRScaledX = _mm_set1_ps(rScaledX);
+	vThresh = _mm_set1_ps(aThresh);
+	for (; y + 4 <= aN; y += 4) {
+	    vT = _mm_sub_ps(_mm_loadu_ps(&aRow[y - aX - 1]),
+	      _mm_add_ps(vRScaledX, _mm_loadu_ps(&aRScaled[y])));
+	    ret += __builtin_popcount(_mm_movemask_ps(_mm_cmple_ps(vT,
+	      vThresh)));
+	}
+    }
+#endif
+    for (; y < aN; y++) {
+	if (CxpNjTrans(aRow, aRScaled, rScaledX, aX, y) <= aThresh) {
+	    ret++;
+	}
+    }
+
+    return ret;
+}
+
+// Find the minimum transformed distance in one block of rows.
+static void
+CxpNjMinJob(void *aArg, unsigned aJob) {
+    CxtNjCtx *ctx = (CxtNjCtx *)aArg;
+    CxtNjBlock *block = &ctx->blocks[aJob];
+    const float *row;
+    size_t x, xEnd, y;
+    uint64_t i;
+    float min;
+
+    block->min = HUGE_VALF;
+    block->xMin = 0;
+    block->yMin = 1;
+    CxpNjBlockRows(ctx->n, ctx->njobs, aJob, &x, &xEnd, &i);
+    for (; x < xEnd; x++) {
+	row = &ctx->d[i];
+	min = CxpNjRowMin(row, ctx->rScaled, ctx->n, x);
+	if (min < block->min) {
+	    // Find the first occurrence of min in the row.  The transformed
+	    // distances are recomputed with the same operations, so exact
+	    // comparison is safe.
+	    for (y = x + 1; CxpNjTrans(row, ctx->rScaled, ctx->rScaled[x], x, y)
+	      != min; y++) {
+		// Do nothing.
+	    }
+	    block->min = min;
+	    block->xMin = x;
+	    block->yMin = y;
+	}
+	i += ctx->n - 1 - x;
+    }
+}
+
+// Count the transformed distances that tie the minimum in one block of rows.
+static void
+CxpNjCountJob(void *aArg, unsigned aJob) {
+    CxtNjCtx *ctx = (CxtNjCtx *)aArg;
+    CxtNjBlock *block = &ctx->blocks[aJob];
+    size_t x, xEnd;
+    uint64_t i;
+
+    block->nties = 0;
+    CxpNjBlockRows(ctx->n, ctx->njobs, aJob, &x, &xEnd, &i);
+    for (; x < xEnd; x++) {
+	block->nties += CxpNjRowCount(&ctx->d[i], ctx->rScaled, ctx->n, x,
+	  ctx->thresh);
+	i += ctx->n - 1 - x;
+    }
+}
+
+// Run CxpNjMinJob() for all blocks, and merge the results in block order, so
+// that the first minimum in storage order wins.
+static void
+CxpNjMinFind(CxtNjCtx *aCtx, const float *aD, const float *aRScaled,
+  size_t aN, size_t *rXMin, size_t *rYMin, float *rMin) {
+    unsigned k, bMin;
+
+    CxmAssert(aN >= 2);
+
+    aCtx->d = aD;
+    aCtx->rScaled = aRScaled;
+    aCtx->n = aN;
+    aCtx->njobs = CxJobsCount(((uint64_t)aN * (aN - 1)) >> 1, CxmNjJobMin);
+    if (aCtx->njobs > CxmNjJobsMax) {
+	aCtx->njobs = CxmNjJobsMax;
+    }
+    CxJobsExecute(CxpNjMinJob, aCtx, aCtx->njobs);
+
+    bMin = 0;
+    for (k = 1; k < aCtx->njobs; k++) {
+	if (aCtx->blocks[k].min < aCtx->blocks[bMin].min) {
+	    bMin = k;
+	}
+    }
+    *rXMin = aCtx->blocks[bMin].xMin;
+    *rYMin = aCtx->blocks[bMin].yMin;
+    *rMin = aCtx->blocks[bMin].min;
+}
+
+void
+CxNjMinFind(const float *aD, const float *aRScaled, size_t aN, size_t *rXMin,
+  size_t *rYMin) {
+    CxtNjCtx ctx;
+    float min;
+
+    CxpNjMinFind(&ctx, aD, aRScaled, aN, rXMin, rYMin, &min);
+}
+
+void
+CxNjRandomMinFind(const float *aD, const float *aRScaled, size_t aN,
+  sfmt_t *aPrng, size_t *rXMin, size_t *rYMin) {
+    CxtNjCtx ctx;
+    const float *row;
+    size_t x, xEnd, y;
+    uint64_t nties, r, i;
+    unsigned k;
+    float min;
+
+    CxpNjMinFind(&ctx, aD, aRScaled, aN, rXMin, rYMin, &min);
+
+    // Count ties in parallel, then choose one of them in the calling thread, so
+    // that only one thread uses aPrng.
+    ctx.thresh = CxpNjUlpsAbove(min, CxmNjMaxUlps);
+    CxJobsExecute(CxpNjCountJob, &ctx, ctx.njobs);
+    nties = 0;
+    for (k = 0; k < ctx.njobs; k++) {
+	nties += ctx.blocks[k].nties;
+    }
+    if (nties <= 1) {
+	// No ties (or no computable distances); keep the minimum.
+	return;
+    }
+
+    r = gen_rand64_range(aPrng, nties);
+    for (k = 0; r >= ctx.blocks[k].nties; k++) {
+	r -= ctx.blocks[k].nties;
+    }
+    CxpNjBlockRows(aN, ctx.njobs, k, &x, &xEnd, &i);
+    for (; x < xEnd; x++) {
+	row = &aD[i];
+	for (y = x + 1; y < aN; y++) {
+	    if (CxpNjTrans(row, aRScaled, aRScaled[x], x, y) <= ctx.thresh) {
+		if (r == 0) {
+		    *rXMin = x;
+		    *rYMin = y;
+		    return;
+		}
+		r--;
+	    }
+	}
+	i += aN - 1 - x;
+    }
+    CxmNotReached();
+}
+
+// Context for CxNjRapidNew() jobs.
+typedef struct {
+    CxtNjRapid *rapid;
+    const float *d;
+    unsigned njobs;
+} CxtNjRapidCtx;
+
+static int
+CxpNjRapidEntCmp(const void *aA, const void *aB) {
+    const CxtNjRapidEnt *a = (const CxtNjRapidEnt *)aA;
+    const CxtNjRapidEnt *b = (const CxtNjRapidEnt *)aB;
+
+    if (a->dist < b->dist) {
+	return -1;
+    } else if (a->dist > b->dist) {
+	return 1;
+    }
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+// Sort the initial rows for one block of taxa.  NaN distances are omitted,
+// since they can never be the minimum.
+static void
+CxpNjRapidNewJob(void *aArg, unsigned aJob) {
+    CxtNjRapidCtx *ctx = (CxtNjRapidCtx *)aArg;
+    CxtNjRapid *rapid = ctx->rapid;
+    CxtNjRapidRow *row;
+    size_t x, xEnd, y;
+    uint64_t i;
+    float dist;
+
+    CxpNjBlockRows(rapid->nBase, ctx->njobs, aJob, &x, &xEnd, &i);
+    for (; x < xEnd; x++) {
+	row = &rapid->rows[x];
+	row->ents = &rapid->entsBase[i];
+	row->nents = 0;
+	for (y = x + 1; y < rapid->nBase; y++) {
+	    dist = ctx->d[i];
+	    i++;
+	    if (isnan(dist) == false) {
+		row->ents[row->nents].dist = dist;
+		row->ents[row->nents].id = (uint32_t)y;
+		row->nents++;
+	    }
+	}
+	qsort(row->ents, row->nents, sizeof(CxtNjRapidEnt), CxpNjRapidEntCmp);
+    }
+}
+
+bool
+CxNjRapidNew(CxtNjRapid *aRapid, const float *aD, size_t aN) {
+    CxtNjRapidCtx ctx;
+    uint64_t nelms;
+    size_t nids, i;
+
+    CxmAssert(aN >= 2);
+    CxmAssert(aN <= 0x80000000U);
+
+    nelms = ((uint64_t)aN * (aN - 1)) >> 1;
+    nids = (aN << 1) - 1;
+    aRapid->nBase = aN;
+    aRapid->nextId = (uint32_t)aN;
+    aRapid->off = 0;
+    aRapid->entsBase = (CxtNjRapidEnt *)malloc(nelms * sizeof(CxtNjRapidEnt)
+      + 1);
+    aRapid->rows = (CxtNjRapidRow *)calloc(nids, sizeof(CxtNjRapidRow));
+    aRapid->id2pos = (size_t *)malloc(nids * sizeof(size_t));
+    aRapid->row2idBase = (uint32_t *)malloc(aN * sizeof(uint32_t));
+    aRapid->row2id = aRapid->row2idBase;
+    if (aRapid->entsBase == NULL || aRapid->rows == NULL
+      || aRapid->id2pos == NULL || aRapid->row2idBase == NULL) {
+	CxNjRapidDelete(aRapid);
+	return true;
+    }
+
+    for (i = 0; i < nids; i++) {
+	aRapid->id2pos[i] = (i < aN) ? i : CxmNjRapidDead;
+    }
+    for (i = 0; i < aN; i++) {
+	aRapid->row2id[i] = (uint32_t)i;
+    }
+
+    ctx.rapid = aRapid;
+    ctx.d = aD;
+    ctx.njobs = CxJobsCount(nelms, CxmNjJobMin);
+    CxJobsExecute(CxpNjRapidNewJob, &ctx, ctx.njobs);
+
+    return false;
+}
+
+void
+CxNjRapidDelete(CxtNjRapid *aRapid) {
+    size_t i;
+
+    if (aRapid->rows != NULL) {
+	for (i = aRapid->nBase; i < aRapid->nextId; i++) {
+	    if (aRapid->rows[i].ents != NULL) {
+		free(aRapid->rows[i].ents);
+	    }
+	}
+	free(aRapid->rows);
+	aRapid->rows = NULL;
+    }
+    if (aRapid->entsBase != NULL) {
+	free(aRapid->entsBase);
+	aRapid->entsBase = NULL;
+    }
+    if (aRapid->id2pos != NULL) {
+	free(aRapid->id2pos);
+	aRapid->id2pos = NULL;
+    }
+    if (aRapid->row2idBase != NULL) {
+	free(aRapid->row2idBase);
+	aRapid->row2idBase = NULL;
+	aRapid->row2id = NULL;
+    }
+}
+
+// Discard entries for joined nodes from aRow, if they dominate it.
+CxmpInline void
+CxpNjRapidRowPurge(CxtNjRapid *aRapid, CxtNjRapidRow *aRow, size_t aN) {
+    uint32_t i, j;
+
+    if (aRow->nents <= (aN << 1)) {
+	return;
+    }
+    for (i = j = 0; i < aRow->nents; i++) {
+	if (aRapid->id2pos[aRow->ents[i].id] != CxmNjRapidDead) {
+	    aRow->ents[j] = aRow->ents[i];
+	    j++;
+	}
+    }
+    aRow->nents = j;
+}
+
+void
+CxNjRapidMinFind(CxtNjRapid *aRapid, const float *aRScaled, size_t aN,
+  size_t *rXMin, size_t *rYMin) {
+    CxtNjRapidRow *row;
+    CxtNjRapidEnt *ent;
+    float maxRScaled, min, rScaledA, sumMax, t;
+    size_t a, b, x, y, xMin, yMin, pos;
+    uint32_t k;
+
+    maxRScaled = -HUGE_VALF;
+    for (a = 0; a < aN; a++) {
+	if (aRScaled[a] > maxRScaled) {
+	    maxRScaled = aRScaled[a];
+	}
+    }
+
+    min = HUGE_VALF;
+    xMin = 0;
+    yMin = 1;
+    for (a = 0; a < aN; a++) {
+	row = &aRapid->rows[aRapid->row2id[a]];
+	CxpNjRapidRowPurge(aRapid, row, aN);
+	rScaledA = aRScaled[a];
+	sumMax = rScaledA + maxRScaled;
+	for (k = 0; k < row->nents; k++) {
+	    ent = &row->ents[k];
+	    // Since rounding is monotonic, this bound is exact with respect to
+	    // the transformed distances computed below.
+	    if (ent->dist - sumMax > min) {
+		break;
+	    }
+	    pos = aRapid->id2pos[ent->id];
+	    if (pos == CxmNjRapidDead) {
+		continue;
+	    }
+	    b = pos - aRapid->off;
+	    t = ent->dist - (rScaledA + aRScaled[b]);
+	    if (t <= min) {
+		if (a < b) {
+		    x = a;
+		    y = b;
+		} else {
+		    x = b;
+		    y = a;
+		}
+		// Break ties in favor of the first minimum in storage order, as
+		// CxNjMinFind() does.
+		if (t < min || x < xMin || (x == xMin && y < yMin)) {
+		    min = t;
+		    xMin = x;
+		    yMin = y;
+		}
+	    }
+	}
+    }
+
+    *rXMin = xMin;
+    *rYMin = yMin;
+}
+
+bool
+CxNjRapidJoin(CxtNjRapid *aRapid, const float *aD, size_t aN, size_t aXMin,
+  size_t aYMin) {
+    CxtNjRapidRow *row;
+    uint32_t newId, ids[2];
+    size_t x, i;
+    float dist;
+    unsigned k;
+
+    CxmAssert(aXMin < aYMin);
+    CxmAssert(aYMin < aN);
+
+    // Create a sorted row for the new node, which is stored in row aXMin.
+    newId = aRapid->nextId;
+    aRapid->nextId++;
+    row = &aRapid->rows[newId];
+    row->ents = (CxtNjRapidEnt *)malloc((aN - 2) * sizeof(CxtNjRapidEnt)
+      + 1);
+    if (row->ents == NULL) {
+	return true;
+    }
+    row->nents = 0;
+    for (x = 0; x < aN; x++) {
+	if (x == aXMin || x == aYMin) {
+	    continue;
+	}
+	if (x < aXMin) {
+	    i = aN*x + aXMin - (((x+3)*x) >> 1) - 1;
+	} else {
+	    i = aN*aXMin + x - (((aXMin+3)*aXMin) >> 1) - 1;
+	}
+	dist = aD[i];
+	if (isnan(dist) == false) {
+	    row->ents[row->nents].dist = dist;
+	    row->ents[row->nents].id = aRapid->row2id[x];
+	    row->nents++;
+	}
+    }
+    qsort(row->ents, row->nents, sizeof(CxtNjRapidEnt), CxpNjRapidEntCmp);
+
+    // Retire the joined nodes.
+    ids[0] = aRapid->row2id[aXMin];
+    ids[1] = aRapid->row2id[aYMin];
+    for (k = 0; k < 2; k++) {
+	aRapid->id2pos[ids[k]] = CxmNjRapidDead;
+	if (ids[k] >= aRapid->nBase) {
+	    free(aRapid->rows[ids[k]].ents);
+	}
+	aRapid->rows[ids[k]].ents = NULL;
+	aRapid->rows[ids[k]].nents = 0;
+    }
+
+    // Mirror the row movements in Nj._njCompact() and Nj._njDiscard().
+    aRapid->row2id[aXMin] = newId;
+    aRapid->id2pos[newId] = aRapid->off + aXMin;
+    aRapid->row2id[aYMin] = aRapid->row2id[0];
+    aRapid->id2pos[aRapid->row2id[aYMin]] = aRapid->off + aYMin;
+    aRapid->row2id = &aRapid->row2id[1];
+    aRapid->off++;
+
+    return false;
+}
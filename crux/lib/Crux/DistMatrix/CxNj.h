@@ -0,0 +1,101 @@
+#ifndef CxNj_h
+#define CxNj_h
+
+#include "../Cx.h"
+#include "../../SFMT/SFMT.h"
+
+// Minimum transformed distance search for neighbor joining.  aD is an aN x aN
+// upper-triangle distance matrix, in the storage order described in
+// Crux/DistMatrix/Nj.pyx, and aRScaled is the vector of scaled distance sums.
+// The transformed distance for (x,y) is:
+//
+//   aD[i] - (aRScaled[x] + aRScaled[y])
+//
+// Rows are partitioned into blocks of roughly equal numbers of matrix elements,
+// and blocks are scanned in parallel via CxJobsExecute().
+
+// Maximum number of ULPs (units in last place) by which two transformed
+// distances may differ and still be considered tied.  Same as MaxUlps in
+// Nj.pyx.
+#define CxmNjMaxUlps 0x7f
+
+// Store the coordinates of the minimum transformed distance in *rXMin and
+// *rYMin.  Ties are broken in favor of the first minimum in storage order, so
+// the result does not depend on the number of threads.
+void
+CxNjMinFind(const float *aD, const float *aRScaled, size_t aN, size_t *rXMin,
+  size_t *rYMin);
+
+// Same as CxNjMinFind(), but choose uniformly at random (using aPrng) among all
+// transformed distances that are within CxmNjMaxUlps of the minimum.
+void
+CxNjRandomMinFind(const float *aD, const float *aRScaled, size_t aN,
+  sfmt_t *aPrng, size_t *rXMin, size_t *rYMin);
+
+// Bounded minimum search, as described by:
+//
+//   Simonsen, M., T. Mailund, C.N.S. Pedersen (2008) Rapid neighbour-joining.
+//   Proc. WABI 2008, LNBI 5251:113-122.
+//
+// Each node has a row of distances to other nodes, sorted in increasing order.
+// Given the maximum scaled distance sum (maxRScaled), the transformed distances
+// for the remainder of a row are bounded below by
+//
+//   dist - (rScaled[x] + maxRScaled)
+//
+// so the remainder of the row can be skipped once this bound exceeds the
+// minimum found so far.  The results are identical to those of CxNjMinFind().
+//
+// Nodes are identified by ids that do not change as the matrix is compacted.
+// Ids [0..aN) are the original taxa, and each join creates a new id.  Initial
+// rows for the original taxa only contain distances to higher numbered taxa,
+// and the row for each new node contains distances to all nodes that exist when
+// it is created, so that each pair of nodes is represented at least once.
+// Entries for nodes that have since been joined are skipped (and periodically
+// purged).
+
+typedef struct {
+    float dist;
+    uint32_t id;
+} CxtNjRapidEnt;
+
+typedef struct {
+    CxtNjRapidEnt *ents;
+    uint32_t nents;
+} CxtNjRapidRow;
+
+typedef struct {
+    size_t nBase;
+    uint32_t nextId;
+    CxtNjRapidEnt *entsBase; // Storage for the original taxa's rows.
+    CxtNjRapidRow *rows; // Indexed by id.
+    size_t *id2pos; // Matrix position of each id, relative to the original
+		    // matrix; CxmNjRapidDead for joined nodes.
+    uint32_t *row2idBase, *row2id; // row2id is advanced as rows are removed.
+    size_t off; // Number of rows removed, which is (id2pos[id] - row).
+} CxtNjRapid;
+
+#define CxmNjRapidDead ((size_t)-1)
+
+// Initialize aRapid for the aN x aN matrix aD.  The initial rows are sorted in
+// parallel.  Return true on error.
+bool
+CxNjRapidNew(CxtNjRapid *aRapid, const float *aD, size_t aN);
+
+void
+CxNjRapidDelete(CxtNjRapid *aRapid);
+
+// Same as CxNjMinFind(), but using the bounded search.
+void
+CxNjRapidMinFind(CxtNjRapid *aRapid, const float *aRScaled, size_t aN,
+  size_t *rXMin, size_t *rYMin);
+
+// Update aRapid to reflect the join of rows aXMin and aYMin.  This must be
+// called after the new node's distances have been stored in row aXMin of aD
+// (Nj._njCompact()), and before the first row is removed (Nj._njDiscard());
+// aN is the number of rows prior to the join.  Return true on error.
+bool
+CxNjRapidJoin(CxtNjRapid *aRapid, const float *aD, size_t aN, size_t aXMin,
+  size_t aYMin);
+
+#endif // CxNj_h
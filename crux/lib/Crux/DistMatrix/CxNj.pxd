@@ -0,0 +1,17 @@
+from SFMT cimport sfmt_t
+
+cdef extern from "CxNj.h":
+    ctypedef struct CxtNjRapid:
+        pass
+
+    cdef void CxNjMinFind(float *aD, float *aRScaled, size_t aN, \
+      size_t *rXMin, size_t *rYMin)
+    cdef void CxNjRandomMinFind(float *aD, float *aRScaled, size_t aN, \
+      sfmt_t *aPrng, size_t *rXMin, size_t *rYMin)
+
+    cdef bint CxNjRapidNew(CxtNjRapid *aRapid, float *aD, size_t aN)
+    cdef void CxNjRapidDelete(CxtNjRapid *aRapid)
+    cdef void CxNjRapidMinFind(CxtNjRapid *aRapid, float *aRScaled, \
+      size_t aN, size_t *rXMin, size_t *rYMin)
+    cdef bint CxNjRapidJoin(CxtNjRapid *aRapid, float *aD, size_t aN, \
+      size_t aXMin, size_t aYMin)
@@ -0,0 +1,401 @@
+#include "CxAsdsf.h"
+
+#include <math.h>
+
+// Initial sizes of growable vectors.
+#define CxmAsdsfMaxMin 64
+
+bool
+CxAsdsfNew(CxtAsdsf *aAsdsf, unsigned aNruns, unsigned aNBits,
+  double aMinFreq) {
+    unsigned r;
+
+    memset(aAsdsf, 0, sizeof(CxtAsdsf));
+    aAsdsf->nruns = aNruns;
+    aAsdsf->nBits = aNBits;
+    aAsdsf->nWords = CxmBipartNWords(aNBits);
+    aAsdsf->minFreq = aMinFreq;
+
+    if (CxBipartTabNew(&aAsdsf->tab, aAsdsf->nWords)) {
+	return true;
+    }
+    aAsdsf->ids = (uint32_t **)calloc(aNruns, sizeof(uint32_t *));
+    aAsdsf->nids = (uint64_t *)calloc(aNruns, sizeof(uint64_t));
+    aAsdsf->maxIds = (uint64_t *)calloc(aNruns, sizeof(uint64_t));
+    aAsdsf->offs = (uint64_t **)calloc(aNruns, sizeof(uint64_t *));
+    aAsdsf->nsamps = (uint64_t *)calloc(aNruns, sizeof(uint64_t));
+    aAsdsf->fenLen = CxmAsdsfMaxMin;
+    aAsdsf->fenN = (uint64_t *)calloc(aAsdsf->fenLen, sizeof(uint64_t));
+    aAsdsf->fenSd = (double *)calloc(aAsdsf->fenLen, sizeof(double));
+    if (aAsdsf->ids == NULL || aAsdsf->nids == NULL || aAsdsf->maxIds == NULL
+      || aAsdsf->offs == NULL || aAsdsf->nsamps == NULL
+      || aAsdsf->fenN == NULL || aAsdsf->fenSd == NULL) {
+	goto ERROR;
+    }
+    aAsdsf->maxSamps = CxmAsdsfMaxMin;
+    for (r = 0; r < aNruns; r++) {
+	aAsdsf->offs[r] = (uint64_t *)malloc(aAsdsf->maxSamps
+	  * sizeof(uint64_t));
+	if (aAsdsf->offs[r] == NULL) {
+	    goto ERROR;
+	}
+    }
+
+    return false;
+    ERROR:
+    CxAsdsfDelete(aAsdsf);
+    return true;
+}
+
+void
+CxAsdsfDelete(CxtAsdsf *aAsdsf) {
+    uint64_t i;
+    unsigned r;
+
+    CxBipartTabDelete(&aAsdsf->tab);
+    for (i = 0; i < aAsdsf->nsplits; i++) {
+	free(aAsdsf->splitWords[i]);
+    }
+    if (aAsdsf->splitWords != NULL) {
+	free(aAsdsf->splitWords);
+    }
+    if (aAsdsf->counts != NULL) {
+	free(aAsdsf->counts);
+    }
+    if (aAsdsf->maxCounts != NULL) {
+	free(aAsdsf->maxCounts);
+    }
+    if (aAsdsf->sds != NULL) {
+	free(aAsdsf->sds);
+    }
+    for (r = 0; r < aAsdsf->nruns; r++) {
+	if (aAsdsf->ids != NULL && aAsdsf->ids[r] != NULL) {
+	    free(aAsdsf->ids[r]);
+	}
+	if (aAsdsf->offs != NULL && aAsdsf->offs[r] != NULL) {
+	    free(aAsdsf->offs[r]);
+	}
+    }
+    if (aAsdsf->ids != NULL) {
+	free(aAsdsf->ids);
+    }
+    if (aAsdsf->nids != NULL) {
+	free(aAsdsf->nids);
+    }
+    if (aAsdsf->maxIds != NULL) {
+	free(aAsdsf->maxIds);
+    }
+    if (aAsdsf->offs != NULL) {
+	free(aAsdsf->offs);
+    }
+    if (aAsdsf->nsamps != NULL) {
+	free(aAsdsf->nsamps);
+    }
+    if (aAsdsf->fenN != NULL) {
+	free(aAsdsf->fenN);
+    }
+    if (aAsdsf->fenSd != NULL) {
+	free(aAsdsf->fenSd);
+    }
+    memset(aAsdsf, 0, sizeof(CxtAsdsf));
+}
+
+// Add (aDN, aDSd) at index aInd (1-based) of the Fenwick tree.
+CxmpInline void
+CxpAsdsfFenAdd(CxtAsdsf *aAsdsf, uint64_t aInd, int64_t aDN, double aDSd) {
+    uint64_t i;
+
+    CxmAssert(aInd > 0);
+    for (i = aInd; i <= aAsdsf->fenLen; i += i & (~i + 1)) {
+	aAsdsf->fenN[i - 1] += aDN;
+	aAsdsf->fenSd[i - 1] += aDSd;
+    }
+}
+
+// Sum Fenwick tree values over indices [1..aInd].
+CxmpInline void
+CxpAsdsfFenPrefix(CxtAsdsf *aAsdsf, uint64_t aInd, uint64_t *rN,
+  double *rSd) {
+    uint64_t i, n;
+    double sd;
+
+    n = 0;
+    sd = 0.0;
+    for (i = aInd; i > 0; i &= i - 1) {
+	n += aAsdsf->fenN[i - 1];
+	sd += aAsdsf->fenSd[i - 1];
+    }
+    *rN = n;
+    *rSd = sd;
+}
+
+// Grow the Fenwick tree to cover at least aLen, and rebuild it.  Return true
+// on memory allocation failure.
+static bool
+CxpAsdsfFenGrow(CxtAsdsf *aAsdsf, uint64_t aLen) {
+    uint64_t fenLen, *fenN, i;
+    double *fenSd;
+
+    for (fenLen = aAsdsf->fenLen; fenLen < aLen; fenLen <<= 1) {
+	// Do nothing.
+    }
+    fenN = (uint64_t *)calloc(fenLen, sizeof(uint64_t));
+    fenSd = (double *)calloc(fenLen, sizeof(double));
+    if (fenN == NULL || fenSd == NULL) {
+	if (fenN != NULL) {
+	    free(fenN);
+	}
+	if (fenSd != NULL) {
+	    free(fenSd);
+	}
+	return true;
+    }
+    free(aAsdsf->fenN);
+    free(aAsdsf->fenSd);
+    aAsdsf->fenN = fenN;
+    aAsdsf->fenSd = fenSd;
+    aAsdsf->fenLen = fenLen;
+
+    for (i = 0; i < aAsdsf->nsplits; i++) {
+	if (aAsdsf->maxCounts[i] > 0) {
+	    CxpAsdsfFenAdd(aAsdsf, aAsdsf->maxCounts[i], 1, aAsdsf->sds[i]);
+	}
+    }
+
+    return false;
+}
+
+// Adjust the count for aSplit in aRun by aDelta, and update the derived
+// statistics.  Return true on memory allocation failure.
+static bool
+CxpAsdsfCount(CxtAsdsf *aAsdsf, uint64_t aSplit, unsigned aRun, int aDelta) {
+    uint32_t *counts;
+    uint64_t s1, s2, max, R;
+    unsigned r;
+
+    if (aAsdsf->maxCounts[aSplit] > 0) {
+	CxpAsdsfFenAdd(aAsdsf, aAsdsf->maxCounts[aSplit], -1,
+	  -aAsdsf->sds[aSplit]);
+    }
+
+    counts = &aAsdsf->counts[aSplit * aAsdsf->nruns];
+    counts[aRun] += aDelta;
+    s1 = s2 = max = 0;
+    for (r = 0; r < aAsdsf->nruns; r++) {
+	s1 += counts[r];
+	s2 += (uint64_t)counts[r] * (uint64_t)counts[r];
+	if (counts[r] > max) {
+	    max = counts[r];
+	}
+    }
+    // Sample standard deviation, computed from exact integer sums.
+    R = aAsdsf->nruns;
+    aAsdsf->sds[aSplit] = (R > 1)
+      ? sqrt((double)(R * s2 - s1 * s1) / (double)(R * (R - 1))) : 0.0;
+    aAsdsf->maxCounts[aSplit] = (uint32_t)max;
+
+    if (max > aAsdsf->fenLen) {
+	return CxpAsdsfFenGrow(aAsdsf, max);
+    }
+    if (max > 0) {
+	CxpAsdsfFenAdd(aAsdsf, max, 1, aAsdsf->sds[aSplit]);
+    }
+
+    return false;
+}
+
+// Add a new split, with a copy of aWords as its bit vector.  Return true on
+// memory allocation failure.
+static bool
+CxpAsdsfSplitNew(CxtAsdsf *aAsdsf, const uint64_t *aWords) {
+    uint64_t *words;
+
+    if (aAsdsf->nsplits == aAsdsf->maxSplits) {
+	uint64_t maxSplits;
+	void *p;
+
+	maxSplits = (aAsdsf->maxSplits == 0) ? CxmAsdsfMaxMin
+	  : aAsdsf->maxSplits << 1;
+	p = realloc(aAsdsf->splitWords, maxSplits * sizeof(uint64_t *));
+	if (p == NULL) {
+	    return true;
+	}
+	aAsdsf->splitWords = (uint64_t **)p;
+	p = realloc(aAsdsf->counts,
+	  maxSplits * aAsdsf->nruns * sizeof(uint32_t));
+	if (p == NULL) {
+	    return true;
+	}
+	aAsdsf->counts = (uint32_t *)p;
+	p = realloc(aAsdsf->maxCounts, maxSplits * sizeof(uint32_t));
+	if (p == NULL) {
+	    return true;
+	}
+	aAsdsf->maxCounts = (uint32_t *)p;
+	p = realloc(aAsdsf->sds, maxSplits * sizeof(double));
+	if (p == NULL) {
+	    return true;
+	}
+	aAsdsf->sds = (double *)p;
+	aAsdsf->maxSplits = maxSplits;
+    }
+
+    words = (uint64_t *)malloc(aAsdsf->nWords * sizeof(uint64_t));
+    if (words == NULL) {
+	return true;
+    }
+    memcpy(words, aWords, aAsdsf->nWords * sizeof(uint64_t));
+    aAsdsf->splitWords[aAsdsf->nsplits] = words;
+    memset(&aAsdsf->counts[aAsdsf->nsplits * aAsdsf->nruns], 0,
+      aAsdsf->nruns * sizeof(uint32_t));
+    aAsdsf->maxCounts[aAsdsf->nsplits] = 0;
+    aAsdsf->sds[aAsdsf->nsplits] = 0.0;
+    aAsdsf->nsplits++;
+
+    return false;
+}
+
+bool
+CxAsdsfSample(CxtAsdsf *aAsdsf, unsigned aRun) {
+    CxmAssert(aRun < aAsdsf->nruns);
+
+    if (aAsdsf->nsamps[aRun] == aAsdsf->maxSamps) {
+	uint64_t maxSamps, *offs;
+	unsigned r;
+
+	maxSamps = aAsdsf->maxSamps << 1;
+	for (r = 0; r < aAsdsf->nruns; r++) {
+	    offs = (uint64_t *)realloc(aAsdsf->offs[r],
+	      maxSamps * sizeof(uint64_t));
+	    if (offs == NULL) {
+		return true;
+	    }
+	    aAsdsf->offs[r] = offs;
+	}
+	aAsdsf->maxSamps = maxSamps;
+    }
+    aAsdsf->offs[aRun][aAsdsf->nsamps[aRun]] = aAsdsf->nids[aRun];
+    aAsdsf->nsamps[aRun]++;
+
+    return false;
+}
+
+bool
+CxAsdsfSplit(CxtAsdsf *aAsdsf, unsigned aRun, uint64_t aHash,
+  const uint64_t *aWords) {
+    uint64_t split;
+
+    CxmAssert(aRun < aAsdsf->nruns);
+    CxmAssert(aAsdsf->nsamps[aRun] > 0);
+
+    // The table must only reference owned bit vectors, so copy aWords before
+    // inserting a new split.
+    if (CxBipartTabSearch(&aAsdsf->tab, aHash, aWords, &split)) {
+	split = aAsdsf->nsplits;
+	if (split == UINT32_MAX || CxpAsdsfSplitNew(aAsdsf, aWords)
+	  || CxBipartTabInsert(&aAsdsf->tab, aHash,
+	  aAsdsf->splitWords[split], split, &split)) {
+	    return true;
+	}
+    }
+
+    if (aAsdsf->nids[aRun] == aAsdsf->maxIds[aRun]) {
+	uint64_t maxIds;
+	uint32_t *ids;
+
+	maxIds = (aAsdsf->maxIds[aRun] == 0) ? CxmAsdsfMaxMin
+	  : aAsdsf->maxIds[aRun] << 1;
+	ids = (uint32_t *)realloc(aAsdsf->ids[aRun],
+	  maxIds * sizeof(uint32_t));
+	if (ids == NULL) {
+	    return true;
+	}
+	aAsdsf->ids[aRun] = ids;
+	aAsdsf->maxIds[aRun] = maxIds;
+    }
+    aAsdsf->ids[aRun][aAsdsf->nids[aRun]] = (uint32_t)split;
+    aAsdsf->nids[aRun]++;
+
+    return CxpAsdsfCount(aAsdsf, split, aRun, 1);
+}
+
+bool
+CxAsdsfWindow(CxtAsdsf *aAsdsf, uint64_t aFirst) {
+    uint64_t s, k, i, lim, shift;
+    unsigned r;
+
+    CxmAssert(aFirst >= aAsdsf->first);
+#ifdef CxmAssertions
+    for (r = 1; r < aAsdsf->nruns; r++) {
+	CxmAssert(aAsdsf->nsamps[r] == aAsdsf->nsamps[0]);
+    }
+#endif
+    CxmAssert(aFirst <= aAsdsf->base + aAsdsf->nsamps[0]);
+
+    // Remove samples that have fallen out of the window.
+    for (s = aAsdsf->first; s < aFirst; s++) {
+	k = s - aAsdsf->base;
+	for (r = 0; r < aAsdsf->nruns; r++) {
+	    lim = (k + 1 < aAsdsf->nsamps[r]) ? aAsdsf->offs[r][k + 1]
+	      : aAsdsf->nids[r];
+	    for (i = aAsdsf->offs[r][k]; i < lim; i++) {
+		if (CxpAsdsfCount(aAsdsf, aAsdsf->ids[r][i], r, -1)) {
+		    return true;
+		}
+	    }
+	}
+    }
+    aAsdsf->first = aFirst;
+
+    // Discard split lists for removed samples once there are at least half as
+    // many of them as there are window samples, so that storage is
+    // proportional to the window size, and the amortized compaction cost per
+    // sample is constant.
+    k = aAsdsf->first - aAsdsf->base;
+    if (k >= CxmAsdsfMaxMin && (k << 1) >= aAsdsf->nsamps[0] - k) {
+	for (r = 0; r < aAsdsf->nruns; r++) {
+	    shift = (k < aAsdsf->nsamps[r]) ? aAsdsf->offs[r][k]
+	      : aAsdsf->nids[r];
+	    memmove(aAsdsf->ids[r], &aAsdsf->ids[r][shift],
+	      (aAsdsf->nids[r] - shift) * sizeof(uint32_t));
+	    aAsdsf->nids[r] -= shift;
+	    memmove(aAsdsf->offs[r], &aAsdsf->offs[r][k],
+	      (aAsdsf->nsamps[r] - k) * sizeof(uint64_t));
+	    aAsdsf->nsamps[r] -= k;
+	    for (i = 0; i < aAsdsf->nsamps[r]; i++) {
+		aAsdsf->offs[r][i] -= shift;
+	    }
+	}
+	aAsdsf->base = aAsdsf->first;
+    }
+
+    return false;
+}
+
+double
+CxAsdsfGet(CxtAsdsf *aAsdsf) {
+    uint64_t n, t, nAll, nBelow;
+    double sdAll, sdBelow;
+
+    n = aAsdsf->base + aAsdsf->nsamps[0] - aAsdsf->first;
+    if (n == 0) {
+	return -1.0;
+    }
+
+    // Include splits with (maxCount/n >= minFreq).
+    t = (uint64_t)ceil(aAsdsf->minFreq * (double)n);
+    if (t == 0) {
+	t = 1;
+    }
+    if (t > aAsdsf->fenLen) {
+	return -1.0;
+    }
+    CxpAsdsfFenPrefix(aAsdsf, aAsdsf->fenLen, &nAll, &sdAll);
+    CxpAsdsfFenPrefix(aAsdsf, t - 1, &nBelow, &sdBelow);
+    if (nAll == nBelow) {
+	return -1.0;
+    }
+
+    // Standard deviations are of counts, so scale them to frequencies.
+    return (sdAll - sdBelow) / (double)(nAll - nBelow) / (double)n;
+}
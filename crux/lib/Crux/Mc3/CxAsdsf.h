@@ -0,0 +1,91 @@
+#ifndef CxAsdsf_h
+#define CxAsdsf_h
+
+#include "../Cx.h"
+#include "../Tree/CxBipart.h"
+
+// Incrementally maintained average standard deviation of split frequencies
+// (ASDSF) among multiple independent runs, over a sliding window of samples.
+//
+// For each distinct split, the number of window samples that contain it is
+// tracked for every run, along with the standard deviation of those counts
+// across runs.  Adding or removing a sample therefore only touches the splits
+// in that sample's tree.  Splits are only included in the average if their
+// maximum frequency among runs is at least minFreq; since the window size
+// changes from sample to sample, inclusion is resolved at query time via a
+// Fenwick tree that is indexed by maximum count, and stores per-index split
+// counts and standard deviation sums.
+typedef struct {
+    unsigned nruns;
+    unsigned nBits;
+    unsigned nWords;
+    double minFreq;
+
+    // Split table, which maps bit vectors to split indices.  splitWords[i] is
+    // the owned bit vector for split i.
+    CxtBipartTab tab;
+    uint64_t **splitWords;
+    uint64_t nsplits;
+    uint64_t maxSplits;
+
+    // counts[i*nruns + run] is the number of window samples from run that
+    // contain split i.  maxCounts[i] is the maximum count among runs, and
+    // sds[i] is the standard deviation of counts among runs.
+    uint32_t *counts;
+    uint32_t *maxCounts;
+    double *sds;
+
+    // Per-run split lists for samples [base..base+nsamps).  The splits in
+    // sample (base+k) of run r are ids[r][offs[r][k]..offs[r][k+1]), where
+    // offs[r][nsamps] is implicitly nids[r].
+    uint32_t **ids;
+    uint64_t *nids;
+    uint64_t *maxIds;
+    uint64_t **offs;
+    uint64_t *nsamps;
+    uint64_t maxSamps;
+    uint64_t base;
+
+    // First sample in the window.  Samples [base..first) have been removed
+    // from counts, and their split lists are awaiting compaction.
+    uint64_t first;
+
+    // Fenwick tree over maximum counts [1..fenLen].
+    uint64_t fenLen; // Power of 2.
+    uint64_t *fenN;
+    double *fenSd;
+} CxtAsdsf;
+
+// Initialize an empty ASDSF tracker for aNruns runs and aNBits taxa.  Return
+// true on error.
+bool
+CxAsdsfNew(CxtAsdsf *aAsdsf, unsigned aNruns, unsigned aNBits,
+  double aMinFreq);
+
+// Discard aAsdsf.
+void
+CxAsdsfDelete(CxtAsdsf *aAsdsf);
+
+// Begin the next sample for run aRun.  Return true on memory allocation
+// failure.
+bool
+CxAsdsfSample(CxtAsdsf *aAsdsf, unsigned aRun);
+
+// Add the split described by aWords (with Zobrist hash aHash) to the current
+// sample of run aRun.  Return true on memory allocation failure.
+bool
+CxAsdsfSplit(CxtAsdsf *aAsdsf, unsigned aRun, uint64_t aHash,
+  const uint64_t *aWords);
+
+// Slide the start of the window forward to aFirst, which must not decrease.
+// Every run must have the same number of samples.  Return true on memory
+// allocation failure.
+bool
+CxAsdsfWindow(CxtAsdsf *aAsdsf, uint64_t aFirst);
+
+// Compute ASDSF for the current window, or return -1.0 if there are no window
+// samples or no splits that meet the frequency threshold.
+double
+CxAsdsfGet(CxtAsdsf *aAsdsf);
+
+#endif // CxAsdsf_h
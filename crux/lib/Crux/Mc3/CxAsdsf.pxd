@@ -0,0 +1,36 @@
+from libc cimport uint32_t, uint64_t
+from CxBipart cimport CxtBipartTab
+
+cdef extern from "CxAsdsf.h":
+    ctypedef struct CxtAsdsf:
+        unsigned nruns
+        unsigned nBits
+        unsigned nWords
+        double minFreq
+        CxtBipartTab tab
+        uint64_t **splitWords
+        uint64_t nsplits
+        uint64_t maxSplits
+        uint32_t *counts
+        uint32_t *maxCounts
+        double *sds
+        uint32_t **ids
+        uint64_t *nids
+        uint64_t *maxIds
+        uint64_t **offs
+        uint64_t *nsamps
+        uint64_t maxSamps
+        uint64_t base
+        uint64_t first
+        uint64_t fenLen
+        uint64_t *fenN
+        double *fenSd
+
+    cdef bint CxAsdsfNew(CxtAsdsf *aAsdsf, unsigned aNruns, unsigned aNBits, \
+      double aMinFreq)
+    cdef void CxAsdsfDelete(CxtAsdsf *aAsdsf)
+    cdef bint CxAsdsfSample(CxtAsdsf *aAsdsf, unsigned aRun)
+    cdef bint CxAsdsfSplit(CxtAsdsf *aAsdsf, unsigned aRun, uint64_t aHash, \
+      uint64_t *aWords)
+    cdef bint CxAsdsfWindow(CxtAsdsf *aAsdsf, uint64_t aFirst)
+    cdef double CxAsdsfGet(CxtAsdsf *aAsdsf)
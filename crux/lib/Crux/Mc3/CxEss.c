@@ -0,0 +1,102 @@
+#include "CxEss.h"
+
+void
+CxEssNew(CxtEss *aEss) {
+    memset(aEss, 0, sizeof(CxtEss));
+    aEss->bsize = 1;
+}
+
+// Merge aB into aA (Chan et al. 1979).
+CxmpInline void
+CxpEssMerge(CxtEssBatch *aA, const CxtEssBatch *aB) {
+    uint64_t n;
+    double delta;
+
+    n = aA->n + aB->n;
+    if (n == 0) {
+	return;
+    }
+    delta = aB->mean - aA->mean;
+    aA->mean += delta * (double)aB->n / (double)n;
+    aA->m2 += aB->m2 + delta * delta * (double)aA->n * (double)aB->n
+      / (double)n;
+    aA->n = n;
+}
+
+void
+CxEssAdd(CxtEss *aEss, double aX) {
+    CxtEssBatch *cur = &aEss->cur;
+    double delta;
+    unsigned i;
+
+    // Welford's method.
+    cur->n++;
+    delta = aX - cur->mean;
+    cur->mean += delta / (double)cur->n;
+    cur->m2 += delta * (aX - cur->mean);
+
+    if (cur->n == aEss->bsize) {
+	aEss->batches[aEss->nbatches] = *cur;
+	aEss->nbatches++;
+	memset(cur, 0, sizeof(CxtEssBatch));
+
+	if (aEss->nbatches == CxmEssMaxBatches) {
+	    for (i = 0; i < CxmEssMaxBatches / 2; i++) {
+		aEss->batches[i] = aEss->batches[i * 2];
+		CxpEssMerge(&aEss->batches[i], &aEss->batches[i * 2 + 1]);
+	    }
+	    aEss->nbatches = CxmEssMaxBatches / 2;
+	    aEss->bsize <<= 1;
+	}
+    }
+}
+
+void
+CxEssWindow(CxtEss *aEss, uint64_t aFirst) {
+    unsigned ndrop;
+
+    for (ndrop = 0; ndrop < aEss->nbatches && aEss->base < aFirst; ndrop++) {
+	aEss->base += aEss->bsize;
+    }
+    if (ndrop > 0) {
+	memmove(aEss->batches, &aEss->batches[ndrop],
+	  (aEss->nbatches - ndrop) * sizeof(CxtEssBatch));
+	aEss->nbatches -= ndrop;
+    }
+    if (aEss->nbatches == 0 && aEss->base < aFirst) {
+	// The window starts within the incomplete batch, so it must also be
+	// discarded in order to keep batches aligned with base.
+	aEss->base += aEss->cur.n;
+	memset(&aEss->cur, 0, sizeof(CxtEssBatch));
+    }
+}
+
+double
+CxEssGet(CxtEss *aEss) {
+    CxtEssBatch all;
+    double s2, vbm, diff;
+    unsigned i;
+
+    if (aEss->nbatches < 2) {
+	return -1.0;
+    }
+
+    all = aEss->batches[0];
+    for (i = 1; i < aEss->nbatches; i++) {
+	CxpEssMerge(&all, &aEss->batches[i]);
+    }
+    s2 = all.m2 / (double)(all.n - 1);
+
+    // Variance of the batch means.
+    vbm = 0.0;
+    for (i = 0; i < aEss->nbatches; i++) {
+	diff = aEss->batches[i].mean - all.mean;
+	vbm += diff * diff;
+    }
+    vbm /= (double)(aEss->nbatches - 1);
+
+    if (s2 <= 0.0 || vbm <= 0.0) {
+	return -1.0;
+    }
+    return (double)all.n * s2 / ((double)aEss->bsize * vbm);
+}
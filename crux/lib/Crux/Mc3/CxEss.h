@@ -0,0 +1,48 @@
+#ifndef CxEss_h
+#define CxEss_h
+
+#include "../Cx.h"
+
+// Online batch means estimator of effective sample size (ESS), over a window
+// of samples whose start only moves forward.
+//
+// Samples are accumulated into batches of equal size.  Whenever the number of
+// complete batches reaches CxmEssMaxBatches, adjacent batches are merged and
+// the batch size doubles, so space is constant and the cost per sample is
+// amortized O(1).  Batches that start before the window are discarded, so the
+// estimate covers the complete batches at the end of the window.
+
+#define CxmEssMaxBatches 64
+
+typedef struct {
+    uint64_t n;
+    double mean;
+    double m2; // Sum of squared deviations from mean.
+} CxtEssBatch;
+
+typedef struct {
+    uint64_t bsize; // Number of samples per batch.
+    uint64_t base; // Index of the first sample in batches[0].
+    unsigned nbatches;
+    CxtEssBatch batches[CxmEssMaxBatches];
+    CxtEssBatch cur; // Incomplete batch.
+} CxtEss;
+
+// Initialize aEss to start at sample 0.
+void
+CxEssNew(CxtEss *aEss);
+
+// Add the next sample.
+void
+CxEssAdd(CxtEss *aEss, double aX);
+
+// Discard batches that start before sample aFirst.
+void
+CxEssWindow(CxtEss *aEss, uint64_t aFirst);
+
+// Compute ESS, or return -1.0 if it is undefined (fewer than two complete
+// batches, or zero variance).
+double
+CxEssGet(CxtEss *aEss);
+
+#endif // CxEss_h
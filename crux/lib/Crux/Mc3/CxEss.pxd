@@ -0,0 +1,20 @@
+from libc cimport uint64_t
+
+cdef extern from "CxEss.h":
+    cdef enum:
+        CxmEssMaxBatches
+    ctypedef struct CxtEssBatch:
+        uint64_t n
+        double mean
+        double m2
+    ctypedef struct CxtEss:
+        uint64_t bsize
+        uint64_t base
+        unsigned nbatches
+        CxtEssBatch batches[CxmEssMaxBatches]
+        CxtEssBatch cur
+
+    cdef void CxEssNew(CxtEss *aEss)
+    cdef void CxEssAdd(CxtEss *aEss, double aX)
+    cdef void CxEssWindow(CxtEss *aEss, uint64_t aFirst)
+    cdef double CxEssGet(CxtEss *aEss)
@@ -0,0 +1,324 @@
+#include "CxPost.h"
+#include "../CxJobs.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Minimum number of records to parse per job in CxPostLogFields().
+#define CxmPostRecsPerJob 4096
+
+// Parsing context for CxPostLogFields() jobs.
+typedef struct {
+    CxtPostLog *log;
+    uint64_t first;
+    uint64_t nrecs;
+    const unsigned *fields;
+    unsigned nfields;
+    double *vals;
+    unsigned njobs;
+    bool error;
+} CxtPostFieldsCtx;
+
+CxmpInline bool
+CxpPostIsSpace(char c) {
+    return (c == ' ' || c == '\t');
+}
+
+// Parse an unsigned decimal integer at *aS, and advance *aS past it.  Return
+// true if there are no digits.
+CxmpInline bool
+CxpPostUint(const char **aS, const char *aEnd, uint64_t *rVal) {
+    const char *s = *aS;
+    uint64_t val = 0;
+
+    if (s == aEnd || *s < '0' || *s > '9') {
+	return true;
+    }
+    for (; s < aEnd && *s >= '0' && *s <= '9'; s++) {
+	val = val * 10 + (uint64_t)(*s - '0');
+    }
+    *aS = s;
+    *rVal = val;
+
+    return false;
+}
+
+CxmpInline const char *
+CxpPostSkipSpace(const char *aS, const char *aEnd) {
+    while (aS < aEnd && CxpPostIsSpace(*aS)) {
+	aS++;
+    }
+    return aS;
+}
+
+// Parse the run/step key at the beginning of aRec.  Return true on error.
+static bool
+CxpPostKey(CxePostLog aVariant, const char *aS, const char *aEnd,
+  CxtPostRec *aRec) {
+    uint64_t run, step;
+
+    switch (aVariant) {
+	case CxePostLogS: {
+	    if (CxpPostUint(&aS, aEnd, &step)) {
+		return true;
+	    }
+	    run = 0;
+	    break;
+	} case CxePostLogP: {
+	    if (CxpPostUint(&aS, aEnd, &run)) {
+		return true;
+	    }
+	    aS = CxpPostSkipSpace(aS, aEnd);
+	    if (CxpPostUint(&aS, aEnd, &step)) {
+		return true;
+	    }
+	    break;
+	} case CxePostLogT: {
+	    if (aS == aEnd || *aS != '[') {
+		return true;
+	    }
+	    aS++;
+	    if (CxpPostUint(&aS, aEnd, &run)) {
+		return true;
+	    }
+	    aS = CxpPostSkipSpace(aS, aEnd);
+	    if (CxpPostUint(&aS, aEnd, &step)) {
+		return true;
+	    }
+	    if (aS == aEnd || *aS != ']') {
+		return true;
+	    }
+	    break;
+	} default: {
+	    CxmNotReached();
+	    return true;
+	}
+    }
+    if (run > UINT32_MAX) {
+	return true;
+    }
+
+    aRec->run = (uint32_t)run;
+    aRec->step = step;
+    return false;
+}
+
+bool
+CxPostLogNew(CxtPostLog *aLog, const char *aPath, CxePostLog aVariant) {
+    struct stat st;
+    const char *p, *end, *nl;
+    uint64_t recsMax;
+
+    aLog->variant = aVariant;
+    aLog->fd = -1;
+    aLog->map = NULL;
+    aLog->mapLen = 0;
+    aLog->recs = NULL;
+    aLog->nrecs = 0;
+
+    aLog->fd = open(aPath, O_RDONLY);
+    if (aLog->fd == -1) {
+	goto ERROR;
+    }
+    if (fstat(aLog->fd, &st) == -1) {
+	goto ERROR;
+    }
+    aLog->mapLen = (size_t)st.st_size;
+    if (aLog->mapLen == 0) {
+	// Nothing to index.
+	return false;
+    }
+    aLog->map = (char *)mmap(NULL, aLog->mapLen, PROT_READ, MAP_SHARED,
+      aLog->fd, 0);
+    if (aLog->map == (char *)MAP_FAILED) {
+	aLog->map = NULL;
+	goto ERROR;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(aLog->map, aLog->mapLen, MADV_SEQUENTIAL);
+#endif
+
+    p = aLog->map;
+    end = aLog->map + aLog->mapLen;
+
+    // Skip the header line.
+    nl = (const char *)memchr(p, '\n', end - p);
+    if (nl == NULL) {
+	return false;
+    }
+    p = nl + 1;
+
+    // Index records.  Start with a guess based on the header length, and
+    // grow geometrically as necessary.
+    recsMax = 1024;
+    aLog->recs = (CxtPostRec *)malloc(recsMax * sizeof(CxtPostRec));
+    if (aLog->recs == NULL) {
+	goto ERROR;
+    }
+    while (p < end
+      && (nl = (const char *)memchr(p, '\n', end - p)) != NULL) {
+	CxtPostRec *rec;
+
+	if (aLog->nrecs == recsMax) {
+	    CxtPostRec *recs;
+
+	    recsMax += recsMax >> 1;
+	    recs = (CxtPostRec *)realloc(aLog->recs,
+	      recsMax * sizeof(CxtPostRec));
+	    if (recs == NULL) {
+		goto ERROR;
+	    }
+	    aLog->recs = recs;
+	}
+	rec = &aLog->recs[aLog->nrecs];
+	if (nl - p > UINT32_MAX) {
+	    goto ERROR;
+	}
+	rec->off = (uint64_t)(p - aLog->map);
+	rec->len = (uint32_t)(nl - p);
+	if (CxpPostKey(aVariant, p, nl, rec)) {
+	    goto ERROR;
+	}
+	aLog->nrecs++;
+	p = nl + 1;
+    }
+
+    return false;
+    ERROR:
+    CxPostLogDelete(aLog);
+    return true;
+}
+
+void
+CxPostLogDelete(CxtPostLog *aLog) {
+    if (aLog->recs != NULL) {
+	free(aLog->recs);
+	aLog->recs = NULL;
+    }
+    aLog->nrecs = 0;
+    if (aLog->map != NULL) {
+	munmap(aLog->map, aLog->mapLen);
+	aLog->map = NULL;
+    }
+    if (aLog->fd != -1) {
+	close(aLog->fd);
+	aLog->fd = -1;
+    }
+}
+
+uint64_t
+CxPostLogLowerBound(CxtPostLog *aLog, uint64_t aStep) {
+    uint64_t lo, hi, mid;
+
+    lo = 0;
+    hi = aLog->nrecs;
+    while (lo < hi) {
+	mid = lo + ((hi - lo) >> 1);
+	if (aLog->recs[mid].step < aStep) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+
+    return lo;
+}
+
+const char *
+CxPostLogField(CxtPostLog *aLog, uint64_t aRec, unsigned aField, bool aRest,
+  size_t *rLen) {
+    const char *s, *end, *f;
+    unsigned i;
+
+    CxmAssert(aRec < aLog->nrecs);
+
+    s = aLog->map + aLog->recs[aRec].off;
+    end = s + aLog->recs[aRec].len;
+    for (i = 0;; i++) {
+	s = CxpPostSkipSpace(s, end);
+	if (s == end) {
+	    return NULL;
+	}
+	for (f = s; s < end && CxpPostIsSpace(*s) == false; s++) {
+	    // Do nothing.
+	}
+	if (i == aField) {
+	    *rLen = (aRest ? end : s) - f;
+	    return f;
+	}
+    }
+}
+
+static void
+CxpPostFieldsJob(void *aArg, unsigned aJob) {
+    CxtPostFieldsCtx *ctx = (CxtPostFieldsCtx *)aArg;
+    uint64_t r, rLim;
+
+    // Divide records as evenly as possible among jobs.
+    r = (ctx->nrecs * aJob) / ctx->njobs;
+    rLim = (ctx->nrecs * (aJob + 1)) / ctx->njobs;
+    for (; r < rLim; r++) {
+	CxtPostRec *rec = &ctx->log->recs[ctx->first + r];
+	const char *s = ctx->log->map + rec->off;
+	// Records are newline-terminated, which assures that strtod() stops
+	// within the mapping.
+	const char *end = s + rec->len;
+	double *vals = &ctx->vals[r * ctx->nfields];
+	unsigned field, i;
+
+	for (field = 0, i = 0; i < ctx->nfields; field++) {
+	    s = CxpPostSkipSpace(s, end);
+	    if (s == end) {
+		ctx->error = true;
+		return;
+	    }
+	    if (field == ctx->fields[i]) {
+		char *e;
+
+		vals[i] = strtod(s, &e);
+		if (e == s || (e < end && CxpPostIsSpace(*e) == false)) {
+		    ctx->error = true;
+		    return;
+		}
+		s = e;
+		i++;
+	    } else {
+		while (s < end && CxpPostIsSpace(*s) == false) {
+		    s++;
+		}
+	    }
+	}
+    }
+}
+
+bool
+CxPostLogFields(CxtPostLog *aLog, uint64_t aFirst, uint64_t aNrecs,
+  const unsigned *aFields, unsigned aNfields, double *rVals) {
+    CxtPostFieldsCtx ctx;
+
+    CxmAssert(aFirst + aNrecs <= aLog->nrecs);
+#ifdef CxmAssertions
+    for (unsigned i = 1; i < aNfields; i++) {
+	CxmAssert(aFields[i-1] < aFields[i]);
+    }
+#endif
+
+    if (aNrecs == 0 || aNfields == 0) {
+	return false;
+    }
+
+    ctx.log = aLog;
+    ctx.first = aFirst;
+    ctx.nrecs = aNrecs;
+    ctx.fields = aFields;
+    ctx.nfields = aNfields;
+    ctx.vals = rVals;
+    ctx.njobs = CxJobsCount(aNrecs, CxmPostRecsPerJob);
+    ctx.error = false;
+
+    CxJobsExecute(CxpPostFieldsJob, &ctx, ctx.njobs);
+
+    return ctx.error;
+}
@@ -0,0 +1,84 @@
+#ifndef CxPost_h
+#define CxPost_h
+
+#include "../Cx.h"
+
+// Mc3 log file variants, as written by Mc3.sWrite(), Mc3.pWrite(), and
+// Mc3.tWrite().  Each log file consists of a single header line, followed by
+// one record per line.  The variant determines how run/step keys are parsed:
+//
+//   CxePostLogS : "step\t[ lnLs ] ..."
+//   CxePostLogP : "run\tstep\tmodel ..."
+//   CxePostLogT : "[run step] tree"
+typedef enum {
+    CxePostLogS = 0,
+    CxePostLogP = 1,
+    CxePostLogT = 2
+} CxePostLog;
+
+// Record index entry.
+typedef struct {
+    // Byte offset of the record within the log file.
+    uint64_t off;
+
+    // Step number associated with the record.
+    uint64_t step;
+
+    // Record length, excluding the trailing newline.
+    uint32_t len;
+
+    // Run index associated with the record.  This is always 0 for
+    // CxePostLogS records, since each such record covers all runs.
+    uint32_t run;
+} CxtPostRec;
+
+// Memory-mapped log file, along with an index of its records.  Indexing is
+// done in a single sequential scan, and only the run/step keys are parsed,
+// so records that precede burn-in are never tokenized.
+typedef struct {
+    CxePostLog variant;
+
+    // Memory mapping of the entire log file.
+    int fd;
+    char *map;
+    size_t mapLen;
+
+    // Vector of records, in file order.  Only complete (newline-terminated)
+    // records are indexed, so a partially written final record is ignored.
+    CxtPostRec *recs;
+    uint64_t nrecs;
+} CxtPostLog;
+
+// Map and index aPath.  Return true on error.
+bool
+CxPostLogNew(CxtPostLog *aLog, const char *aPath, CxePostLog aVariant);
+
+// Unmap aLog and discard its index.
+void
+CxPostLogDelete(CxtPostLog *aLog);
+
+// Return the index of the first record with (step >= aStep), or aLog->nrecs
+// if there is no such record.  Records must be in non-decreasing step order,
+// as is the case for all logs written by Mc3.
+uint64_t
+CxPostLogLowerBound(CxtPostLog *aLog, uint64_t aStep);
+
+// Get a pointer to the beginning of whitespace-separated field aField within
+// record aRec, and store its length in *rLen.  If aRest is true, the length
+// extends to the end of the record, rather than to the end of the field.
+// Return NULL if the record has too few fields.
+const char *
+CxPostLogField(CxtPostLog *aLog, uint64_t aRec, unsigned aField, bool aRest,
+  size_t *rLen);
+
+// For each record in [aFirst..aFirst+aNrecs), parse the aNfields fields
+// specified by the (strictly increasing) aFields vector as floating point
+// numbers, and store them in row-major order in rVals, such that the values
+// for record (aFirst+i) start at rVals[i*aNfields].  Records are parsed in
+// parallel if thread parallelism is enabled.  Return true if any field is
+// missing or malformed.
+bool
+CxPostLogFields(CxtPostLog *aLog, uint64_t aFirst, uint64_t aNrecs,
+  const unsigned *aFields, unsigned aNfields, double *rVals);
+
+#endif // CxPost_h
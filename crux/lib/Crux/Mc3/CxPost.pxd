@@ -0,0 +1,27 @@
+from libc cimport uint32_t, uint64_t
+
+cdef extern from "CxPost.h":
+    ctypedef enum CxePostLog:
+        CxePostLogS = 0
+        CxePostLogP = 1
+        CxePostLogT = 2
+    ctypedef struct CxtPostRec:
+        uint64_t off
+        uint64_t step
+        uint32_t len
+        uint32_t run
+    ctypedef struct CxtPostLog:
+        CxePostLog variant
+        int fd
+        char *map
+        size_t mapLen
+        CxtPostRec *recs
+        uint64_t nrecs
+
+    cdef bint CxPostLogNew(CxtPostLog *aLog, char *aPath, CxePostLog aVariant)
+    cdef void CxPostLogDelete(CxtPostLog *aLog)
+    cdef uint64_t CxPostLogLowerBound(CxtPostLog *aLog, uint64_t aStep)
+    cdef char *CxPostLogField(CxtPostLog *aLog, uint64_t aRec, \
+      unsigned aField, bint aRest, size_t *rLen)
+    cdef bint CxPostLogFields(CxtPostLog *aLog, uint64_t aFirst, \
+      uint64_t aNrecs, unsigned *aFields, unsigned aNfields, double *rVals)
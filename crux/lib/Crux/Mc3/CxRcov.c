@@ -0,0 +1,280 @@
+#include "CxRcov.h"
+
+// Initial number of nodes per tree for which space is allocated.
+#define CxmRcovMaxMin 64
+
+bool
+CxRcovNew(CxtRcov *aRcov, unsigned aNruns) {
+    unsigned r;
+
+    aRcov->nruns = aNruns;
+    aRcov->trees = (CxtRcovTree *)calloc(aNruns, sizeof(CxtRcovTree));
+    if (aRcov->trees == NULL) {
+	return true;
+    }
+    for (r = 0; r < aNruns; r++) {
+	aRcov->trees[r].free = CxmRcovNil;
+	aRcov->trees[r].root = CxmRcovNil;
+    }
+
+    return false;
+}
+
+void
+CxRcovDelete(CxtRcov *aRcov) {
+    unsigned r;
+
+    if (aRcov->trees != NULL) {
+	for (r = 0; r < aRcov->nruns; r++) {
+	    if (aRcov->trees[r].nodes != NULL) {
+		free(aRcov->trees[r].nodes);
+	    }
+	}
+	free(aRcov->trees);
+	aRcov->trees = NULL;
+    }
+}
+
+// Mix the bits of aSamp (splitmix64 finalizer).
+CxmpInline uint64_t
+CxpRcovPrio(uint64_t aSamp) {
+    uint64_t z;
+
+    z = aSamp + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+CxmpInline uint64_t
+CxpRcovSize(CxtRcovTree *aTree, uint64_t aNode) {
+    return (aNode == CxmRcovNil) ? 0 : aTree->nodes[aNode].size;
+}
+
+CxmpInline void
+CxpRcovUpdate(CxtRcovTree *aTree, uint64_t aNode) {
+    CxtRcovNode *node = &aTree->nodes[aNode];
+
+    node->size = 1 + CxpRcovSize(aTree, node->left)
+      + CxpRcovSize(aTree, node->right);
+}
+
+// Return true if (aLnL, aSamp) orders before aNode.
+CxmpInline bool
+CxpRcovLess(CxtRcovTree *aTree, double aLnL, uint64_t aSamp,
+  uint64_t aNode) {
+    CxtRcovNode *node = &aTree->nodes[aNode];
+
+    return (aLnL < node->lnL || (aLnL == node->lnL && aSamp < node->samp));
+}
+
+// Split the subtree rooted at aNode into nodes that order before aPivot
+// (*rLeft), and the rest (*rRight).
+static void
+CxpRcovSplit(CxtRcovTree *aTree, uint64_t aNode, uint64_t aPivot,
+  uint64_t *rLeft, uint64_t *rRight) {
+    CxtRcovNode *pivot = &aTree->nodes[aPivot];
+
+    if (aNode == CxmRcovNil) {
+	*rLeft = CxmRcovNil;
+	*rRight = CxmRcovNil;
+    } else if (CxpRcovLess(aTree, pivot->lnL, pivot->samp, aNode)) {
+	CxpRcovSplit(aTree, aTree->nodes[aNode].left, aPivot, rLeft,
+	  &aTree->nodes[aNode].left);
+	CxpRcovUpdate(aTree, aNode);
+	*rRight = aNode;
+    } else {
+	CxpRcovSplit(aTree, aTree->nodes[aNode].right, aPivot,
+	  &aTree->nodes[aNode].right, rRight);
+	CxpRcovUpdate(aTree, aNode);
+	*rLeft = aNode;
+    }
+}
+
+// Merge the subtrees rooted at aLeft and aRight, where all nodes in aLeft
+// order before those in aRight, and return the root of the result.
+static uint64_t
+CxpRcovMerge(CxtRcovTree *aTree, uint64_t aLeft, uint64_t aRight) {
+    if (aLeft == CxmRcovNil) {
+	return aRight;
+    }
+    if (aRight == CxmRcovNil) {
+	return aLeft;
+    }
+    if (aTree->nodes[aLeft].prio >= aTree->nodes[aRight].prio) {
+	aTree->nodes[aLeft].right = CxpRcovMerge(aTree,
+	  aTree->nodes[aLeft].right, aRight);
+	CxpRcovUpdate(aTree, aLeft);
+	return aLeft;
+    } else {
+	aTree->nodes[aRight].left = CxpRcovMerge(aTree, aLeft,
+	  aTree->nodes[aRight].left);
+	CxpRcovUpdate(aTree, aRight);
+	return aRight;
+    }
+}
+
+// Insert aNewNode into the subtree rooted at aNode, and return the root of the
+// result.
+static uint64_t
+CxpRcovInsert(CxtRcovTree *aTree, uint64_t aNode, uint64_t aNewNode) {
+    CxtRcovNode *newNode = &aTree->nodes[aNewNode];
+
+    if (aNode == CxmRcovNil) {
+	return aNewNode;
+    }
+    if (newNode->prio > aTree->nodes[aNode].prio) {
+	CxpRcovSplit(aTree, aNode, aNewNode, &newNode->left, &newNode->right);
+	CxpRcovUpdate(aTree, aNewNode);
+	return aNewNode;
+    }
+    if (CxpRcovLess(aTree, newNode->lnL, newNode->samp, aNode)) {
+	aTree->nodes[aNode].left = CxpRcovInsert(aTree,
+	  aTree->nodes[aNode].left, aNewNode);
+    } else {
+	aTree->nodes[aNode].right = CxpRcovInsert(aTree,
+	  aTree->nodes[aNode].right, aNewNode);
+    }
+    CxpRcovUpdate(aTree, aNode);
+    return aNode;
+}
+
+// Remove (aLnL, aSamp) from the subtree rooted at aNode, and return the root of
+// the result.
+static uint64_t
+CxpRcovRemove(CxtRcovTree *aTree, uint64_t aNode, double aLnL,
+  uint64_t aSamp) {
+    CxtRcovNode *node;
+    uint64_t ret;
+
+    CxmAssert(aNode != CxmRcovNil);
+    node = &aTree->nodes[aNode];
+    if (node->samp == aSamp) {
+	CxmAssert(node->lnL == aLnL);
+	ret = CxpRcovMerge(aTree, node->left, node->right);
+	node->left = aTree->free;
+	aTree->free = aNode;
+	return ret;
+    }
+    if (CxpRcovLess(aTree, aLnL, aSamp, aNode)) {
+	node->left = CxpRcovRemove(aTree, node->left, aLnL, aSamp);
+    } else {
+	node->right = CxpRcovRemove(aTree, node->right, aLnL, aSamp);
+    }
+    CxpRcovUpdate(aTree, aNode);
+    return aNode;
+}
+
+bool
+CxRcovInsert(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, double aLnL) {
+    CxtRcovTree *tree;
+    CxtRcovNode *node;
+    uint64_t ind;
+
+    CxmAssert(aRun < aRcov->nruns);
+    tree = &aRcov->trees[aRun];
+
+    if (tree->free != CxmRcovNil) {
+	ind = tree->free;
+	tree->free = tree->nodes[ind].left;
+    } else {
+	if (tree->nnodes == tree->maxNodes) {
+	    uint64_t maxNodes;
+	    CxtRcovNode *nodes;
+
+	    maxNodes = (tree->maxNodes == 0) ? CxmRcovMaxMin
+	      : tree->maxNodes << 1;
+	    nodes = (CxtRcovNode *)realloc(tree->nodes,
+	      maxNodes * sizeof(CxtRcovNode));
+	    if (nodes == NULL) {
+		return true;
+	    }
+	    tree->nodes = nodes;
+	    tree->maxNodes = maxNodes;
+	}
+	ind = tree->nnodes;
+	tree->nnodes++;
+    }
+
+    node = &tree->nodes[ind];
+    node->lnL = aLnL;
+    node->samp = aSamp;
+    node->prio = CxpRcovPrio(aSamp);
+    node->left = CxmRcovNil;
+    node->right = CxmRcovNil;
+    node->size = 1;
+    tree->root = CxpRcovInsert(tree, tree->root, ind);
+
+    return false;
+}
+
+void
+CxRcovRemove(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, double aLnL) {
+    CxtRcovTree *tree;
+
+    CxmAssert(aRun < aRcov->nruns);
+    tree = &aRcov->trees[aRun];
+    tree->root = CxpRcovRemove(tree, tree->root, aLnL, aSamp);
+}
+
+uint64_t
+CxRcovSize(CxtRcov *aRcov, unsigned aRun) {
+    CxmAssert(aRun < aRcov->nruns);
+    return CxpRcovSize(&aRcov->trees[aRun], aRcov->trees[aRun].root);
+}
+
+double
+CxRcovSelect(CxtRcov *aRcov, unsigned aRun, uint64_t aRank) {
+    CxtRcovTree *tree;
+    uint64_t node, nleft;
+
+    CxmAssert(aRun < aRcov->nruns);
+    tree = &aRcov->trees[aRun];
+    CxmAssert(aRank < CxpRcovSize(tree, tree->root));
+
+    node = tree->root;
+    while (true) {
+	nleft = CxpRcovSize(tree, tree->nodes[node].left);
+	if (aRank < nleft) {
+	    node = tree->nodes[node].left;
+	} else if (aRank == nleft) {
+	    return tree->nodes[node].lnL;
+	} else {
+	    aRank -= nleft + 1;
+	    node = tree->nodes[node].right;
+	}
+    }
+}
+
+// Return the number of nodes with (lnL < aLnL), or (lnL <= aLnL) if aInclusive.
+static uint64_t
+CxpRcovCountBelow(CxtRcovTree *aTree, double aLnL, bool aInclusive) {
+    uint64_t node, ret;
+    CxtRcovNode *n;
+
+    ret = 0;
+    node = aTree->root;
+    while (node != CxmRcovNil) {
+	n = &aTree->nodes[node];
+	if (n->lnL < aLnL || (aInclusive && n->lnL == aLnL)) {
+	    ret += CxpRcovSize(aTree, n->left) + 1;
+	    node = n->right;
+	} else {
+	    node = n->left;
+	}
+    }
+
+    return ret;
+}
+
+uint64_t
+CxRcovCount(CxtRcov *aRcov, unsigned aRun, double aLo, double aHi) {
+    CxtRcovTree *tree;
+
+    CxmAssert(aRun < aRcov->nruns);
+    CxmAssert(aLo <= aHi);
+    tree = &aRcov->trees[aRun];
+
+    return CxpRcovCountBelow(tree, aHi, true)
+      - CxpRcovCountBelow(tree, aLo, false);
+}
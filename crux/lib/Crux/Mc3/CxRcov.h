@@ -0,0 +1,75 @@
+#ifndef CxRcov_h
+#define CxRcov_h
+
+#include "../Cx.h"
+
+// Incrementally maintained order statistics for the log-likelihoods of
+// multiple independent runs, as needed to compute the Rcov convergence
+// diagnostic over a sliding window of samples.
+//
+// Each run's window samples are stored in a treap (randomized binary search
+// tree) that is ordered by (lnL, sample index), and annotated with subtree
+// sizes.  Insertion, removal, selection by rank, and counting the samples in a
+// closed interval all take O(lg n) expected time, so Rcov for R runs can be
+// computed in O(R^2 lg n) time, rather than by copying, sorting, and scanning
+// the window samples.  Treap priorities are derived by hashing sample indices,
+// so that the structure is deterministic and does not consume PRNG state.
+
+#define CxmRcovNil UINT64_MAX
+
+typedef struct {
+    double lnL;
+    uint64_t samp;
+    uint64_t prio;
+    uint64_t left;
+    uint64_t right;
+    uint64_t size; // Number of nodes in the subtree rooted at this node.
+} CxtRcovNode;
+
+typedef struct {
+    // Node pool.  Unused nodes are linked into a free list via their left
+    // fields.
+    CxtRcovNode *nodes;
+    uint64_t maxNodes;
+    uint64_t nnodes;
+    uint64_t free;
+
+    uint64_t root;
+} CxtRcovTree;
+
+typedef struct {
+    unsigned nruns;
+    CxtRcovTree *trees;
+} CxtRcov;
+
+// Initialize empty trees for aNruns runs.  Return true on error.
+bool
+CxRcovNew(CxtRcov *aRcov, unsigned aNruns);
+
+// Discard aRcov.
+void
+CxRcovDelete(CxtRcov *aRcov);
+
+// Insert sample aSamp of run aRun, with log-likelihood aLnL.  Return true on
+// memory allocation failure.
+bool
+CxRcovInsert(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, double aLnL);
+
+// Remove sample aSamp of run aRun, which must have been inserted with
+// log-likelihood aLnL.
+void
+CxRcovRemove(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, double aLnL);
+
+// Return the number of samples stored for run aRun.
+uint64_t
+CxRcovSize(CxtRcov *aRcov, unsigned aRun);
+
+// Return the lnL with 0-based rank aRank among run aRun's samples.
+double
+CxRcovSelect(CxtRcov *aRcov, unsigned aRun, uint64_t aRank);
+
+// Return the number of run aRun's samples with aLo <= lnL <= aHi.
+uint64_t
+CxRcovCount(CxtRcov *aRcov, unsigned aRun, double aLo, double aHi);
+
+#endif // CxRcov_h
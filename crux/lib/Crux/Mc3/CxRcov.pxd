@@ -0,0 +1,30 @@
+from libc cimport uint64_t
+
+cdef extern from "CxRcov.h":
+    ctypedef struct CxtRcovNode:
+        double lnL
+        uint64_t samp
+        uint64_t prio
+        uint64_t left
+        uint64_t right
+        uint64_t size
+    ctypedef struct CxtRcovTree:
+        CxtRcovNode *nodes
+        uint64_t maxNodes
+        uint64_t nnodes
+        uint64_t free
+        uint64_t root
+    ctypedef struct CxtRcov:
+        unsigned nruns
+        CxtRcovTree *trees
+
+    cdef bint CxRcovNew(CxtRcov *aRcov, unsigned aNruns)
+    cdef void CxRcovDelete(CxtRcov *aRcov)
+    cdef bint CxRcovInsert(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, \
+      double aLnL)
+    cdef void CxRcovRemove(CxtRcov *aRcov, unsigned aRun, uint64_t aSamp, \
+      double aLnL)
+    cdef uint64_t CxRcovSize(CxtRcov *aRcov, unsigned aRun)
+    cdef double CxRcovSelect(CxtRcov *aRcov, unsigned aRun, uint64_t aRank)
+    cdef uint64_t CxRcovCount(CxtRcov *aRcov, unsigned aRun, double aLo, \
+      double aHi)
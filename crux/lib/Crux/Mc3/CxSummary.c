@@ -0,0 +1,463 @@
+#include "CxSummary.h"
+
+#include <math.h>
+
+// Initial number of splits for which space is allocated.
+#define CxmSummaryMaxMin 64
+
+//==============================================================================
+// Moments.
+
+static void
+CxpSummaryMomentsAdd(CxtSummaryMoments *aMoments, double aVal) {
+    double diff;
+
+    aMoments->n++;
+    diff = aVal - aMoments->mean;
+    aMoments->mean += diff / (double)aMoments->n;
+    aMoments->m2 += diff * (aVal - aMoments->mean);
+}
+
+// Merge aSrc into aDst (Chan et al.'s parallel variant of Welford's method).
+static void
+CxpSummaryMomentsMerge(CxtSummaryMoments *aDst, const CxtSummaryMoments *aSrc)
+{
+    uint64_t n;
+    double diff;
+
+    if (aSrc->n == 0) {
+	return;
+    }
+    n = aDst->n + aSrc->n;
+    diff = aSrc->mean - aDst->mean;
+    aDst->mean += diff * (double)aSrc->n / (double)n;
+    aDst->m2 += aSrc->m2
+      + diff * diff * (double)aDst->n * (double)aSrc->n / (double)n;
+    aDst->n = n;
+}
+
+//==============================================================================
+// Quantile sketches.
+
+static void
+CxpSummarySketchInit(CxtSummarySketch *aSketch) {
+    aSketch->ncents = 0;
+    aSketch->nbuf = 0;
+    aSketch->weight = 0.0;
+    aSketch->min = INFINITY;
+    aSketch->max = -INFINITY;
+}
+
+// Arcsine scale function, which maps quantiles in [0..1] to
+// [-CxmSummaryDelta/4..CxmSummaryDelta/4].
+static double
+CxpSummarySketchK(double aQ) {
+    if (aQ >= 1.0) {
+	aQ = 1.0;
+    }
+    return (double)CxmSummaryDelta / (2.0 * M_PI) * asin(2.0 * aQ - 1.0);
+}
+
+static int
+CxpSummaryCentroidCmp(const void *aA, const void *aB) {
+    double a = ((const CxtSummaryCentroid *)aA)->mean;
+    double b = ((const CxtSummaryCentroid *)aB)->mean;
+
+    return (a > b) - (a < b);
+}
+
+// Merge the buffered centroids into the sketch's centroids.
+static void
+CxpSummarySketchCompress(CxtSummarySketch *aSketch) {
+    CxtSummaryCentroid items[CxmSummaryCentroidsMax + CxmSummaryBufMax];
+    CxtSummaryCentroid cur;
+    unsigned nitems, i;
+    double wSoFar, kLeft, w;
+
+    if (aSketch->nbuf == 0) {
+	return;
+    }
+
+    nitems = aSketch->ncents + aSketch->nbuf;
+    memcpy(items, aSketch->cents,
+      aSketch->ncents * sizeof(CxtSummaryCentroid));
+    memcpy(&items[aSketch->ncents], aSketch->buf,
+      aSketch->nbuf * sizeof(CxtSummaryCentroid));
+    qsort(items, nitems, sizeof(CxtSummaryCentroid), CxpSummaryCentroidCmp);
+
+    aSketch->ncents = 0;
+    aSketch->nbuf = 0;
+    cur = items[0];
+    wSoFar = 0.0;
+    kLeft = CxpSummarySketchK(0.0);
+    for (i = 1; i < nitems; i++) {
+	w = cur.weight + items[i].weight;
+	if (CxpSummarySketchK((wSoFar + w) / aSketch->weight) - kLeft <= 1.0) {
+	    cur.mean += (items[i].mean - cur.mean) * items[i].weight / w;
+	    cur.weight = w;
+	} else {
+	    CxmAssert(aSketch->ncents < CxmSummaryCentroidsMax - 1);
+	    aSketch->cents[aSketch->ncents] = cur;
+	    aSketch->ncents++;
+	    wSoFar += cur.weight;
+	    kLeft = CxpSummarySketchK(wSoFar / aSketch->weight);
+	    cur = items[i];
+	}
+    }
+    aSketch->cents[aSketch->ncents] = cur;
+    aSketch->ncents++;
+}
+
+static void
+CxpSummarySketchAddCentroid(CxtSummarySketch *aSketch, double aMean,
+  double aWeight) {
+    if (aSketch->nbuf == CxmSummaryBufMax) {
+	CxpSummarySketchCompress(aSketch);
+    }
+    aSketch->buf[aSketch->nbuf].mean = aMean;
+    aSketch->buf[aSketch->nbuf].weight = aWeight;
+    aSketch->nbuf++;
+    aSketch->weight += aWeight;
+}
+
+static void
+CxpSummarySketchAdd(CxtSummarySketch *aSketch, double aVal) {
+    if (aVal < aSketch->min) {
+	aSketch->min = aVal;
+    }
+    if (aVal > aSketch->max) {
+	aSketch->max = aVal;
+    }
+    CxpSummarySketchAddCentroid(aSketch, aVal, 1.0);
+}
+
+static void
+CxpSummarySketchMerge(CxtSummarySketch *aDst, CxtSummarySketch *aSrc) {
+    unsigned i;
+
+    CxpSummarySketchCompress(aSrc);
+    if (aSrc->min < aDst->min) {
+	aDst->min = aSrc->min;
+    }
+    if (aSrc->max > aDst->max) {
+	aDst->max = aSrc->max;
+    }
+    for (i = 0; i < aSrc->ncents; i++) {
+	CxpSummarySketchAddCentroid(aDst, aSrc->cents[i].mean,
+	  aSrc->cents[i].weight);
+    }
+}
+
+// Estimate the aQ quantile.  Each centroid's mean is placed at the center of
+// its weight, and values are linearly interpolated between adjacent centroids
+// (or the extreme values).
+static double
+CxpSummarySketchQuantile(CxtSummarySketch *aSketch, double aQ) {
+    double pos, t, tNext;
+    unsigned i;
+
+    CxpSummarySketchCompress(aSketch);
+    CxmAssert(aSketch->ncents > 0);
+
+    pos = aQ * aSketch->weight;
+    t = aSketch->cents[0].weight / 2.0;
+    if (pos <= t) {
+	if (t == 0.0) {
+	    return aSketch->min;
+	}
+	return aSketch->min + (aSketch->cents[0].mean - aSketch->min) * pos / t;
+    }
+    for (i = 0; i + 1 < aSketch->ncents; i++) {
+	tNext = t + (aSketch->cents[i].weight + aSketch->cents[i+1].weight)
+	  / 2.0;
+	if (pos <= tNext) {
+	    return aSketch->cents[i].mean + (aSketch->cents[i+1].mean
+	      - aSketch->cents[i].mean) * (pos - t) / (tNext - t);
+	}
+	t = tNext;
+    }
+    tNext = aSketch->weight;
+    if (pos >= tNext) {
+	return aSketch->max;
+    }
+    return aSketch->cents[i].mean + (aSketch->max - aSketch->cents[i].mean)
+      * (pos - t) / (tNext - t);
+}
+
+// Estimate the proportion of values that are no greater than aVal; the inverse
+// of CxpSummarySketchQuantile().
+static double
+CxpSummarySketchCdf(CxtSummarySketch *aSketch, double aVal) {
+    double t, tNext, lo, hi;
+    unsigned i;
+
+    CxpSummarySketchCompress(aSketch);
+    CxmAssert(aSketch->ncents > 0);
+
+    if (aVal < aSketch->min) {
+	return 0.0;
+    }
+    if (aVal >= aSketch->max) {
+	return 1.0;
+    }
+
+    t = 0.0;
+    lo = aSketch->min;
+    for (i = 0; i <= aSketch->ncents; i++) {
+	if (i < aSketch->ncents) {
+	    tNext = t + ((i == 0) ? 0.0 : aSketch->cents[i-1].weight / 2.0)
+	      + aSketch->cents[i].weight / 2.0;
+	    hi = aSketch->cents[i].mean;
+	} else {
+	    tNext = aSketch->weight;
+	    hi = aSketch->max;
+	}
+	if (aVal < hi) {
+	    return (t + (tNext - t) * (aVal - lo) / (hi - lo))
+	      / aSketch->weight;
+	}
+	t = tNext;
+	lo = hi;
+    }
+
+    return 1.0;
+}
+
+//==============================================================================
+// Summaries.
+
+bool
+CxSummaryNew(CxtSummary *aSumm, unsigned aNruns, unsigned aNBits,
+  unsigned aNParms, uint64_t aFirst) {
+    unsigned i;
+
+    aSumm->nruns = aNruns;
+    aSumm->nBits = aNBits;
+    aSumm->nWords = CxmBipartNWords(aNBits);
+    aSumm->nParms = aNParms;
+    aSumm->first = aFirst;
+    aSumm->splitWords = NULL;
+    aSumm->nobs = NULL;
+    aSumm->lens = NULL;
+    aSumm->nsplits = 0;
+    aSumm->maxSplits = 0;
+    aSumm->moments = NULL;
+    aSumm->sketches = NULL;
+    aSumm->nsamps = NULL;
+
+    if (CxBipartTabNew(&aSumm->tab, aSumm->nWords)) {
+	return true;
+    }
+    aSumm->moments = (CxtSummaryMoments *)calloc(aNruns * aNParms,
+      sizeof(CxtSummaryMoments));
+    aSumm->sketches = (CxtSummarySketch *)malloc(aNruns * aNParms
+      * sizeof(CxtSummarySketch));
+    aSumm->nsamps = (uint64_t *)calloc(aNruns, sizeof(uint64_t));
+    if (aSumm->moments == NULL || aSumm->sketches == NULL
+      || aSumm->nsamps == NULL) {
+	CxSummaryDelete(aSumm);
+	return true;
+    }
+    for (i = 0; i < aNruns * aNParms; i++) {
+	CxpSummarySketchInit(&aSumm->sketches[i]);
+    }
+
+    return false;
+}
+
+void
+CxSummaryDelete(CxtSummary *aSumm) {
+    uint64_t i;
+
+    CxBipartTabDelete(&aSumm->tab);
+    for (i = 0; i < aSumm->nsplits; i++) {
+	free(aSumm->splitWords[i]);
+    }
+    if (aSumm->splitWords != NULL) {
+	free(aSumm->splitWords);
+	aSumm->splitWords = NULL;
+    }
+    if (aSumm->nobs != NULL) {
+	free(aSumm->nobs);
+	aSumm->nobs = NULL;
+    }
+    if (aSumm->lens != NULL) {
+	free(aSumm->lens);
+	aSumm->lens = NULL;
+    }
+    aSumm->nsplits = 0;
+    aSumm->maxSplits = 0;
+
+    if (aSumm->moments != NULL) {
+	free(aSumm->moments);
+	aSumm->moments = NULL;
+    }
+    if (aSumm->sketches != NULL) {
+	free(aSumm->sketches);
+	aSumm->sketches = NULL;
+    }
+    if (aSumm->nsamps != NULL) {
+	free(aSumm->nsamps);
+	aSumm->nsamps = NULL;
+    }
+}
+
+// Add a new split, with a copy of aWords as its bit vector.  Return true on
+// memory allocation failure.
+static bool
+CxpSummarySplitNew(CxtSummary *aSumm, const uint64_t *aWords) {
+    uint64_t *words;
+
+    if (aSumm->nsplits == aSumm->maxSplits) {
+	uint64_t maxSplits;
+	uint64_t **splitWords;
+	uint64_t *nobs;
+	CxtSummaryMoments *lens;
+
+	maxSplits = (aSumm->maxSplits == 0) ? CxmSummaryMaxMin
+	  : aSumm->maxSplits << 1;
+	splitWords = (uint64_t **)realloc(aSumm->splitWords,
+	  maxSplits * sizeof(uint64_t *));
+	if (splitWords == NULL) {
+	    return true;
+	}
+	aSumm->splitWords = splitWords;
+	nobs = (uint64_t *)realloc(aSumm->nobs,
+	  maxSplits * aSumm->nruns * sizeof(uint64_t));
+	if (nobs == NULL) {
+	    return true;
+	}
+	aSumm->nobs = nobs;
+	lens = (CxtSummaryMoments *)realloc(aSumm->lens,
+	  maxSplits * sizeof(CxtSummaryMoments));
+	if (lens == NULL) {
+	    return true;
+	}
+	aSumm->lens = lens;
+	aSumm->maxSplits = maxSplits;
+    }
+
+    words = (uint64_t *)malloc(aSumm->nWords * sizeof(uint64_t));
+    if (words == NULL) {
+	return true;
+    }
+    memcpy(words, aWords, aSumm->nWords * sizeof(uint64_t));
+    aSumm->splitWords[aSumm->nsplits] = words;
+    memset(&aSumm->nobs[aSumm->nsplits * aSumm->nruns], 0,
+      aSumm->nruns * sizeof(uint64_t));
+    memset(&aSumm->lens[aSumm->nsplits], 0, sizeof(CxtSummaryMoments));
+    aSumm->nsplits++;
+
+    return false;
+}
+
+bool
+CxSummarySplit(CxtSummary *aSumm, unsigned aRun, uint64_t aHash,
+  const uint64_t *aWords, double aLen) {
+    uint64_t split;
+
+    CxmAssert(aRun < aSumm->nruns);
+
+    // The table must only reference owned bit vectors, so copy aWords before
+    // inserting a new split.
+    if (CxBipartTabSearch(&aSumm->tab, aHash, aWords, &split)) {
+	split = aSumm->nsplits;
+	if (CxpSummarySplitNew(aSumm, aWords)
+	  || CxBipartTabInsert(&aSumm->tab, aHash,
+	  aSumm->splitWords[split], split, &split)) {
+	    return true;
+	}
+    }
+
+    aSumm->nobs[split * aSumm->nruns + aRun]++;
+    CxpSummaryMomentsAdd(&aSumm->lens[split], aLen);
+
+    return false;
+}
+
+void
+CxSummaryParms(CxtSummary *aSumm, unsigned aRun, const double *aParms) {
+    unsigned i, j;
+
+    CxmAssert(aRun < aSumm->nruns);
+
+    for (i = 0; i < aSumm->nParms; i++) {
+	j = aRun * aSumm->nParms + i;
+	CxpSummaryMomentsAdd(&aSumm->moments[j], aParms[i]);
+	CxpSummarySketchAdd(&aSumm->sketches[j], aParms[i]);
+    }
+    aSumm->nsamps[aRun]++;
+}
+
+void
+CxSummarySplitStats(CxtSummary *aSumm, uint64_t aSplit, uint64_t *rNobs,
+  double *rMean, double *rV2Mean, double *rVar) {
+    const CxtSummaryMoments *lens;
+    unsigned r;
+
+    CxmAssert(aSplit < aSumm->nsplits);
+
+    for (r = 0; r < aSumm->nruns; r++) {
+	rNobs[r] = aSumm->nobs[aSplit * aSumm->nruns + r];
+    }
+
+    lens = &aSumm->lens[aSplit];
+    *rMean = lens->mean;
+    *rVar = (lens->n > 0) ? lens->m2 / (double)lens->n : 0.0;
+    *rV2Mean = *rVar + lens->mean * lens->mean;
+}
+
+void
+CxSummaryParmStats(CxtSummary *aSumm, unsigned aParm, double aCvgAlpha,
+  CxtSummaryStats *rStats) {
+    CxtSummaryMoments moments;
+    CxtSummarySketch sketch;
+    unsigned r;
+
+    CxmAssert(aParm < aSumm->nParms);
+
+    memset(&moments, 0, sizeof(moments));
+    CxpSummarySketchInit(&sketch);
+    for (r = 0; r < aSumm->nruns; r++) {
+	CxpSummaryMomentsMerge(&moments,
+	  &aSumm->moments[r * aSumm->nParms + aParm]);
+	CxpSummarySketchMerge(&sketch,
+	  &aSumm->sketches[r * aSumm->nParms + aParm]);
+    }
+    CxmAssert(moments.n > 0);
+
+    rStats->mean = moments.mean;
+    rStats->var = moments.m2 / (double)moments.n;
+    rStats->minCred = CxpSummarySketchQuantile(&sketch, aCvgAlpha / 2.0);
+    rStats->maxCred = CxpSummarySketchQuantile(&sketch,
+      1.0 - aCvgAlpha / 2.0);
+    rStats->med = CxpSummarySketchQuantile(&sketch, 0.5);
+}
+
+double
+CxSummaryRcov(CxtSummary *aSumm, unsigned aParm, double aCvgAlpha) {
+    CxtSummarySketch *sketch;
+    double ret, minVal, maxVal, n, N;
+    unsigned i, j;
+
+    CxmAssert(aParm < aSumm->nParms);
+
+    ret = 0.0;
+    for (i = 0; i < aSumm->nruns; i++) {
+	sketch = &aSumm->sketches[i * aSumm->nParms + aParm];
+	minVal = CxpSummarySketchQuantile(sketch, aCvgAlpha / 2.0);
+	maxVal = CxpSummarySketchQuantile(sketch, 1.0 - aCvgAlpha / 2.0);
+
+	n = 0.0;
+	N = 0.0;
+	for (j = 0; j < aSumm->nruns; j++) {
+	    sketch = &aSumm->sketches[j * aSumm->nParms + aParm];
+	    n += sketch->weight * (CxpSummarySketchCdf(sketch, maxVal)
+	      - CxpSummarySketchCdf(sketch, minVal));
+	    N += sketch->weight;
+	}
+	ret += n / N;
+    }
+
+    return ret / (double)aSumm->nruns;
+}
@@ -0,0 +1,124 @@
+#ifndef CxSummary_h
+#define CxSummary_h
+
+#include "../Cx.h"
+#include "../Tree/CxBipart.h"
+
+// Running first and second moments (Welford's method).
+typedef struct {
+    uint64_t n;
+    double mean;
+    double m2; // Sum of squared deviations from mean.
+} CxtSummaryMoments;
+
+// Quantile sketch compression parameter.  Sketches never hold more than
+// (CxmSummaryDelta + 1) centroids.
+#define CxmSummaryDelta 100
+#define CxmSummaryCentroidsMax (CxmSummaryDelta + 1)
+// Number of values/centroids that are buffered before being merged.
+#define CxmSummaryBufMax 64
+
+typedef struct {
+    double mean;
+    double weight;
+} CxtSummaryCentroid;
+
+// Merging t-digest (Dunning and Ertl), which approximates the distribution of
+// a stream of values in constant space.  Centroids are ordered by mean, and
+// adjacent centroids are merged as long as they span at most one unit of the
+// arcsine scale function, which bounds the number of centroids, and keeps
+// centroids near the tails small (and the tail quantiles accurate).
+typedef struct {
+    CxtSummaryCentroid cents[CxmSummaryCentroidsMax];
+    unsigned ncents;
+    CxtSummaryCentroid buf[CxmSummaryBufMax];
+    unsigned nbuf;
+    double weight; // Total weight of cents and buf.
+    double min;
+    double max;
+} CxtSummarySketch;
+
+// Summary statistics for one parameter, as computed by Crux.Mc3.Post (with
+// approximate quantiles).
+typedef struct {
+    double minCred;
+    double maxCred;
+    double mean;
+    double var;
+    double med;
+} CxtSummaryStats;
+
+// Running summary of the samples taken by the unheated chains of an Mc3 run.
+// Samples are incorporated as they are taken, starting at sample aFirst (as
+// passed to CxSummaryNew()), and storage does not grow with the number of
+// samples: each distinct split has per-run observation counts and moments of
+// the inducing edges' lengths, and each scalar parameter has per-run moments
+// and a quantile sketch.
+typedef struct {
+    unsigned nruns;
+    unsigned nBits;
+    unsigned nWords;
+    unsigned nParms;
+    uint64_t first;
+
+    // Split table, which maps bit vectors to split indices.  splitWords[i] is
+    // the owned bit vector for split i, nobs[i*nruns + run] is the number of
+    // times it was observed in the specified run, and lens[i] holds the
+    // moments of its lengths across all runs.
+    CxtBipartTab tab;
+    uint64_t **splitWords;
+    uint64_t *nobs;
+    CxtSummaryMoments *lens;
+    uint64_t nsplits;
+    uint64_t maxSplits;
+
+    // moments[run*nParms + parm] and sketches[run*nParms + parm] describe
+    // parameter parm for nsamps[run] incorporated samples of run.
+    CxtSummaryMoments *moments;
+    CxtSummarySketch *sketches;
+    uint64_t *nsamps;
+} CxtSummary;
+
+// Initialize an empty summary for aNruns runs, aNBits taxa, and aNParms
+// parameters per sample, which incorporates samples [aFirst..).  Return true
+// on error.
+bool
+CxSummaryNew(CxtSummary *aSumm, unsigned aNruns, unsigned aNBits,
+  unsigned aNParms, uint64_t aFirst);
+
+// Discard aSumm.
+void
+CxSummaryDelete(CxtSummary *aSumm);
+
+// Record that the current sample of run aRun contains the split described by
+// aWords (with Zobrist hash aHash), induced by an edge of length aLen.  Return
+// true on memory allocation failure.
+bool
+CxSummarySplit(CxtSummary *aSumm, unsigned aRun, uint64_t aHash,
+  const uint64_t *aWords, double aLen);
+
+// Incorporate a row of aSumm->nParms parameter values for the current sample
+// of run aRun, which completes the sample.
+void
+CxSummaryParms(CxtSummary *aSumm, unsigned aRun, const double *aParms);
+
+// Compute statistics for split aSplit: per-run observation counts
+// (rNobs[0..nruns)), and the mean, mean of squares, and (population) variance
+// of the lengths of the inducing edges.
+void
+CxSummarySplitStats(CxtSummary *aSumm, uint64_t aSplit, uint64_t *rNobs,
+  double *rMean, double *rV2Mean, double *rVar);
+
+// Compute statistics for parameter aParm, pooled across all runs.  The
+// credibility interval is as defined by aCvgAlpha.
+void
+CxSummaryParmStats(CxtSummary *aSumm, unsigned aParm, double aCvgAlpha,
+  CxtSummaryStats *rStats);
+
+// Compute Rcov for parameter aParm, as Crux.Mc3.Post does for lnL, but based
+// on the quantile sketches: the mean (over runs) of the proportion of all
+// samples that lie within each run's aCvgAlpha credibility interval.
+double
+CxSummaryRcov(CxtSummary *aSumm, unsigned aParm, double aCvgAlpha);
+
+#endif // CxSummary_h
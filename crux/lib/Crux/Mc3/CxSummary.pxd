@@ -0,0 +1,48 @@
+from libc cimport uint64_t
+from CxBipart cimport CxtBipartTab
+
+cdef extern from "CxSummary.h":
+    ctypedef struct CxtSummaryMoments:
+        uint64_t n
+        double mean
+        double m2
+    ctypedef struct CxtSummarySketch:
+        unsigned ncents
+        unsigned nbuf
+        double weight
+        double min
+        double max
+    ctypedef struct CxtSummaryStats:
+        double minCred
+        double maxCred
+        double mean
+        double var
+        double med
+    ctypedef struct CxtSummary:
+        unsigned nruns
+        unsigned nBits
+        unsigned nWords
+        unsigned nParms
+        uint64_t first
+        CxtBipartTab tab
+        uint64_t **splitWords
+        uint64_t *nobs
+        CxtSummaryMoments *lens
+        uint64_t nsplits
+        uint64_t maxSplits
+        CxtSummaryMoments *moments
+        CxtSummarySketch *sketches
+        uint64_t *nsamps
+
+    cdef bint CxSummaryNew(CxtSummary *aSumm, unsigned aNruns, \
+      unsigned aNBits, unsigned aNParms, uint64_t aFirst)
+    cdef void CxSummaryDelete(CxtSummary *aSumm)
+    cdef bint CxSummarySplit(CxtSummary *aSumm, unsigned aRun, \
+      uint64_t aHash, uint64_t *aWords, double aLen)
+    cdef void CxSummaryParms(CxtSummary *aSumm, unsigned aRun, double *aParms)
+    cdef void CxSummarySplitStats(CxtSummary *aSumm, uint64_t aSplit, \
+      uint64_t *rNobs, double *rMean, double *rV2Mean, double *rVar)
+    cdef void CxSummaryParmStats(CxtSummary *aSumm, unsigned aParm, \
+      double aCvgAlpha, CxtSummaryStats *rStats)
+    cdef double CxSummaryRcov(CxtSummary *aSumm, unsigned aParm, \
+      double aCvgAlpha)
@@ -0,0 +1,378 @@
+#define CxBipart_c
+#include "CxBipart.h"
+#include "../CxJobs.h"
+
+// Initial number of table entries; must be a power of 2.
+#define CxmBipartTabNentsMin 1024
+
+// Context for CxBipartRfMatrix() jobs.
+typedef struct {
+    unsigned ntrees;
+    unsigned ntaxa;
+    const uint64_t *treeOffs;
+
+    // For each distinct split u, lists[listOffs[u]..listOffs[u+1]) is the
+    // ordered list of trees that contain u.
+    uint64_t nuniq;
+    const uint64_t *listOffs;
+    const unsigned *lists;
+
+    // Shared split counts, in the same layout as dists.
+    uint32_t *shared;
+    float *dists;
+
+    unsigned njobs;
+} CxtBipartRfCtx;
+
+uint64_t
+CxBipartKeysAll(unsigned aNBits) {
+    uint64_t ret;
+    unsigned i;
+
+    ret = 0;
+    for (i = 0; i < aNBits; i++) {
+	ret ^= CxBipartKey(i);
+    }
+
+    return ret;
+}
+
+uint64_t
+CxBipartMerge(uint64_t *aDst, const uint64_t *aSrc, unsigned aNWords) {
+    uint64_t ret, added;
+    unsigned i, pos;
+
+    ret = 0;
+    for (i = 0; i < aNWords; i++) {
+	added = aSrc[i] & ~aDst[i];
+	aDst[i] |= added;
+	// Iterate over newly set bits, from most to least significant.
+	while (added != 0) {
+#ifdef __GNUC__
+	    pos = (unsigned)__builtin_clzll(added);
+#else
+	    for (pos = 0; (added & (0x8000000000000000ULL >> pos)) == 0;
+	      pos++) {
+		// Do nothing.
+	    }
+#endif
+	    ret ^= CxBipartKey((i << 6) + pos);
+	    added &= ~(0x8000000000000000ULL >> pos);
+	}
+    }
+
+    return ret;
+}
+
+void
+CxBipartInvert(uint64_t *aWords, unsigned aNBits) {
+    unsigned i, nWords;
+
+    nWords = CxmBipartNWords(aNBits);
+    for (i = 0; i < nWords; i++) {
+	aWords[i] = ~aWords[i];
+    }
+
+    // Clear trailing bits in order to allow word-wise comparison.
+    if ((aNBits & 0x3f) != 0) {
+	aWords[nWords - 1] &= ~(0xffffffffffffffffULL >> (aNBits & 0x3f));
+    }
+}
+
+void
+CxBipartSubtrees(uint32_t aNNodes, const uint32_t *aParents,
+  const uint32_t *aBits, unsigned aNWords, uint64_t *rWords,
+  uint64_t *rHashes) {
+    uint32_t i, bit;
+    uint64_t *words;
+
+    memset(rWords, 0, aNNodes * aNWords * sizeof(uint64_t));
+    memset(rHashes, 0, aNNodes * sizeof(uint64_t));
+    for (i = aNNodes; i-- > 0;) {
+	words = &rWords[i * aNWords];
+	bit = aBits[i];
+	if (bit != CxmBipartNone
+	  && (words[bit >> 6] & CxBipartMask(bit)) == 0) {
+	    words[bit >> 6] |= CxBipartMask(bit);
+	    rHashes[i] ^= CxBipartKey(bit);
+	}
+	if (i != 0) {
+	    // Merge into the parent, which has a lower index, and is therefore
+	    // not yet complete.
+	    rHashes[aParents[i]] ^= CxBipartMerge(
+	      &rWords[aParents[i] * aNWords], words, aNWords);
+	}
+    }
+}
+
+void
+CxBipartNormalize(uint64_t *aWords, uint64_t *arHash, unsigned aNBits,
+  uint64_t aKeysAll) {
+    if (aNBits > 0 && (aWords[0] & CxBipartMask(0))) {
+	CxBipartInvert(aWords, aNBits);
+	*arHash ^= aKeysAll;
+    }
+}
+
+static bool
+CxpBipartTabAlloc(CxtBipartTab *aTab, uint64_t aNents) {
+    aTab->ents = (CxtBipartTabEnt *)calloc(aNents, sizeof(CxtBipartTabEnt));
+    if (aTab->ents == NULL) {
+	return true;
+    }
+    aTab->nents = aNents;
+
+    return false;
+}
+
+// Find the entry for aWords, or the empty entry at which it would be inserted.
+CxmpInline CxtBipartTabEnt *
+CxpBipartTabLookup(CxtBipartTab *aTab, uint64_t aHash,
+  const uint64_t *aWords) {
+    CxtBipartTabEnt *ent;
+    uint64_t mask, i;
+
+    mask = aTab->nents - 1;
+    for (i = aHash & mask;; i = (i + 1) & mask) {
+	ent = &aTab->ents[i];
+	if (ent->words == NULL || (ent->hash == aHash
+	  && CxBipartCmp(ent->words, aWords, aTab->nWords) == 0)) {
+	    return ent;
+	}
+    }
+}
+
+// Double the number of entries and rehash.
+static bool
+CxpBipartTabGrow(CxtBipartTab *aTab) {
+    CxtBipartTabEnt *oldEnts;
+    uint64_t oldNents, i;
+
+    oldEnts = aTab->ents;
+    oldNents = aTab->nents;
+    if (CxpBipartTabAlloc(aTab, oldNents << 1)) {
+	aTab->ents = oldEnts;
+	return true;
+    }
+    for (i = 0; i < oldNents; i++) {
+	if (oldEnts[i].words != NULL) {
+	    *CxpBipartTabLookup(aTab, oldEnts[i].hash, oldEnts[i].words)
+	      = oldEnts[i];
+	}
+    }
+    free(oldEnts);
+
+    return false;
+}
+
+bool
+CxBipartTabNew(CxtBipartTab *aTab, unsigned aNWords) {
+    aTab->nWords = aNWords;
+    aTab->count = 0;
+
+    return CxpBipartTabAlloc(aTab, CxmBipartTabNentsMin);
+}
+
+void
+CxBipartTabDelete(CxtBipartTab *aTab) {
+    if (aTab->ents != NULL) {
+	free(aTab->ents);
+	aTab->ents = NULL;
+    }
+    aTab->nents = 0;
+    aTab->count = 0;
+}
+
+bool
+CxBipartTabInsert(CxtBipartTab *aTab, uint64_t aHash, const uint64_t *aWords,
+  uint64_t aVal, uint64_t *rVal) {
+    CxtBipartTabEnt *ent;
+
+    ent = CxpBipartTabLookup(aTab, aHash, aWords);
+    if (ent->words == NULL) {
+	// Keep the load factor at or below 1/2.
+	if ((aTab->count + 1) << 1 > aTab->nents) {
+	    if (CxpBipartTabGrow(aTab)) {
+		return true;
+	    }
+	    ent = CxpBipartTabLookup(aTab, aHash, aWords);
+	}
+	ent->hash = aHash;
+	ent->words = aWords;
+	ent->val = aVal;
+	aTab->count++;
+    }
+    *rVal = ent->val;
+
+    return false;
+}
+
+bool
+CxBipartTabSearch(CxtBipartTab *aTab, uint64_t aHash, const uint64_t *aWords,
+  uint64_t *rVal) {
+    CxtBipartTabEnt *ent;
+
+    ent = CxpBipartTabLookup(aTab, aHash, aWords);
+    if (ent->words == NULL) {
+	return true;
+    }
+    *rVal = ent->val;
+
+    return false;
+}
+
+// Compute the index of (x,y) in an upper-triangular n x n matrix, as for
+// nxy2i() in DistMatrix.
+CxmpInline size_t
+CxpBipartNxy2i(size_t aN, size_t aX, size_t aY) {
+    CxmAssert(aX < aY);
+    CxmAssert(aY < aN);
+
+    return aN * aX + aY - (((aX + 3) * aX) >> 1) - 1;
+}
+
+// Job j owns matrix rows {i : i % njobs == j}, so jobs never write the same
+// elements, and rows near the top of the triangle (which are longest) are
+// spread evenly among jobs.
+static void
+CxpBipartRfJob(void *aArg, unsigned aJob) {
+    CxtBipartRfCtx *ctx = (CxtBipartRfCtx *)aArg;
+    uint64_t u, a, b, lo, hi;
+    unsigned i, j, prev;
+    uint64_t lenI, lenJ, s;
+    double fn, fp;
+
+    // Accumulate shared split counts.  A tree may appear more than once in a
+    // list if it contains duplicate splits (i.e. has degree-2 nodes), in
+    // which case the split is only counted as shared once.
+    for (u = 0; u < ctx->nuniq; u++) {
+	lo = ctx->listOffs[u];
+	hi = ctx->listOffs[u + 1];
+	for (a = lo; a < hi; a++) {
+	    i = ctx->lists[a];
+	    if (i % ctx->njobs != aJob || (a > lo && ctx->lists[a - 1] == i)) {
+		continue;
+	    }
+	    prev = i;
+	    for (b = a + 1; b < hi; b++) {
+		j = ctx->lists[b];
+		if (j != prev) {
+		    ctx->shared[CxpBipartNxy2i(ctx->ntrees, i, j)]++;
+		    prev = j;
+		}
+	    }
+	}
+    }
+
+    // Convert counts to distances.
+    for (i = aJob; i < ctx->ntrees; i += ctx->njobs) {
+	lenI = ctx->treeOffs[i + 1] - ctx->treeOffs[i];
+	for (j = i + 1; j < ctx->ntrees; j++) {
+	    size_t x = CxpBipartNxy2i(ctx->ntrees, i, j);
+
+	    lenJ = ctx->treeOffs[j + 1] - ctx->treeOffs[j];
+	    s = ctx->shared[x];
+	    fn = (lenI > ctx->ntaxa)
+	      ? (double)(lenI - s) / (double)(lenI - ctx->ntaxa) : 0.0;
+	    fp = (lenJ > ctx->ntaxa)
+	      ? (double)(lenJ - s) / (double)(lenJ - ctx->ntaxa) : 0.0;
+	    ctx->dists[x] = (float)((fn + fp) / 2.0);
+	}
+    }
+}
+
+bool
+CxBipartRfMatrix(unsigned aNtrees, unsigned aNtaxa, unsigned aNWords,
+  const uint64_t *aHashes, uint64_t **aWords, const uint64_t *aTreeOffs,
+  float *rDists) {
+    bool ret;
+    CxtBipartTab tab;
+    CxtBipartRfCtx ctx;
+    uint64_t nsplits, k, u, *occ, *listOffs;
+    unsigned *lists, i;
+    uint32_t *shared;
+
+    CxmAssert(aNtrees > 1);
+
+    occ = NULL;
+    listOffs = NULL;
+    lists = NULL;
+    shared = NULL;
+    if (CxBipartTabNew(&tab, aNWords)) {
+	return true;
+    }
+
+    // Map each split occurrence to the index of its distinct split.
+    nsplits = aTreeOffs[aNtrees];
+    occ = (uint64_t *)malloc(nsplits * sizeof(uint64_t));
+    if (occ == NULL && nsplits != 0) {
+	goto ERROR;
+    }
+    for (k = 0; k < nsplits; k++) {
+	if (CxBipartTabInsert(&tab, aHashes[k], aWords[k], tab.count,
+	  &occ[k])) {
+	    goto ERROR;
+	}
+    }
+
+    // Build per-split lists of trees.  Trees are visited in order, so the
+    // lists are ordered.
+    listOffs = (uint64_t *)calloc(tab.count + 1, sizeof(uint64_t));
+    lists = (unsigned *)malloc(nsplits * sizeof(unsigned));
+    if (listOffs == NULL || (lists == NULL && nsplits != 0)) {
+	goto ERROR;
+    }
+    for (k = 0; k < nsplits; k++) {
+	listOffs[occ[k] + 1]++;
+    }
+    for (u = 0; u < tab.count; u++) {
+	listOffs[u + 1] += listOffs[u];
+    }
+    for (i = 0; i < aNtrees; i++) {
+	for (k = aTreeOffs[i]; k < aTreeOffs[i + 1]; k++) {
+	    // Use the start offsets as fill cursors, then restore them below.
+	    lists[listOffs[occ[k]]++] = i;
+	}
+    }
+    for (u = tab.count; u > 0; u--) {
+	listOffs[u] = listOffs[u - 1];
+    }
+    listOffs[0] = 0;
+
+    shared = (uint32_t *)calloc(CxpBipartNxy2i(aNtrees, aNtrees - 2,
+      aNtrees - 1) + 1, sizeof(uint32_t));
+    if (shared == NULL) {
+	goto ERROR;
+    }
+
+    ctx.ntrees = aNtrees;
+    ctx.ntaxa = aNtaxa;
+    ctx.treeOffs = aTreeOffs;
+    ctx.nuniq = tab.count;
+    ctx.listOffs = listOffs;
+    ctx.lists = lists;
+    ctx.shared = shared;
+    ctx.dists = rDists;
+    ctx.njobs = CxJobsCount(aNtrees, 1);
+    CxJobsExecute(CxpBipartRfJob, &ctx, ctx.njobs);
+
+    ret = false;
+    goto RETURN;
+    ERROR:
+    ret = true;
+    RETURN:
+    if (shared != NULL) {
+	free(shared);
+    }
+    if (lists != NULL) {
+	free(lists);
+    }
+    if (listOffs != NULL) {
+	free(listOffs);
+    }
+    if (occ != NULL) {
+	free(occ);
+    }
+    CxBipartTabDelete(&tab);
+    return ret;
+}
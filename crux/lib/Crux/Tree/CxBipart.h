@@ -0,0 +1,197 @@
+#ifndef CxBipart_h
+#define CxBipart_h
+
+#include "../Cx.h"
+
+// Bit vectors are stored as vectors of 64-bit words.  Bit i is stored in word
+// (i >> 6), at bit position (63 - (i & 0x3f)), so that comparing words in
+// order, as unsigned integers, yields the same ordering as comparing bits in
+// order.  Trailing bits in the last word are always clear.
+#define CxmBipartNWords(aNBits) (((aNBits) + 63) >> 6)
+
+// Bit index for nodes that have no taxon (see CxBipartSubtrees()).
+#define CxmBipartNone 0xffffffffU
+
+#ifndef CxmUseInlines
+uint64_t
+CxBipartKey(unsigned aBit);
+uint64_t
+CxBipartMask(unsigned aBit);
+unsigned
+CxBipartPopcount(const uint64_t *aWords, unsigned aNWords);
+int
+CxBipartCmp(const uint64_t *aA, const uint64_t *aB, unsigned aNWords);
+void
+CxBipartFpAdd(uint64_t *aFp, uint64_t aHash);
+#endif
+
+#if (defined(CxmUseInlines) || defined(CxBipart_c))
+// Get the Zobrist key for aBit.  Keys are fixed pseudo-random values (the
+// splitmix64 finalizer applied to the bit index), so that hashes are
+// reproducible across processes.  The hash of a bit vector is the XOR of the
+// keys for all of its set bits, which makes it possible to incrementally
+// compute the hash of a union of disjoint sets, or of a complement.
+CxmInline uint64_t
+CxBipartKey(unsigned aBit) {
+    uint64_t z;
+
+    z = ((uint64_t)aBit + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Get the mask for aBit within word (aBit >> 6).
+CxmInline uint64_t
+CxBipartMask(unsigned aBit) {
+    return 0x8000000000000000ULL >> (aBit & 0x3f);
+}
+
+// Count the number of set bits.
+CxmInline unsigned
+CxBipartPopcount(const uint64_t *aWords, unsigned aNWords) {
+    unsigned ret, i;
+
+    ret = 0;
+    for (i = 0; i < aNWords; i++) {
+#ifdef __GNUC__
+	ret += __builtin_popcountll(aWords[i]);
+#else
+	uint64_t x = aWords[i];
+
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	ret += (unsigned)((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    return ret;
+}
+
+// Perform ordered comparison of two bit vectors.  Return -1, 0, or 1.
+CxmInline int
+CxBipartCmp(const uint64_t *aA, const uint64_t *aB, unsigned aNWords) {
+    unsigned i;
+
+    for (i = 0; i < aNWords; i++) {
+	if (aA[i] != aB[i]) {
+	    return (aA[i] < aB[i]) ? -1 : 1;
+	}
+    }
+
+    return 0;
+}
+
+// Add split hash aHash to the 128-bit topology fingerprint aFp[0..1].  Each
+// half accumulates (by addition modulo 2^64) a differently remixed copy of
+// aHash, so the fingerprint does not depend on the order in which splits are
+// added, and is not a linear function of the (XOR-linear) Zobrist hashes.
+CxmInline void
+CxBipartFpAdd(uint64_t *aFp, uint64_t aHash) {
+    uint64_t z;
+
+    // MurmurHash3 finalizer.
+    z = aHash;
+    z = (z ^ (z >> 33)) * 0xff51afd7ed558ccdULL;
+    z = (z ^ (z >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+    aFp[0] += z ^ (z >> 33);
+
+    // splitmix64 finalizer, applied to a rotated copy.
+    z = (aHash << 29) | (aHash >> 35);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    aFp[1] += z ^ (z >> 31);
+}
+#endif
+
+// Compute the XOR of the keys for bits [0..aNBits).
+uint64_t
+CxBipartKeysAll(unsigned aNBits);
+
+// Merge aSrc into aDst (bitwise union), and return the XOR of the keys for
+// all bits that were set in aSrc but not in aDst.  The result can be XORed
+// into the hash for aDst to keep it current.
+uint64_t
+CxBipartMerge(uint64_t *aDst, const uint64_t *aSrc, unsigned aNWords);
+
+// Complement the aNBits-bit vector aWords, keeping trailing bits clear.
+void
+CxBipartInvert(uint64_t *aWords, unsigned aNBits);
+
+// Compute the subtree bit vectors of an aNNodes-node tree, from the leaves
+// up.  Nodes are numbered in preorder, so that aParents[i] < i for all i > 0.
+// aBits[i] is the bit index of node i's taxon, or CxmBipartNone.  Node i's
+// subtree vector is stored in rWords[i*aNWords..(i+1)*aNWords), and its
+// Zobrist hash in rHashes[i].  This is the traversal that Splits and
+// CxNewickSplitsCompute() share.
+void
+CxBipartSubtrees(uint32_t aNNodes, const uint32_t *aParents,
+  const uint32_t *aBits, unsigned aNWords, uint64_t *rWords,
+  uint64_t *rHashes);
+
+// Normalize the aNBits-bit split aWords so that bit 0 is clear, and keep its
+// hash, *arHash, current.  aKeysAll is CxBipartKeysAll(aNBits).
+void
+CxBipartNormalize(uint64_t *aWords, uint64_t *arHash, unsigned aNBits,
+  uint64_t aKeysAll);
+
+// Split table entry.  words is NULL for empty entries.
+typedef struct {
+    uint64_t hash;
+    const uint64_t *words;
+    uint64_t val;
+} CxtBipartTabEnt;
+
+// Open addressing (linear probing) hash table that maps bit vectors to
+// integer values, typically indices into an array of per-split statistics.
+// The table does not copy bit vectors, so the caller must keep inserted
+// vectors alive and unmodified for the lifetime of the table.  Hashes are
+// compared before the vectors themselves, and keys are presumed to be
+// well-mixed (as Zobrist hashes are), so low-order hash bits are used
+// directly to choose slots.
+typedef struct {
+    unsigned nWords;
+    CxtBipartTabEnt *ents;
+    uint64_t nents; // Power of 2.
+    uint64_t count;
+} CxtBipartTab;
+
+// Initialize an empty table for aNWords-word bit vectors.  Return true on
+// error.
+bool
+CxBipartTabNew(CxtBipartTab *aTab, unsigned aNWords);
+
+// Discard aTab.
+void
+CxBipartTabDelete(CxtBipartTab *aTab);
+
+// Look up aWords (with hash aHash).  If it is not yet in the table, insert it
+// with value aVal.  Either way, store the associated value in *rVal.  Return
+// true on error (memory allocation failure).
+bool
+CxBipartTabInsert(CxtBipartTab *aTab, uint64_t aHash, const uint64_t *aWords,
+  uint64_t aVal, uint64_t *rVal);
+
+// Look up aWords (with hash aHash), and store its associated value in *rVal.
+// Return true if not found.
+bool
+CxBipartTabSearch(CxtBipartTab *aTab, uint64_t aHash, const uint64_t *aWords,
+  uint64_t *rVal);
+
+// Compute all-pairs Robinson-Foulds distances (as defined for
+// Bipart.rfDist()) among aNtrees trees on aNtaxa taxa, HashRF-style: every
+// split of every tree is hashed once into a shared table, which yields, for
+// each distinct split, the list of trees that contain it; shared split counts
+// are then accumulated for all pairs of trees in each list.  The splits of
+// tree i are described by aHashes[aTreeOffs[i]..aTreeOffs[i+1]) and the
+// corresponding aNWords-word bit vectors in aWords.  Distances are stored in
+// rDists, in the upper-triangular layout used by DistMatrix.  Pairs are
+// processed in parallel if thread parallelism is enabled.  Return true on
+// memory allocation failure.
+bool
+CxBipartRfMatrix(unsigned aNtrees, unsigned aNtaxa, unsigned aNWords,
+  const uint64_t *aHashes, uint64_t **aWords, const uint64_t *aTreeOffs,
+  float *rDists);
+
+#endif // CxBipart_h
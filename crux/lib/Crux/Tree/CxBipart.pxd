@@ -0,0 +1,41 @@
+from libc cimport uint32_t, uint64_t
+
+cdef extern from "CxBipart.h":
+    cdef unsigned CxmBipartNWords(unsigned aNBits)
+    cdef enum:
+        CxmBipartNone
+
+    cdef inline uint64_t CxBipartKey(unsigned aBit)
+    cdef inline uint64_t CxBipartMask(unsigned aBit)
+    cdef inline unsigned CxBipartPopcount(uint64_t *aWords, unsigned aNWords)
+    cdef inline int CxBipartCmp(uint64_t *aA, uint64_t *aB, unsigned aNWords)
+    cdef inline void CxBipartFpAdd(uint64_t *aFp, uint64_t aHash)
+    cdef uint64_t CxBipartKeysAll(unsigned aNBits)
+    cdef uint64_t CxBipartMerge(uint64_t *aDst, uint64_t *aSrc, \
+      unsigned aNWords)
+    cdef void CxBipartInvert(uint64_t *aWords, unsigned aNBits)
+    cdef void CxBipartSubtrees(uint32_t aNNodes, uint32_t *aParents, \
+      uint32_t *aBits, unsigned aNWords, uint64_t *rWords, uint64_t *rHashes)
+    cdef void CxBipartNormalize(uint64_t *aWords, uint64_t *arHash, \
+      unsigned aNBits, uint64_t aKeysAll)
+
+    ctypedef struct CxtBipartTabEnt:
+        uint64_t hash
+        uint64_t *words
+        uint64_t val
+    ctypedef struct CxtBipartTab:
+        unsigned nWords
+        CxtBipartTabEnt *ents
+        uint64_t nents
+        uint64_t count
+
+    cdef bint CxBipartTabNew(CxtBipartTab *aTab, unsigned aNWords)
+    cdef void CxBipartTabDelete(CxtBipartTab *aTab)
+    cdef bint CxBipartTabInsert(CxtBipartTab *aTab, uint64_t aHash, \
+      uint64_t *aWords, uint64_t aVal, uint64_t *rVal)
+    cdef bint CxBipartTabSearch(CxtBipartTab *aTab, uint64_t aHash, \
+      uint64_t *aWords, uint64_t *rVal)
+
+    cdef bint CxBipartRfMatrix(unsigned aNtrees, unsigned aNtaxa, \
+      unsigned aNWords, uint64_t *aHashes, uint64_t **aWords, \
+      uint64_t *aTreeOffs, float *rDists)
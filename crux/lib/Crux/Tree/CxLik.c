@@ -16,6 +16,7 @@ typedef struct {
 typedef struct {
     CxtLik *lik;
     unsigned stripe;
+    uint64_t npmats; // Set by the worker: P matrices computed for stripe.
 } CxtLikMsg;
 
 // Thread initialization control variable.
@@ -33,6 +34,8 @@ static CxtLikWorkerCtx *CxpLikThreads;
 static CxtMq CxpLikTodoMq;
 static CxtMq CxpLikDoneMq;
 
+CxtLikStats CxLikStats;
+
 CxmpInline unsigned
 CxpLikNxy2i(unsigned n, unsigned x, unsigned y) {
     CxmAssert(x < n);
@@ -291,7 +294,8 @@ CxLikPt(int n, double *P, double *qEigVecCube, double *qEigVals, double v) {
 #endif
 }
 
-CxmpInline void
+// Return the number of P matrices computed.
+CxmpInline uint64_t
 CxLikExecuteStripeDna(CxtLik *lik, unsigned stripe) {
     unsigned dim = lik->dim;
     unsigned dimSq = dim * dim;
@@ -301,6 +305,7 @@ CxLikExecuteStripeDna(CxtLik *lik, unsigned stripe) {
     unsigned cLim = cMin + lik->stripeWidth;
     double P[ncomp][dimSq];
     double scale[cLim-cMin];
+    uint64_t npmats = 0;
 
     CxmAssert(dim == 4);
 
@@ -343,6 +348,7 @@ CxLikExecuteStripeDna(CxtLik *lik, unsigned stripe) {
 #endif
 		CxLikPt(dim, P[mc], model->qEigVecCube, model->qEigVals,
 		  step->edgeLen * comp->cmult * model->rmult * lik->wNorm);
+		npmats++;
 	    }
 	}
 
@@ -630,9 +636,12 @@ CxLikExecuteStripeDna(CxtLik *lik, unsigned stripe) {
 	stripeLnL += lnL;
     }
     lik->stripeLnL[stripe] = stripeLnL;
+
+    return npmats;
 }
 
-static void
+// Return the number of P matrices computed.
+static uint64_t
 CxLikExecuteStripe(CxtLik *lik, unsigned stripe) {
     unsigned dim = lik->dim;
     unsigned dimSq = dim * dim;
@@ -642,6 +651,7 @@ CxLikExecuteStripe(CxtLik *lik, unsigned stripe) {
     unsigned cLim = cMin + lik->stripeWidth;
     double P[ncomp][dimSq];
     double scale[cLim-cMin];
+    uint64_t npmats = 0;
 
     memset(scale, 0, sizeof(scale));
 
@@ -682,6 +692,7 @@ CxLikExecuteStripe(CxtLik *lik, unsigned stripe) {
 #endif
 		CxLikPt(dim, P[mc], model->qEigVecCube, model->qEigVals,
 		  step->edgeLen * comp->cmult * model->rmult * lik->wNorm);
+		npmats++;
 	    }
 	}
 
@@ -843,6 +854,8 @@ CxLikExecuteStripe(CxtLik *lik, unsigned stripe) {
 	stripeLnL += lnL;
     }
     lik->stripeLnL[stripe] = stripeLnL;
+
+    return npmats;
 }
 
 // Worker thread entry function.
@@ -855,9 +868,9 @@ CxpLikWorker(void *arg) {
     // indicate completion status.
     while (CxMqGet(&CxpLikTodoMq, &msg) == false) {
 	if (msg->lik->dim == 4) {
-	    CxLikExecuteStripeDna(msg->lik, msg->stripe);
+	    msg->npmats = CxLikExecuteStripeDna(msg->lik, msg->stripe);
 	} else {
-	    CxLikExecuteStripe(msg->lik, msg->stripe);
+	    msg->npmats = CxLikExecuteStripe(msg->lik, msg->stripe);
 	}
 	CxMqPut(&CxpLikDoneMq, msg);
     }
@@ -913,7 +926,10 @@ CxpLikThreaded(void) {
 
 void
 CxLikExecute(CxtLik *lik) {
+    uint64_t npmats;
+
     if (lik->stepsLen > 0) {
+	npmats = 0;
 	if (CxNcpus > 1 && lik->nstripes > 1) {
 	    pthread_once(&CxpLikOnce, CxpLikThreaded);
 	}
@@ -942,6 +958,7 @@ CxLikExecute(CxtLik *lik) {
 	    for (; stripe < lik->nstripes; stripe++) {
 		CxMqGet(&CxpLikDoneMq, &msg);
 		CxmAssert(msg->lik == lik);
+		npmats += msg->npmats;
 		msg->stripe = stripe;
 		CxMqPut(&CxpLikTodoMq, msg);
 		ndone++;
@@ -950,19 +967,23 @@ CxLikExecute(CxtLik *lik) {
 	    // Receive remaining status messages.
 	    while (ndone < lik->nstripes) {
 		CxMqGet(&CxpLikDoneMq, &msg);
+		npmats += msg->npmats;
 		ndone++;
 	    }
 	} else {
 	    // No worker threads; do all computations in the main thread.
 	    if (lik->dim == 4) {
 		for (unsigned stripe = 0; stripe < lik->nstripes; stripe++) {
-		    CxLikExecuteStripeDna(lik, stripe);
+		    npmats += CxLikExecuteStripeDna(lik, stripe);
 		}
 	    } else {
 		for (unsigned stripe = 0; stripe < lik->nstripes; stripe++) {
-		    CxLikExecuteStripe(lik, stripe);
+		    npmats += CxLikExecuteStripe(lik, stripe);
 		}
 	    }
 	}
+
+	CxLikStats.nsteps += lik->stepsLen;
+	CxLikStats.npmats += npmats;
     }
 }
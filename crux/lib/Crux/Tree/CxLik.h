@@ -272,6 +272,19 @@ typedef struct {
     unsigned stepsMax;
 } CxtLik;
 
+// Cumulative counts of likelihood computation work, for attributing cost to
+// callers (e.g. Crux.Mc3 proposals) by comparing snapshots.  The counters are
+// only updated by the thread that calls CxLikExecute() or the Lik methods.
+typedef struct {
+    uint64_t nlnL;    // Lik.lnL() calls.
+    uint64_t nsteps;  // Execution plan steps, each of which covers all sites.
+    uint64_t npmats;  // P matrices computed, summed over all data stripes.
+    uint64_t nclones; // Lik.clone() calls.
+    uint64_t nallocs; // Conditional likelihood matrix allocations.
+} CxtLikStats;
+
+extern CxtLikStats CxLikStats;
+
 // Use message queues that have CxNcpus * CxmLikMqMult slots to communicate
 // with worker threads.
 #define CxmLikMqMult 8
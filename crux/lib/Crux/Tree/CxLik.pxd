@@ -77,6 +77,14 @@ cdef extern from "CxLik.h":
         unsigned stepsLen
         unsigned stepsMax
 
+    ctypedef struct CxtLikStats:
+        uint64_t nlnL
+        uint64_t nsteps
+        uint64_t npmats
+        uint64_t nclones
+        uint64_t nallocs
+    cdef CxtLikStats CxLikStats
+
     cdef unsigned CxmLikMqMult
 
     cdef bint CxLikQDecomp(int n, double *RTri, double *PiDiag, \
@@ -0,0 +1,332 @@
+#include "CxSim.h"
+#include "../CxJobs.h"
+
+typedef struct {
+    const CxtSim *sim;
+    sfmt_t **prngs; // One stream per block.
+    uint32_t blockSites;
+    const char *i2c;
+    char *rows;
+    uint64_t rowStride;
+    uint32_t nsites;
+    bool err;
+} CxtSimCtx;
+
+bool
+CxSimNew(CxtSim *aSim, unsigned aDim, unsigned aNcomps, unsigned aNnodes) {
+    unsigned nscratch;
+
+    CxmAssert(aDim > 0 && aDim <= 256);
+    CxmAssert(aNcomps > 0);
+    CxmAssert(aNnodes > 0);
+
+    aSim->dim = aDim;
+    aSim->ncomps = aNcomps;
+    aSim->nnodes = aNnodes;
+    nscratch = (aDim > aNcomps) ? aDim : aNcomps;
+
+    aSim->parents = (uint32_t *)calloc(aNnodes, sizeof(uint32_t));
+    aSim->rows = (int32_t *)malloc(aNnodes * sizeof(int32_t));
+    aSim->compTab = (CxtSimAlias *)malloc(aNcomps * sizeof(CxtSimAlias));
+    aSim->rootTabs = (CxtSimAlias *)malloc(aNcomps * aDim
+      * sizeof(CxtSimAlias));
+    aSim->edgeTabs = (CxtSimAlias *)malloc((size_t)aNnodes * aNcomps * aDim
+      * aDim * sizeof(CxtSimAlias));
+    aSim->q = (double *)malloc(nscratch * sizeof(double));
+    aSim->small = (uint32_t *)malloc(nscratch * sizeof(uint32_t));
+    aSim->large = (uint32_t *)malloc(nscratch * sizeof(uint32_t));
+    if (aSim->parents == NULL || aSim->rows == NULL || aSim->compTab == NULL
+      || aSim->rootTabs == NULL || aSim->edgeTabs == NULL || aSim->q == NULL
+      || aSim->small == NULL || aSim->large == NULL) {
+	CxSimDelete(aSim);
+	return true;
+    }
+    memset(aSim->rows, 0xff, aNnodes * sizeof(int32_t));
+
+    return false;
+}
+
+void
+CxSimDelete(CxtSim *aSim) {
+    if (aSim->parents != NULL) {
+	free(aSim->parents);
+	aSim->parents = NULL;
+    }
+    if (aSim->rows != NULL) {
+	free(aSim->rows);
+	aSim->rows = NULL;
+    }
+    if (aSim->compTab != NULL) {
+	free(aSim->compTab);
+	aSim->compTab = NULL;
+    }
+    if (aSim->rootTabs != NULL) {
+	free(aSim->rootTabs);
+	aSim->rootTabs = NULL;
+    }
+    if (aSim->edgeTabs != NULL) {
+	free(aSim->edgeTabs);
+	aSim->edgeTabs = NULL;
+    }
+    if (aSim->q != NULL) {
+	free(aSim->q);
+	aSim->q = NULL;
+    }
+    if (aSim->small != NULL) {
+	free(aSim->small);
+	aSim->small = NULL;
+    }
+    if (aSim->large != NULL) {
+	free(aSim->large);
+	aSim->large = NULL;
+    }
+}
+
+void
+CxSimNode(CxtSim *aSim, unsigned aNode, uint32_t aParent, int32_t aRow) {
+    CxmAssert(aNode < aSim->nnodes);
+    CxmAssert(aNode == 0 || aParent < aNode);
+
+    aSim->parents[aNode] = aParent;
+    aSim->rows[aNode] = aRow;
+}
+
+// Construct an alias table for the (unnormalized) distribution aP[0..aN),
+// using Vose's algorithm.  Negative values (which CxLikPt() can produce due to
+// rounding error) are treated as 0, and if all values are 0, the distribution
+// is uniform.
+static void
+CxpSimAliasInit(CxtSim *aSim, CxtSimAlias *rTab, const double *aP,
+  unsigned aN) {
+    double *q = aSim->q;
+    uint32_t *small = aSim->small;
+    uint32_t *large = aSim->large;
+    double sum;
+    unsigned i, nsmall, nlarge;
+    uint32_t s, l;
+
+    sum = 0.0;
+    for (i = 0; i < aN; i++) {
+	if (aP[i] > 0.0) {
+	    sum += aP[i];
+	}
+    }
+
+    nsmall = nlarge = 0;
+    for (i = 0; i < aN; i++) {
+	if (sum > 0.0) {
+	    q[i] = (aP[i] > 0.0) ? aP[i] * (double)aN / sum : 0.0;
+	} else {
+	    q[i] = 1.0;
+	}
+	if (q[i] < 1.0) {
+	    small[nsmall++] = i;
+	} else {
+	    large[nlarge++] = i;
+	}
+    }
+
+    while (nsmall > 0 && nlarge > 0) {
+	s = small[--nsmall];
+	l = large[nlarge - 1];
+	// q[s] is in [0..1), so the scaled threshold is in [0..2^32).
+	rTab[s].thresh = (uint32_t)(q[s] * 4294967296.0);
+	rTab[s].alias = l;
+	q[l] = (q[l] + q[s]) - 1.0;
+	if (q[l] < 1.0) {
+	    nlarge--;
+	    small[nsmall++] = l;
+	}
+    }
+
+    // Whatever remains has (up to rounding error) probability 1.
+    while (nlarge > 0) {
+	l = large[--nlarge];
+	rTab[l].thresh = 0;
+	rTab[l].alias = l;
+    }
+    while (nsmall > 0) {
+	s = small[--nsmall];
+	rTab[s].thresh = 0;
+	rTab[s].alias = s;
+    }
+}
+
+// Draw from aTab, using the 64-bit random number aR: the high 32 bits choose
+// the column, and the low 32 bits choose between the column and its alias.
+CxmpInline uint32_t
+CxpSimDraw(const CxtSimAlias *aTab, unsigned aN, uint64_t aR) {
+    uint32_t i;
+
+    i = (uint32_t)(((aR >> 32) * aN) >> 32);
+    return ((uint32_t)aR < aTab[i].thresh) ? i : aTab[i].alias;
+}
+
+void
+CxSimCompWeights(CxtSim *aSim, const double *aWeights) {
+    CxpSimAliasInit(aSim, aSim->compTab, aWeights, aSim->ncomps);
+}
+
+void
+CxSimRootFreqs(CxtSim *aSim, unsigned aComp, const double *aFreqs) {
+    CxmAssert(aComp < aSim->ncomps);
+
+    CxpSimAliasInit(aSim, &aSim->rootTabs[aComp * aSim->dim], aFreqs,
+      aSim->dim);
+}
+
+void
+CxSimEdgeP(CxtSim *aSim, unsigned aNode, unsigned aComp, const double *aP) {
+    CxtSimAlias *tabs;
+    unsigned dim, i;
+
+    CxmAssert(aNode > 0 && aNode < aSim->nnodes);
+    CxmAssert(aComp < aSim->ncomps);
+
+    dim = aSim->dim;
+    tabs = &aSim->edgeTabs[((size_t)aNode * aSim->ncomps + aComp) * dim * dim];
+    for (i = 0; i < dim; i++) {
+	CxpSimAliasInit(aSim, &tabs[i * dim], &aP[i * dim], dim);
+    }
+}
+
+// Simulate sites [aS0..aS0+aNb), using aRands, aComps, and aStates as scratch
+// space.
+static void
+CxpSimChunk(CxtSimCtx *aCtx, sfmt_t *aPrng, uint32_t aS0, uint32_t aNb,
+  uint64_t *aRands, uint32_t *aComps, uint8_t *aStates) {
+    const CxtSim *sim = aCtx->sim;
+    unsigned dim = sim->dim;
+    unsigned ncomps = sim->ncomps;
+    uint8_t *parStates, *nodeStates;
+    const CxtSimAlias *tabs;
+    char *row;
+    uint32_t s, n;
+
+    // Draw site components.
+    if (ncomps == 1) {
+	memset(aComps, 0, aNb * sizeof(uint32_t));
+    } else {
+	fill_gen_rand64(aPrng, aRands, aNb);
+	for (s = 0; s < aNb; s++) {
+	    aComps[s] = CxpSimDraw(sim->compTab, ncomps, aRands[s]);
+	}
+    }
+
+    // Propagate states from the root, in preorder, so that every node's
+    // parent states are available before they are needed.
+    for (n = 0; n < sim->nnodes; n++) {
+	nodeStates = &aStates[(size_t)n * aNb];
+	fill_gen_rand64(aPrng, aRands, aNb);
+	if (n == 0) {
+	    for (s = 0; s < aNb; s++) {
+		nodeStates[s] = (uint8_t)CxpSimDraw(
+		  &sim->rootTabs[aComps[s] * dim], dim, aRands[s]);
+	    }
+	} else {
+	    parStates = &aStates[(size_t)sim->parents[n] * aNb];
+	    tabs = &sim->edgeTabs[(size_t)n * ncomps * dim * dim];
+	    for (s = 0; s < aNb; s++) {
+		nodeStates[s] = (uint8_t)CxpSimDraw(
+		  &tabs[(aComps[s] * dim + parStates[s]) * dim], dim,
+		  aRands[s]);
+	    }
+	}
+
+	if (sim->rows[n] >= 0) {
+	    row = &aCtx->rows[(uint64_t)sim->rows[n] * aCtx->rowStride + aS0];
+	    for (s = 0; s < aNb; s++) {
+		row[s] = aCtx->i2c[nodeStates[s]];
+	    }
+	}
+    }
+}
+
+static void
+CxpSimJob(void *aArg, unsigned aJob) {
+    CxtSimCtx *ctx = (CxtSimCtx *)aArg;
+    uint64_t *rands;
+    uint32_t *comps;
+    uint8_t *states;
+    uint32_t s0, send, nb;
+
+    s0 = aJob * ctx->blockSites;
+    send = ctx->nsites - s0;
+    send = s0 + ((send > ctx->blockSites) ? ctx->blockSites : send);
+
+    // Random numbers are generated in bulk, one per site for each pass over
+    // a chunk.
+    rands = (uint64_t *)malloc(CxmSimChunkSites * sizeof(uint64_t)
+      + CxmSimChunkSites * sizeof(uint32_t)
+      + (size_t)ctx->sim->nnodes * CxmSimChunkSites);
+    if (rands == NULL) {
+	ctx->err = true;
+	return;
+    }
+    comps = (uint32_t *)&rands[CxmSimChunkSites];
+    states = (uint8_t *)&comps[CxmSimChunkSites];
+
+    for (; s0 < send; s0 += nb) {
+	nb = send - s0;
+	if (nb > CxmSimChunkSites) {
+	    nb = CxmSimChunkSites;
+	}
+	CxpSimChunk(ctx, ctx->prngs[aJob], s0, nb, rands, comps, states);
+    }
+
+    free(rands);
+}
+
+bool
+CxSimRun(const CxtSim *aSim, uint32_t aSeed, const char *aI2c, char *rRows,
+  uint64_t aRowStride, uint32_t aNsites) {
+    CxtSimCtx ctx;
+    uint32_t nchunks, nblocks, i;
+
+    if (aNsites == 0) {
+	return false;
+    }
+
+    // Divide the sites into at most CxmSimBlocksMax blocks of whole chunks.
+    // Block i uses the stream that results from jumping ahead i times from
+    // the seeded stream.
+    nchunks = (aNsites + CxmSimChunkSites - 1) / CxmSimChunkSites;
+    nblocks = (nchunks < CxmSimBlocksMax) ? nchunks : CxmSimBlocksMax;
+    ctx.blockSites = ((nchunks + nblocks - 1) / nblocks) * CxmSimChunkSites;
+    nblocks = (aNsites + ctx.blockSites - 1) / ctx.blockSites;
+
+    ctx.prngs = (sfmt_t **)calloc(nblocks, sizeof(sfmt_t *));
+    if (ctx.prngs == NULL) {
+	return true;
+    }
+    ctx.err = false;
+    ctx.prngs[0] = init_gen_rand(aSeed);
+    if (ctx.prngs[0] == NULL) {
+	ctx.err = true;
+	goto RETURN;
+    }
+    for (i = 1; i < nblocks; i++) {
+	ctx.prngs[i] = dup_gen_rand(ctx.prngs[i-1]);
+	if (ctx.prngs[i] == NULL) {
+	    ctx.err = true;
+	    goto RETURN;
+	}
+	jump_gen_rand(ctx.prngs[i]);
+    }
+
+    ctx.sim = aSim;
+    ctx.i2c = aI2c;
+    ctx.rows = rRows;
+    ctx.rowStride = aRowStride;
+    ctx.nsites = aNsites;
+    CxJobsExecute(CxpSimJob, &ctx, nblocks);
+
+    RETURN:
+    for (i = 0; i < nblocks; i++) {
+	if (ctx.prngs[i] != NULL) {
+	    fini_gen_rand(ctx.prngs[i]);
+	}
+    }
+    free(ctx.prngs);
+    return ctx.err;
+}
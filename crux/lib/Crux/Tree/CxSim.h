@@ -0,0 +1,97 @@
+#ifndef CxSim_h
+#define CxSim_h
+
+#include "../Cx.h"
+#include "../../SFMT/SFMT.h"
+
+// Sequence simulation under a Crux.Tree.Lik model.  The tree is flattened to
+// preorder parent links, and every random draw (site mixture component, root
+// state, child state given parent state) is made in O(1) time via a Walker
+// alias table.  Alias tables for the transition probability matrices are
+// precomputed once per (edge, component) pair, so the per-site cost is one
+// PRNG call per node.
+//
+// Sites are divided into blocks, which are simulated in parallel as
+// independent jobs.  All blocks draw from one SFMT generator seeded with
+// aSeed: block i uses the stream that starts 2^128 128-bit words after block
+// (i-1)'s (see jump_gen_rand()), so streams never overlap, and the results
+// depend only on aSeed and the number of sites (not on the number of
+// threads).  Within a block, sites are simulated in fixed-size chunks, which
+// bounds scratch memory.
+
+// Number of sites per chunk.
+#define CxmSimChunkSites 1024
+// Maximum number of blocks (and streams).  Streams are derived serially, and
+// each jump takes on the order of a millisecond, so blocks are made large
+// enough to keep the number of jumps small.
+#define CxmSimBlocksMax 64
+
+// Alias table entry.  Draw a uniform column i, and return i with probability
+// thresh / 2^32, or alias otherwise.  Columns that are chosen with certainty
+// have alias == i.
+typedef struct {
+    uint32_t thresh;
+    uint32_t alias;
+} CxtSimAlias;
+
+typedef struct {
+    unsigned dim; // At most 256.
+    unsigned ncomps;
+    unsigned nnodes;
+
+    // Nodes, in preorder; node 0 is the root.  parents[0] is unused, and
+    // rows[n] is the alignment row for node n, or -1 if n has no taxon.
+    uint32_t *parents;
+    int32_t *rows;
+
+    // Alias tables:
+    //   compTab : ncomps entries, for the site component distribution.
+    //   rootTabs: ncomps tables of dim entries, for the root state
+    //             distribution of each component.
+    //   edgeTabs: (nnodes * ncomps * dim) tables of dim entries, for the child
+    //             state distribution of node n, given component c and parent
+    //             state i, at edgeTabs[((n*ncomps + c)*dim + i) * dim].
+    CxtSimAlias *compTab;
+    CxtSimAlias *rootTabs;
+    CxtSimAlias *edgeTabs;
+
+    // Scratch space for alias table construction.
+    double *q;
+    uint32_t *small;
+    uint32_t *large;
+} CxtSim;
+
+// Initialize aSim for aNnodes nodes, with aDim character states and aNcomps
+// model components.  Return true on error.
+bool
+CxSimNew(CxtSim *aSim, unsigned aDim, unsigned aNcomps, unsigned aNnodes);
+
+// Discard aSim.
+void
+CxSimDelete(CxtSim *aSim);
+
+// Set node aNode's parent (ignored for the root) and alignment row.
+void
+CxSimNode(CxtSim *aSim, unsigned aNode, uint32_t aParent, int32_t aRow);
+
+// Set the component weights, aWeights[0..ncomps).
+void
+CxSimCompWeights(CxtSim *aSim, const double *aWeights);
+
+// Set the root state frequencies for component aComp, aFreqs[0..dim).
+void
+CxSimRootFreqs(CxtSim *aSim, unsigned aComp, const double *aFreqs);
+
+// Set the transition probability matrix (row-major, dim x dim, as computed by
+// CxLikPt()) for the edge that connects aNode to its parent, under component
+// aComp.  Rows need not be normalized.
+void
+CxSimEdgeP(CxtSim *aSim, unsigned aNode, unsigned aComp, const double *aP);
+
+// Simulate aNsites sites, and store the character aI2c[state] for each row
+// node n at rRows[rows[n]*aRowStride + site].  Return true on error.
+bool
+CxSimRun(const CxtSim *aSim, uint32_t aSeed, const char *aI2c, char *rRows,
+  uint64_t aRowStride, uint32_t aNsites);
+
+#endif // CxSim_h
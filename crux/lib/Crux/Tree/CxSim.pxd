@@ -0,0 +1,19 @@
+from libc cimport uint32_t, int32_t, uint64_t
+
+cdef extern from "CxSim.h":
+    ctypedef struct CxtSim:
+        unsigned dim
+        unsigned ncomps
+        unsigned nnodes
+
+    cdef bint CxSimNew(CxtSim *aSim, unsigned aDim, unsigned aNcomps, \
+      unsigned aNnodes)
+    cdef void CxSimDelete(CxtSim *aSim)
+    cdef void CxSimNode(CxtSim *aSim, unsigned aNode, uint32_t aParent, \
+      int32_t aRow)
+    cdef void CxSimCompWeights(CxtSim *aSim, double *aWeights)
+    cdef void CxSimRootFreqs(CxtSim *aSim, unsigned aComp, double *aFreqs)
+    cdef void CxSimEdgeP(CxtSim *aSim, unsigned aNode, unsigned aComp, \
+      double *aP)
+    cdef bint CxSimRun(CxtSim *aSim, uint32_t aSeed, char *aI2c, \
+      char *rRows, uint64_t aRowStride, uint32_t aNsites)
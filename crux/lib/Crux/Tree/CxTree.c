@@ -0,0 +1,383 @@
+#include "CxTree.h"
+
+// Remove aRing from its node's ring list.
+CxmpInline void
+CxpTreeRingRemove(CxtTree *aTree, uint32_t aRing) {
+    uint32_t node, next, prev;
+
+    node = aTree->ringNodes[aRing];
+    CxmAssert(node != CxmTreeNone);
+    next = aTree->ringNext[aRing];
+    if (next == aRing) {
+	aTree->nodeRings[node] = CxmTreeNone;
+    } else {
+	if (aTree->nodeRings[node] == aRing) {
+	    aTree->nodeRings[node] = next;
+	}
+	prev = aTree->ringPrev[aRing];
+	aTree->ringPrev[next] = prev;
+	aTree->ringNext[prev] = next;
+	aTree->ringNext[aRing] = aRing;
+	aTree->ringPrev[aRing] = aRing;
+    }
+    aTree->ringNodes[aRing] = CxmTreeNone;
+}
+
+// Insert detached aRing into aNode's ring list, just before aAt (or as the
+// only ring, if aAt is CxmTreeNone).  The list header is not changed unless
+// the list was empty.
+CxmpInline void
+CxpTreeRingInsert(CxtTree *aTree, uint32_t aRing, uint32_t aNode,
+  uint32_t aAt) {
+    uint32_t prev;
+
+    CxmAssert(aTree->ringNodes[aRing] == CxmTreeNone);
+    if (aAt == CxmTreeNone) {
+	CxmAssert(aTree->nodeRings[aNode] == CxmTreeNone);
+	aTree->ringNext[aRing] = aRing;
+	aTree->ringPrev[aRing] = aRing;
+	aTree->nodeRings[aNode] = aRing;
+    } else {
+	CxmAssert(aTree->ringNodes[aAt] == aNode);
+	prev = aTree->ringPrev[aAt];
+	aTree->ringNext[aRing] = aAt;
+	aTree->ringPrev[aRing] = prev;
+	aTree->ringPrev[aAt] = aRing;
+	aTree->ringNext[prev] = aRing;
+    }
+    aTree->ringNodes[aRing] = aNode;
+}
+
+// Put detached aNew in aOld's place, and detach aOld.
+CxmpInline void
+CxpTreeRingReplace(CxtTree *aTree, uint32_t aOld, uint32_t aNew) {
+    uint32_t node, next;
+    bool head;
+
+    node = aTree->ringNodes[aOld];
+    head = (aTree->nodeRings[node] == aOld);
+    next = aTree->ringNext[aOld];
+    CxpTreeRingRemove(aTree, aOld);
+    CxpTreeRingInsert(aTree, aNew, node, (next == aOld) ? CxmTreeNone : next);
+    if (head) {
+	aTree->nodeRings[node] = aNew;
+    }
+}
+
+bool
+CxTreeNew(CxtTree *aTree, uint32_t aMaxNodes, uint32_t aMaxEdges) {
+    uint32_t maxRings;
+
+    memset(aTree, 0, sizeof(CxtTree));
+    if (aMaxEdges >= (CxmTreeNone >> 1)) {
+	return true;
+    }
+    aTree->maxNodes = aMaxNodes;
+    aTree->maxEdges = aMaxEdges;
+    aTree->base = CxmTreeNone;
+    aTree->cacheSn = (uint64_t)-1;
+    maxRings = aMaxEdges << 1;
+
+    if ((aTree->nodeTaxa = (uint32_t *)malloc((aMaxNodes + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->nodeRings = (uint32_t *)malloc((aMaxNodes + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->lengths = (double *)malloc((aMaxEdges + 1)
+      * sizeof(double))) == NULL
+      || (aTree->ringNodes = (uint32_t *)malloc((maxRings + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->ringNext = (uint32_t *)malloc((maxRings + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->ringPrev = (uint32_t *)malloc((maxRings + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->order = (uint32_t *)malloc((aMaxEdges + 1)
+      * sizeof(uint32_t))) == NULL
+      || (aTree->stack = (uint32_t *)malloc((aMaxEdges + 1)
+      * sizeof(uint32_t))) == NULL) {
+	CxTreeDelete(aTree);
+	return true;
+    }
+
+    return false;
+}
+
+void
+CxTreeDelete(CxtTree *aTree) {
+    if (aTree->nodeTaxa != NULL) {
+	free(aTree->nodeTaxa);
+    }
+    if (aTree->nodeRings != NULL) {
+	free(aTree->nodeRings);
+    }
+    if (aTree->lengths != NULL) {
+	free(aTree->lengths);
+    }
+    if (aTree->ringNodes != NULL) {
+	free(aTree->ringNodes);
+    }
+    if (aTree->ringNext != NULL) {
+	free(aTree->ringNext);
+    }
+    if (aTree->ringPrev != NULL) {
+	free(aTree->ringPrev);
+    }
+    if (aTree->order != NULL) {
+	free(aTree->order);
+    }
+    if (aTree->stack != NULL) {
+	free(aTree->stack);
+    }
+    memset(aTree, 0, sizeof(CxtTree));
+}
+
+void
+CxTreeCopy(CxtTree *aTree, const CxtTree *aOther) {
+    uint32_t nrings;
+
+    CxmAssert(aOther->nnodes <= aTree->maxNodes);
+    CxmAssert(aOther->nedges <= aTree->maxEdges);
+
+    nrings = aOther->nedges << 1;
+    memcpy(aTree->nodeTaxa, aOther->nodeTaxa,
+      aOther->nnodes * sizeof(uint32_t));
+    memcpy(aTree->nodeRings, aOther->nodeRings,
+      aOther->nnodes * sizeof(uint32_t));
+    aTree->nnodes = aOther->nnodes;
+    memcpy(aTree->lengths, aOther->lengths, aOther->nedges * sizeof(double));
+    aTree->nedges = aOther->nedges;
+    memcpy(aTree->ringNodes, aOther->ringNodes, nrings * sizeof(uint32_t));
+    memcpy(aTree->ringNext, aOther->ringNext, nrings * sizeof(uint32_t));
+    memcpy(aTree->ringPrev, aOther->ringPrev, nrings * sizeof(uint32_t));
+    aTree->base = aOther->base;
+
+    // Never let the sequence number move backward, since callers may be
+    // caching derived data.
+    aTree->sn++;
+}
+
+uint32_t
+CxTreeNodeNew(CxtTree *aTree) {
+    uint32_t ret;
+
+    CxmAssert(aTree->nnodes < aTree->maxNodes);
+    ret = aTree->nnodes;
+    aTree->nodeTaxa[ret] = CxmTreeNone;
+    aTree->nodeRings[ret] = CxmTreeNone;
+    aTree->nnodes++;
+    aTree->sn++;
+
+    return ret;
+}
+
+uint32_t
+CxTreeEdgeNew(CxtTree *aTree) {
+    uint32_t ret, r;
+
+    CxmAssert(aTree->nedges < aTree->maxEdges);
+    ret = aTree->nedges;
+    aTree->lengths[ret] = 0.0;
+    for (r = (ret << 1); r <= ((ret << 1) | 1); r++) {
+	aTree->ringNodes[r] = CxmTreeNone;
+	aTree->ringNext[r] = r;
+	aTree->ringPrev[r] = r;
+    }
+    aTree->nedges++;
+    aTree->sn++;
+
+    return ret;
+}
+
+void
+CxTreeEdgeAttach(CxtTree *aTree, uint32_t aEdge, uint32_t aNodeA,
+  uint32_t aNodeB) {
+    uint32_t ring;
+
+    CxmAssert(aEdge < aTree->nedges);
+    CxmAssert(aNodeA != aNodeB);
+
+    ring = aEdge << 1;
+    CxpTreeRingInsert(aTree, ring, aNodeA, aTree->nodeRings[aNodeA]);
+    aTree->nodeRings[aNodeA] = ring;
+
+    ring |= 1;
+    CxpTreeRingInsert(aTree, ring, aNodeB, aTree->nodeRings[aNodeB]);
+    aTree->nodeRings[aNodeB] = ring;
+
+    aTree->sn++;
+}
+
+void
+CxTreeEdgeDetach(CxtTree *aTree, uint32_t aEdge) {
+    CxmAssert(aEdge < aTree->nedges);
+
+    CxpTreeRingRemove(aTree, aEdge << 1);
+    CxpTreeRingRemove(aTree, (aEdge << 1) | 1);
+
+    aTree->sn++;
+}
+
+uint32_t
+CxTreeDegree(const CxtTree *aTree, uint32_t aNode) {
+    uint32_t ret, head, r;
+
+    head = aTree->nodeRings[aNode];
+    if (head == CxmTreeNone) {
+	return 0;
+    }
+    ret = 1;
+    for (r = aTree->ringNext[head]; r != head; r = aTree->ringNext[r]) {
+	ret++;
+    }
+
+    return ret;
+}
+
+void
+CxTreeRecache(CxtTree *aTree) {
+    uint32_t *stack, *order;
+    uint32_t nstack, norder, ntaxa, head, r, c;
+
+    if (aTree->cacheSn == aTree->sn) {
+	return;
+    }
+
+    stack = aTree->stack;
+    order = aTree->order;
+    nstack = norder = ntaxa = 0;
+    if (aTree->base != CxmTreeNone) {
+	if (aTree->nodeTaxa[aTree->base] != CxmTreeNone) {
+	    ntaxa++;
+	}
+	// Push rings in reverse order, so that they are popped in ring order.
+	head = aTree->nodeRings[aTree->base];
+	if (head != CxmTreeNone) {
+	    r = head;
+	    do {
+		r = aTree->ringPrev[r];
+		stack[nstack++] = r;
+	    } while (r != head);
+	}
+	while (nstack > 0) {
+	    c = stack[--nstack] ^ 1;
+	    CxmAssert(norder < aTree->nedges);
+	    order[norder++] = c;
+	    if (aTree->nodeTaxa[aTree->ringNodes[c]] != CxmTreeNone) {
+		ntaxa++;
+	    }
+	    for (r = aTree->ringPrev[c]; r != c; r = aTree->ringPrev[r]) {
+		stack[nstack++] = r;
+	    }
+	}
+    }
+    aTree->norder = norder;
+    aTree->ntaxa = ntaxa;
+
+    aTree->cacheSn = aTree->sn;
+}
+
+bool
+CxTreeInSubtree(CxtTree *aTree, uint32_t aRing, uint32_t aEdge) {
+    uint32_t *stack;
+    uint32_t nstack, r, c;
+
+    if ((aRing >> 1) == aEdge) {
+	return true;
+    }
+
+    stack = aTree->stack;
+    nstack = 0;
+    stack[nstack++] = aRing;
+    while (nstack > 0) {
+	c = stack[--nstack] ^ 1;
+	for (r = aTree->ringNext[c]; r != c; r = aTree->ringNext[r]) {
+	    if ((r >> 1) == aEdge) {
+		return true;
+	    }
+	    stack[nstack++] = r;
+	}
+    }
+
+    return false;
+}
+
+void
+CxTreeNni(CxtTree *aTree, uint32_t aEdge, uint32_t aRingA, uint32_t aRingB) {
+    uint32_t nodeA, next;
+    bool head;
+
+    nodeA = aTree->ringNodes[aRingA];
+    CxmAssert((aRingA >> 1) != aEdge);
+    CxmAssert((aRingB >> 1) != aEdge);
+    CxmAssert((nodeA == aTree->ringNodes[aEdge << 1]
+      && aTree->ringNodes[aRingB] == aTree->ringNodes[(aEdge << 1) | 1])
+      || (nodeA == aTree->ringNodes[(aEdge << 1) | 1]
+      && aTree->ringNodes[aRingB] == aTree->ringNodes[aEdge << 1]));
+
+    // aRingA's list contains at least aRingA and a ring of aEdge, so next is
+    // never aRingA, and remains in place while aRingA is moved.
+    head = (aTree->nodeRings[nodeA] == aRingA);
+    next = aTree->ringNext[aRingA];
+    CxpTreeRingRemove(aTree, aRingA);
+    CxpTreeRingReplace(aTree, aRingB, aRingA);
+    CxpTreeRingInsert(aTree, aRingB, nodeA, next);
+    if (head) {
+	aTree->nodeRings[nodeA] = aRingB;
+    }
+
+    aTree->sn++;
+}
+
+bool
+CxTreeSpr(CxtTree *aTree, uint32_t aRing, uint32_t aEdge) {
+    uint32_t node, rA, rB, rY;
+    bool head;
+
+    node = aTree->ringNodes[aRing];
+    CxmAssert(CxTreeDegree(aTree, node) == 3);
+    CxmAssert(aEdge < aTree->nedges);
+    CxmAssert(aTree->ringNodes[aEdge << 1] != CxmTreeNone);
+    CxmAssert(CxTreeInSubtree(aTree, aRing, aEdge) == false);
+
+    rA = aTree->ringNext[aRing];
+    rB = aTree->ringNext[rA];
+    if ((rA >> 1) == aEdge || (rB >> 1) == aEdge) {
+	return true;
+    }
+
+    // Prune: rA's edge takes the place of rB's edge at the far end of rB's
+    // edge, which leaves rB's edge dangling from node.
+    head = (aTree->nodeRings[node] == rA);
+    CxpTreeRingRemove(aTree, rA);
+    CxpTreeRingReplace(aTree, rB ^ 1, rA);
+
+    // Regraft: rB's edge takes the place of aEdge at one end of aEdge, and
+    // aEdge takes rA's former place at node.
+    rY = (aEdge << 1) | 1;
+    CxpTreeRingReplace(aTree, rY, rB ^ 1);
+    CxpTreeRingInsert(aTree, rY, node, rB);
+    if (head) {
+	aTree->nodeRings[node] = rY;
+    }
+
+    aTree->sn++;
+    return false;
+}
+
+bool
+CxTreeTbr(CxtTree *aTree, uint32_t aEdge, uint32_t aEdgeX, uint32_t aEdgeY) {
+    bool ret;
+
+    ret = true;
+    if (aEdgeX != CxmTreeNone) {
+	if (CxTreeSpr(aTree, aEdge << 1, aEdgeX) == false) {
+	    ret = false;
+	}
+    }
+    if (aEdgeY != CxmTreeNone) {
+	if (CxTreeSpr(aTree, (aEdge << 1) | 1, aEdgeY) == false) {
+	    ret = false;
+	}
+    }
+
+    return ret;
+}
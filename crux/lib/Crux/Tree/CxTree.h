@@ -0,0 +1,136 @@
+#ifndef CxTree_h
+#define CxTree_h
+
+#include "../Cx.h"
+
+// Array-backed tree.  This is the same node/edge/ring structure that
+// Crux.Tree.{Tree,Node,Edge,Ring} implement with objects, but all records are
+// stored in contiguous index-linked vectors, so that traversal and
+// rearrangement involve neither reference counting nor pointer chasing.
+//
+// Edge e owns rings (e << 1) and ((e << 1) | 1), so the ring at the other end
+// of an edge is always (r ^ 1), and the edge that ring r is part of is
+// (r >> 1).  Ring (e << 1) corresponds to Edge.ring.
+
+// Index value that means "no node/ring/edge/taxon".
+#define CxmTreeNone 0xffffffffU
+
+typedef struct {
+    uint32_t maxNodes;
+    uint32_t maxEdges;
+
+    // Nodes.  nodeTaxa[n] is a caller-defined taxon index for node n (or
+    // CxmTreeNone), and nodeRings[n] is the header of n's ring list (or
+    // CxmTreeNone if no edges are attached to n).
+    uint32_t *nodeTaxa;
+    uint32_t *nodeRings;
+    uint32_t nnodes;
+
+    // Edges.
+    double *lengths;
+    uint32_t nedges;
+
+    // Rings.  ringNodes[r] is the node that r is attached to (or CxmTreeNone
+    // if r's edge is detached), and ringNext/ringPrev link the circular list
+    // of rings that are attached to the same node.
+    uint32_t *ringNodes;
+    uint32_t *ringNext;
+    uint32_t *ringPrev;
+
+    // Base node (or CxmTreeNone).
+    uint32_t base;
+
+    // Incremented every time the tree is modified.
+    uint64_t sn;
+
+    // Traversal cache, valid only if (cacheSn == sn); see CxTreeRecache().
+    uint64_t cacheSn;
+    uint32_t *order;
+    uint32_t norder;
+    uint32_t ntaxa;
+
+    // Scratch stack for iterative traversal.
+    uint32_t *stack;
+} CxtTree;
+
+// Initialize an empty tree with space for aMaxNodes nodes and aMaxEdges
+// edges.  Return true on error.
+bool
+CxTreeNew(CxtTree *aTree, uint32_t aMaxNodes, uint32_t aMaxEdges);
+
+// Discard aTree.
+void
+CxTreeDelete(CxtTree *aTree);
+
+// Make aTree an exact copy of aOther, which must fit within aTree's capacity.
+// Since no memory is allocated, this is an inexpensive way to snapshot a tree
+// before speculative rearrangement, and to restore it afterward.
+void
+CxTreeCopy(CxtTree *aTree, const CxtTree *aOther);
+
+// Create a detached node and return its index.
+uint32_t
+CxTreeNodeNew(CxtTree *aTree);
+
+// Create a detached edge of length 0.0, and return its index.
+uint32_t
+CxTreeEdgeNew(CxtTree *aTree);
+
+// Attach edge aEdge to aNodeA and aNodeB, with the same ring ordering as
+// Edge.attach(): each of the edge's rings becomes the header of its node's
+// ring list, and the previous header follows it.
+void
+CxTreeEdgeAttach(CxtTree *aTree, uint32_t aEdge, uint32_t aNodeA,
+  uint32_t aNodeB);
+
+// Detach edge aEdge.
+void
+CxTreeEdgeDetach(CxtTree *aTree, uint32_t aEdge);
+
+// Count the edges attached to aNode.
+uint32_t
+CxTreeDegree(const CxtTree *aTree, uint32_t aNode);
+
+// Rebuild the traversal cache if it is stale.  order[0..norder) lists the
+// rings that are reached from the base, in the same preorder as Tree.edges
+// (children in ring order): for each edge, the ring at the end farther from
+// the base is listed, so ringNodes[order[i]] are the non-base nodes in the
+// same order as Tree.nodes[1:], and reverse order is a postorder.  ntaxa is
+// the number of reachable nodes with taxa.
+void
+CxTreeRecache(CxtTree *aTree);
+
+// Return true if aEdge is part of the subtree that is reached via aRing (the
+// subtree that contains (aRing ^ 1)'s node, when entered from aRing's node).
+bool
+CxTreeInSubtree(CxtTree *aTree, uint32_t aRing, uint32_t aEdge);
+
+// Nearest neighbor interchange.  aRingA and aRingB must be attached to the two
+// different ends of aEdge, and must not be part of aEdge.  The subtrees that
+// are reached via aRingA and aRingB are swapped, and each of the moved rings
+// takes the other's place in its new ring list, so the operation is its own
+// inverse.  Branch lengths are not modified.
+void
+CxTreeNni(CxtTree *aTree, uint32_t aEdge, uint32_t aRingA, uint32_t aRingB);
+
+// Subtree pruning and regrafting.  aRing must be attached to a node p of
+// degree 3, and aEdge must not be in the subtree that is reached via aRing.
+// The subtree that is reached via aRing is pruned along with p, p's two other
+// edges are replaced by one of them, and p is regrafted by inserting it into
+// aEdge.  Node, edge, and ring indices remain valid, and branch lengths are
+// not modified.  Return true (and leave the tree unmodified) if the operation
+// would be a no-op, which is the case if aEdge is attached to p.
+bool
+CxTreeSpr(CxtTree *aTree, uint32_t aRing, uint32_t aEdge);
+
+// Tree bisection and reconnection.  aEdge is removed, and the two resulting
+// subtrees are reconnected via aEdgeX (on the side of ring (aEdge << 1)) and
+// aEdgeY (on the side of ring ((aEdge << 1) | 1)), either of which may be
+// CxmTreeNone, in order to leave that side as is.  This is equivalent to
+// CxTreeSpr(aTree, aEdge << 1, aEdgeX) followed by
+// CxTreeSpr(aTree, (aEdge << 1) | 1, aEdgeY).  Return true if neither side was
+// modified.
+bool
+CxTreeTbr(CxtTree *aTree, uint32_t aEdge, uint32_t aEdgeX, uint32_t aEdgeY);
+
+#endif // CxTree_h
@@ -0,0 +1,38 @@
+from libc cimport uint32_t, uint64_t
+
+cdef extern from "CxTree.h":
+    cdef enum:
+        CxmTreeNone
+    ctypedef struct CxtTree:
+        uint32_t maxNodes
+        uint32_t maxEdges
+        uint32_t *nodeTaxa
+        uint32_t *nodeRings
+        uint32_t nnodes
+        double *lengths
+        uint32_t nedges
+        uint32_t *ringNodes
+        uint32_t *ringNext
+        uint32_t *ringPrev
+        uint32_t base
+        uint64_t sn
+        uint32_t *order
+        uint32_t norder
+        uint32_t ntaxa
+
+    cdef bint CxTreeNew(CxtTree *aTree, uint32_t aMaxNodes, uint32_t aMaxEdges)
+    cdef void CxTreeDelete(CxtTree *aTree)
+    cdef void CxTreeCopy(CxtTree *aTree, CxtTree *aOther)
+    cdef uint32_t CxTreeNodeNew(CxtTree *aTree)
+    cdef uint32_t CxTreeEdgeNew(CxtTree *aTree)
+    cdef void CxTreeEdgeAttach(CxtTree *aTree, uint32_t aEdge, \
+      uint32_t aNodeA, uint32_t aNodeB)
+    cdef void CxTreeEdgeDetach(CxtTree *aTree, uint32_t aEdge)
+    cdef uint32_t CxTreeDegree(CxtTree *aTree, uint32_t aNode)
+    cdef void CxTreeRecache(CxtTree *aTree)
+    cdef bint CxTreeInSubtree(CxtTree *aTree, uint32_t aRing, uint32_t aEdge)
+    cdef void CxTreeNni(CxtTree *aTree, uint32_t aEdge, uint32_t aRingA, \
+      uint32_t aRingB)
+    cdef bint CxTreeSpr(CxtTree *aTree, uint32_t aRing, uint32_t aEdge)
+    cdef bint CxTreeTbr(CxtTree *aTree, uint32_t aEdge, uint32_t aEdgeX, \
+      uint32_t aEdgeY)
@@ -0,0 +1,92 @@
+#ifndef SFMT_JUMP19937_H
+#define SFMT_JUMP19937_H
+
+/*
+ * Jump polynomial for MEXP 19937: x^(2^JUMP_LOG2) modulo the minimal
+ * polynomial (degree 19968) of the state transition, in the format expected
+ * by jump_gen_rand_poly().  The minimal polynomial was computed via the
+ * Berlekamp-Massey algorithm from the generator's output, as SFMT's calc-jump
+ * does.
+ */
+#define JUMP_LOG2 128
+#define JUMP_POLY \
+    "c5ecf0b605bcbebf05a6ae430dc3cd1777acaff2b99fe5221eaa2a2c8acf0ea0" \
+    "b9617d0b4a5e8f94828b6710c0f365e69b690be81b206e04f64a9994b013dc1e" \
+    "046fb5e182b3d794fdd3d01d73d1c2aaaa03ce4398cce92cc67ed20c031a607f" \
+    "dca6dce456b8268481c80bcf740a810c5d73dcab943e05e8a2adfe5f81d9f118" \
+    "435ceef77fbe3d9d58baa17378e24001fea40b87181de63568f4342c05ddd174" \
+    "a617d1452cfcb4fd1df0dc94802ce7b8c04f21ced8cd34d29771f5cb25471704" \
+    "d2bfc8abc2acc47f10d9f72f781556c62e4a089f44c63d4a2d7b3541fe07c197" \
+    "c0bd10178c2a81fa7888d0ddc777502f8dda122e3bf335e365f0e70be77f0383" \
+    "bf2d0b5ba5c1ab9cd94288e59f086262c42bde8f832819e9fa1467661d68ff8e" \
+    "d3edd81c8aa6c268a72bcafbc3ab20c1ecb1799988abf25a6b9b4262bf93fbd2" \
+    "ef44fe16e6a2702e57b8d1f0468a58a85cc74f2a75d18b3373cfc47cfd028f70" \
+    "ea8e6a5ef2e871b929b47f4fd1ffe3be9c4c89ac6c2c135fd1f410c8e0e9e55e" \
+    "4a75891f00e3a48f6a4a48b1e12f9032675e4942c502241e3d75b34fe803d6cd" \
+    "4e33709cb2632a4fe42c7a94d1a57b166f1a9d19e58bc7d904740df1bca2481a" \
+    "01e6f390d647353dd18dc1ba77ac5334e3e0037413f2f41d33941ecfdd1cbdf0" \
+    "cbe4ad3c08ac47ec03c440971327b1631a8742ef3fa2d2fa7e76af3de0216f52" \
+    "d7f44d0efcaf927f54b673a0ade6910f7fb86da9ef4f3715d84fcd2159b31333" \
+    "71bdbf6e888276e238e3b03ee0c255000ae8914736f597f7222c1764eb1b13a9" \
+    "447c406257b23e707576b0456b76fc414a75620093e8f7017ac980a867f1221c" \
+    "1eb0979d14032c0838d976cf5d139b1c5a610ab09f117776c2167b201056b7f0" \
+    "cc246232d183c207ae38dd8d0fccc302b034bcdeb4976b2b8864cc5fc2f162b7" \
+    "2b55f3ee9cd28fd4f271063d4a58e3a66698d56487651dbf7a135b383adb7166" \
+    "1d188f6c39521381dbc3b2bd01041f2ebd396f9f76511cffc7ef7897903bdee6" \
+    "c086e193c541ebb401dca2d28d779000a2d69740e8f6560477c23b01920175c3" \
+    "8604150200ecce4d4ccfd0a6cb6f4f2bf2ab37a3072d4e613356307338ee2e67" \
+    "67b6a83ec6cda267bb1994e099af4067d67d95341a1ca150f7196db5e2209969" \
+    "b3d432179a3d8da93f71825bc7b385d960f4b881b30aa6a4cf16a2672eda09b3" \
+    "efea2ed7cbcf77ed405f1aa175c59f5f619a54cc0a437ba97cd8d041a5ca0e75" \
+    "534b2e9c61d5ee2e1570945fe276921e18308db9f3a9805d798611f7f496d2b9" \
+    "58b6eb4e946d572c471c619565832d20d0e82eae1eef9e1a2472c6c851250c08" \
+    "aae4d403558e1fde9c399e324a5e8dede8ca57b4492afda60cea0996508a3567" \
+    "a01a5e6e822bca9ec8ac223bc0534c311ed07eae4bcaed013776ba0bbdb22b8b" \
+    "c038b61cb431c8079201e0f8304a439fb8dc1d71050e4d6c93b154a152def253" \
+    "ad808a11dea33c6d797c94ac0eac9b518096ccb85081c2c02a89e32624e700cd" \
+    "1ccfa7eb90592afaf886d4f61f1a378ab44f29dd73dfe5ab7a23a8f31a9b6f12" \
+    "639c81d3db851abff93938a60f61b659a481f286ba10339e0409f39885f58b42" \
+    "e255ad89d0484763459e03a04097d2427444f59e3d49206f784ef676914f4a4e" \
+    "11b66635881ab05accd0020559a780ebd53999974dae64cfedc4ee856ae2d3b3" \
+    "cd5d40337d33115dea8376f07da698f20c11dc86d8203d0d12bf3ae973bfec07" \
+    "00d2337961e1c4c9448cb5730d9457afb1d8891301f3264fd30cba095db3f527" \
+    "907c80fca305ea8b9ca2adcdb0e2b2781839a1ebcb7ff5b627ddfcf721701186" \
+    "06e5742be995af9d5e0f31798640f32d6e09438cc75737d6876daa5c0eea191c" \
+    "6aceff45d66b5beceda17833b2968b1e9454612f85a93c239c96a96eead57a36" \
+    "da005c661e1ac83427e5724b06b7423e99731bd126719998e17ab3be9d2c1410" \
+    "02533c84cd27ff029cea709f5c585dc1194bcb6df9663a7b1c6adca72895bc2f" \
+    "42bf8019f52975398d8d68e64b76796e93187ebb1d92a10387c5d41687d8bace" \
+    "bf2705904783edd71b1b652f4acf1185289441b21ddb079de827dad3adfc68a1" \
+    "832a2ef50d9b4b324392267dd3ed9094eb442c4306758ba07225268026010bf5" \
+    "82ce2563dc4de2b6ad0c8b0aac39003f4b0ec473854125038a77be70ec8d4130" \
+    "1c56e970d8aef57ce13f0619f882edc582d78248178adf5576466b0215ae8b89" \
+    "9d95df9b6753c87fdc3a54ed8a90923dce88b89f371235ca1d0f4c0d6737ee8d" \
+    "b168f7ef4aea9c3bdf06d9e96236333b7ee207bdf4c3603c55be04a890837a04" \
+    "1f3a8e6ec6e3f91e57a94504098e341ec44a3236608d439cd0b5840d7f1f2c58" \
+    "9fb356f378c66439dc97ee5b176050a208bc813a2db4b023dbc5298a013aefc5" \
+    "6792d62c245ff9d18228d53ae155918d0a6ccf61131cc5cdf34deb4545eb48a0" \
+    "f5b7e486b146af6699a756fac06e9a331a8fa944a5b0046321a40635a709bf2b" \
+    "9bbff44d907d83924dc0d908ee1d21c60100ddb448687928ed760783568ec89d" \
+    "65fdbd077d5312683ca526d413f4bee45e814a160854b7329c83fe490a242595" \
+    "fbf3b85f32b4715f1034c9737d7fab25b4b29b4c90c9919df8377c5111cfdbb4" \
+    "3e6ad9e467ff48d0d85de6457131a4b4ca6a69e3de7d09691a9b5da24dda54f3" \
+    "fdc5f5c316ddcc99842cce8af4440034f4bf6236fae7092d41a027880b8e2937" \
+    "1a476451997d52ec9bc428308e171499e29fd008f7a9dceff044deb0e7164e77" \
+    "4b248e472ef5f38893e7f71bfbfb4728e6063ba1111df7b978e81313388f5b6b" \
+    "c1111ca35885810ed57cc6fce9a8f53c7cf40cc360ef836bc73a937a19791174" \
+    "66b2e1ab4a11cbc0be9c0741d12d5d1f7c7333f7d34ec9d8734541f0544a7242" \
+    "895a40eec2d46e606d751b275ac6b7d208bb5cd112dedea4652a38b134ad0617" \
+    "71b9ba842108e77ad0149d3fb265a277a770d9083825b7876e8c30a1f83dec6d" \
+    "54da4da61dbeadf706e6a8d18d4e00fcd19985cb61c3e25439cfa68ba1f007b4" \
+    "3a4d79c1f2ae8566318e0d0c0ac6e312fd9af2760258a16c1c2e864ec053ce49" \
+    "70520e1780c9ffa218fcbeeb803e553f29ed66da093b8498ca20e030c9dab6d2" \
+    "ab214837468cc65c3a122222d482917c2ef4aae56e8b0f7625997cc5e726ae9b" \
+    "110ab111b123e71e123ba0b2847481d324d6f5568878613ab22aa7fe23ac40b0" \
+    "4c82d9c118803804aa014d7b60d1d05c5bd4ff07e44cdedf09f8dbd3738366d8" \
+    "7301460db172acba11fcdba924ed7bc0debeabc4ea9ed658d12abc8d529f8b9b" \
+    "c736b07968db946a80c9a6e0d5ba9b412742aaa0675b09844685059cd00ff7ab" \
+    "088813ed6db4460004d48f61f905c373d223a7363bcc5bbcb6d02bc711ac954b" \
+    "0a694c7bc40dbbb9eeef50282e63c56088786a70b1fc8720aeb993451c33a533" \
+    "e3703ce76e2eb8450796109cff8c2d4ba3f2e1dcd6d9397608ac967baa41b564"
+
+#endif /* SFMT_JUMP19937_H */
@@ -12,8 +12,12 @@
  */
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 #include "SFMT.h"
 #include "SFMT-params.h"
+#if MEXP == 19937
+  #include "SFMT-jump19937.h"
+#endif
 #include "../Cx_defs.h"
 
 #if defined(__BIG_ENDIAN__) && !defined(__amd64) && !defined(BIG_ENDIAN64)
@@ -203,8 +207,10 @@ inline static void lshift128(w128_t *out, w128_t const *in, int shift) {
  * @param b a 128-bit part of the internal state array
  * @param c a 128-bit part of the internal state array
  * @param d a 128-bit part of the internal state array
+ *
+ * @note This is defined even for SIMD builds, since jump_gen_rand_poly()
+ * advances the state one 128-bit word at a time.
  */
-#if (!defined(HAVE_ALTIVEC)) && (!defined(HAVE_SSE2))
 #ifdef ONLY64
 inline static void do_recursion(w128_t *r, w128_t *a, w128_t *b, w128_t *c,
 				w128_t *d) {
@@ -240,7 +246,6 @@ inline static void do_recursion(w128_t *r, w128_t *a, w128_t *b, w128_t *c,
 	^ (d->u[3] << SL1);
 }
 #endif
-#endif
 
 #if (!defined(HAVE_ALTIVEC)) && (!defined(HAVE_SSE2))
 /**
@@ -564,15 +569,10 @@ void fill_array64(sfmt_t *ctx, uint64_t *array, int size) {
 }
 
 /**
- * This function initializes the internal state array with a 32-bit
- * integer seed.
- *
- * @param seed a 32-bit integer used as the seed.
+ * This function allocates an uninitialized context, aligned for SIMD access.
  */
-sfmt_t *init_gen_rand(uint32_t seed) {
+static sfmt_t *alloc_gen_rand(void) {
     sfmt_t *ctx;
-    int i;
-    uint32_t *psfmt32;
 
 #ifdef CxmHavePosixMemalign
     if (posix_memalign((void **)&ctx, sizeof(w128_t), sizeof(sfmt_t)) != 0) {
@@ -583,6 +583,24 @@ sfmt_t *init_gen_rand(uint32_t seed) {
 	return NULL;
     }
 #endif
+
+    return ctx;
+}
+
+/**
+ * This function initializes the internal state array with a 32-bit
+ * integer seed.
+ *
+ * @param seed a 32-bit integer used as the seed.
+ */
+sfmt_t *init_gen_rand(uint32_t seed) {
+    sfmt_t *ctx;
+    int i;
+    uint32_t *psfmt32;
+
+    if ((ctx = alloc_gen_rand()) == NULL) {
+	return NULL;
+    }
     psfmt32 = &ctx->sfmt[0].u[0];
 
     psfmt32[idxof(0)] = seed;
@@ -613,15 +631,9 @@ sfmt_t *init_by_array(uint32_t *init_key, int key_length) {
     int size = N * 4;
     uint32_t *psfmt32;
 
-#ifdef CxmHavePosixMemalign
-    if (posix_memalign((void **)&ctx, sizeof(w128_t), sizeof(sfmt_t)) != 0) {
-	return NULL;
-    }
-#else
-    if ((ctx = (sfmt_t *)malloc(sizeof(sfmt_t))) == NULL) {
+    if ((ctx = alloc_gen_rand()) == NULL) {
 	return NULL;
     }
-#endif
     psfmt32 = &ctx->sfmt[0].u[0];
 
     if (size >= 623) {
@@ -690,3 +702,220 @@ void fini_gen_rand(sfmt_t *ctx) {
     ctx->initialized = 0;
     free(ctx);
 }
+
+/**
+ * This function allocates a new context with the same state as ctx, such that
+ * both generate the same sequence.
+ * @param ctx the context to duplicate.
+ */
+sfmt_t *dup_gen_rand(sfmt_t const *ctx) {
+    sfmt_t *ret;
+
+    assert(ctx->initialized);
+
+    if ((ret = alloc_gen_rand()) == NULL) {
+	return NULL;
+    }
+    memcpy(ret, ctx, sizeof(sfmt_t));
+
+    return ret;
+}
+
+/*------------------------------------------------------------------
+  Jump-ahead, after SFMT_jump() in SFMT 1.4.  A jump polynomial is the
+  polynomial x^step modulo the minimal polynomial of the state transition,
+  which advances the state by step 128-bit words when evaluated at the
+  transition function.
+  ------------------------------------------------------------------*/
+
+/**
+ * This function adds (xors) src's state to dest's state, which is in
+ * block-aligned order (dest->idx is 0).  src's state array is rotated so
+ * that its oldest word aligns with dest's first word.
+ */
+inline static void jump_add(sfmt_t *dest, sfmt_t const *src) {
+    int diff = (src->idx / 4) % N;
+    int i, j;
+
+    for (i = 0, j = diff; i < N; i++, j++) {
+	if (j == N) {
+	    j = 0;
+	}
+#if defined(HAVE_SSE2)
+	dest->sfmt[i].si = _mm_xor_si128(dest->sfmt[i].si, src->sfmt[j].si);
+#else
+	dest->sfmt[i].u[0] ^= src->sfmt[j].u[0];
+	dest->sfmt[i].u[1] ^= src->sfmt[j].u[1];
+	dest->sfmt[i].u[2] ^= src->sfmt[j].u[2];
+	dest->sfmt[i].u[3] ^= src->sfmt[j].u[3];
+#endif
+    }
+}
+
+/**
+ * This function advances the state by one 128-bit word.
+ */
+inline static void jump_next_state(sfmt_t *ctx) {
+    int idx = (ctx->idx / 4) % N;
+
+    do_recursion(&ctx->sfmt[idx], &ctx->sfmt[idx],
+		 &ctx->sfmt[(idx + POS1) % N], &ctx->sfmt[(idx + N - 2) % N],
+		 &ctx->sfmt[(idx + N - 1) % N]);
+    ctx->idx += 4;
+}
+
+/**
+ * This function advances the state of ctx as specified by jump_string, which
+ * is a jump polynomial in hexadecimal, with the coefficient of x^0 in the
+ * least significant bit of the first digit.  The position within the current
+ * output block is preserved, so the result is the same as generating (step *
+ * 128) bits of output, regardless of whether gen_rand32() or gen_rand64() was
+ * previously called.
+ * @param jump_string jump polynomial, as computed by SFMT's calc-jump.
+ */
+void jump_gen_rand_poly(sfmt_t *ctx, const char *jump_string) {
+    sfmt_t work;
+    int index, bits, i, j;
+
+    assert(ctx->initialized);
+
+    index = ctx->idx;
+    memset(work.sfmt, 0, sizeof(work.sfmt));
+    ctx->idx = N32;
+    for (i = 0; jump_string[i] != '\0'; i++) {
+	bits = jump_string[i];
+	if (bits >= 'a' && bits <= 'f') {
+	    bits = bits - 'a' + 10;
+	} else if (bits >= 'A' && bits <= 'F') {
+	    bits = bits - 'A' + 10;
+	} else {
+	    assert(bits >= '0' && bits <= '9');
+	    bits = bits - '0';
+	}
+	for (j = 0; j < 4; j++) {
+	    if ((bits & 1) != 0) {
+		jump_add(&work, ctx);
+	    }
+	    jump_next_state(ctx);
+	    bits >>= 1;
+	}
+    }
+    memcpy(ctx->sfmt, work.sfmt, sizeof(work.sfmt));
+    ctx->idx = index;
+}
+
+#ifdef JUMP_POLY
+/**
+ * This function advances the state of ctx by 2^JUMP_LOG2 128-bit words, so
+ * that contexts derived from one seed by repeated jumps generate
+ * non-overlapping sequences.
+ */
+void jump_gen_rand(sfmt_t *ctx) {
+    jump_gen_rand_poly(ctx, JUMP_POLY);
+}
+#endif
+
+/*------------------------------------------------------------------
+  Bulk generation.  These functions generate exactly the same values as the
+  corresponding sequence of single-value calls, but make use of the
+  fill_array64() path (generating directly into the destination) for large
+  arrays.  Unlike fill_array64(), they may be intermixed with gen_rand64(),
+  and place no restrictions on the array size or alignment.
+  ------------------------------------------------------------------*/
+
+/**
+ * This function copies n 64-bit values from the internal state array.
+ */
+inline static void copy_rand64(sfmt_t *ctx, uint64_t *array, size_t n) {
+#if defined(BIG_ENDIAN64) && !defined(ONLY64)
+    uint32_t *psfmt32 = &ctx->sfmt[0].u[0];
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	array[i] = ((uint64_t)psfmt32[ctx->idx + 1] << 32)
+	  | psfmt32[ctx->idx];
+	ctx->idx += 2;
+    }
+#else
+    if (n > 0) {
+	memcpy(array, &ctx->sfmt[0].u[ctx->idx], n * sizeof(uint64_t));
+	ctx->idx += (int)(n * 2);
+    }
+#endif
+}
+
+/**
+ * This function fills array[0..size) with the same values as size calls to
+ * gen_rand64().
+ */
+void fill_gen_rand64(sfmt_t *ctx, uint64_t *array, size_t size) {
+    size_t i, n;
+
+    assert(ctx->initialized);
+    assert(ctx->idx % 2 == 0);
+
+    /* Use what remains of the current block. */
+    n = (size_t)(N32 - ctx->idx) / 2;
+    if (n > size) {
+	n = size;
+    }
+    copy_rand64(ctx, array, n);
+    i = n;
+
+    /* Generate directly into array, in chunks that gen_rand_array() can
+     * handle. */
+    if (((uintptr_t)&array[i] & (sizeof(w128_t) - 1)) == 0) {
+	while (size - i >= N64) {
+	    n = size - i;
+	    if (n > (1U << 20)) {
+		n = (1U << 20);
+	    }
+	    n &= ~(size_t)1;
+	    gen_rand_array(ctx, (w128_t *)&array[i], (int)(n / 2));
+#if defined(BIG_ENDIAN64) && !defined(ONLY64)
+	    swap((w128_t *)&array[i], (int)(n / 2));
+#endif
+	    i += n;
+	}
+    }
+
+    /* Generate the remainder via the internal state array. */
+    while (i < size) {
+	gen_rand_all(ctx);
+	ctx->idx = 0;
+	n = size - i;
+	if (n > N64) {
+	    n = N64;
+	}
+	copy_rand64(ctx, &array[i], n);
+	i += n;
+    }
+}
+
+/**
+ * This function fills array[0..size) with the same values as size calls to
+ * genrand_res53().
+ */
+void fill_res53(sfmt_t *ctx, double *array, size_t size) {
+    size_t i;
+    uint64_t v;
+
+    fill_gen_rand64(ctx, (uint64_t *)array, size);
+    for (i = 0; i < size; i++) {
+	memcpy(&v, &array[i], sizeof(v));
+	array[i] = to_res53(v);
+    }
+}
+
+/**
+ * This function fills array[0..size) with standard exponential variates,
+ * -log(1 - u), where u is as generated by genrand_res53().
+ */
+void fill_exp(sfmt_t *ctx, double *array, size_t size) {
+    size_t i;
+
+    fill_res53(ctx, array, size);
+    for (i = 0; i < size; i++) {
+	array[i] = -log(1.0 - array[i]);
+    }
+}
@@ -87,6 +87,20 @@ void fini_gen_rand(sfmt_t *ctx);
 const char *get_idstring(void);
 int get_min_array_size32(void);
 int get_min_array_size64(void);
+sfmt_t *dup_gen_rand(sfmt_t const *ctx);
+
+/* Jump-ahead.  jump_gen_rand() advances ctx by 2^128 128-bit words, which
+ * yields non-overlapping substreams of a single seed: for the i'th of n
+ * streams, duplicate the (i-1)'th stream via dup_gen_rand(), and jump.
+ * jump_gen_rand() is only available for MEXP=19937. */
+void jump_gen_rand_poly(sfmt_t *ctx, const char *jump_string);
+void jump_gen_rand(sfmt_t *ctx);
+
+/* Bulk generation, equivalent to repeated gen_rand64(), genrand_res53(), and
+ * -log(1.0 - genrand_res53()) calls, respectively. */
+void fill_gen_rand64(sfmt_t *ctx, uint64_t *array, size_t size);
+void fill_res53(sfmt_t *ctx, double *array, size_t size);
+void fill_exp(sfmt_t *ctx, double *array, size_t size);
 
 /* These real versions are due to Isaku Wada */
 /** generates a random number on [0,1]-real-interval */
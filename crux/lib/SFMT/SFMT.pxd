@@ -15,6 +15,12 @@ cdef extern from "SFMT.h":
     cdef char *get_idstring()
     cdef int get_min_array_size32()
     cdef int get_min_array_size64()
+    cdef sfmt_t *dup_gen_rand(sfmt_t *ctx)
+    cdef void jump_gen_rand_poly(sfmt_t *ctx, char *jump_string)
+    cdef void jump_gen_rand(sfmt_t *ctx)
+    cdef void fill_gen_rand64(sfmt_t *ctx, uint64_t *array, size_t size)
+    cdef void fill_res53(sfmt_t *ctx, double *array, size_t size)
+    cdef void fill_exp(sfmt_t *ctx, double *array, size_t size)
     cdef inline double to_real1(uint32_t v)
     cdef inline double genrand_real1(sfmt_t *ctx)
     cdef inline double to_real2(uint32_t v)
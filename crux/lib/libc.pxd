@@ -2,6 +2,7 @@ cdef extern from "sys/types.h":
     ctypedef size_t uintptr_t
 
 cdef extern from "stdint.h":
+    ctypedef unsigned char uint8_t
     ctypedef int int32_t
     ctypedef unsigned uint32_t
     ctypedef long long int int64_t
@@ -6,6 +6,9 @@ from Crux.Character cimport Character
 from Crux.Taxa cimport Taxon
 cimport Crux.Taxa as Taxa
 from Crux.DistMatrix cimport DistMatrix
+from libc cimport uint8_t, uint64_t
+from CxPack cimport CxtPack
+from CxDist cimport CxeDist
 
 cdef class CTMatrix:
     cdef readonly type charType
@@ -27,11 +30,16 @@ cdef class Alignment:
     cdef readonly int npad
     cdef readonly bint rowMajor
     cdef readonly bint colMajor
+    cdef readonly unsigned packBits
     cdef char *rows
     cdef char *cols
+    cdef CxtPack packed
+    cdef uint8_t code2val[256]
     cdef unsigned *freqs
 
     cdef char *_allocMatrix(self, int ntaxa, int nchars, str pad) except NULL
+    cdef void _unpackMatrix(self, char *cells, uint64_t rowStride,
+      uint64_t colStride) except *
     cdef void _initRowMajor(self) except *
     cdef void _initColMajor(self) except *
 
@@ -39,6 +47,13 @@ cdef class Alignment:
 
     cpdef deRow(self)
     cpdef deCol(self)
+    cpdef pack(self, unsigned bits=*)
+    cpdef dePack(self)
+    cdef unsigned _unPack(self, bint *rTemp) except *
+    cdef void _rePack(self, unsigned bits, bint temp) except *
+    cdef unsigned *_packFreqs(self, unsigned *freqs)
+    cdef void _packDists(self, DistMatrix m, unsigned *freqs, CxeDist method, \
+      bint scoreGaps) except *
 
     cdef void setRow(self, int row, int col, char *chars, unsigned len) except *
     cdef void setCol(self, int row, int col, char *chars, unsigned len) except *
@@ -55,16 +70,34 @@ cdef class Alignment:
 
     cdef void _fitchCanonize(self, Character char_) except *
     cpdef canonize(self, bint fitch=*)
-    cdef int _fitchCompact(self, list deco) except -1
     cpdef int compact(self, bint fitch=*)
 
     cdef void _renderLine(self, str line, list lines, file outFile) except *
     cpdef str render(self, unsigned interleave=*, file outFile=*, bint pad=*)
     cpdef str fastaPrint(self, file outFile=*, bint pad=*)
 
-    cpdef DistMatrix dists(self, bint scoreGaps=*)
-    cpdef DistMatrix jukesDists(self, bint scoreGaps=*)
-    cdef void _kimuraDistsDNA(self, DistMatrix m, bint scoreGaps)
-    cdef void _kimuraDistsProtein(self, DistMatrix m, bint scoreGaps)
-    cpdef DistMatrix kimuraDists(self, bint scoreGaps=*)
-    cpdef DistMatrix logdetDists(self, bint scoreGaps=*, str nan=*)
+    cdef unsigned *_weightsGet(self, weights) except NULL
+    cdef void _pctDists(self, DistMatrix m, unsigned *freqs, bint scoreGaps) \
+      except *
+    cpdef DistMatrix dists(self, bint scoreGaps=*, str path=*, weights=*)
+    cdef void _jukesDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *
+    cpdef DistMatrix jukesDists(self, bint scoreGaps=*, str path=*,
+      weights=*)
+    cdef void _kimuraDistsDNA(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *
+    cdef void _kimuraDistsProtein(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *
+    cdef void _kimuraDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *
+    cpdef DistMatrix kimuraDists(self, bint scoreGaps=*, str path=*,
+      weights=*)
+    cdef void _logdetDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *
+    cdef void _logdetNan(self, DistMatrix m, str nan) except *
+    cpdef DistMatrix logdetDists(self, bint scoreGaps=*, str nan=*,
+      str path=*, weights=*)
+    cdef void _bootDists(self, DistMatrix m, str dists, unsigned *freqs, \
+      bint scoreGaps) except *
+    cpdef bootstrap(self, unsigned nreps, str dists=*, bint scoreGaps=*,
+      str nan=*, str joiner=*, bint joinRandom=*, bint tryAdditive=*)
@@ -16,19 +16,33 @@ cimport Crux.Taxa as Taxa
 cimport Crux.Fasta as Fasta
 from Crux.Character cimport Character, Dna, Protein
 from Crux.DistMatrix cimport DistMatrix
+from Crux.Tree cimport Tree
+from Crux.Tree.Sumt cimport Sumt
 
 from libc cimport *
 from libm cimport *
 from CxMat cimport CxMatLogDet
+from CxPack cimport *
+from CxDist cimport *
+from CxPattern cimport *
+from CxBoot cimport *
 from CxMath cimport pop
+from Cx cimport CxNcpus
+from SFMT cimport *
 
 cdef extern from "Python.h":
     cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
 
+import random
 import sys
 
 global __name__
 
+# Maximum total size of the distance matrices that bootstrap() computes at
+# once.
+cdef enum:
+    _bootBatchBytes = 256 * 1024 * 1024
+
 cdef class CTMatrix:
     """
         Character-by-taxon matrix.  The Alignment class is best used for most
@@ -58,10 +72,10 @@ cdef class CTMatrix:
             self._fastaNew(input, charType)
 
     cdef void _fastaNew(self, input, type charType) except *:
-        cdef Fasta.Parser parser
+        cdef Fasta.Reader reader
 
-        parser = Fasta.Parser(self, self.taxaMap)
-        parser.parse(input, charType)
+        reader = Fasta.Reader(input, charType)
+        reader.fill(self)
 
     cdef void _renderLine(self, str line, list lines, file outFile) except *:
         if outFile is not None:
@@ -191,195 +205,6 @@ cdef class PctIdent:
         fident[0] = ident
         nvalid[0] = valid
 
-cdef class K2p:
-    cdef bint scoreGaps
-    cdef int code2val[128]
-
-    def __init__(self, bint scoreGaps):
-        cdef Dna dna
-        cdef str code
-        cdef char *sCode
-        cdef int iCode
-
-        self.scoreGaps = scoreGaps
-
-        dna = Dna.get()
-        for code in dna.codes():
-            sCode = <char *>code
-            iCode = sCode[0]
-            self.code2val[iCode] = dna.code2val(code)
-
-    cdef void stats(self, char *a, char *b, unsigned len, unsigned *freqs, \
-      unsigned *rN, unsigned *rKs, unsigned *rKv) except *:
-        cdef unsigned j
-        cdef int aC, bC, aI, bI
-        cdef int ambiguous, aVal, bVal, aOff, bOff
-        cdef double A[16]
-        cdef double p, n, ks, kv, k
-
-        ambiguous = Dna.get().any
-        memset(A, 0, sizeof(A))
-        for 0 <= j < len:
-            aC = a[j]
-            bC = b[j]
-            aVal = self.code2val[aC]
-            aPop = pop(aVal)
-            if aC == bC and aPop== 1:
-                aOff = ffs(aVal) - 1
-                # Identical non-ambiguous characters.
-                A[aOff*4 + aOff] += <double>freqs[j]
-            else:
-                bVal = self.code2val[bC]
-                bPop = pop(bVal)
-
-                if aPop== 1 and bPop == 1:
-                    aOff = ffs(aVal) - 1
-                    bOff = ffs(bVal) - 1
-                    A[aOff*4 + bOff] += <double>freqs[j]
-                elif not self.scoreGaps and (aPop== 0 or bPop == 0):
-                    # Ignore this character.
-                    pass
-                else:
-                    # Ambiguous character(s).
-
-                    # Translate gaps to mean "any character".
-                    if aVal == 0:
-                        aVal = ambiguous
-                        aPop= pop(aVal)
-                    if bVal == 0:
-                        bVal = ambiguous
-                        bPop = pop(bVal)
-
-                    # Each possible state combination is assigned an equal
-                    # probability.  All combinations sum to 1.0.
-                    p = <double>freqs[j] / <double>(aPop * bPop)
-
-                    # Iterate over every state combination, and add p to the
-                    # combinations that are represented by the ambiguity.
-                    for 0 <= aI < 4:
-                        for 0 <= bI < 4:
-                            if (aVal & (1 << aI)) and (bVal & (1 << bI)):
-                                A[aI*4 + bI] += p
-
-        # Compute stats needed by the k2p correction method.
-        #
-        #    A C G T
-        #  /--------  /------------
-        # A| - v s v  |  0  1  2  3
-        # C| v - v s  |  4  5  6  7
-        # G| s v - v  |  8  9 10 11
-        # T| v s v -  | 12 13 14 15
-        assert self.code2val[c'A'] == 1
-        assert self.code2val[c'C'] == 2
-        assert self.code2val[c'G'] == 4
-        assert self.code2val[c'T'] == 8
-        ks = A[2] + A[7] + A[8] + A[13]
-        kv = A[1] + A[3] + A[4] + A[6] + A[9] + A[11] + A[12] + A[14]
-        k = ks + kv
-        n = k + A[0] + A[5] + A[10] + A[15]
-
-        # Tajima's Taylor expansion method for computing corrected distances
-        # requires integer values.  Assuming it were possible to complete the
-        # computation with real numbers, this rounding would be a minor
-        # (unbiased) source of error for all but the shortest of sequences.
-        #
-        # Note that care is taken to do even rounding for ks and kv such that
-        # they sum to the rounded k.
-        rN[0] = <unsigned>round(n)
-        rKs[0] = <unsigned>round(ks)
-        rKv[0] = <unsigned>round(k - ks)
-
-    #                           ^
-    # Compute the first term of d, which can be factored as:
-    #
-    #     k
-    #  ------          max
-    #  \               ------   (i-j)    j   j
-    #   \      i!      \      kv        2  ks
-    #    >   ------- *  >     ------- * ------
-    #   /         i    /      (i-j)!    j!
-    #  /     2 i n     ------
-    #  ------          j=min
-    #   i=1
-    cdef double dist1(self, unsigned n, unsigned ks, unsigned kv) except -1.0:
-        cdef double ret, t, u
-        cdef unsigned h, i, j, k, min, max
-
-        ret = 0.0
-        k = ks + kv
-        for 1 <= i <= k:
-            t = 0.5 / <double>i
-            for 1 <= h <= i:
-                t *= <double>h / <double>n
-
-            min = (0 if i < kv else i - kv)
-            max = (i if i < ks else ks)
-            # Compute first iteration.
-            j = min
-            for 1 <= h <= i-j:
-                t *= <double>kv
-                t /= <double>h
-            u = 2.0 * <double>ks
-            for 1 <= h <= j:
-                t *= u
-                t /= <double>h
-            ret += t
-
-            # Compute remaining iterations based on previous.
-            u = (2.0 / <double>kv) * <double>ks
-            for j + 1 <= j <= max:
-                t *= u
-                if i-j > 0:
-                    t /= <double>(i-j)
-                t /= <double>j
-                ret += t
-
-        return ret
-
-    #                            ^
-    # Compute the second term of d, which can be factored as:
-    #
-    #        kv
-    #      ----   i   i
-    #   1  \     2  kv
-    #  ---  >    ------
-    #   4  /        i
-    #      ----  i n
-    #      i=1
-    #
-    # Reduce the chances of numerical overflow by computing the numerator and
-    # denominator separately, trying to cancel common factors at each step.
-    cdef double dist2(self, unsigned n, unsigned kv) except -1.0:
-        cdef double ret, t, u
-        cdef unsigned h, i
-
-        ret = 0.0
-        # Compute first iteration.
-        i = 1
-        t = 0.5
-        t *= <double>kv
-        t /= <double>n
-        ret += t
-
-        # Compute remaining iterations based on previous.
-        u = 2.0 / <double>n * <double>kv
-        for i + 1 <= i < kv:
-            t *= u
-            ret += t / <double>i
-
-        return ret
-
-    cdef double dist(self, char *a, char *b, unsigned len, unsigned *freqs) \
-      except -1.0:
-        cdef unsigned n, ks, kv
-
-        self.stats(a, b, len, freqs, &n, &ks, &kv)
-
-        if n == 0:
-            return NAN
-
-        return self.dist1(n, ks, kv) + self.dist2(n, kv)
-
 cdef class LogDet:
     cdef Character char_
     cdef bint scoreGaps
@@ -415,13 +240,13 @@ cdef class LogDet:
         if self.A == NULL:
             raise MemoryError("Matrix allocation failed")
 
-    # Compute LogDet/paralinear distance for a vs. b.
-    cdef double dist(self, char *a, char *b, unsigned seqlen, unsigned *freqs) \
-      except -1.0:
-        cdef unsigned i, j, aPop, bPop
+    # Compute the matrix of state pairs (A) for a vs. b.
+    cdef void count(self, char *a, char *b, unsigned seqlen, unsigned *freqs) \
+      except *:
+        cdef unsigned j, aPop, bPop
         cdef int aC, bC, aI, bI
         cdef int ambiguous, aVal, bVal, aOff, bOff
-        cdef double p, sum
+        cdef double p
 
         ambiguous = self.char_.any
         memset(self.A, 0, self.n * self.n * sizeof(double))
@@ -468,6 +293,12 @@ cdef class LogDet:
                             if (aVal & (1 << aI)) and (bVal & (1 << bI)):
                                 self.A[aI*self.n + bI] += p
 
+    # Compute LogDet/paralinear distance for the state pair matrix (A), as
+    # computed by count().
+    cdef double dist(self) except -1.0:
+        cdef unsigned i
+        cdef double sum
+
         # If the matrix is empty, there are no data on which to base a distance.
         sum = 0.0
         for 0 <= i < self.n * self.n:
@@ -485,15 +316,25 @@ cdef class Alignment:
         If no CTMatrix is specified, create an empty alignment for the taxa in
         taxaMap, with space for nchars characters.
 
+        Alternatively, specify FASTA input (a file or string of charType
+        characters), which is read directly into the alignment, without
+        creating an intermediate CTMatrix.  Alignment(input=input, ...) is
+        equivalent to Alignment(CTMatrix(input, charType), ...).
+
         By default, create only a row-major matrix, but support row-major
         and/or column-major format.  Any calls to the get{Row,Seq}() methods
         will implicitly enable row-major storage.  Likewise, any calls to the
         the get{Col,Char}() methods will implicitly enable column-major
         storage.
+
+        DNA alignments can additionally be bit-packed (packBits=4 or
+        packBits=2); see the pack() method.  If neither rowMajor nor colMajor
+        is enabled, the packed matrix is the only storage.
     """
     def __cinit__(self):
         self.rows = NULL
         self.cols = NULL
+        self.packBits = 0
         self.freqs = NULL
 
     def __dealloc__(self):
@@ -503,25 +344,64 @@ cdef class Alignment:
         if self.cols != NULL:
             free(self.cols)
             self.cols = NULL
+        if self.packBits != 0:
+            CxPackDelete(&self.packed)
+            self.packBits = 0
         if self.freqs != NULL:
             free(self.freqs)
             self.freqs = NULL
 
     def __init__(self, CTMatrix matrix=None, str pad=None,
       Taxa.Map taxaMap=None, int nchars=-1, type charType=Dna,
-      bint rowMajor=True, bint colMajor=False):
+      bint rowMajor=True, bint colMajor=False, input=None,
+      unsigned packBits=0):
         cdef int ntaxa, i, j
-        cdef list taxa
+        cdef list taxa, rows
         cdef Taxon taxon
+        cdef Fasta.Reader reader
+        cdef char *chars
+        cdef uint64_t length
+        cdef bint adopt, temp
 
         assert issubclass(charType, Character)
         assert pad is None or \
           (len(pad) == 1 and pad[0] in charType.get().codes())
 
-        if not rowMajor and not colMajor:
-            raise ValueError("Enable at least one of {rowMajor,colMajor}")
+        if not rowMajor and not colMajor and packBits == 0:
+            raise ValueError(
+              "Enable at least one of {rowMajor,colMajor,packBits}")
+        # If only packed storage is requested, fill in a temporary row-major
+        # matrix first.
+        temp = not rowMajor and not colMajor
+        if temp:
+            rowMajor = True
+
+        reader = None
+        adopt = False
+        if input is not None:
+            if matrix is not None:
+                raise ValueError("Specify at most one of {matrix,input}")
+            # Read FASTA input directly, rather than via a CTMatrix.
+            reader = Fasta.Reader(input, charType)
+            rows = reader.rowsLast()
+            taxa = [reader.getTaxa()[i] for i in rows]
+            taxaMap = Taxa.Map(taxa)
+            ntaxa = taxaMap.ntaxa
 
-        if matrix is not None:
+            reader.rowChars(rows[0], &length)
+            nchars = length
+            adopt = (rowMajor and len(rows) == reader.getNrows())
+            for 0 <= i < ntaxa:
+                reader.rowChars(rows[i], &length)
+                if length != nchars:
+                    adopt = False
+                    if pad is None:
+                        raise ValueError(
+                          "Inconsistent sequence lengths (%d vs. %d)" %
+                          (nchars, length))
+                    if length > nchars:
+                        nchars = length
+        elif matrix is not None:
             charType = matrix.charType
             taxaMap = Taxa.Map(matrix.taxaMap.taxaGet())
             ntaxa = taxaMap.ntaxa
@@ -557,7 +437,11 @@ cdef class Alignment:
         self.rowMajor = rowMajor
         self.colMajor = colMajor
         if rowMajor:
-            self.rows = self._allocMatrix(ntaxa, nchars, pad)
+            if adopt:
+                # The reader's buffer is already in row-major order.
+                self.rows = reader.charsTake()
+            else:
+                self.rows = self._allocMatrix(ntaxa, nchars, pad)
         if colMajor:
             self.cols = self._allocMatrix(ntaxa, nchars, pad)
         self.freqs = <unsigned *>malloc(nchars * sizeof(unsigned))
@@ -566,13 +450,29 @@ cdef class Alignment:
         for 0 <= j < nchars:
             self.freqs[j] = 1
 
-        if matrix is not None:
+        if reader is not None:
+            # Fill in matrix.
+            if adopt:
+                if colMajor:
+                    for 0 <= i < ntaxa:
+                        for 0 <= j < nchars:
+                            self.cols[i + j*ntaxa] = self.rows[i*nchars + j]
+            else:
+                for 0 <= i < ntaxa:
+                    chars = reader.rowChars(rows[i], &length)
+                    self.setRow(i, 0, chars, length)
+        elif matrix is not None:
             # Fill in matrix.
             i = 0
             for taxon in taxa:
                 self.setSeq(i, 0, matrix.dataGet(taxon))
                 i += 1
 
+        if packBits != 0:
+            self.pack(packBits)
+            if temp:
+                self.deRow()
+
     cdef char *_allocMatrix(self, int ntaxa, int nchars, str pad) except NULL:
         cdef char *ret
         cdef char *padS
@@ -587,14 +487,43 @@ cdef class Alignment:
 
         return ret
 
+    # Unpack the packed matrix into cells, where cell (i,j) is
+    # cells[i*rowStride + j*colStride].  Character codes come out canonized.
+    cdef void _unpackMatrix(self, char *cells, uint64_t rowStride,
+      uint64_t colStride) except *:
+        cdef Character char_
+        cdef char val2code[16]
+        cdef uint8_t *vals
+        cdef str code
+        cdef unsigned i, j
+
+        assert self.packBits != 0
+
+        char_ = self.charType.get()
+        for 0 <= i < 16:
+            code = char_.val2code(i)
+            val2code[i] = (<char *>code)[0]
+
+        vals = <uint8_t *>malloc(self.nchars)
+        if vals == NULL:
+            raise MemoryError("Error allocating vals")
+        for 0 <= i < self.ntaxa:
+            CxPackRowGet(&self.packed, i, 0, self.nchars, vals)
+            for 0 <= j < self.nchars:
+                cells[i*rowStride + j*colStride] = val2code[vals[j]]
+        free(vals)
+
     cdef void _initRowMajor(self) except *:
         assert not self.rowMajor
         assert self.rows == NULL
 
         self.rows = self._allocMatrix(self.ntaxa, self.nchars, None)
-        for 0 <= i < self.ntaxa:
-            for 0 <= j < self.nchars:
-                self.rows[i*self.nchars + j] = self.cols[i + j*self.ntaxa]
+        if self.colMajor:
+            for 0 <= i < self.ntaxa:
+                for 0 <= j < self.nchars:
+                    self.rows[i*self.nchars + j] = self.cols[i + j*self.ntaxa]
+        else:
+            self._unpackMatrix(self.rows, self.nchars, 1)
         self.rowMajor = True
 
     cdef void _initColMajor(self) except *:
@@ -602,9 +531,12 @@ cdef class Alignment:
         assert self.cols == NULL
 
         self.cols = self._allocMatrix(self.ntaxa, self.nchars, None)
-        for 0 <= i < self.ntaxa:
-            for 0 <= j < self.nchars:
-                self.cols[i + j*self.ntaxa] = self.rows[i*self.nchars + j]
+        if self.rowMajor:
+            for 0 <= i < self.ntaxa:
+                for 0 <= j < self.nchars:
+                    self.cols[i + j*self.ntaxa] = self.rows[i*self.nchars + j]
+        else:
+            self._unpackMatrix(self.cols, 1, self.ntaxa)
         self.colMajor = True
 
     cpdef pad(self, str pad, int npad):
@@ -613,12 +545,15 @@ cdef class Alignment:
         """
         cdef char *rows, *cols
         cdef unsigned *freqs
-        cdef unsigned i, j
+        cdef unsigned i, j, bits
+        cdef bint temp
 
         assert len(pad) == 1
         assert pad[0] in self.charType.get().codes()
         assert npad > 0
 
+        bits = self._unPack(&temp)
+
         # Re-allocate.
         rows = cols = freqs = NULL
         try:
@@ -661,6 +596,8 @@ cdef class Alignment:
         self.nchars += npad
         self.npad += npad
 
+        self._rePack(bits, temp)
+
     cpdef deRow(self):
         """
             Discard row-major matrix.
@@ -681,6 +618,93 @@ cdef class Alignment:
         self.cols = NULL
         self.colMajor = False
 
+    cpdef pack(self, unsigned bits=4):
+        """
+            Create a bit-packed copy of the matrix, with 'bits' (4 or 2) bits
+            per cell.  Only DNA alignments can be packed.
+
+            In 4-bit mode, each cell stores the set of states that its
+            character code represents (A=1, C=2, G=4, T=8, ambiguity codes as
+            unions, and gaps as 0).  In 2-bit mode, each cell stores a single
+            state, and the cells that contain gaps or ambiguity codes are
+            recorded in a sparse exception list, so this mode is best suited
+            to mostly unambiguous data.
+
+            Distance calculations and likelihood tip initialization read the
+            packed matrix directly.  Row-major and column-major storage can be
+            discarded via deRow()/deCol(), in which case it is re-created on
+            demand from the packed matrix, with canonized character codes (see
+            canonize()).
+        """
+        cdef Character char_
+        cdef str code
+        cdef unsigned i
+
+        if bits != 2 and bits != 4:
+            raise ValueError("Unsupported packing: %d bits" % bits)
+        if self.charType is not Dna:
+            raise ValueError("Only DNA alignments can be packed")
+
+        if self.packBits != 0:
+            self.dePack()
+
+        char_ = self.charType.get()
+        memset(self.code2val, 0, sizeof(self.code2val))
+        for code in char_.codes():
+            self.code2val[<uint8_t>(<char *>code)[0]] = char_.code2val(code)
+
+        if self.rowMajor:
+            if CxPackNew(&self.packed, bits, self.ntaxa, self.nchars, \
+              self.rows, self.nchars, 1, self.code2val):
+                raise MemoryError("Packed matrix allocation failed")
+        else:
+            if CxPackNew(&self.packed, bits, self.ntaxa, self.nchars, \
+              self.cols, 1, self.ntaxa, self.code2val):
+                raise MemoryError("Packed matrix allocation failed")
+        self.packBits = bits
+
+    cpdef dePack(self):
+        """
+            Discard bit-packed matrix.  If it is the only storage, create a
+            row-major matrix first.
+        """
+        assert self.packBits != 0
+
+        if not self.rowMajor and not self.colMajor:
+            self._initRowMajor()
+        CxPackDelete(&self.packed)
+        self.packBits = 0
+
+    # Discard the packed matrix (if any) prior to restructuring the alignment.
+    # Return the packing mode to be passed to _rePack(), and set *rTemp to
+    # indicate whether row-major storage had to be created.
+    cdef unsigned _unPack(self, bint *rTemp) except *:
+        cdef unsigned ret
+
+        ret = self.packBits
+        rTemp[0] = (ret != 0 and not self.rowMajor and not self.colMajor)
+        if ret != 0:
+            self.dePack()
+
+        return ret
+
+    cdef void _rePack(self, unsigned bits, bint temp) except *:
+        if bits != 0:
+            self.pack(bits)
+            if temp:
+                self.deRow()
+
+    # Get the frequency vector to pass to CxPackStats() in place of freqs,
+    # which is NULL if all frequencies are 1, so that the word-parallel method
+    # can be used.
+    cdef unsigned *_packFreqs(self, unsigned *freqs):
+        cdef unsigned j
+
+        for 0 <= j < self.nchars:
+            if freqs[j] != 1:
+                return freqs
+        return NULL
+
     cdef void setRow(self, int row, int col, char *chars, unsigned len) \
       except *:
         cdef unsigned j
@@ -695,6 +719,12 @@ cdef class Alignment:
             for 0 <= j < len:
                 self.cols[row + (self.ntaxa * (col + j))] = chars[col + j]
 
+        if self.packBits != 0:
+            for 0 <= j < len:
+                if CxPackSet(&self.packed, row, col + j, \
+                  self.code2val[<uint8_t>chars[j]]):
+                    raise MemoryError("Packed matrix update failed")
+
     cdef void setCol(self, int row, int col, char *chars, unsigned len) \
       except *:
         cdef unsigned i
@@ -709,6 +739,12 @@ cdef class Alignment:
             for 0 <= i < len:
                 self.rows[(self.nchars * (row + i)) + col] = chars[row + i]
 
+        if self.packBits != 0:
+            for 0 <= i < len:
+                if CxPackSet(&self.packed, row + i, col, \
+                  self.code2val[<uint8_t>chars[i]]):
+                    raise MemoryError("Packed matrix update failed")
+
     cdef char *getRow(self, int row) except NULL:
         assert row < self.ntaxa
 
@@ -784,11 +820,13 @@ cdef class Alignment:
 
     cdef void _fitchCanonize(self, Character char_) except *:
         cdef int trans[128], fTrans[sizeof(int) << 3]
-        cdef unsigned nstates, i, j, fSeen
-        cdef bint wasColMajor
+        cdef unsigned nstates, i, j, fSeen, bits
+        cdef bint wasColMajor, temp
         cdef char *col
         cdef int val, bit
 
+        bits = self._unPack(&temp)
+
         # Column-major storage is used below, so keep track of whether to
         # discard it afterwards.
         wasColMajor = self.colMajor
@@ -853,6 +891,8 @@ cdef class Alignment:
         if not wasColMajor:
             self.deCol()
 
+        self._rePack(bits, temp)
+
     cpdef canonize(self, bint fitch=False):
         """
             Convert all character aliases to their equivalent primary codes.
@@ -886,66 +926,6 @@ cdef class Alignment:
         if fitch:
             self._fitchCanonize(char_)
 
-    # Discard parsimony-uninformative sites.
-    cdef int _fitchCompact(self, list deco) except -1:
-        cdef ret
-        cdef Character char_
-        cdef int freqs[sizeof(int) << 3]
-        cdef unsigned nstates, i, j, fSeen, fMult
-        cdef int val, bit
-
-        char_ = self.charType.get()
-        nstates = char_.nstates
-
-        ret = 0
-        j = 0
-        while j < len(deco):
-            # Scan down the column and count the number of times each character
-            # state appears.
-            for 0 <= i < nstates:
-                freqs[i] = 0
-            fSeen = 0
-            col = deco[j][0]
-            informative = False
-            i = 0
-            while not informative and i < self.ntaxa:
-                val = char_.code2val(col[i])
-                while val != 0:
-                    bit = ffs(val) - 1
-                    val ^= 1 << bit
-                    freqs[bit] += 1
-                    if freqs[bit] == 1:
-                        fSeen += 1
-                        if fSeen > 2:
-                            informative = True
-                            break
-                i += 1
-            if not informative and fSeen == 2:
-                # This site is actually informative if both states occur more
-                # than once.
-                fMult = 0
-                i = 0
-                while fMult < 2 and i < nstates:
-                    if freqs[i] != 0:
-                        if freqs[i] == 1:
-                            break
-                        fMult += 1
-                    i += 1
-                if fMult == 2:
-                    informative = True
-
-            if informative:
-                j += 1
-            else:
-                # Only count changes for variable sites.
-                if fSeen == 2:
-                    # Count one change per multiple of the site frequency.
-                    ret += deco[j][1]
-                # Discard the uninformative site.
-                deco.pop(j)
-
-        return ret
-
     cpdef int compact(self, bint fitch=False):
         """
             Compact the alignment such that each site pattern is stored at most
@@ -963,72 +943,85 @@ cdef class Alignment:
             included when computing total tree length.
         """
         cdef int ret
-        cdef bint wasColMajor
-        cdef list deco
-        cdef unsigned j
+        cdef bint wasColMajor, temp
+        cdef unsigned i, j, bits
+        cdef uint32_t npats
+        cdef uint32_t *pats
         cdef char *rows, *cols
         cdef unsigned *freqs
+        cdef Character char_
+        cdef int code2val[256]
+        cdef str code
 
-        # Column-major storage is implicitly triggered by method calls below,
-        # so keep track of whether to discard it afterwards.
+        bits = self._unPack(&temp)
+
+        # Column-major storage is implicitly triggered below, so keep track of
+        # whether to discard it afterwards.
         wasColMajor = self.colMajor
 
         self.canonize(fitch)
+        if not self.colMajor:
+            self._initColMajor()
 
-        # Create an association of chars/freqs, so that they can be sorted
-        # together.
-        deco = [[self.getChar(j), self.freqs[j]] for j in xrange(self.nchars)]
-        deco.sort()
-
-        # Merge adjacent equivalent characters.
-        j = 1
-        while j < len(deco):
-            if deco[j][0] == deco[j-1][0]:
-                deco[j-1][1] += deco[j][1]
-                deco.pop(j)
+        # Hash the columns to find the distinct site patterns, in the same
+        # (sorted) order as the character data would sort as strings.
+        rows = cols = NULL
+        pats = <uint32_t *>malloc(self.nchars * sizeof(uint32_t))
+        freqs = <unsigned *>malloc(self.nchars * sizeof(unsigned))
+        try:
+            if pats == NULL or freqs == NULL:
+                raise MemoryError("Pattern allocation failed")
+            if CxPatternCompact(self.cols, self.ntaxa, self.nchars, \
+              self.freqs, pats, freqs, &npats):
+                raise MemoryError("Pattern compaction failed")
+
+            if fitch:
+                # Discard parsimony-uninformative sites.
+                char_ = self.charType.get()
+                memset(code2val, 0, sizeof(code2val))
+                for code in char_.codes():
+                    code2val[<unsigned char>(<char *>code)[0]] = \
+                      char_.code2val(code)
+                ret = CxPatternFitch(self.cols, self.ntaxa, code2val, \
+                  char_.nstates, pats, freqs, &npats)
             else:
-                j += 1
+                ret = 0
 
-        if fitch:
-            ret = self._fitchCompact(deco)
-        else:
-            ret = 0
-
-        # Re-initialize.
-        rows = cols = freqs = NULL
-        try:
+            # Re-initialize.
             if self.rowMajor:
-                rows = self._allocMatrix(self.ntaxa, len(deco), None)
-            if self.colMajor:
-                cols = self._allocMatrix(self.ntaxa, len(deco), None)
-            freqs = <unsigned *>malloc(len(deco) * sizeof(unsigned))
-            if freqs == NULL:
-                raise MemoryError()
+                rows = self._allocMatrix(self.ntaxa, npats, None)
+            cols = self._allocMatrix(self.ntaxa, npats, None)
         except:
             if rows != NULL:
                 free(rows)
-            if cols != NULL:
-                free(cols)
-            assert freqs == NULL
-            raise MemoryError("Matrix allocation failed")
-
-        if self.rowMajor:
-            free(self.rows)
-            self.rows = rows
-        assert self.colMajor
+            if pats != NULL:
+                free(pats)
+            if freqs != NULL:
+                free(freqs)
+            raise
+
+        for 0 <= j < npats:
+            memcpy(&cols[<uint64_t>j * self.ntaxa], \
+              &self.cols[<uint64_t>pats[j] * self.ntaxa], self.ntaxa)
+        free(pats)
         free(self.cols)
         self.cols = cols
         free(self.freqs)
         self.freqs = freqs
+        self.nchars = npats
 
-        self.nchars = len(deco)
-        for 0 <= j < len(deco):
-            self.setChar(0, j, deco[j][0])
-            self.freqs[j] = deco[j][1]
+        if self.rowMajor:
+            for 0 <= i < self.ntaxa:
+                for 0 <= j < self.nchars:
+                    rows[i*self.nchars + j] = self.cols[i + j*self.ntaxa]
+            free(self.rows)
+            self.rows = rows
 
         if not wasColMajor:
             self.deCol()
 
+        self._rePack(bits, temp)
+
         return ret
 
     cdef void _renderLine(self, str line, list lines, file outFile) except *:
@@ -1186,7 +1179,56 @@ cdef class Alignment:
         else:
             return None
 
-    cpdef DistMatrix dists(self, bint scoreGaps=True):
+    # Get the column weights to use in place of freqs for distance
+    # computation: freqs itself if weights is None, otherwise a newly
+    # allocated copy of weights, which the caller must free.
+    cdef unsigned *_weightsGet(self, weights) except NULL:
+        cdef unsigned *ret
+        cdef unsigned j
+
+        if weights is None:
+            return self.freqs
+
+        if len(weights) != self.nchars:
+            raise ValueError("Expected %d weights, got %d" % (self.nchars,
+              len(weights)))
+        ret = <unsigned *>malloc(self.nchars * sizeof(unsigned))
+        if ret == NULL:
+            raise MemoryError("Error allocating weights")
+        try:
+            for 0 <= j < self.nchars:
+                ret[j] = weights[j]
+        except:
+            free(ret)
+            raise
+        return ret
+
+    cdef void _pctDists(self, DistMatrix m, unsigned *freqs, bint scoreGaps) \
+      except *:
+        cdef PctIdent tab
+        cdef int i, j
+        cdef char *iRow, *jRow
+        cdef unsigned nvalid
+        cdef float fident, dist
+
+        if self.charType is Dna:
+            self._packDists(m, freqs, CxeDistPct, scoreGaps)
+            return
+
+        tab = PctIdent(self.charType, scoreGaps)
+        for 0 <= i < self.ntaxa:
+            iRow = self.getRow(i)
+            for i + 1 <= j < self.ntaxa:
+                jRow = self.getRow(j)
+                tab.stats(iRow, jRow, self.nchars, freqs, &fident, &nvalid)
+                if nvalid > 0:
+                    dist = 1.0 - (fident / <float>nvalid)
+                else:
+                    dist = 1.0
+                m.distanceSet(i, j, dist)
+
+    cpdef DistMatrix dists(self, bint scoreGaps=True, str path=None,
+      weights=None):
         """
             Calculate uncorrected pairwise distances.
 
@@ -1195,33 +1237,32 @@ cdef class Alignment:
 
             If scoreGaps is enabled, gaps are treated as being ambiguous,
             rather than as missing.
+
+            If path is specified, the distances are written to a memory-mapped
+            matrix file at that path as they are computed (see
+            Crux.DistMatrix.DistMatrix).
+
+            If weights is specified, it is a sequence of per-column weights to
+            use in place of the column frequencies (see getFreq()), e.g. for
+            bootstrap resampling.
         """
         cdef DistMatrix ret
-        cdef PctIdent tab
-        cdef int i, j
-        cdef char *iRow, *jRow
-        cdef unsigned nvalid
-        cdef float fident, dist
+        cdef unsigned *freqs
 
-        ret = DistMatrix(self.taxaMap)
+        ret = DistMatrix(self.taxaMap, path=path)
 
         if self.ntaxa > 1:
-            tab = PctIdent(self.charType, scoreGaps)
-            for 0 <= i < self.ntaxa:
-                iRow = self.getRow(i)
-                for i + 1 <= j < self.ntaxa:
-                    jRow = self.getRow(j)
-                    tab.stats(iRow, jRow, self.nchars, self.freqs, &fident, \
-                      &nvalid)
-                    if nvalid > 0:
-                        dist = 1.0 - (fident / <float>nvalid)
-                    else:
-                        dist = 1.0
-                    ret.distanceSet(i, j, dist)
+            freqs = self._weightsGet(weights)
+            try:
+                self._pctDists(ret, freqs, scoreGaps)
+            finally:
+                if freqs != self.freqs:
+                    free(freqs)
 
         return ret
 
-    cpdef DistMatrix jukesDists(self, bint scoreGaps=True):
+    cpdef DistMatrix jukesDists(self, bint scoreGaps=True, str path=None,
+      weights=None):
         """
             Calculate pairwise distances, corrected for multiple hits using the
             Jukes-Cantor method, and the computational methods described by:
@@ -1234,60 +1275,89 @@ cdef class Alignment:
 
             If scoreGaps is enabled, gaps are treated as being ambiguous,
             rather than as missing.
+
+            If path is specified, the distances are written to a memory-mapped
+            matrix file at that path as they are computed (see
+            Crux.DistMatrix.DistMatrix).
+
+            If weights is specified, it is used in place of the column
+            frequencies, as for dists().
         """
         cdef DistMatrix ret
+        cdef unsigned *freqs
+
+        ret = DistMatrix(self.taxaMap, path=path)
+
+        if self.ntaxa > 1:
+            freqs = self._weightsGet(weights)
+            try:
+                self._jukesDists(ret, freqs, scoreGaps)
+            finally:
+                if freqs != self.freqs:
+                    free(freqs)
+
+        return ret
+
+    cdef void _jukesDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *:
         cdef PctIdent tab
         cdef int nstates, i, j
         cdef char *iRow, *jRow
         cdef unsigned n, x
         cdef float fident, k, b, p, d, t
 
-        ret = DistMatrix(self.taxaMap)
+        if self.charType is Dna:
+            self._packDists(m, freqs, CxeDistJukes, scoreGaps)
+            return
 
-        if self.ntaxa > 1:
-            tab = PctIdent(self.charType, scoreGaps)
-            nstates = self.charType.get().nstates
-            b = <float>(nstates - 1) / <float>nstates
-
-            for 0 <= i < self.ntaxa:
-                iRow = self.getRow(i)
-                for i + 1 <= j < self.ntaxa:
-                    jRow = self.getRow(j)
-                    tab.stats(iRow, jRow, self.nchars, self.freqs, &fident, &n)
-                    if n > 0:
-                        k = <float>n - fident
-                        p = k / <float>n
-
-                        d = 0.0
-                        t = b
-                        for 1 <= x <= <unsigned>k:
-                            t *= ((k / <float>(x * n))) / b
-                            d += t
-                            if t < FLT_EPSILON:
-                                # Terms in the summation monotonically decrease,
-                                # so there's no point in continuing.
-                                break
-                    else:
-                        d = NAN
-                    ret.distanceSet(i, j, d)
-
-        return ret
-
-    cdef void _kimuraDistsDNA(self, DistMatrix m, bint scoreGaps):
-        cdef K2p k2p
-        cdef int a, b
-        cdef char *aRow, *bRow
-        cdef double d
+        tab = PctIdent(self.charType, scoreGaps)
+        nstates = self.charType.get().nstates
+        b = <float>(nstates - 1) / <float>nstates
 
-        k2p = K2p(scoreGaps)
-        for 0 <= a < self.ntaxa:
-            aRow = self.getRow(a)
-            for a + 1 <= b < self.ntaxa:
-                bRow = self.getRow(b)
-                d = k2p.dist(aRow, bRow, self.nchars, self.freqs)
-                m.distanceSet(a, b, d)
+        for 0 <= i < self.ntaxa:
+            iRow = self.getRow(i)
+            for i + 1 <= j < self.ntaxa:
+                jRow = self.getRow(j)
+                tab.stats(iRow, jRow, self.nchars, freqs, &fident, &n)
+                if n > 0:
+                    k = <float>n - fident
+                    p = k / <float>n
 
-    cdef void _kimuraDistsProtein(self, DistMatrix m, bint scoreGaps):
+                    d = 0.0
+                    t = b
+                    for 1 <= x <= <unsigned>k:
+                        t *= ((k / <float>(x * n))) / b
+                        d += t
+                        if t < FLT_EPSILON:
+                            # Terms in the summation monotonically decrease,
+                            # so there's no point in continuing.
+                            break
+                else:
+                    d = NAN
+                m.distanceSet(i, j, d)
+
+    cdef void _packDists(self, DistMatrix m, unsigned *freqs, CxeDist method, \
+      bint scoreGaps) except *:
+        cdef bint temp
+
+        # DNA distances are computed from the packed matrix, in parallel.
+        # Pack temporarily if necessary.
+        temp = (self.packBits == 0)
+        if temp:
+            self.pack(4)
+        try:
+            CxDistPack(&self.packed, self._packFreqs(freqs), scoreGaps, \
+              method, m.dists)
+        finally:
+            if temp:
+                self.dePack()
+
+    cdef void _kimuraDistsDNA(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *:
+        self._packDists(m, freqs, CxeDistK2p, scoreGaps)
+
+    cdef void _kimuraDistsProtein(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *:
         cdef PctIdent tab
         cdef int a, b
         cdef char *aRow, *bRow
@@ -1319,7 +1389,7 @@ cdef class Alignment:
             aRow = self.getRow(a)
             for a + 1 <= b < self.ntaxa:
                 bRow = self.getRow(b)
-                tab.stats(aRow, bRow, self.nchars, self.freqs, &fident, &n)
+                tab.stats(aRow, bRow, self.nchars, freqs, &fident, &n)
                 if n == 0:
                     m.distanceSet(a, b, NAN)
                     continue
@@ -1341,7 +1411,18 @@ cdef class Alignment:
 
                 m.distanceSet(a, b, d)
 
-    cpdef DistMatrix kimuraDists(self, bint scoreGaps=True):
+    cdef void _kimuraDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *:
+        if self.charType is Dna:
+            self._kimuraDistsDNA(m, freqs, scoreGaps)
+        elif self.charType is Protein:
+            self._kimuraDistsProtein(m, freqs, scoreGaps)
+        else:
+            raise ValueError(
+              "Unsupported character type for Kimura distance correction")
+
+    cpdef DistMatrix kimuraDists(self, bint scoreGaps=True, str path=None,
+      weights=None):
         """
             Calculate corrected pairwise distances.
 
@@ -1386,24 +1467,77 @@ cdef class Alignment:
             states are equally likely, so this option tends to substantially
             increase distance, due to unlikely mutations being highly
             represented.
+
+            If path is specified, the distances are written to a memory-mapped
+            matrix file at that path as they are computed (see
+            Crux.DistMatrix.DistMatrix).
+
+            If weights is specified, it is used in place of the column
+            frequencies, as for dists().
         """
         cdef DistMatrix ret
+        cdef unsigned *freqs
 
-        ret = DistMatrix(self.taxaMap)
+        ret = DistMatrix(self.taxaMap, path=path)
 
         if self.ntaxa > 1:
-            if self.charType is Dna:
-                self._kimuraDistsDNA(ret, scoreGaps)
-            elif self.charType is Protein:
-                self._kimuraDistsProtein(ret, scoreGaps)
-            else:
-                raise ValueError(
-                  "Unsupported character type for Kimura distance correction")
+            freqs = self._weightsGet(weights)
+            try:
+                self._kimuraDists(ret, freqs, scoreGaps)
+            finally:
+                if freqs != self.freqs:
+                    free(freqs)
 
         return ret
 
+    cdef void _logdetDists(self, DistMatrix m, unsigned *freqs, \
+      bint scoreGaps) except *:
+        cdef LogDet logDet
+        cdef int i, j
+        cdef char *iRow, *jRow
+
+        if self.charType is Dna:
+            self._packDists(m, freqs, CxeDistLogDet, scoreGaps)
+            return
+
+        logDet = LogDet(self.charType, scoreGaps)
+        for 0 <= i < self.ntaxa:
+            iRow = self.getRow(i)
+            for i + 1 <= j < self.ntaxa:
+                jRow = self.getRow(j)
+                logDet.count(iRow, jRow, self.nchars, freqs)
+                m.distanceSet(i, j, logDet.dist())
+
+    # Handle NaN distances computed by _logdetDists(), as specified by the nan
+    # parameter to logdetDists().
+    cdef void _logdetNan(self, DistMatrix m, str nan) except *:
+        cdef int i, j
+        cdef double d, max
+        cdef bint convertNan
+
+        convertNan = False
+        max = 0.0
+        for 0 <= i < self.ntaxa:
+            for i + 1 <= j < self.ntaxa:
+                d = m.distanceGet(i, j)
+                if isnan(d):
+                    if nan == "error":
+                        raise OverflowError("NaN at (%d,%d)" % (i, j))
+                    elif nan == "convert":
+                        convertNan = True
+                else:
+                    if d > max:
+                        max = d
+
+        if convertNan:
+            for 0 <= i < self.ntaxa:
+                for i + 1 <= j < self.ntaxa:
+                    d = m.distanceGet(i, j)
+                    if isnan(d):
+                        m.distanceSet(i, j, max*2.0)
+
     cpdef DistMatrix logdetDists(self, bint scoreGaps=True, \
-      str nan="error"):
+      str nan="error", str path=None, weights=None):
         """
             Calculate pairwise distances, corrected for unequal state
             frequencies using the LogDet/paralinear method described by:
@@ -1439,43 +1573,176 @@ cdef class Alignment:
             optionally be allowed (nan="allow") or arbitrarily converted to be
             twice the maximum computable distance in the resulting distance
             matrix (nan="convert").
+
+            If path is specified, the distances are written to a memory-mapped
+            matrix file at that path as they are computed (see
+            Crux.DistMatrix.DistMatrix).
+
+            If weights is specified, it is used in place of the column
+            frequencies, as for dists().
         """
         cdef DistMatrix ret
-        cdef LogDet logDet
-        cdef int i, j
-        cdef char *iRow, *jRow
-        cdef double d, max
-        cdef bint convertNan
+        cdef unsigned *freqs
 
         assert nan in ("error", "allow", "convert")
 
-        ret = DistMatrix(self.taxaMap)
+        ret = DistMatrix(self.taxaMap, path=path)
 
         if self.ntaxa > 1:
-            logDet = LogDet(self.charType, scoreGaps)
+            freqs = self._weightsGet(weights)
+            try:
+                self._logdetDists(ret, freqs, scoreGaps)
+            finally:
+                if freqs != self.freqs:
+                    free(freqs)
+            self._logdetNan(ret, nan)
 
-            convertNan = False
-            max = 0.0
-            for 0 <= i < self.ntaxa:
-                iRow = self.getRow(i)
-                for i + 1 <= j < self.ntaxa:
-                    jRow = self.getRow(j)
-                    d = logDet.dist(iRow, jRow, self.nchars, self.freqs)
-                    if isnan(d):
-                        if nan == "error":
-                            raise OverflowError("NaN at (%d,%d)" % (i, j))
-                        elif nan == "convert":
-                            convertNan = True
-                    else:
-                        if d > max:
-                            max = d
-                    ret.distanceSet(i, j, d)
+        return ret
+
+    # Compute distances of the specified type (as for bootstrap()) into m,
+    # using column weights freqs.
+    cdef void _bootDists(self, DistMatrix m, str dists, unsigned *freqs, \
+      bint scoreGaps) except *:
+        if dists == "pct":
+            self._pctDists(m, freqs, scoreGaps)
+        elif dists == "jukes":
+            self._jukesDists(m, freqs, scoreGaps)
+        elif dists == "kimura":
+            self._kimuraDists(m, freqs, scoreGaps)
+        elif dists == "logdet":
+            self._logdetDists(m, freqs, scoreGaps)
+        else:
+            assert False
 
-            if convertNan:
-                for 0 <= i < self.ntaxa:
-                    for i + 1 <= j < self.ntaxa:
-                        d = ret.distanceGet(i, j)
-                        if isnan(d):
-                            ret.distanceSet(i, j, max*2.0)
+    cpdef bootstrap(self, unsigned nreps, str dists="pct", \
+      bint scoreGaps=True, str nan="error", str joiner="rnj", \
+      bint joinRandom=True, bint tryAdditive=True):
+        """
+            Perform a nonparametric bootstrap analysis, and return a
+            Crux.Tree.Sumt that summarizes the nreps replicate trees.  The
+            Sumt's parts are the replicate splits, and getConTree() computes
+            a consensus tree with bootstrap support values.
+
+            Each replicate resamples the alignment's sites with replacement,
+            which is represented as a vector of column weights (a multinomial
+            draw over the column frequencies), rather than as a copy of the
+            alignment.  Distances ('pct', 'jukes', 'kimura', or 'logdet', with
+            scoreGaps and nan as for the corresponding methods) are computed
+            using the weights, and a tree is constructed via 'rnj' (with
+            joinRandom and tryAdditive as for DistMatrix.rnj()), 'nj' (with
+            joinRandom as for DistMatrix.nj()), or 'rapid' (DistMatrix.nj()
+            with rapid=True).
+
+            For DNA, the distance matrices for multiple replicates are
+            computed at once, so that all threads are kept busy even for
+            alignments with few taxa.
+        """
+        cdef CxtBoot boot
+        cdef sfmt_t *prng
+        cdef unsigned **freqs
+        cdef float **mats
+        cdef CxeDist method
+        cdef uint64_t matBytes
+        cdef unsigned batch, nmats, i
+        cdef bint temp
+        cdef list trees, ms
+        cdef DistMatrix m
+        cdef Tree tree
 
-        return ret
+        assert nan in ("error", "allow", "convert")
+        assert joiner in ("rnj", "nj", "rapid")
+        if dists == "pct":
+            method = CxeDistPct
+        elif dists == "jukes":
+            method = CxeDistJukes
+        elif dists == "kimura":
+            if self.charType is not Dna and self.charType is not Protein:
+                raise ValueError("Unsupported character type for Kimura "
+                  "distance correction")
+            method = CxeDistK2p
+        elif dists == "logdet":
+            method = CxeDistLogDet
+        else:
+            assert False
+
+        # Limit the number of matrices that are computed at once, both by
+        # the number of CPUs and by memory usage.
+        matBytes = ((<uint64_t>self.ntaxa * (self.ntaxa - 1)) >> 1) \
+          * sizeof(float)
+        batch = CxNcpus if CxNcpus > 0 else 1
+        if batch > nreps:
+            batch = nreps
+        while batch > 1 and batch * matBytes > _bootBatchBytes:
+            batch -= 1
+
+        if CxBootNew(&boot, self.freqs, self.nchars):
+            raise MemoryError("Error initializing bootstrap")
+        prng = NULL
+        freqs = NULL
+        mats = NULL
+        temp = False
+        try:
+            prng = init_gen_rand(random.randint(0, 0xffffffffU))
+            if prng == NULL:
+                raise MemoryError("Error initializing prng")
+            freqs = <unsigned **>calloc(batch, sizeof(unsigned *))
+            mats = <float **>calloc(batch, sizeof(float *))
+            if freqs == NULL or mats == NULL:
+                raise MemoryError("Error allocating bootstrap weights")
+            for 0 <= i < batch:
+                freqs[i] = <unsigned *>malloc(self.nchars * sizeof(unsigned))
+                if freqs[i] == NULL:
+                    raise MemoryError("Error allocating bootstrap weights")
+
+            if self.charType is Dna and self.ntaxa > 1:
+                temp = (self.packBits == 0)
+                if temp:
+                    self.pack(4)
+
+            trees = []
+            while len(trees) < nreps:
+                nmats = nreps - len(trees)
+                if nmats > batch:
+                    nmats = batch
+
+                ms = []
+                for 0 <= i < nmats:
+                    CxBootWeights(&boot, prng, freqs[i])
+                    m = DistMatrix(self.taxaMap)
+                    ms.append(m)
+                    mats[i] = m.dists
+                if self.ntaxa > 1:
+                    if self.charType is Dna:
+                        CxDistPackBatch(&self.packed, freqs, scoreGaps, \
+                          method, mats, nmats)
+                    else:
+                        for 0 <= i < nmats:
+                            self._bootDists(<DistMatrix>ms[i], dists, \
+                              freqs[i], scoreGaps)
+
+                for 0 <= i < nmats:
+                    m = <DistMatrix>ms[i]
+                    if dists == "logdet":
+                        self._logdetNan(m, nan)
+                    if joiner == "rnj":
+                        tree = m.rnj(joinRandom, tryAdditive, True)
+                    elif joiner == "nj":
+                        tree = m.nj(joinRandom, True)
+                    else:
+                        tree = m.nj(False, True, True)
+                    trees.append(tree)
+        finally:
+            if temp:
+                self.dePack()
+            if mats != NULL:
+                free(mats)
+            if freqs != NULL:
+                for 0 <= i < batch:
+                    if freqs[i] != NULL:
+                        free(freqs[i])
+                free(freqs)
+            if prng != NULL:
+                fini_gen_rand(prng)
+            CxBootDelete(&boot)
+
+        return Sumt([trees])
@@ -3,12 +3,15 @@ cimport Crux.Taxa as Taxa
 
 from libc cimport *
 from SFMT cimport sfmt_t
+from CxNj cimport CxtNjRapid
+from CxDistMatrixMap cimport CxtDistMatrixMap
 
 DEF NjDebug = False # Note companion DEF in Nj.pyx.
 
 cdef class Nj:
     cdef sfmt_t *prng
     cdef float *dBase, *d # d is advanced as rows are removed.
+    cdef CxtDistMatrixMap *map # Backing store for dBase, or NULL.
     cdef size_t nBase, n
     cdef float *rBase, *r
     cdef float *rScaledBase, *rScaled
@@ -31,7 +34,8 @@ cdef class Nj:
     cdef void _njDiscard(self)
     cdef void _njFinalJoin(self) except *
 
-    cdef void prepare(self, float *d, size_t n, Taxa.Map taxaMap) except *
+    cdef void prepare(self, float *d, size_t n, Taxa.Map taxaMap,
+      CxtDistMatrixMap *map=*) except *
     cdef Tree nj(self, bint random)
 
 cdef class Rnj(Nj):
@@ -43,3 +47,9 @@ cdef class Rnj(Nj):
     cdef bint _rnjRandomCluster(self, bint additive) except -1
     cdef bint _rnjDeterministicCluster(self, bint additive) except -1
     cdef rnj(self, bint random, bint additive)
+
+cdef class RapidNj(Nj):
+    cdef CxtNjRapid rapid
+    cdef bint rapidValid
+
+    cdef Tree rapidNj(self)
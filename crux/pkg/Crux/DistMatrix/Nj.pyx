@@ -152,6 +152,8 @@ from libm cimport *
 
 from SFMT cimport *
 from CxRi cimport *
+from CxNj cimport *
+from CxDistMatrixMap cimport *
 
 from Crux.Tree cimport Tree, Node, Edge
 from Crux.DistMatrix cimport nxy2i
@@ -165,7 +167,7 @@ cdef union fiUnion:
     int32_t i
 
 cdef enum:
-    MaxUlps = 0x7f
+    MaxUlps = 0x7f # Note companion CxmNjMaxUlps in CxNj.h.
 
 # Compare two distances, and consider them equal if they are close enough.
 # MaxUlps (ULP: Units in Last Place) specifies the maximum number of ulps that
@@ -196,6 +198,7 @@ cdef class Nj:
         self.prng = NULL
         self.dBase = NULL
         self.d = NULL
+        self.map = NULL
         self.rBase = NULL
         self.r = NULL
         self.rScaledBase = NULL
@@ -205,7 +208,12 @@ cdef class Nj:
         if self.prng != NULL:
             fini_gen_rand(self.prng)
             self.prng = NULL
-        if self.dBase != NULL:
+        if self.map != NULL:
+            CxDistMatrixMapClose(self.map)
+            free(self.map)
+            self.map = NULL
+            self.dBase = NULL
+        elif self.dBase != NULL:
             free(self.dBase)
             self.dBase = NULL
         if self.rBase != NULL:
@@ -315,83 +323,18 @@ cdef class Nj:
         for 0 <= x < self.n:
             self.rScaled[x] = self.r[x] / denom
 
+    # Find the minimum transformed distance, so that the corresponding nodes
+    # can be joined.  This is by far the most time-consuming portion of NJ, so
+    # the search is done natively, in parallel (see CxNj.h).
     cdef void _njRandomMinFind(self, size_t *rXMin, size_t *rYMin):
-        cdef size_t nmins, i, n, x, y, xMin, yMin
-        cdef float *d, *rScaled
-        cdef float transMin, transCur, rScaledX
-
-        IF @enable_cc_silence@:
-            xMin = yMin = 0
-
-        # Calculate the transformed distance for each pairwise distance.  Keep
-        # track of the minimum transformed distance, so that the corresponding
-        # nodes can be joined.
-        #
-        # This is by far the most time-consuming portion of NJ.
-        nmins = 1
-        transMin = HUGE_VALF
-        i = 0
-        d = self.d
-        rScaled = self.rScaled
-        n = self.n
-        for 0 <= x < n:
-            rScaledX = rScaled[x]
-            for x + 1 <= y < n:
-                transCur = d[i] - (rScaledX + rScaled[y])
-                i += 1
-
-                # Use distEq() in order to compare transformed distances,
-                # so that random selection is possible.
-                if distEq(transCur, transMin):
-                    # Choose such that all tied distances have an equal
-                    # probability of being chosen.
-                    nmins += 1
-                    if gen_rand64_range(self.prng, nmins) == 0:
-                        xMin = x
-                        yMin = y
-                        transMin = transCur
-                elif transCur < transMin:
-                    nmins = 1
-                    xMin = x
-                    yMin = y
-                    transMin = transCur
-
-        rXMin[0] = xMin
-        rYMin[0] = yMin
+        # Choose such that all tied distances have an equal probability of
+        # being chosen.
+        CxNjRandomMinFind(self.d, self.rScaled, self.n, self.prng, rXMin, \
+          rYMin)
 
     cdef void _njDeterministicMinFind(self, size_t *rXMin, size_t *rYMin):
-        cdef size_t i, n, x, y, xMin, yMin
-        cdef float *d, *rScaled
-        cdef float transMin, transCur, rScaledX
-
-        IF @enable_cc_silence@:
-            xMin = yMin = 0
-
-        # Calculate the transformed distance for each pairwise distance.  Keep
-        # track of the minimum transformed distance, so that the corresponding
-        # nodes can be joined.
-        #
-        # This is by far the most time-consuming portion of NJ.
-        transMin = HUGE_VALF
-        i = 0
-        d = self.d
-        rScaled = self.rScaled
-        n = self.n
-        for 0 <= x < n:
-            rScaledX = rScaled[x]
-            for x + 1 <= y < n:
-                transCur = d[i] - (rScaledX + rScaled[y])
-                i += 1
-
-                # Since an arbitrary tie-breaking decision is being made anyway,
-                # don't bother using distEq() here.
-                if transCur < transMin:
-                    xMin = x
-                    yMin = y
-                    transMin = transCur
-
-        rXMin[0] = xMin
-        rYMin[0] = yMin
+        # Ties are broken in favor of the first minimum in matrix order.
+        CxNjMinFind(self.d, self.rScaled, self.n, rXMin, rYMin)
 
     cdef Node _njNodesJoin(self, size_t xMin, size_t yMin,
       float *rDistX, float *rDistY):
@@ -551,6 +494,9 @@ cdef class Nj:
         self.r = &self.r[1]
         self.rScaled = &self.rScaled[1]
         self.nodes.pop(0)
+        if self.map != NULL:
+            # Let the page cache drop the discarded rows.
+            CxDistMatrixMapRelease(self.map, self.d)
 
     cdef void _njFinalJoin(self) except *:
         cdef Edge edge
@@ -562,12 +508,13 @@ cdef class Nj:
 
         self.tree.base = self.nodes[0]
 
-    cdef void prepare(self, float *d, size_t n, Taxa.Map taxaMap) \
-      except *:
+    cdef void prepare(self, float *d, size_t n, Taxa.Map taxaMap,
+      CxtDistMatrixMap *map=NULL) except *:
         assert self.dBase == NULL # Was self.prepare() already called?
 
         self.dBase = d
         self.d = d
+        self.map = map
         self.nBase = n
         self.n = self.nBase
 
@@ -607,6 +554,57 @@ cdef class Nj:
 
         return self.tree
 
+# NJ, using the bounded minimum search described by:
+#
+#   Simonsen, M., T. Mailund, C.N.S. Pedersen (2008) Rapid neighbour-joining.
+#   Proc. WABI 2008, LNBI 5251:113-122.
+#
+# Each node's distances are kept sorted (see CxNj.h), so that most of each row
+# can be skipped when searching for the minimum transformed distance.  The
+# joins, and therefore the trees, are identical to those of deterministic NJ.
+cdef class RapidNj(Nj):
+    def __cinit__(self):
+        self.rapidValid = False
+
+    def __dealloc__(self):
+        if self.rapidValid:
+            CxNjRapidDelete(&self.rapid)
+            self.rapidValid = False
+
+    cdef Tree rapidNj(self):
+        cdef size_t xMin, yMin
+        cdef float distX, distY
+        cdef Node node
+
+        assert self.tree is not None # Was self.prepare() called?
+
+        if self.n > 2:
+            if CxNjRapidNew(&self.rapid, self.d, self.n):
+                raise MemoryError("Failed to allocate %d-taxon sorted matrix" %
+                  <int>self.n)
+            self.rapidValid = True
+
+        # Iteratively join two nodes in the matrix, until only two are left.
+        while self.n > 2:
+            self._rScaledUpdate()
+            IF NjDebug:
+                self._njDump()
+            CxNjRapidMinFind(&self.rapid, self.rScaled, self.n, &xMin, &yMin)
+            node = self._njNodesJoin(xMin, yMin, &distX, &distY)
+            self._njRSubtract(xMin, yMin)
+            self._njCompact(xMin, yMin, node, distX, distY)
+            if CxNjRapidJoin(&self.rapid, self.d, self.n, xMin, yMin):
+                raise MemoryError("Failed to allocate sorted matrix row")
+            self._njDiscard()
+            self.n -= 1
+
+        # Join last two nodes.
+        IF NjDebug:
+            self._njDump()
+        self._njFinalJoin()
+
+        return self.tree
+
 cdef class Rnj(Nj):
     cdef size_t _rnjRowAllMinFind(self, size_t x, float *rDist):
         cdef size_t ret, n, y, i, nmins
@@ -5,26 +5,47 @@ from Crux.Tree cimport Tree
 cimport Crux.Taxa as Taxa
 
 from libc cimport *
+from CxDistMatrixMap cimport CxtDistMatrixMap
+from CxDistMatrixParser cimport CxtDistMatrixParser
+from CxFmt cimport CxtFmt, CxtFmtSpec
 
 cdef class DistMatrix:
     cdef readonly Taxa.Map taxaMap
     cdef float *dists
+    cdef CxtDistMatrixMap *map # Backing store for dists, or NULL.
+    cdef readonly str path
     cdef readonly size_t ntaxa
     cdef readonly bint additive # Unspecified unless rnj() has been used.
 
-    cdef void _parse(self, input) except *
+    cdef void _parseRaise(self, CxtDistMatrixParser *parser) except *
+    cdef void _parse(self, input, int line=*) except *
     cdef void _allocDists(self, size_t ntaxa) except *
+    cdef void _mapError(self, CxtDistMatrixMap *map, int err) except *
+    cdef void _mapCreate(self, size_t ntaxa) except *
+    cdef void _mapOpen(self, int fd=*) except *
+    cdef str _labelsJoin(self)
+    cdef void _mapLabelsStore(self) except *
+    cdef DistMatrix _dupScratch(self)
     cdef void _dup(self, DistMatrix other, int sampleSize) except *
     cpdef float distanceGet(self, size_t x, size_t y)
     cpdef distanceSet(self, size_t x, size_t y, float distance)
-    cdef Tree _nj(self, bint random)
+    cdef Tree _nj(self, bint random, bint rapid)
     cdef Tree _rnj(self, bint random, bint additive)
     cdef void _rowsSwap(self, size_t a, size_t b)
     cdef void _matrixShuffle(self, list order) except *
     cpdef shuffle(self)
-    cpdef Tree nj(self, bint joinRandom=*, bint destructive=*)
+    cpdef Tree nj(self, bint joinRandom=*, bint destructive=*, bint rapid=*)
     cpdef Tree rnj(self, bint joinRandom=*, bint tryAdditive=*,
       bint destructive=*)
+    cdef void _renderPy(self, str format, str distFormat, file outFile) \
+      except *
+    cdef void _renderFlush(self, CxtFmt *fmt, file outFile) except *
+    cdef void _renderLabel(self, CxtFmt *fmt, size_t i, bint pad) except *
+    cdef void _renderDists(self, CxtFmt *fmt, CxtFmtSpec *spec, size_t i,
+      size_t j0, size_t j1, bint blank) except *
+    cdef void _renderFmt(self, str format, CxtFmtSpec *spec, file outFile) \
+      except *
+    cdef void _renderBinary(self, file outFile) except *
     cpdef render(self, str format=*, str distFormat=*, file outFile=*)
 
 cdef inline size_t nxy2i(size_t n, size_t x, size_t y):
@@ -18,16 +18,28 @@ cimport Crux.Tree as Tree
 
 from libc cimport *
 
-from CxDistMatrixLexer cimport *
+from CxDistMatrixMap cimport *
+from CxDistMatrixParser cimport *
+from CxFmt cimport *
 cimport Crux.DistMatrix.Nj as Nj
 
+import os
 import random
 import re
 import sys
+import tempfile
+
+cdef extern from "Python.h":
+    cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
 
 # Forward declaration.
 cdef class DistMatrix
 
+# render() accumulates output in a buffer, and writes it to the output file
+# whenever it exceeds _renderFlushLen bytes.
+cdef enum:
+    _renderFlushLen = 1024 * 1024
+
 #===============================================================================
 #
 # This parser implements a superset of the PHYLIP distance matrix format.  There
@@ -69,197 +81,8 @@ cdef class DistMatrix
 #   Taxon_D 3.0 2.5 2.2
 #   Taxon_E 4.0 3.5 3.2 3.1
 #
-#===============================================================================
-
-cdef enum Format:
-    FormatUninitialized,
-    FormatUnknown,
-    FormatFull,
-    FormatUpper,
-    FormatLower
-
-cdef class Parser:
-    cdef int line
-    cdef DistMatrix matrix
-    cdef Taxa.Map taxaMap
-    cdef Format format
-    cdef size_t i, j
-
-    def __init__(self, DistMatrix matrix, Taxa.Map taxaMap):
-        self.matrix = matrix
-        self.taxaMap = taxaMap
-        self.format = FormatUninitialized
-
-    cdef void tokenDist(self, float dist, unsigned line) except *:
-        cdef DistMatrix m
-        cdef size_t i, j, k
-
-        m = self.matrix
-        i = self.i
-        j = self.j
-
-        if self.format == FormatUninitialized:
-            raise SyntaxError(line, "Unexpected distance")
-        elif self.format == FormatUnknown:
-            if j < m.ntaxa:
-                m.dists[nxy2i(m.ntaxa, i, j)] = dist
-            else:
-                # This is the last distance for the first row of a full matrix.
-                # Up to now we have been working under the assumption that the
-                # matrix would turn out to be in upper format, so now we need
-                # to discard the diagonal and shift all the distances down one
-                # element.
-                self.format = FormatFull
-                if m.dists[nxy2i(m.ntaxa, 0, 1)] != <float>0.0:
-                    raise SyntaxError(line, "Non-zero distance on diagonal")
-                # Shift the entire first row back one element.
-                for 1 <= k < j - 1:
-                    m.dists[nxy2i(m.ntaxa, 0, k)] = \
-                      m.dists[nxy2i(m.ntaxa, 0, k + 1)]
-                j -= 1
-                m.dists[nxy2i(m.ntaxa, i, j)] = dist
-        elif self.format == FormatFull:
-            if j < i:
-                if dist != m.dists[nxy2i(m.ntaxa, j, i)]:
-                    raise SyntaxError(line,
-                      "Non-symmetric distance for %r <--> %r" %
-                      (self.taxaMap.taxonGet(j).label,
-                      self.taxaMap.taxonGet(i).label))
-            elif j == i:
-                if dist != 0.0:
-                    raise SyntaxError(line, "Non-zero distance on diagonal")
-            elif j == m.ntaxa:
-                raise SyntaxError(line, "Too many distances")
-            else:
-                m.dists[nxy2i(m.ntaxa, i, j)] = dist
-        elif self.format == FormatUpper:
-            if j == m.ntaxa:
-                raise SyntaxError(line, "Too many distances")
-            m.dists[nxy2i(m.ntaxa, i, j)] = dist
-        elif self.format == FormatLower:
-            if j == i:
-                raise SyntaxError(line, "Too many distances")
-            m.dists[nxy2i(m.ntaxa, i, j)] = dist
-        else:
-            assert False
-
-        j += 1
-        self.j = j
-
-    cdef void nextRow(self, unsigned line) except *:
-        cdef size_t i, j
-
-        i = self.i
-        j = self.j
-
-        if self.format == FormatUninitialized:
-            self.format = FormatUnknown
-            i = 0
-            j = 1
-        elif self.format == FormatUnknown:
-            if i == 0:
-                if j == self.matrix.ntaxa:
-                    self.format = FormatUpper
-                    i = 1
-                    j = 2
-                elif j == 1:
-                    self.format = FormatLower
-                    i = 1
-                    j = 0
-                else:
-                    raise SyntaxError(line, "Incorrect number of distances")
-            else:
-                assert False
-        elif self.format == FormatFull:
-            if j != self.matrix.ntaxa:
-                raise SyntaxError(line, "Incorrect number of distances")
-            i += 1
-            j = 0
-        elif self.format == FormatUpper:
-            if j != self.matrix.ntaxa:
-                raise SyntaxError(line, "Incorrect number of distances")
-            i += 1
-            j = i + 1
-        elif self.format == FormatLower:
-            if j != i:
-                raise SyntaxError(line, "Incorrect number of distances")
-            i += 1
-            j = 0
-        else:
-            assert False
-
-        self.i = i
-        self.j = j
-
-    cdef void tokenLabel(self, str label, unsigned line) except *:
-        cdef Taxon taxon
-
-        # Update row state.
-        self.nextRow(line)
-
-        # Create taxon mapping.
-        taxon = Taxa.get(label)
-        if self.taxaMap.indGet(taxon) != -1:
-            raise SyntaxError(line, "Duplicate taxon label: %r" % label)
-        if self.taxaMap.ntaxa == self.matrix.ntaxa:
-            raise SyntaxError(line, "Excess taxon: %r" % label)
-        self.taxaMap.map(taxon, self.taxaMap.ntaxa)
-
-    cdef void parse(self, input, int line=1) except *:
-        cdef yyscan_t scanner
-        cdef CxtDistMatrixLexerExtra extra
-        cdef int status, ntaxa, tokType
-
-        assert type(input) in (file, str)
-
-        extra.line = line
-        extra.ioerror = 0
-        if type(input) == file:
-            extra.inputMode = CxeDistMatrixLexerInputModeFd
-            extra.input.fd = input.fileno()
-        elif type(input) == str:
-            extra.inputMode = CxeDistMatrixLexerInputModeStr
-            extra.input.s.s = input
-            extra.input.s.len = len(input)
-        else:
-            assert False
-
-        if CxDistMatrixLexer_lex_init_extra(&extra, &scanner) != 0:
-            raise MemoryError("Error initializing lexer")
-
-        try:
-            # Get number of taxa.
-            status = CxDistMatrixLexer_lex(scanner)
-            if status > 0:
-                if extra.tokType != CxeDistMatrixLexerTokTypeInt:
-                    raise SyntaxError(extra.line, "Number of taxa expected")
-                ntaxa = int(CxDistMatrixLexer_get_text(scanner))
-                self.matrix._allocDists(ntaxa)
-                self.matrix.ntaxa = ntaxa
-                status = CxDistMatrixLexer_lex(scanner)
-
-            # Get rows.
-            while status > 0:
-                tokType = extra.tokType
-                if tokType in (CxeDistMatrixLexerTokTypeInt, \
-                  CxeDistMatrixLexerTokTypeDist):
-                    self.tokenDist(extra.tok.dist, extra.line)
-                elif tokType == CxeDistMatrixLexerTokTypeLabel:
-                    self.tokenLabel(extra.tok.label, extra.line)
-                else:
-                    assert False
-
-                status = CxDistMatrixLexer_lex(scanner)
-            if status == -1:
-                raise SyntaxError(extra.line, "Invalid character")
-            if extra.ioerror != 0:
-                raise IOError("I/O error for %r" % input)
-            self.nextRow(extra.line)
-            if self.taxaMap.ntaxa != self.matrix.ntaxa:
-                raise SyntaxError(extra.line, "Insufficient taxa")
-        finally:
-            CxDistMatrixLexer_lex_destroy(scanner);
-
+# The parser is implemented in C (CxDistMatrixParser.c), and scans distances
+# directly into the matrix.
 #
 #===============================================================================
 
@@ -269,24 +92,46 @@ cdef class DistMatrix:
 
         Construct a symmetric DistMatrix from one of the following inputs:
 
-          file/str : Parse the input file/string as a distance matrix.
+          file/str : Parse the input file/string as a distance matrix.  Files
+                     in the binary matrix file format (see 'path' below)
+                     are memory-mapped rather than parsed, which makes them
+                     suitable for matrices that are reused across runs.
 
           Taxa.Map : Create an uninitialized distance matrix of the appropriate
                      size, given the number of taxa in the Taxa.Map.
 
           DistMatrix : Duplicate or sample from the input DistMatrix, depending
                        on the value of the 'sampleSize' parameter.
+
+        If 'path' is specified, the distances are stored in a memory-mapped
+        file rather than in memory, so that the matrix need not fit in
+        physical memory.  With input=None, the existing matrix file at 'path'
+        is used; otherwise the file is (re-)created, and the distances are
+        written to it as they are computed.  Changes to the matrix are written
+        back to the file, except when nj()/rnj() are used non-destructively,
+        in which case they operate on a temporary copy (which is created in
+        the same directory as 'path').  Destructive nj()/rnj() invalidate the
+        file, which can then no longer be opened as a matrix file.
     """
     def __cinit__(self):
         self.dists = NULL
+        self.map = NULL
 
     def __dealloc__(self):
-        if self.dists != NULL:
+        if self.map != NULL:
+            CxDistMatrixMapClose(self.map)
+            free(self.map)
+            self.map = NULL
+            self.dists = NULL
+        elif self.dists != NULL:
             free(self.dists)
             self.dists = NULL
 
-    def __init__(self, input=None, int sampleSize=-1):
-        if type(input) in (file, str):
+    def __init__(self, input=None, int sampleSize=-1, str path=None):
+        self.path = path
+        if input is None and path is not None:
+            self._mapOpen()
+        elif type(input) in (file, str):
             self._parse(input)
         elif type(input) is Taxa.Map:
             self.taxaMap = <Taxa.Map>input
@@ -295,10 +140,14 @@ cdef class DistMatrix:
             self._dup(input, sampleSize)
         else:
             raise ValueError("File, string, Taxa.Map, or DistMatrix expected")
+        self._mapLabelsStore()
 
     cdef void _allocDists(self, size_t ntaxa) except *:
         assert self.dists == NULL
         assert ntaxa > 1
+        if self.path is not None:
+            self._mapCreate(ntaxa)
+            return
         self.dists = <float *>calloc(nxy2i(ntaxa, ntaxa - 2,
           ntaxa - 1) + 1, sizeof(float))
         if self.dists == NULL:
@@ -306,6 +155,99 @@ cdef class DistMatrix:
               <int>ntaxa)
         self.ntaxa = ntaxa
 
+    cdef void _mapError(self, CxtDistMatrixMap *map, int err) except *:
+        if err == CxeDistMatrixMapErrIo:
+            raise IOError(map.errNo, os.strerror(map.errNo), self.path)
+        elif err == CxeDistMatrixMapErrFormat:
+            raise ValueError("%r is not a distance matrix file" % self.path)
+        else:
+            assert False
+
+    cdef void _mapCreate(self, size_t ntaxa) except *:
+        cdef CxtDistMatrixMap *map
+        cdef CxeDistMatrixMapErr err
+
+        map = <CxtDistMatrixMap *>malloc(sizeof(CxtDistMatrixMap))
+        if map == NULL:
+            raise MemoryError("Error allocating distance matrix map")
+        err = CxDistMatrixMapCreate(map, self.path, ntaxa)
+        if err != CxeDistMatrixMapErrNone:
+            try:
+                self._mapError(map, err)
+            finally:
+                free(map)
+        self.map = map
+        self.dists = map.dists
+        self.ntaxa = ntaxa
+
+    # Map the matrix file at self.path, or the file open on fd (privately) if
+    # fd is non-negative.
+    cdef void _mapOpen(self, int fd=-1) except *:
+        cdef CxtDistMatrixMap *map
+        cdef CxeDistMatrixMapErr err
+        cdef list labels
+
+        map = <CxtDistMatrixMap *>malloc(sizeof(CxtDistMatrixMap))
+        if map == NULL:
+            raise MemoryError("Error allocating distance matrix map")
+        if fd >= 0:
+            err = CxDistMatrixMapFdOpen(map, fd)
+        else:
+            err = CxDistMatrixMapOpen(map, self.path)
+        if err != CxeDistMatrixMapErrNone:
+            try:
+                self._mapError(map, err)
+            finally:
+                free(map)
+        self.map = map
+        self.dists = map.dists
+        self.ntaxa = map.header.ntaxa
+
+        labels = map.labels[:map.header.labelsLen].split("\0")[:-1]
+        if len(labels) != self.ntaxa:
+            raise ValueError("%r has %d labels, but %d taxa" % (self.path,
+              len(labels), self.ntaxa))
+        self.taxaMap = Taxa.Map([Taxa.get(label) for label in labels])
+
+    # Return the taxon labels, each terminated by '\0', as stored in matrix
+    # files.
+    cdef str _labelsJoin(self):
+        return "".join(["%s\0" % self.taxaMap.taxonGet(i).label
+          for i in xrange(self.ntaxa)])
+
+    # Write the taxon labels to the matrix file, if any.  This is deferred
+    # until the Taxa.Map is complete, since the parser discovers labels after
+    # allocating the matrix.
+    cdef void _mapLabelsStore(self) except *:
+        cdef str labels
+        cdef CxeDistMatrixMapErr err
+
+        if self.map == NULL or self.map.header.labelsLen != 0:
+            return
+
+        labels = self._labelsJoin()
+        err = CxDistMatrixMapLabelsSet(self.map, labels, len(labels))
+        if err != CxeDistMatrixMapErrNone:
+            self._mapError(self.map, err)
+
+    # Duplicate the matrix, for use by nj()/rnj().  File-backed matrices are
+    # duplicated to an unlinked temporary file, so that the matrix never has
+    # to fit in memory, and the original file is not modified.
+    cdef DistMatrix _dupScratch(self):
+        cdef DistMatrix ret
+
+        if self.path is None:
+            return DistMatrix(self)
+
+        (fd, path) = tempfile.mkstemp(suffix=".tmp",
+          dir=os.path.dirname(os.path.abspath(self.path)))
+        os.close(fd)
+        try:
+            ret = DistMatrix(self, path=path)
+        finally:
+            os.unlink(path)
+        return ret
+
     cdef void _dup(self, DistMatrix other, int sampleSize) except *:
         cdef Taxa.Map taxaMap, otherMap
         cdef list sample
@@ -338,12 +280,87 @@ cdef class DistMatrix:
                       sample[j])]
         self.additive = other.additive
 
-    cdef void _parse(self, input) except *:
-        cdef Parser parser
+    cdef void _parseRaise(self, CxtDistMatrixParser *parser) except *:
+        cdef CxeDistMatrixParseErr err
+        cdef list labels
+        cdef str msg
+
+        err = parser.err
+        if err == CxeDistMatrixParseErrMem:
+            raise MemoryError("Error parsing distance matrix")
+        elif err == CxeDistMatrixParseErrToken:
+            msg = "Invalid character"
+        elif err == CxeDistMatrixParseErrNTaxa:
+            msg = "Number of taxa expected"
+        elif err == CxeDistMatrixParseErrNTaxaRange:
+            msg = "Number of taxa out of range"
+        elif err == CxeDistMatrixParseErrDist:
+            msg = "Unexpected distance"
+        elif err == CxeDistMatrixParseErrDiagonal:
+            msg = "Non-zero distance on diagonal"
+        elif err == CxeDistMatrixParseErrDistsExcess:
+            msg = "Too many distances"
+        elif err == CxeDistMatrixParseErrDistsCount:
+            msg = "Incorrect number of distances"
+        elif err == CxeDistMatrixParseErrTaxaShort:
+            msg = "Insufficient taxa"
+        else:
+            labels = parser.labels[:parser.labelsLen].split("\0")[:-1]
+            if err == CxeDistMatrixParseErrAsymmetric:
+                msg = "Non-symmetric distance for %r <--> %r" % \
+                  (labels[parser.errX], labels[parser.errY])
+            elif err == CxeDistMatrixParseErrLabelDup:
+                msg = "Duplicate taxon label: %r" % labels[-1]
+            elif err == CxeDistMatrixParseErrTaxaExcess:
+                msg = "Excess taxon: %r" % labels[-1]
+            else:
+                assert False
+        raise SyntaxError(parser.errLine, msg)
+
+    cdef void _parse(self, input, int line=1) except *:
+        cdef CxtDistMatrixParser parser
+        cdef DistMatrix binary
+        cdef long off
+        cdef str s
+
+        assert type(input) in (file, str)
+
+        if type(input) == file:
+            try:
+                off = input.tell()
+            except IOError:
+                # Not seekable (a pipe, for example); read it.
+                input = input.read()
+        if type(input) == file and CxDistMatrixMapSniff(input.fileno(), off):
+            if self.path is None:
+                self._mapOpen(input.fileno())
+            else:
+                binary = DistMatrix(input)
+                self._dup(binary, -1)
+            return
 
-        self.taxaMap = Taxa.Map()
-        parser = Parser(self, self.taxaMap)
-        parser.parse(input)
+        CxDistMatrixParserNew(&parser)
+        try:
+            if type(input) == file:
+                if CxDistMatrixParseFdBegin(&parser, input.fileno(), off, \
+                  line):
+                    if parser.err != CxeDistMatrixParseErrIo:
+                        self._parseRaise(&parser)
+                    # Not a regular file; fall back to reading it.
+                    input = input.read()
+            if type(input) == str:
+                s = input
+                if CxDistMatrixParseBegin(&parser, s, len(s), line):
+                    self._parseRaise(&parser)
+
+            if parser.ntaxa != 0:
+                self._allocDists(parser.ntaxa)
+            if CxDistMatrixParseRows(&parser, self.dists):
+                self._parseRaise(&parser)
+            self.taxaMap = Taxa.Map([Taxa.get(label) for label in \
+              parser.labels[:parser.labelsLen].split("\0")[:-1]])
+        finally:
+            CxDistMatrixParserDelete(&parser)
 
     cpdef float distanceGet(self, size_t x, size_t y):
         """
@@ -370,15 +387,25 @@ cdef class DistMatrix:
 
         self.dists[nxy2i(self.ntaxa, x, y)] = distance
 
-    cdef Tree _nj(self, bint random):
+    cdef Tree _nj(self, bint random, bint rapid):
         cdef Nj.Nj nj
+        cdef Nj.RapidNj rapidNj
 
-        nj = Nj.Nj()
-        nj.prepare(self.dists, self.ntaxa, self.taxaMap)
+        if rapid:
+            rapidNj = Nj.RapidNj()
+            nj = rapidNj
+        else:
+            nj = Nj.Nj()
+        if self.map != NULL:
+            CxDistMatrixMapInvalidate(self.map)
+        nj.prepare(self.dists, self.ntaxa, self.taxaMap, self.map)
         # The NJ code owns the matrix now.
         self.dists = NULL
+        self.map = NULL
         self.ntaxa = 0
 
+        if rapid:
+            return rapidNj.rapidNj()
         return nj.nj(random)
 
     cdef Tree _rnj(self, bint random, bint additive):
@@ -386,9 +413,12 @@ cdef class DistMatrix:
         cdef Nj.Rnj rnj
 
         rnj = Nj.Rnj()
-        rnj.prepare(self.dists, self.ntaxa, self.taxaMap)
+        if self.map != NULL:
+            CxDistMatrixMapInvalidate(self.map)
+        rnj.prepare(self.dists, self.ntaxa, self.taxaMap, self.map)
         # The RNJ code owns the matrix now.
         self.dists = NULL
+        self.map = NULL
         self.ntaxa = 0
 
         (ret, self.additive) = rnj.rnj(random, additive)
@@ -459,19 +489,30 @@ cdef class DistMatrix:
         for i in xrange(self.ntaxa):
             taxaMap.map(<Taxon>taxa[<int>order[i]], i, True)
 
-    cpdef Tree nj(self, bint joinRandom=False, bint destructive=False):
+    cpdef Tree nj(self, bint joinRandom=False, bint destructive=False,
+      bint rapid=False):
         """
             Construct a tree using the neighbor joining (NJ) algorithm.  If
             destructive=True, the matrix contents will be discarded, thus
             rendering the matrix useless for any further operations.
+
+            If rapid=True, use a bounded search (as in RapidNJ) to find each
+            pair of nodes to join, rather than scanning the entire matrix.
+            The resulting tree is identical to that for joinRandom=False, but
+            is typically computed much faster for large matrices, at the cost
+            of approximately three times as much memory.  Random joining is
+            not supported in this mode.
         """
         cdef DistMatrix m
 
+        if rapid and joinRandom:
+            raise ValueError("Random joining is incompatible with rapid=True")
+
         if (destructive):
-            return self._nj(joinRandom)
+            return self._nj(joinRandom, rapid)
         else:
-            m = DistMatrix(self)
-            return m._nj(joinRandom)
+            m = self._dupScratch()
+            return m._nj(joinRandom, rapid)
 
     cpdef Tree rnj(self, bint joinRandom=False, bint tryAdditive=True,
       bint destructive=False):
@@ -486,24 +527,14 @@ cdef class DistMatrix:
         if (destructive):
             return self._rnj(joinRandom, tryAdditive)
         else:
-            m = DistMatrix(self)
+            m = self._dupScratch()
             return m._rnj(joinRandom, tryAdditive)
 
-    cpdef render(self, str format=None, str distFormat="%.7e",
-      file outFile=None):
-        """
-            Print the matrix to a string in 'full', 'upper', or 'lower' format.
-            If outFile is unspecified, print to stdout.
-        """
+    cdef void _renderPy(self, str format, str distFormat, file outFile) \
+      except *:
         cdef size_t i, j
         cdef str s
 
-        if format is None:
-            format = 'lower'
-        assert format in ('full', 'upper', 'lower')
-        if outFile is None:
-            outFile = sys.stdout
-
         distFormat = " " + distFormat
 
         outFile.write("%d\n" % self.ntaxa)
@@ -535,3 +566,122 @@ cdef class DistMatrix:
                 outFile.write("\n")
         else:
             assert False
+
+    # Write fmt's contents to outFile, and empty fmt.
+    cdef void _renderFlush(self, CxtFmt *fmt, file outFile) except *:
+        outFile.write(PyString_FromStringAndSize(fmt.buf, fmt.len))
+        fmt.len = 0
+
+    # Append the row label for taxon i, padded to 10 columns if pad is true.
+    cdef void _renderLabel(self, CxtFmt *fmt, size_t i, bint pad) except *:
+        cdef str label
+
+        label = self.taxaMap.taxonGet(i).label
+        if CxFmtStrPad(fmt, label, len(label), 10 if pad else 0):
+            raise MemoryError("Error formatting distance matrix")
+
+    # Append " <distance>" for each distance in row i, from column j0 up to
+    # (but not including) column j1.  Distances on or below the diagonal are
+    # rendered as spaces if blank is true.
+    cdef void _renderDists(self, CxtFmt *fmt, CxtFmtSpec *spec, size_t i,
+      size_t j0, size_t j1, bint blank) except *:
+        cdef size_t j, start
+
+        for j0 <= j < j1:
+            start = fmt.len
+            if CxFmtSpaces(fmt, 1) \
+              or CxFmtDouble(fmt, spec, self.distanceGet(i, j)):
+                raise MemoryError("Error formatting distance matrix")
+            if blank and j <= i:
+                memset(&fmt.buf[start], c' ', fmt.len - start)
+
+    cdef void _renderFmt(self, str format, CxtFmtSpec *spec, file outFile) \
+      except *:
+        cdef CxtFmt fmt
+        cdef size_t i
+
+        if CxFmtNew(&fmt, _renderFlushLen + 4096):
+            raise MemoryError("Error allocating render buffer")
+        try:
+            if CxFmtUint(&fmt, self.ntaxa) or CxFmtStr(&fmt, "\n", 1):
+                raise MemoryError("Error formatting distance matrix")
+            for 0 <= i < self.ntaxa:
+                if format == 'full':
+                    self._renderLabel(&fmt, i, True)
+                    self._renderDists(&fmt, spec, i, 0, self.ntaxa, False)
+                elif format == 'upper':
+                    self._renderLabel(&fmt, i, i < self.ntaxa - 1)
+                    if i < self.ntaxa - 1:
+                        self._renderDists(&fmt, spec, i, 0, self.ntaxa, True)
+                elif format == 'lower':
+                    self._renderLabel(&fmt, i, i > 0)
+                    self._renderDists(&fmt, spec, i, 0, i, False)
+                else:
+                    assert False
+                if CxFmtStr(&fmt, "\n", 1):
+                    raise MemoryError("Error formatting distance matrix")
+                if fmt.len >= _renderFlushLen:
+                    self._renderFlush(&fmt, outFile)
+            self._renderFlush(&fmt, outFile)
+        finally:
+            CxFmtDelete(&fmt)
+
+    # Write the matrix in the binary matrix file format (see
+    # CxDistMatrixMap.h).
+    cdef void _renderBinary(self, file outFile) except *:
+        cdef CxtDistMatrixMapHeader header
+        cdef str labels
+        cdef uint64_t distsLen, off, n
+
+        if self.ntaxa < 2:
+            raise ValueError("Binary format requires at least 2 taxa")
+
+        labels = self._labelsJoin()
+        CxDistMatrixMapHeaderInit(&header, self.ntaxa, len(labels))
+        outFile.write(PyString_FromStringAndSize(<char *>&header,
+          sizeof(header)))
+        outFile.write("\0" * (CxmDistMatrixMapAlign - sizeof(header)))
+
+        # Write the distances directly from the matrix, in chunks so that no
+        # more than _renderFlushLen bytes are ever copied at once.
+        distsLen = ((self.ntaxa * (self.ntaxa - 1)) >> 1) * sizeof(float)
+        off = 0
+        while off < distsLen:
+            n = distsLen - off
+            if n > _renderFlushLen:
+                n = _renderFlushLen
+            outFile.write(PyString_FromStringAndSize(&(<char *>self.dists)[off],
+              n))
+            off += n
+
+        outFile.write(labels)
+
+    cpdef render(self, str format=None, str distFormat="%.7e",
+      file outFile=None):
+        """
+            Print the matrix in 'full', 'upper', 'lower', or 'binary'
+            format.  If outFile is unspecified, print to stdout.
+
+            'binary' is the matrix file format that DistMatrix memory-maps
+            (see the 'path' constructor parameter), and which can be read
+            back far faster than text; distFormat is ignored, and outFile
+            must be opened in binary mode.
+
+            Text output is formatted natively in bulk when distFormat is of
+            the form "%.<prec>e" or "%.<prec>f" (with the same results as
+            Python's formatting), and via Python string formatting otherwise.
+        """
+        cdef CxtFmtSpec spec
+
+        if format is None:
+            format = 'lower'
+        assert format in ('full', 'upper', 'lower', 'binary')
+        if outFile is None:
+            outFile = sys.stdout
+
+        if format == 'binary':
+            self._renderBinary(outFile)
+        elif CxFmtSpecParse(&spec, distFormat):
+            self._renderPy(format, distFormat, outFile)
+        else:
+            self._renderFmt(format, &spec, outFile)
@@ -1,3 +1,5 @@
+from libc cimport *
+from CxFasta cimport *
 from Crux.CTMatrix cimport CTMatrix
 cimport Parsing
 from Crux.Taxa cimport Taxon
@@ -13,6 +15,7 @@ cdef class RowList(Nonterm)
 cdef class Row(Nonterm)
 cdef class Chars(Nonterm)
 cdef class Parser(Parsing.Lr)
+cdef class Reader
 
 #===============================================================================
 # Begin Token.
@@ -78,3 +81,20 @@ cdef class Parser(Parsing.Lr):
     cdef _initRe(self, type charType)
     cdef void _addTaxon(self, Taxon taxon, str chars) except *
     cpdef parse(self, lines, type charType=*, int line=*, bint verbose=*)
+
+cdef class Reader:
+    cdef CxtFasta _fasta
+    cdef bint _fastaAlloced
+    cdef readonly type charType
+    cdef list _taxa # Row index-->Taxon, or None if not yet computed.
+
+    cdef void _raise(self) except *
+    cdef uint64_t getNrows(self)
+    # property nrows
+    cdef list getTaxa(self)
+    # property taxa
+    cdef list rowsLast(self)
+    cdef char *rowChars(self, uint64_t row, uint64_t *rLen)
+    cpdef str rowGet(self, uint64_t row)
+    cdef char *charsTake(self) except NULL
+    cpdef fill(self, CTMatrix matrix)
@@ -33,6 +33,10 @@ import sys
 import Crux.Config
 
 cimport Parsing
+import Parsing
+from libc cimport *
+from CxFasta cimport *
+from Crux.CTMatrix cimport CTMatrix
 from Crux.Character cimport Character, Dna
 from Crux.Taxa cimport Taxon
 cimport Crux.Taxa as Taxa
@@ -49,6 +53,10 @@ cdef class RowList(Nonterm)
 cdef class Row(Nonterm)
 cdef class Chars(Nonterm)
 cdef class Parser(Parsing.Lr)
+cdef class Reader
+
+cdef extern from "Python.h":
+    cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
 
 #===============================================================================
 # Begin Token.
@@ -221,3 +229,155 @@ cdef class Parser(Parsing.Lr):
             line += 1
 
         self.eoi()
+
+cdef class Reader:
+    """
+        Native FASTA reader.  The input (a file or string) is scanned in a
+        single pass by a C scanner that accepts the same grammar as Parser,
+        and raises the same exceptions.  Files are memory-mapped rather than
+        read.  Character data are stored contiguously, row after row, so an
+        aligned input is read directly into row-major Alignment order (see
+        CxFasta.h).
+    """
+    def __cinit__(self):
+        self._fastaAlloced = False
+
+    def __dealloc__(self):
+        if self._fastaAlloced:
+            CxFastaDelete(&self._fasta)
+            self._fastaAlloced = False
+
+    def __init__(self, input, type charType=Dna, int line=1):
+        cdef str codes, s
+
+        assert type(input) in (file, str)
+
+        self.charType = charType
+        self._taxa = None
+        codes = "".join(charType.get().codes())
+        if CxFastaNew(&self._fasta, codes, len(codes)):
+            raise MemoryError("Error allocating FASTA scanner")
+        self._fastaAlloced = True
+
+        if type(input) == file:
+            if not CxFastaParseFd(&self._fasta, input.fileno(), \
+              input.tell(), line):
+                return
+            if self._fasta.err != CxeFastaErrIo:
+                self._raise()
+            # Not a regular file; fall back to reading it.
+            input = input.read()
+        s = input
+        if CxFastaParse(&self._fasta, s, len(s), line):
+            self._raise()
+
+    cdef void _raise(self) except *:
+        cdef str tok
+
+        if self._fasta.err == CxeFastaErrToken:
+            raise SyntaxError(self._fasta.errLine, "Invalid token")
+        elif self._fasta.err == CxeFastaErrDescr \
+          or self._fasta.err == CxeFastaErrChars:
+            tok = PyString_FromStringAndSize(self._fasta.errTok, \
+              self._fasta.errTokLen)
+            raise Parsing.SyntaxError("Unexpected token: %s (%r)" % \
+              ("descr" if self._fasta.err == CxeFastaErrDescr else "chars", \
+              tok))
+        elif self._fasta.err == CxeFastaErrEnd:
+            raise Parsing.SyntaxError("Unexpected token: <$>")
+        raise MemoryError("Error reading FASTA input")
+
+    cdef uint64_t getNrows(self):
+        return self._fasta.nrows
+    property nrows:
+        """
+            Number of rows (description lines) in the input.
+        """
+        def __get__(self):
+            return self.getNrows()
+
+    cdef list getTaxa(self):
+        cdef uint64_t i, off
+
+        if self._taxa is None:
+            self._taxa = [None] * self._fasta.nrows
+            for 0 <= i < self._fasta.nrows:
+                off = self._fasta.labelOffs[i]
+                self._taxa[i] = Taxa.get(PyString_FromStringAndSize( \
+                  &self._fasta.labels[off], self._fasta.labelOffs[i+1] - off))
+        return self._taxa
+    property taxa:
+        """
+            List of the taxa that label the rows, in input order.
+        """
+        def __get__(self):
+            return self.getTaxa()
+
+    cdef list rowsLast(self):
+        """
+            Return a list of row indices, one for each distinct taxon, in
+            order of first appearance.  If a taxon labels multiple rows, the
+            last such row supersedes the others, as for CTMatrix.dataSet().
+        """
+        cdef list taxa, ret
+        cdef dict taxaX
+        cdef Taxon taxon
+        cdef uint64_t i
+
+        taxa = self.getTaxa()
+        ret = []
+        taxaX = {}
+        for 0 <= i < len(taxa):
+            taxon = <Taxon>taxa[i]
+            if taxon in taxaX:
+                ret[taxaX[taxon]] = i
+            else:
+                taxaX[taxon] = len(ret)
+                ret.append(i)
+        return ret
+
+    cdef char *rowChars(self, uint64_t row, uint64_t *rLen):
+        assert row < self._fasta.nrows
+        assert self._fasta.chars != NULL
+
+        rLen[0] = self._fasta.rowOffs[row+1] - self._fasta.rowOffs[row]
+        return &self._fasta.chars[self._fasta.rowOffs[row]]
+
+    cpdef str rowGet(self, uint64_t row):
+        """
+            Get the character data for row.
+        """
+        cdef char *chars
+        cdef uint64_t length
+
+        if row >= self._fasta.nrows:
+            raise IndexError("Row index out of range")
+        chars = self.rowChars(row, &length)
+        return PyString_FromStringAndSize(chars, length)
+
+    # Transfer ownership of the character buffer (trimmed to size) to the
+    # caller, which must free() it.  The reader is left without rows.
+    cdef char *charsTake(self) except NULL:
+        cdef char *ret
+
+        ret = CxFastaCharsTake(&self._fasta)
+        if ret == NULL:
+            raise MemoryError("Error trimming character buffer")
+        self._taxa = None
+        return ret
+
+    cpdef fill(self, CTMatrix matrix):
+        """
+            Store the rows in matrix, and map their taxa in matrix.taxaMap,
+            precisely as Parser does.
+        """
+        cdef list taxa
+        cdef Taxon taxon
+        cdef uint64_t i
+
+        taxa = self.getTaxa()
+        for 0 <= i < len(taxa):
+            taxon = <Taxon>taxa[i]
+            if matrix.taxaMap.indGet(taxon) == -1:
+                matrix.taxaMap.map(taxon, matrix.taxaMap.ntaxa)
+            matrix.dataSet(taxon, self.rowGet(i))
@@ -18,6 +18,11 @@ cdef enum:
     PropMixtureJump      = 13
     PropCnt              = 14 # Number of proposals.
 
+    # Proposals [0..PropLambdaCnt) are multiplier proposals, the step sizes of
+    # which are controlled by per chain lambdas.  eTBR is not among them, since
+    # its acceptance rate mainly reflects the topology change.
+    PropLambdaCnt        =  7
+
 from libc cimport uint64_t
 from SFMT cimport sfmt_t
 from Crux.Tree cimport Tree
@@ -32,9 +37,14 @@ cdef class Chain:
     cdef uint64_t nswap
     cdef uint64_t accepts[PropCnt]
     cdef uint64_t rejects[PropCnt]
+    # Proposal multiplier lambdas, initialized from the corresponding Mc3
+    # settings, and adjusted by adapt() until Mc3.adaptStep.
+    cdef double lambdas[PropLambdaCnt]
     cdef double heat
     cdef unsigned swapInd
     cdef double swapProb
+    # Step at which the pending heat swap (if any) was initiated.
+    cdef uint64_t swapStep
     cdef sfmt_t *swapPrng
     cdef sfmt_t *prng
     cdef Tree tree
@@ -79,5 +89,6 @@ cdef class Chain:
     cdef void mixtureRemovePropose(self, unsigned nmodels) except *
     cdef void mixtureAddPropose(self, unsigned nmodels) except *
     cdef bint mixtureJumpPropose(self) except *
+    cdef void adapt(self) except *
     cdef void advance0(self) except *
     cdef void advance1(self) except *
@@ -5,6 +5,8 @@ from libc cimport *
 from libm cimport *
 from SFMT cimport *
 from CxRi cimport *
+from Cx cimport CxTime
+from CxLik cimport CxtLikStats, CxLikStats
 from Crux.Tree cimport Tree, Node, Edge, Ring
 from Crux.Tree.Lik cimport Lik
 from Crux.Tree.Bipart cimport Vec, Bipart
@@ -50,8 +52,16 @@ cdef class Chain:
         for 0 <= i < PropCnt:
             self.accepts[i] = 0
             self.rejects[i] = 0
+        self.lambdas[PropWeight] = self.master._weightLambda
+        self.lambdas[PropFreq] = self.master._freqLambda
+        self.lambdas[PropRmult] = self.master._rmultLambda
+        self.lambdas[PropRate] = self.master._rateLambda
+        self.lambdas[PropRateShapeInv] = self.master._rateShapeInvLambda
+        self.lambdas[PropInvar] = self.master._invarLambda
+        self.lambdas[PropBrlen] = self.master._brlenLambda
         self.heat = 1.0 / (1.0 + (ind * self.master._heatDelta))
         self.swapInd = ind
+        self.swapStep = 0
         # Use a separate PRNG for Metropolis-coupled chain swaps, so that all
         # chains can independently compute the same sequence of swaps.
         self.swapPrng = init_gen_rand(swapSeed)
@@ -85,7 +95,7 @@ cdef class Chain:
 
         # Generate the weight multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._weightLambda * (u - 0.5)
+        lnM = self.lambdas[PropWeight] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified weight.
@@ -169,7 +179,7 @@ cdef class Chain:
 
         # Generate the frequency multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._freqLambda * (u - 0.5)
+        lnM = self.lambdas[PropFreq] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified frequency.
@@ -213,7 +223,7 @@ cdef class Chain:
 
         # Generate the rmult multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._rmultLambda * (u - 0.5)
+        lnM = self.lambdas[PropRmult] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified rmult.
@@ -279,7 +289,7 @@ cdef class Chain:
 
         # Generate the rate multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._rateLambda * (u - 0.5)
+        lnM = self.lambdas[PropRate] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified rate.
@@ -340,7 +350,7 @@ cdef class Chain:
 
         # Generate the inverse rate shape multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._rateShapeInvLambda * (u - 0.5)
+        lnM = self.lambdas[PropRateShapeInv] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified rate shape.
@@ -402,7 +412,7 @@ cdef class Chain:
 
         # Generate weight multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._invarLambda * (u - 0.5)
+        lnM = self.lambdas[PropInvar] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified weight.
@@ -445,7 +455,7 @@ cdef class Chain:
 
         # Generate the branch length multiplier.
         u = genrand_res53(self.prng)
-        lnM = self.master._brlenLambda * (u - 0.5)
+        lnM = self.lambdas[PropBrlen] * (u - 0.5)
         m = exp(lnM)
 
         # Compute lnL with modified branch length.
@@ -1813,10 +1823,39 @@ cdef class Chain:
 
         return False
 
+    # Adjust lambdas toward the target acceptance rate, based on the
+    # acceptance counts since the previous sample.  Each lambda is scaled by
+    # exp(g*(r - adaptTarget)), where r is the observed acceptance rate and
+    # g = 1/sqrt(k) for the kth adaptation.  Larger lambdas propose larger
+    # moves, which lowers the acceptance rate.  The adjustments diminish in
+    # magnitude, so the lambdas settle rather than chasing sampling noise.
+    cdef void adapt(self) except *:
+        cdef unsigned i
+        cdef uint64_t d
+        cdef double g, r
+
+        g = 1.0 / sqrt(<double>(self.step / self.master._stride))
+        for 0 <= i < PropLambdaCnt:
+            d = self.accepts[i] + self.rejects[i]
+            if d == 0:
+                continue
+            r = <double>self.accepts[i] / <double>d
+            self.lambdas[i] *= exp(g * (r - self.master._adaptTarget))
+            # Keep multipliers within [e^-10..e^10], so that proposals cannot
+            # overflow, even for parameters that the data do not inform.
+            # Likewise keep lambdas above 0.01, so that a run of rejections
+            # cannot shrink proposals to the point that the chain stops
+            # moving.
+            if self.lambdas[i] > 20.0:
+                self.lambdas[i] = 20.0
+            elif self.lambdas[i] < 0.01:
+                self.lambdas[i] = 0.01
+
     cdef void advance0(self) except *:
         cdef bint again
         cdef unsigned propInd, a, b, other
-        cdef double u
+        cdef double u, t0
+        cdef CxtLikStats stats0
 
         self.step += 1
 
@@ -1829,7 +1868,10 @@ cdef class Chain:
               sizeof(double), _propsCdfCmp) - <uintptr_t>self.master.propsCdf) \
               / sizeof(double)
 
-            # Propose new state.
+            # Propose new state, and attribute the time and likelihood
+            # computation work to the proposal.
+            t0 = CxTime()
+            stats0 = CxLikStats
             if propInd == PropWeight:
                 again = self.weightPropose()
             elif propInd == PropFreq:
@@ -1860,9 +1902,13 @@ cdef class Chain:
                 again = self.mixtureJumpPropose()
             else:
                 assert False
+            self.master.sendPropWork(self.run, propInd, CxTime() - t0, \
+              &stats0)
 
         # Sample if this step is a multiple of the sample stride.
         if self.step % self.master._stride == 0:
+            if self.step <= self.master._adaptStep:
+                self.adapt()
             self.master.sendSample(self.run, self.step, self.heat, self.nswap, \
               self.accepts, self.rejects, self.lik, self.lnL)
             # Clear swap stats.
@@ -1872,6 +1918,10 @@ cdef class Chain:
                 self.accepts[i] = 0
                 self.rejects[i] = 0
 
+        # Report the final lambdas at the end of the adaptation phase.
+        if self.step == self.master._adaptStep:
+            self.master.sendLambdas(self.run, self.ind, self.lambdas)
+
         # Potentially try a heat swap with another chain.
         if self.master._ncoupled > 1 and \
           self.step % self.master._swapStride == 0:
@@ -1888,20 +1938,32 @@ cdef class Chain:
                 self.swapInd = a
 
             if self.swapInd != self.ind:
-                self.master.sendSwapInfo(self.run, self.ind, self.swapInd, \
-                  self.step, self.heat, self.lnL)
+                self.swapStep = self.step
 
             # All chains must advance the PRNG identically, so swapProb must be
             # drawn here regardless of whether it is used by this chain later.
             self.swapProb = genrand_res53(self.swapPrng)
 
+        # Send this chain's current state for a pending heat swap that is to be
+        # applied at this step.  The partner chain does the same, so by the time
+        # advance1() runs, both chains' states are as of the same step.
+        if self.swapInd != self.ind and \
+          self.step == self.swapStep + self.master._swapLag:
+            self.master.sendSwapInfo(self.run, self.ind, self.swapInd, \
+              self.swapStep, self.heat, self.lnL)
+
     cdef void advance1(self) except *:
         cdef double rcvHeat, rcvLnL, p
 
-        # Finish handling a pending potential heat swap.
-        if self.swapInd != self.ind:
+        # Finish handling a pending potential heat swap, swapLag steps after it
+        # was initiated.  The decision is based on both chains' current states,
+        # so this is an ordinary Metropolis-coupled swap; only the choice of
+        # partner and the uniform variate were fixed at swapStep, and neither
+        # depends on the chains' states.
+        if self.swapInd != self.ind and \
+          self.step == self.swapStep + self.master._swapLag:
             self.master.recvSwapInfo(self.run, self.ind, self.swapInd, \
-              self.step, &rcvHeat, &rcvLnL)
+              self.swapStep, &rcvHeat, &rcvLnL)
             assert rcvHeat != self.heat
             p = exp((rcvLnL - self.lnL) * self.heat \
               + (self.lnL - rcvLnL) * rcvHeat)
@@ -5,6 +5,7 @@ cdef class Post
 
 from libc cimport *
 from Crux.Mc3 cimport Mc3
+from Crux.Newick cimport Trees
 from Crux.Tree cimport Tree
 from Crux.Tree.Sumt cimport Sumt
 
@@ -21,7 +22,9 @@ cdef class Samp:
     cdef readonly double lnL   # Call Post.parseS() before accessing.
     cdef readonly list msamps  # Call Post.parseP() before accessing.
     cdef readonly double wNorm # Call Post.parseP() before accessing.
-    cdef readonly Tree tree    # Call Post.parseT() before accessing.
+    cdef Trees _trees          # Set by Post.parseT().
+    cdef uint64_t _treeInd     # Index into _trees.
+    cdef Tree _tree            # Materialized on demand; see tree property.
 
 cdef class Post:
     cdef bint verbose
@@ -29,6 +32,7 @@ cdef class Post:
     cdef readonly uint64_t seed
     cdef readonly uint64_t burnin
     cdef bint _sDone, _pDone, _tDone
+    cdef readonly bint summarized    # True if loadSummary() succeeded.
     cdef readonly uint64_t nsamples  # Call parseS() before accessing.
     cdef readonly uint64_t stepFirst # Call parseS() before accessing.
     cdef readonly uint64_t stepLast  # Call parseS() before accessing.
@@ -46,6 +50,7 @@ cdef class Post:
     cdef double _pinvarMinCred, _pinvarMaxCred, _pinvarMean, _pinvarVar, \
       _pinvarMed
     cdef Sumt _sumt
+    cdef Trees _trees # Posterior trees, in .t file order.
 
     cdef readonly list runs
 
@@ -53,6 +58,7 @@ cdef class Post:
     cpdef parseS(self)
     cpdef parseP(self)
     cpdef parseT(self)
+    cpdef bint loadSummary(self) except *
 
     cdef void _computeRcovLnL(self) except *
     cdef double getRcovLnL(self) except -1.0
@@ -5,14 +5,22 @@
     on their contents.
 """
 
+import os
 import re
 import sys
 
+cdef extern from "Python.h":
+    cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
 from libc cimport *
 from libm cimport *
+from CxPost cimport *
+cimport Crux.Taxa as Taxa
 from Crux.Mc3 cimport Mc3
 from Crux.CTMatrix cimport Alignment
+from Crux.Newick cimport Trees
 from Crux.Tree cimport Tree
+from Crux.Tree.Bipart cimport Vec
+from Crux.Tree.Sumt cimport Sumt, Part
 
 cdef class Msamp:
     """
@@ -36,7 +44,19 @@ cdef class Samp:
         self.lnL = lnL
         self.msamps = []
         self.wNorm = -1.0
-        self.tree = None
+        self._trees = None
+        self._treeInd = 0
+        self._tree = None
+
+    property tree:
+        """
+            Sampled tree.  Call Post.parseT() before accessing.  Trees are
+            stored compactly until first accessed.
+        """
+        def __get__(self):
+            if self._tree is None and self._trees is not None:
+                self._tree = self._trees.getTree(self._treeInd, False)
+            return self._tree
 
 cdef class Post:
     """
@@ -65,6 +85,7 @@ cdef class Post:
         self._sDone = False
         self._pDone = False
         self._tDone = False
+        self.summarized = False
         self.maxModels = 0
 
         self._rcovLnL = -1.0
@@ -155,6 +176,12 @@ cdef class Post:
                     self.mc3.setCvgAlpha(float(v))
                 elif k == 'cvgEpsilon':
                     self.mc3.setCvgEpsilon(float(v))
+                elif k == 'cvgAsdsf':
+                    self.mc3.setCvgAsdsf(float(v))
+                elif k == 'asdsfMinFreq':
+                    self.mc3.setAsdsfMinFreq(float(v))
+                elif k == 'cvgEss':
+                    self.mc3.setCvgEss(float(v))
                 elif k == 'minStep':
                     self.mc3.setMinStep(long(v))
                 elif k == 'maxStep':
@@ -169,6 +196,8 @@ cdef class Post:
                     self.mc3.setHeatDelta(float(v))
                 elif k == 'swapStride':
                     self.mc3.setSwapStride(long(v))
+                elif k == 'swapLag':
+                    self.mc3.setSwapLag(long(v))
                 elif k == 'nmodels':
                     self.mc3.setNmodels(long(v))
                 elif k == 'ncat':
@@ -177,6 +206,10 @@ cdef class Post:
                     self.mc3.setCatMedian(v == 'True')
                 elif k == 'invar':
                     self.mc3.setInvar(v == 'True')
+                elif k == 'summary':
+                    self.mc3.setSummary(v == 'True')
+                elif k == 'summaryBurnin':
+                    self.mc3.setSummaryBurnin(long(v))
                 elif k == 'weightLambda':
                     self.mc3.setWeightLambda(float(v))
                 elif k == 'freqLambda':
@@ -195,6 +228,10 @@ cdef class Post:
                     self.mc3.setEtbrPExt(float(v))
                 elif k == 'etbrLambda':
                     self.mc3.setEtbrLambda(float(v))
+                elif k == 'adaptStep':
+                    self.mc3.setAdaptStep(long(v))
+                elif k == 'adaptTarget':
+                    self.mc3.setAdaptTarget(float(v))
                 elif k == 'rateShapeInvPrior':
                     self.mc3.setRateShapeInvPrior(float(v))
                 elif k == 'invarPrior':
@@ -257,50 +294,71 @@ cdef class Post:
             stepFirst, stepLast, and Samp.lnL, in order to assure the field's
             validity.
         """
-        cdef file sFile
-        cdef int nruns
-        cdef uint64_t stride, nlines, i, j
-        cdef str line
-        cdef list toks
-        cdef Samp samp
+        cdef str path
+        cdef CxtPostLog log
+        cdef unsigned nruns, j
+        cdef uint64_t stride, first, i
+        cdef unsigned *fields
+        cdef double *lnLs
+        cdef list run
 
         if self._sDone:
             return
 
-        sFile = open("%s.s" % self.mc3.outPrefix, "r")
+        path = "%s.s" % self.mc3.outPrefix
+        if CxPostLogNew(&log, path, CxePostLogS):
+            raise IOError("Error reading %r" % path)
+        fields = NULL
+        lnLs = NULL
+        try:
+            if log.nrecs == 0:
+                raise ValueError("No samples in %r" % path)
+
+            nruns = self.mc3.getNruns()
+            self.runs = [[] for i in xrange(nruns)]
+            stride = self.mc3.getStride()
+
+            # Get the step number for the last sample.
+            self.stepLast = log.recs[log.nrecs-1].step
+
+            if self.burnin == ULLONG_MAX:
+                # Use the last half of each chain by default.
+                self.stepFirst = ((self.stepLast/stride/2)+1)*stride
+            else:
+                if self.burnin > self.stepLast / stride:
+                    raise ValueError( \
+                      "Burnin (%d) consumes all samples (%d)" % \
+                      (self.burnin, self.stepLast/stride + 1))
+                self.stepFirst = self.burnin * stride
+            self.nsamples = (self.stepLast - self.stepFirst + stride) / stride
+
+            # Skip burnin without tokenizing it, then parse the lnLs for all
+            # posterior samples (in parallel, if threading is enabled).
+            first = CxPostLogLowerBound(&log, self.stepFirst)
+            if log.nrecs - first != self.nsamples:
+                raise ValueError("Missing samples in %r" % path)
+            fields = <unsigned *>malloc(nruns * sizeof(unsigned))
+            if fields == NULL:
+                raise MemoryError("Error allocating fields")
+            for 0 <= j < nruns:
+                fields[j] = j+2
+            lnLs = <double *>malloc(self.nsamples * nruns * sizeof(double))
+            if lnLs == NULL:
+                raise MemoryError("Error allocating lnLs")
+            if CxPostLogFields(&log, first, self.nsamples, fields, nruns, \
+              lnLs):
+                raise ValueError("Malformed sample in %r" % path)
 
-        nruns = self.mc3.getNruns()
-        self.runs = [[] for i in xrange(nruns)]
-        stride = self.mc3.getStride()
-
-        # Get the number of lines and the step number for the last sample.
-        nlines = 0
-        for line in sFile:
-            nlines += 1
-        self.stepLast = long(line.split(None, 1)[0])
-
-        if self.burnin == ULLONG_MAX:
-            # Use the last half of each chain by default.
-            self.stepFirst = ((self.stepLast/stride/2)+1)*stride
-        else:
-            if self.burnin > self.stepLast / stride:
-                raise ValueError("Burnin (%d) consumes all samples (%d)" % \
-                  (self.burnin, self.stepLast/stride + 1))
-            self.stepFirst = self.burnin * stride
-        self.nsamples = (self.stepLast - self.stepFirst + stride) / stride
-
-        # Rewind to beginning of file, then skip the header and burnin.
-        sFile.seek(0)
-        for 0 <= i < nlines - self.nsamples:
-            sFile.readline()
-
-        # Parse posterior samples.
-        for i <= i < nlines:
-            line = sFile.readline()
-            toks = line.split(None, nruns+2)
             for 0 <= j < nruns:
-                samp = Samp(float(toks[j+2]))
-                self.runs[j].append(samp)
+                run = <list>self.runs[j]
+                for 0 <= i < self.nsamples:
+                    run.append(Samp(lnLs[i*nruns + j]))
+        finally:
+            if fields != NULL:
+                free(fields)
+            if lnLs != NULL:
+                free(lnLs)
+            CxPostLogDelete(&log)
 
         self._sDone = True
 
@@ -314,12 +372,16 @@ cdef class Post:
             must be called manually prior to directly accessing Samp.msamps, in
             order to assure the field's validity.
         """
-        cdef file pFile
-        cdef unsigned nfreqs, nrates, run, model
-        cdef str line, rclass
-        cdef list toks, rates, freqs
-        cdef uint64_t stride, step
-        cdef double weight, rmult, wNorm, alpha
+        cdef str path, rclass
+        cdef CxtPostLog log
+        cdef CxtPostRec *rec
+        cdef unsigned nfreqs, nrates, nfields, i
+        cdef uint64_t stride, first, nrecs, r
+        cdef unsigned *fields
+        cdef double *vals, *v
+        cdef char *s
+        cdef size_t slen
+        cdef list rates, freqs
         cdef Samp samp
         cdef Msamp msamp
 
@@ -327,43 +389,70 @@ cdef class Post:
             return
         self.parseS()
 
-        pFile = open("%s.p" % self.mc3.outPrefix, "r")
-
-        nfreqs = self.mc3.alignment.charType.get().nstates
-        nrates = (nfreqs*(nfreqs-1))/2
-        stride = self.mc3.getStride()
-
-        # Skip header.
-        pFile.readline()
-
-        for line in pFile:
-            toks = line.split()
-            step = long(toks[1])
-            if step >= self.stepFirst:
-                assert step <= self.stepLast
-                run = int(toks[0])
-                model = int(toks[2])
-                weight = float(toks[3])
-                rmult = float(toks[4])
-                rclass = toks[6]
-                rates = []
-                for 0 <= i < nrates:
-                    rates.append(float(toks[i+8]))
-                wNorm = float(toks[nrates+9])
-                alpha = float(toks[nrates+10])
-                pinvar = float(toks[nrates+11])
-                freqs = []
-                for 0 <= i < nfreqs:
-                    freqs.append(float(toks[i+nrates+13]))
-                msamp = Msamp(weight, rmult, rclass, rates, alpha, pinvar, \
-                  freqs)
-                samp = \
-                  <Samp>(<list>self.runs[run])[(step-self.stepFirst)/stride]
+        path = "%s.p" % self.mc3.outPrefix
+        if CxPostLogNew(&log, path, CxePostLogP):
+            raise IOError("Error reading %r" % path)
+        fields = NULL
+        vals = NULL
+        try:
+            nfreqs = self.mc3.alignment.charType.get().nstates
+            nrates = (nfreqs*(nfreqs-1))/2
+            stride = self.mc3.getStride()
+
+            # Field layout (see Mc3.pWrite()):
+            #
+            #   run step model weight rmult ( rclass )[ R... ] wNorm alpha
+            #   pinvar [ Pi... ]
+            #
+            # Parse the numeric fields other than run/step/model, which are
+            # already available via the index.
+            nfields = 2 + nrates + 3 + nfreqs
+            fields = <unsigned *>malloc(nfields * sizeof(unsigned))
+            if fields == NULL:
+                raise MemoryError("Error allocating fields")
+            fields[0] = 3
+            fields[1] = 4
+            for 0 <= i < nrates:
+                fields[2+i] = i+8
+            fields[2+nrates] = nrates+9
+            fields[2+nrates+1] = nrates+10
+            fields[2+nrates+2] = nrates+11
+            for 0 <= i < nfreqs:
+                fields[2+nrates+3+i] = i+nrates+13
+
+            # Skip burnin without tokenizing it.
+            first = CxPostLogLowerBound(&log, self.stepFirst)
+            nrecs = log.nrecs - first
+            vals = <double *>malloc(nrecs * nfields * sizeof(double))
+            if vals == NULL:
+                raise MemoryError("Error allocating vals")
+            if CxPostLogFields(&log, first, nrecs, fields, nfields, vals):
+                raise ValueError("Malformed sample in %r" % path)
+
+            for 0 <= r < nrecs:
+                rec = &log.recs[first+r]
+                assert rec.step <= self.stepLast
+                v = &vals[r*nfields]
+                s = CxPostLogField(&log, first+r, 6, False, &slen)
+                assert s != NULL
+                rclass = PyString_FromStringAndSize(s, slen)
+                rates = [v[2+i] for i in xrange(nrates)]
+                freqs = [v[2+nrates+3+i] for i in xrange(nfreqs)]
+                msamp = Msamp(v[0], v[1], rclass, rates, v[2+nrates+1], \
+                  v[2+nrates+2], freqs)
+                samp = <Samp>(<list>self.runs[rec.run]) \
+                  [(rec.step-self.stepFirst)/stride]
                 samp.msamps.append(msamp)
-                assert samp.wNorm == -1.0 or samp.wNorm == wNorm
-                samp.wNorm = wNorm
+                assert samp.wNorm == -1.0 or samp.wNorm == v[2+nrates]
+                samp.wNorm = v[2+nrates]
                 if len(samp.msamps) > self.maxModels:
                     self.maxModels = len(samp.msamps)
+        finally:
+            if fields != NULL:
+                free(fields)
+            if vals != NULL:
+                free(vals)
+            CxPostLogDelete(&log)
 
         self._pDone = True
 
@@ -376,38 +465,168 @@ cdef class Post:
             must be called manually prior to directly accessing Samp.tree, in
             order to assure the field's validity.
         """
-        cdef file tFile
-        cdef uint64_t stride, step
-        cdef str line
-        cdef list toks
-        cdef unsigned run
-        cdef Tree tree
+        cdef str path
+        cdef CxtPostLog log
+        cdef CxtPostRec *rec, *last
+        cdef uint64_t stride, first, r
         cdef Samp samp
 
         if self._tDone:
             return
         self.parseS()
 
-        tFile = open("%s.t" % self.mc3.outPrefix, "r")
-
-        stride = self.mc3.getStride()
+        path = "%s.t" % self.mc3.outPrefix
+        if CxPostLogNew(&log, path, CxePostLogT):
+            raise IOError("Error reading %r" % path)
+        try:
+            stride = self.mc3.getStride()
+
+            # Skip burnin without tokenizing it.  Each record is of the form
+            # "[run step] tree", and the "[run step]" keys are Newick
+            # comments, so the posterior records can all be handed to the
+            # bulk parser at once.  Tree instances are created only if
+            # Samp.tree is accessed.
+            self._trees = Trees()
+            first = CxPostLogLowerBound(&log, self.stepFirst)
+            if first < log.nrecs:
+                rec = &log.recs[first]
+                last = &log.recs[log.nrecs-1]
+                try:
+                    self._trees.parseBuf(&log.map[rec.off], \
+                      last.off + last.len - rec.off, <unsigned>first + 2)
+                except SyntaxError, e:
+                    raise ValueError("Malformed sample in %r (%s)" % (path, e))
+                if self._trees.getNtrees() != log.nrecs - first:
+                    raise ValueError("Malformed sample in %r" % path)
+            for first <= r < log.nrecs:
+                rec = &log.recs[r]
+                assert rec.step <= self.stepLast
+                samp = <Samp>(<list>self.runs[rec.run]) \
+                  [(rec.step-self.stepFirst)/stride]
+                samp._trees = self._trees
+                samp._treeInd = r - first
+        finally:
+            CxPostLogDelete(&log)
 
-        # Skip header.
-        tFile.readline()
+        self._tDone = True
 
-        for line in tFile:
-            toks = line.split(None, 2)
-            step = long(toks[1][:-1])
-            if step >= self.stepFirst:
-                assert step <= self.stepLast
-                run = int(toks[0][1:])
-                tree = Tree(toks[2], None, False)
-                tree.deroot()
-                samp = \
-                  <Samp>(<list>self.runs[run])[(step-self.stepFirst)/stride]
-                samp.tree = tree
+    cpdef bint loadSummary(self) except *:
+        """
+            Load the statistics in <self.outPrefix>.summary, as written by Mc3
+            when its summary parameter is enabled, rather than computing them
+            from the log files.  Return True if the summary was loaded, or
+            False if there is no summary, if it is older than the log files
+            (i.e. left over from a previous run), or if it was computed for a
+            different burnin.  Quantiles in the summary are approximate.  A
+            summary that was written with Mc3's default summaryBurnin matches
+            the default burnin, but its burn-in is fixed (see
+            Mc3.summaryBurnin), so stepFirst may precede the last half of the
+            samples.
+
+            Once a summary has been loaded, nsamples, stepFirst, stepLast,
+            maxModels, all of the parameter and Rcov statistics, and
+            sumt.parts/sumt.getConTree() are valid without parsing the log
+            files.  sumt.trprobs is unavailable, since tree topologies are not
+            summarized.
+        """
+        cdef file f
+        cdef str line, k, v, vecStr
+        cdef list stats, taxa, parts, fields, nobs, rates, freqs
+        cdef unsigned nruns, ntaxa, i
+        cdef Vec vec
+        cdef Part part
+
+        try:
+            if os.path.getmtime("%s.summary" % self.mc3.outPrefix) < \
+              os.path.getmtime("%s.s" % self.mc3.outPrefix):
+                return False
+            f = open("%s.summary" % self.mc3.outPrefix, "r")
+        except (IOError, OSError):
+            return False
 
-        self._tDone = True
+        nruns = self.mc3.getNruns()
+        taxa = []
+        parts = []
+        rates = []
+        freqs = []
+        for line in f:
+            (k, v) = line.rstrip("\n").split(": ", 1)
+            if k == 'burnin':
+                if long(v) != self.burnin:
+                    f.close()
+                    return False
+            elif k == 'stepFirst':
+                self.stepFirst = long(v)
+            elif k == 'stepLast':
+                self.stepLast = long(v)
+            elif k == 'nsamples':
+                self.nsamples = long(v)
+            elif k == 'maxModels':
+                self.maxModels = long(v)
+            elif k == 'rcovLnL':
+                self._rcovLnL = float(v)
+            elif k == 'rcovRclass':
+                self._rcovRclass = float(v)
+            elif k == 'taxon':
+                taxa.append(Taxa.get(v))
+            elif k == 'part':
+                fields = v.split()
+                vecStr = fields[0]
+                ntaxa = len(taxa)
+                if len(vecStr) != ntaxa or len(fields) != 4 + nruns:
+                    raise ValueError("Malformed partition: %r" % line)
+                vec = Vec(None, ntaxa)
+                for 0 <= i < ntaxa:
+                    if vecStr[i] == '*':
+                        vec.set(i, True)
+                nobs = [long(field) for field in fields[4:]]
+                part = Part(vec, nruns)
+                part._load(nobs, float(fields[1]), float(fields[2]), \
+                  float(fields[3]))
+                parts.append(part)
+            else:
+                # Parameter statistics: mean var minCred maxCred med.
+                stats = [float(field) for field in v.split()]
+                if len(stats) != 5:
+                    raise ValueError("Malformed statistics: %r" % line)
+                if k == 'lnL':
+                    (self._lnLMean, self._lnLVar, self._lnLMinCred, \
+                      self._lnLMaxCred, self._lnLMed) = stats
+                elif k == 'nmodels':
+                    (self._nmodelsMean, self._nmodelsVar, \
+                      self._nmodelsMinCred, self._nmodelsMaxCred, \
+                      self._nmodelsMed) = stats
+                elif k == 'alpha':
+                    (self._alphaMean, self._alphaVar, self._alphaMinCred, \
+                      self._alphaMaxCred, self._alphaMed) = stats
+                elif k == 'pinvar':
+                    (self._pinvarMean, self._pinvarVar, \
+                      self._pinvarMinCred, self._pinvarMaxCred, \
+                      self._pinvarMed) = stats
+                elif k == 'rate':
+                    rates.append(stats)
+                elif k == 'freq':
+                    freqs.append(stats)
+                else:
+                    raise ValueError("Unknown summary field: %r" % k)
+        f.close()
+
+        if len(rates) > 0:
+            self._ratesMean = [stats[0] for stats in rates]
+            self._ratesVar = [stats[1] for stats in rates]
+            self._ratesMinCred = [stats[2] for stats in rates]
+            self._ratesMaxCred = [stats[3] for stats in rates]
+            self._ratesMed = [stats[4] for stats in rates]
+        if len(freqs) > 0:
+            self._freqsMean = [stats[0] for stats in freqs]
+            self._freqsVar = [stats[1] for stats in freqs]
+            self._freqsMinCred = [stats[2] for stats in freqs]
+            self._freqsMaxCred = [stats[3] for stats in freqs]
+            self._freqsMed = [stats[4] for stats in freqs]
+        self._sumt = Sumt(None, parts, taxa, self.nsamples * nruns)
+
+        self.summarized = True
+        return True
 
     # This method is conceptually identical to Crux.Mc3.Mc3.computeRcov(), but
     # it does not have to deal with discarding burn-in, nor does speed matter
@@ -1255,11 +1474,10 @@ cdef class Post:
             return self.getPinvarMed()
 
     cdef void _summarizeTrees(self) except *:
-        cdef list treeLists, trees
+        cdef list treeLists, inds
         cdef unsigned nruns, i
         cdef uint64_t j
         cdef Samp samp
-        cdef Tree tree
 
         self.parseT()
 
@@ -1269,13 +1487,12 @@ cdef class Post:
         treeLists = []
         nruns = self.mc3.getNruns()
         for 0 <= i < nruns:
-            trees = []
-            treeLists.append(trees)
+            inds = []
+            treeLists.append(inds)
             for 0 <= j < self.nsamples:
                 samp = <Samp>(<list>self.runs[i])[j]
-                tree = samp.tree
-                trees.append(tree)
-        self._sumt = Sumt(treeLists)
+                inds.append(samp._treeInd)
+        self._sumt = Sumt(treeLists, trees=self._trees)
     cdef Sumt getSumt(self):
         if self._sumt is None:
             self._summarizeTrees()
@@ -0,0 +1,32 @@
+from libc cimport uint64_t
+from CxSummary cimport CxtSummary
+from Crux.Tree.Lik cimport Lik
+from Crux.Tree.Bipart cimport Splits
+
+# Parameter columns.  Rates (rlen of them) follow SummParmRates, and state
+# frequencies (nstates of them) follow the rates.
+cdef enum:
+    SummParmLnL     = 0
+    SummParmNmodels = 1
+    SummParmRclass  = 2
+    SummParmAlpha   = 3
+    SummParmPinvar  = 4
+    SummParmRates   = 5
+
+cdef class Summary:
+    cdef CxtSummary _summ
+    cdef bint _summAlloced
+    cdef unsigned _rlen
+    cdef unsigned _nstates
+    cdef list _taxa
+    cdef Splits _splits
+    cdef dict _rclasses # rclass tuple-->SummParmRclass value.
+    cdef list _rclassCounts # Per run: SummParmRclass value-->count.
+    cdef uint64_t _last # Most recently observed sample.
+    cdef double *_parms # Scratch row for observe().
+
+    cdef void observe(self, unsigned run, uint64_t samp, Lik lik, double lnL) \
+      except *
+    cdef double _rcovRclass(self, double cvgAlpha) except -1.0
+    cpdef write(self, str path, unsigned stride, uint64_t burnin, \
+      double cvgAlpha)
@@ -0,0 +1,261 @@
+"""
+    Running posterior summary for Mc3.
+
+    Summary incorporates the samples taken by the unheated chains of an Mc3
+    run as they are taken, so that the posterior statistics that are otherwise
+    computed by Crux.Mc3.Post (parameter statistics, Rcov, and split
+    frequencies/branch length moments) can be written when sampling ends,
+    without re-reading the log files.  Storage does not grow with the number
+    of samples: moments are accumulated with Welford's method, and quantiles
+    (credibility intervals, medians, and the lnL Rcov) are estimated from
+    t-digest sketches, so they approximate the values that Post computes.
+"""
+import os
+
+from libc cimport *
+from libm cimport *
+from CxBipart cimport *
+from CxSummary cimport *
+from Crux.Taxa cimport Taxon
+from Crux.Tree cimport Tree, Edge
+from Crux.Tree.Bipart cimport Vec, Splits
+from Crux.Tree.Lik cimport Lik
+
+cdef class Summary:
+    """
+        nruns
+          Number of independent runs.
+
+        taxa
+          Alphabetized list of the taxa in the sampled trees.
+
+        nstates
+          Number of character states.
+
+        first
+          Index of the first sample to incorporate; earlier samples are
+          burn-in.
+    """
+    def __cinit__(self):
+        self._summAlloced = False
+        self._parms = NULL
+
+    def __dealloc__(self):
+        if self._summAlloced:
+            CxSummaryDelete(&self._summ)
+            self._summAlloced = False
+        if self._parms != NULL:
+            free(self._parms)
+            self._parms = NULL
+
+    def __init__(self, unsigned nruns, list taxa, unsigned nstates, \
+      uint64_t first):
+        cdef unsigned nParms
+
+        self._rlen = nstates * (nstates-1) / 2
+        self._nstates = nstates
+        self._taxa = taxa
+        self._splits = Splits(taxa)
+        self._rclasses = {}
+        self._rclassCounts = [{} for i in xrange(nruns)]
+        self._last = ULLONG_MAX
+
+        nParms = SummParmRates + self._rlen + self._nstates
+        self._parms = <double *>malloc(nParms * sizeof(double))
+        if self._parms == NULL:
+            raise MemoryError("Error allocating parameter row")
+        if CxSummaryNew(&self._summ, nruns, len(taxa), nParms, first):
+            raise MemoryError("Error allocating summary")
+        self._summAlloced = True
+
+    cdef void observe(self, unsigned run, uint64_t samp, Lik lik, double lnL) \
+      except *:
+        """
+            Incorporate sample samp of run, as represented by the unheated
+            chain's lik.  Every run must be observed once for each sample, in
+            sample order.
+        """
+        cdef Splits splits
+        cdef list rclass
+        cdef tuple key
+        cdef dict counts
+        cdef double rclassId
+        cdef unsigned i
+        cdef double wNorm, rmult, wVar, wInvar, fSum
+
+        self._last = samp
+        if samp < self._summ.first:
+            return
+
+        splits = self._splits
+        splits.compute(lik.tree)
+        for 0 <= i < splits.nsplits:
+            if CxSummarySplit(&self._summ, run, splits.hashes[i], \
+              &splits.words[i * splits.nWords], \
+              (<Edge>splits.edges[i]).length):
+                raise MemoryError("Error growing summary")
+
+        # Model parameters are summarized for the first model only, since
+        # Post only reports them when there is exactly one model.
+        self._parms[SummParmLnL] = lnL
+        self._parms[SummParmNmodels] = <double>lik.nmodels()
+
+        rclass = lik.getRclass(0)
+        key = tuple(rclass)
+        if key not in self._rclasses:
+            self._rclasses[key] = <double>len(self._rclasses)
+        rclassId = self._rclasses[key]
+        self._parms[SummParmRclass] = rclassId
+        counts = <dict>self._rclassCounts[run]
+        counts[rclassId] = counts.get(rclassId, 0) + 1
+
+        self._parms[SummParmAlpha] = lik.getAlpha(0)
+        wVar = lik.getWVar(0)
+        wInvar = lik.getWInvar(0)
+        self._parms[SummParmPinvar] = wInvar / (wVar+wInvar)
+
+        wNorm = lik.getWNorm()
+        rmult = lik.getRmult(0)
+        for 0 <= i < self._rlen:
+            self._parms[SummParmRates + i] = lik.getRate(0, \
+              <unsigned>rclass[i]) * wNorm * rmult
+
+        fSum = 0.0
+        for 0 <= i < self._nstates:
+            fSum += lik.getFreq(0, i)
+        for 0 <= i < self._nstates:
+            self._parms[SummParmRates + self._rlen + i] = \
+              lik.getFreq(0, i) / fSum
+
+        CxSummaryParms(&self._summ, run, self._parms)
+
+    # Equivalent to Crux.Mc3.Post._computeRcovRclass(), based on the per-run
+    # rclass counts.  rclasses are represented by integer identifiers rather
+    # than strings, which does not affect the result, since all rclasses that
+    # tie at the tail boundary are treated alike.
+    cdef double _rcovRclass(self, double cvgAlpha) except -1.0:
+        cdef double rcovRclass, cvgAlphaEmp, r, rclass
+        cdef uint64_t nsamples, tail, j, k, n, nCum
+        cdef unsigned nruns, i
+        cdef dict rclasses
+        cdef list deco
+
+        nruns = self._summ.nruns
+        nsamples = self._summ.nsamps[0]
+        rcovRclass = 0.0
+
+        tail = <uint64_t>floor(cvgAlpha * <double>nsamples)
+
+        for 0 <= i < nruns:
+            rclasses = dict(<dict>self._rclassCounts[i])
+
+            deco = [(rclasses[rclass], rclass) for rclass in rclasses]
+            deco.sort()
+
+            nCum = 0
+            for 0 <= j < len(deco):
+                (n, rclass) = deco[j]
+                if nCum + n > tail:
+                    break
+                nCum += n
+            for j >= j > 0:
+                if deco[j-1][0] != deco[j][0]:
+                    break
+            nCum = 0
+            for 0 <= k < j:
+                (n, rclass) = deco[k]
+                nCum += n
+                del rclasses[rclass]
+            cvgAlphaEmp = <double>nCum / <double>nsamples
+
+            n = 0
+            for 0 <= j < nruns:
+                for rclass in rclasses:
+                    n += (<dict>self._rclassCounts[j]).get(rclass, 0)
+
+            r = <double>n / <double>(nruns * nsamples)
+            r *= (1.0-cvgAlpha) / (1.0-cvgAlphaEmp)
+            rcovRclass += r
+        rcovRclass /= <double>nruns
+        return rcovRclass
+
+    cpdef write(self, str path, unsigned stride, uint64_t burnin, \
+      double cvgAlpha):
+        """
+            Write the summary of the posterior samples to path.  burnin is
+            the Mc3 summaryBurnin setting (ULLONG_MAX for the default), which
+            Crux.Mc3.Post.loadSummary() matches against its own burnin; the
+            incorporated samples are those that follow first, as passed to
+            the constructor.  Nothing is written if there are no incorporated
+            samples.  Return True if the summary was written.
+        """
+        cdef file f
+        cdef str tmpPath
+        cdef unsigned nruns, nParms, maxModels, i
+        cdef uint64_t first, last, j, s
+        cdef uint64_t *nobs
+        cdef double mean, v2mean, var
+        cdef CxtSummaryStats stats
+        cdef Taxon taxon
+        cdef Vec vec
+        cdef list labels
+
+        nruns = self._summ.nruns
+        nParms = self._summ.nParms
+        if self._summ.nsamps[0] == 0:
+            return False
+        first = self._summ.first
+        last = self._last
+
+        maxModels = 0
+        for 0 <= i < nruns:
+            if self._summ.sketches[i*nParms + SummParmNmodels].max > \
+              <double>maxModels:
+                maxModels = <unsigned> \
+                  self._summ.sketches[i*nParms + SummParmNmodels].max
+
+        # Parameter rows are written in column order: lnL, nmodels, rclass
+        # (omitted), alpha, pinvar, rates, freqs.
+        labels = ["lnL", "nmodels", None, "alpha", "pinvar"] \
+          + ["rate"] * self._rlen + ["freq"] * self._nstates
+
+        # Write to a temporary file and rename it, so that an interrupted
+        # write never leaves a truncated summary.
+        tmpPath = "%s.tmp" % path
+        f = open(tmpPath, "w")
+        f.write("burnin: %d\n" % burnin)
+        f.write("stepFirst: %d\n" % (first * stride))
+        f.write("stepLast: %d\n" % (last * stride))
+        f.write("nsamples: %d\n" % (last + 1 - first))
+        f.write("maxModels: %d\n" % maxModels)
+        if nruns > 1:
+            f.write("rcovLnL: %r\n" % CxSummaryRcov(&self._summ, \
+              SummParmLnL, cvgAlpha))
+            if maxModels == 1:
+                f.write("rcovRclass: %r\n" % self._rcovRclass(cvgAlpha))
+        for taxon in self._taxa:
+            f.write("taxon: %s\n" % taxon.label)
+        for 0 <= i < nParms:
+            if labels[i] is None or (i > SummParmNmodels and maxModels != 1):
+                continue
+            CxSummaryParmStats(&self._summ, i, cvgAlpha, &stats)
+            f.write("%s: %r %r %r %r %r\n" % (labels[i], stats.mean, \
+              stats.var, stats.minCred, stats.maxCred, stats.med))
+
+        nobs = <uint64_t *>malloc(nruns * sizeof(uint64_t))
+        if nobs == NULL:
+            raise MemoryError("Error allocating nobs")
+        try:
+            vec = Vec(None, self._summ.nBits)
+            for 0 <= s < self._summ.nsplits:
+                CxSummarySplitStats(&self._summ, s, nobs, &mean, &v2mean, \
+                  &var)
+                memcpy(vec.bits, self._summ.splitWords[s], \
+                  vec.nWords * sizeof(uint64_t))
+                f.write("part: %r %r %r %r %s\n" % (vec, mean, v2mean, var, \
+                  " ".join(["%d" % nobs[i] for i in xrange(nruns)])))
+        finally:
+            free(nobs)
+        f.close()
+        os.rename(tmpPath, path)
+        return True
@@ -3,13 +3,19 @@ cdef class Mc3
 
 from libc cimport uint64_t
 from SFMT cimport *
+from CxLik cimport CxtLikStats
+from CxAsdsf cimport CxtAsdsf
+from CxRcov cimport CxtRcov
+from CxEss cimport CxtEss
 from Crux.CTMatrix cimport Alignment
-from Crux.Mc3.Chain cimport Chain, PropCnt
+from Crux.Mc3.Chain cimport Chain, PropCnt, PropLambdaCnt
 from Crux.Tree cimport Tree
+from Crux.Tree.Bipart cimport Splits
 from Crux.Tree.Lik cimport Lik
 IF @enable_mpi@:
     cimport mpi4py.mpi_c as mpi
 from Crux.Mc3.Post cimport Post
+from Crux.Mc3.Summary cimport Summary
 
 cdef struct Mc3SwapInfo:
     uint64_t step
@@ -21,6 +27,26 @@ cdef struct Mc3RateStats:
     uint64_t n # Numerator.
     uint64_t d # Denominator.
 
+# Cumulative proposal work.  The uint64_t fields must remain contiguous, since
+# they are reduced as an array under MPI.
+cdef struct Mc3PropWork:
+    double time       # Wall time, in seconds.
+    uint64_t nlnL     # Lik.lnL() calls.
+    uint64_t nsteps   # Conditional likelihood execution plan steps.
+    uint64_t npmats   # P matrices computed.
+    uint64_t nclones  # Lik.clone() calls.
+    uint64_t nallocs  # Conditional likelihood matrix allocations.
+
+# Quantities for which effective sample sizes are monitored.
+cdef enum:
+    EssLnL     = 0
+    EssAlpha   = 1
+    EssPinvar  = 2
+    EssRmult   = 3
+    EssNmodels = 4
+    EssTreeLen = 5
+    EssCnt     = 6 # Number of quantities.
+
 cdef class Mc3:
     cdef readonly Alignment alignment
     cdef public str outPrefix
@@ -33,6 +59,9 @@ cdef class Mc3:
     cdef uint64_t _cvgSampStride
     cdef double _cvgAlpha
     cdef double _cvgEpsilon
+    cdef double _cvgAsdsf
+    cdef double _asdsfMinFreq
+    cdef double _cvgEss
 
     # Chain parameters.
     cdef uint64_t _minStep
@@ -44,6 +73,7 @@ cdef class Mc3:
     cdef unsigned _ncoupled
     cdef double _heatDelta
     cdef unsigned _swapStride
+    cdef unsigned _swapLag
 
     # Mixture model parameters.
     cdef unsigned _nmodels
@@ -55,6 +85,10 @@ cdef class Mc3:
     # Use +I models if true.
     cdef bint _invar
 
+    # Running posterior summary parameters.
+    cdef bint _summary
+    cdef uint64_t _summaryBurnin
+
     # Proposal parameters.
     cdef double _weightLambda
     cdef double _freqLambda
@@ -66,6 +100,10 @@ cdef class Mc3:
     cdef double _etbrPExt
     cdef double _etbrLambda
 
+    # Proposal adaptation parameters.
+    cdef uint64_t _adaptStep
+    cdef double _adaptTarget
+
     # Model parameter priors.
     cdef double _rateShapeInvPrior
     cdef double _invarPrior
@@ -104,6 +142,9 @@ cdef class Mc3:
         # communicators are stored here rather than in the Chain class, because
         # not all nodes necessarily instantiate all chains.
         cdef mpi.MPI_Comm *mpiChainComms
+        # Non-blocking swap info exchange requests, two (receive, send) for
+        # each chain.
+        cdef mpi.MPI_Request *mpiSwapReqs
 
     # Matrix of heat swapInfo structures, two for each pair of
     # Metropolis-coupled chains (even/odd swaps).  The matrix is ordered as
@@ -130,6 +171,16 @@ cdef class Mc3:
     # Arrays of accept/reject statistics, one element for each run.
     cdef Mc3RateStats *propStats[PropCnt]
 
+    # Arrays of proposal work statistics, one element for each run.
+    # propWork accumulates work since the previous sample, which is then added
+    # to propWorkTotals.
+    cdef Mc3PropWork *propWork[PropCnt]
+    cdef Mc3PropWork *propWorkTotals[PropCnt]
+
+    # Matrix of adapted proposal lambdas, PropLambdaCnt for each chain, ordered
+    # by run, then chain.  Only allocated if _adaptStep is non-zero.
+    cdef double *lambdas
+
     # Temporary storage for the most recent Liks.  These are used to write
     # statistics to pFile/tFile.
     cdef list liks
@@ -138,17 +189,49 @@ cdef class Mc3:
     # lnLs arrays once every run has provided its lnL via sendSample().
     cdef double *cachedLnLs
 
-    # Array of pointers to lnL sample arrays from unheated chains, plus one
-    # extra (used as a scratch area).
+    # Array of pointers to lnL sample arrays from unheated chains.
     cdef double **lnLs
     cdef size_t lnLsMax
 
+    # Order statistics for the lnLs in the Rcov window, which starts at sample
+    # rcovFirst.
+    cdef CxtRcov rcov
+    cdef bint rcovAlloced
+    cdef uint64_t rcovFirst
+
+    # Incrementally maintained ASDSF for the unheated chains, over the same
+    # window of samples as Rcov.
+    cdef CxtAsdsf asdsf
+    cdef bint asdsfAlloced
+    cdef Splits asdsfSplits # Scratch space for updateAsdsf().
+
+    # Effective sample size estimators for the unheated chains, over the same
+    # window of samples as Rcov.  ess[run*EssCnt + quantity] contains the
+    # estimator for a particular run and quantity, and essTotals[quantity]
+    # contains the total ESS among runs for the current sample, or -1.0 if
+    # undefined.
+    cdef CxtEss *ess
+    cdef double essTotals[EssCnt]
+
+    # Throughput since the previous sample, or -1.0 if unknown.
+    cdef uint64_t rateStep
+    cdef double rateTime
+    cdef double stepRate
+    cdef double lnLRate
+
+    # Running posterior summary, maintained if _summary is true.
+    cdef Summary summ
+
     cdef bint verbose
 
     cpdef Mc3 dup(self)
     IF @enable_mpi@:
         cdef void storeSwapStats(self) except *
         cdef void storePropStats(self) except *
+        cdef void storePropWork(self) except *
+        cdef void storeLambdas(self) except *
+    cdef void updateRates(self, uint64_t step) except *
+    cdef void updatePropWork(self) except *
     cdef void updateDiags(self, uint64_t step) except *
     cdef void storeLiksLnLsUni(self, uint64_t step) except *
     IF @enable_mpi@:
@@ -157,11 +240,18 @@ cdef class Mc3:
     cdef void sendSample(self, unsigned runInd, uint64_t step, double heat, \
       uint64_t nswap, uint64_t *accepts, uint64_t *rejects, Lik lik, \
       double lnL) except *
+    cdef void sendPropWork(self, unsigned runInd, unsigned propInd, \
+      double t, CxtLikStats *stats0) except *
+    cdef void sendLambdas(self, unsigned runInd, unsigned chainInd, \
+      double *lambdas) except *
+    cdef void writeLambdas(self, uint64_t step) except *
     cdef void sendSwapInfo(self, unsigned runInd, unsigned srcChainInd, \
       unsigned dstChainInd, uint64_t step, double heat, double lnL) except *
     cdef void recvSwapInfoUni(self, unsigned runInd, unsigned dstChainInd, \
       unsigned srcChainInd, uint64_t step, double *heat, double *lnL) except *
     IF @enable_mpi@:
+        cdef void postSwapInfoMpi(self, unsigned runInd, \
+          unsigned srcChainInd, unsigned dstChainInd, uint64_t step) except *
         cdef void recvSwapInfoMpi(self, unsigned runInd, unsigned dstChainInd, \
           unsigned srcChainInd, uint64_t step, double *heat, double *lnL) \
           except *
@@ -173,9 +263,12 @@ cdef class Mc3:
     cdef void initSwapInfo(self) except *
     cdef void initSwapStats(self) except *
     cdef void initPropStats(self) except *
+    cdef void initPropWork(self) except *
+    cdef void initLambdas(self) except *
     cdef void initLiks(self) except *
     cdef void resetLiks(self) except *
     cdef void initLnLs(self) except *
+    cdef void initRcov(self) except *
     cdef void initProps(self) except *
     cdef void initRunsUni(self, list liks) except *
     IF @enable_mpi@:
@@ -185,10 +278,22 @@ cdef class Mc3:
     IF @enable_mpi@:
         cdef void advanceMpi(self) except *
     cdef void advance(self) except *
+    cdef void updateRcov(self, uint64_t step) except *
     cdef double computeRcovUni(self, uint64_t step) except *
     IF @enable_mpi@:
         cdef double computeRcovMpi(self, uint64_t step) except *
     cdef double computeRcov(self, uint64_t step) except *
+    cdef void initAsdsf(self) except *
+    cdef void updateAsdsf(self, uint64_t step) except *
+    IF @enable_mpi@:
+        cdef double computeAsdsfMpi(self) except *
+    cdef double computeAsdsf(self) except *
+    cdef void initEss(self) except *
+    cdef void updateEss(self, uint64_t step) except *
+    cdef double computeEssUni(self) except *
+    IF @enable_mpi@:
+        cdef double computeEssMpi(self) except *
+    cdef double computeEss(self) except *
     cdef bint writeGraph(self, uint64_t step) except *
     cdef str formatRclass(self, Lik lik, unsigned model)
     cdef str formatRates(self, Lik lik, unsigned model, str fmt)
@@ -196,15 +301,22 @@ cdef class Mc3:
     cdef str formatLnLs(self, uint64_t step, str fmt)
     cdef str formatRateStats(self, Mc3RateStats *rateStats)
     cdef str formatPropStats(self)
+    cdef str formatPropWork(self)
+    cdef str formatEss(self)
     cdef void lWrite(self, str s) except *
     cdef void tWrite(self, uint64_t step) except *
     cdef void pWrite(self, uint64_t step) except *
-    cdef void sWrite(self, uint64_t step, double rcov) except *
+    cdef void sWrite(self, uint64_t step, double rcov, double asdsf) \
+      except *
+    cdef void summarize(self, uint64_t step) except *
+    cdef void writeSummary(self) except *
     cdef bint sample(self, uint64_t step) except *
     cdef void randomDnaQ(self, Lik lik, unsigned model, sfmt_t *prng) except *
     cpdef Lik randomLik(self, Tree tree=*)
     cpdef run(self, bint verbose=*, list liks=*)
 
+    cdef dict getPropWork(self)
+    # property propWork
     cdef double getGraphDelay(self)
     cdef void setGraphDelay(self, double graphDelay)
     # property graphDelay
@@ -220,6 +332,15 @@ cdef class Mc3:
     cdef double getCvgEpsilon(self)
     cdef void setCvgEpsilon(self, double cvgEpsilon) except *
     # property cvgEpsilon
+    cdef double getCvgAsdsf(self)
+    cdef void setCvgAsdsf(self, double cvgAsdsf) except *
+    # property cvgAsdsf
+    cdef double getAsdsfMinFreq(self)
+    cdef void setAsdsfMinFreq(self, double asdsfMinFreq) except *
+    # property asdsfMinFreq
+    cdef double getCvgEss(self)
+    cdef void setCvgEss(self, double cvgEss) except *
+    # property cvgEss
     cdef uint64_t getMinStep(self)
     cdef void setMinStep(self, uint64_t minStep) except *
     # property minStep
@@ -241,6 +362,9 @@ cdef class Mc3:
     cdef unsigned getSwapStride(self)
     cdef void setSwapStride(self, unsigned swapStride) except *
     # property swapStride
+    cdef unsigned getSwapLag(self)
+    cdef void setSwapLag(self, unsigned swapLag) except *
+    # property swapLag
     cdef unsigned getNmodels(self)
     cdef void setNmodels(self, unsigned nmodels) except *
     # property nmodels
@@ -253,6 +377,12 @@ cdef class Mc3:
     cdef bint getInvar(self)
     cdef void setInvar(self, bint invar)
     # property invar
+    cdef bint getSummary(self)
+    cdef void setSummary(self, bint summary)
+    # property summary
+    cdef uint64_t getSummaryBurnin(self)
+    cdef void setSummaryBurnin(self, uint64_t summaryBurnin)
+    # property summaryBurnin
     cdef double getWeightLambda(self)
     cdef void setWeightLambda(self, double weightLambda) except *
     # property weightLambda
@@ -280,6 +410,12 @@ cdef class Mc3:
     cdef double getEtbrLambda(self)
     cdef void setEtbrLambda(self, double etbrLambda) except *
     # property etbrLambda
+    cdef uint64_t getAdaptStep(self)
+    cdef void setAdaptStep(self, uint64_t adaptStep)
+    # property adaptStep
+    cdef double getAdaptTarget(self)
+    cdef void setAdaptTarget(self, double adaptTarget) except *
+    # property adaptTarget
     cdef double getRateShapeInvPrior(self)
     cdef void setRateShapeInvPrior(self, double rateShapeInvPrior) except *
     # property rateShapeInvPrior
@@ -39,6 +39,19 @@
     convergence condition indicates that the chains are sampling from
     approximately the same distribution.
 
+    Effective sample sizes (ESS) for lnL and several scalar model parameters
+    are estimated online via batch means, over the same samples as Rcov, and
+    are reported along with throughput, so that proposal mixes can be tuned
+    for mixing efficiency.  Optionally, convergence additionally requires a
+    minimum ESS.
+
+    The average standard deviation of split frequencies (ASDSF) among chains is
+    also monitored, over the same samples as Rcov.  Split counts are updated
+    incrementally as samples enter and leave the window, so the cost of
+    monitoring is proportional to the number of splits in the affected trees.
+    Optionally, convergence additionally requires ASDSF to fall below a
+    threshold.
+
     References:
 
       Altekar, G., S. Dwarkadas, J.P. Huelsenbeck, F. Ronquist (2004) Parallel
@@ -74,10 +87,15 @@ cdef extern from "Python.h":
 from libc cimport *
 from libm cimport *
 from SFMT cimport *
+from CxAsdsf cimport *
+from CxRcov cimport *
+from CxEss cimport *
+from CxLik cimport CxtLikStats, CxLikStats
 from Crux.Mc3.Chain cimport *
 from Crux.Mc3.Post cimport *
+from Crux.Mc3.Summary cimport Summary
 from Crux.Tree cimport Tree, Edge
-from Crux.Tree.Bipart cimport Vec, Bipart
+from Crux.Tree.Bipart cimport Vec, Bipart, Splits
 from Crux.Tree.Lik cimport Lik
 from Crux.Tree.Sumt cimport Part
 from Crux.Character cimport Dna
@@ -92,11 +110,10 @@ IF @enable_mpi@:
         TagHeatSwap = 1
         TagLikLnL   = 2
 
-cdef int _lnLCmp(void *va, void *vb):
-    cdef double a = (<double *>va)[0]
-    cdef double b = (<double *>vb)[0]
-
-    return (a > b) - (a < b)
+# Proposal names, in Prop* order.
+cdef list _propNames = ["weight", "freq", "rmult", "rate", "rateShapeInv", \
+  "invar", "brlen", "etbr", "rateJump", "polytomyJump", "rateShapeInvJump", \
+  "invarJump", "freqJump", "mixtureJump"]
 
 # Lookup table of DNA rclasses, used to randomly draw rclasses from the
 # appropriate resolution class when drawing a Q from the prior.
@@ -195,11 +212,18 @@ cdef class Mc3:
         self.swapStats = NULL
         for 0 <= i < PropCnt:
             self.propStats[i] = NULL
+            self.propWork[i] = NULL
+            self.propWorkTotals[i] = NULL
+        self.lambdas = NULL
         self.cachedLnLs = NULL
         self.lnLs = NULL
+        self.rcovAlloced = False
+        self.asdsfAlloced = False
+        self.ess = NULL
         IF @enable_mpi@:
             self.mpiLeaderCommAlloced = False
             self.mpiChainComms = NULL
+            self.mpiSwapReqs = NULL
 
     def __dealloc__(self):
         cdef unsigned i
@@ -214,16 +238,34 @@ cdef class Mc3:
             if self.propStats[i] != NULL:
                 free(self.propStats[i])
                 self.propStats[i] = NULL
+            if self.propWork[i] != NULL:
+                free(self.propWork[i])
+                self.propWork[i] = NULL
+            if self.propWorkTotals[i] != NULL:
+                free(self.propWorkTotals[i])
+                self.propWorkTotals[i] = NULL
+        if self.lambdas != NULL:
+            free(self.lambdas)
+            self.lambdas = NULL
         if self.cachedLnLs != NULL:
             free(self.cachedLnLs)
             self.cachedLnLs = NULL
         if self.lnLs != NULL:
-            for 0 <= i < self._nruns+1:
+            for 0 <= i < self._nruns:
                 if self.lnLs[i] != NULL:
                     free(self.lnLs[i])
                     self.lnLs[i] = NULL
             free(self.lnLs)
             self.lnLs = NULL
+        if self.rcovAlloced:
+            CxRcovDelete(&self.rcov)
+            self.rcovAlloced = False
+        if self.ess != NULL:
+            free(self.ess)
+            self.ess = NULL
+        if self.asdsfAlloced:
+            CxAsdsfDelete(&self.asdsf)
+            self.asdsfAlloced = False
         IF @enable_mpi@:
             if self.mpiLeaderCommAlloced:
                 mpi.MPI_Comm_free(&self.mpiLeaderComm)
@@ -233,6 +275,9 @@ cdef class Mc3:
                     mpi.MPI_Comm_free(&self.mpiChainComms[i])
                 free(self.mpiChainComms)
                 self.mpiChainComms = NULL
+            if self.mpiSwapReqs != NULL:
+                free(self.mpiSwapReqs)
+                self.mpiSwapReqs = NULL
 
     def __init__(self, Alignment alignment, str outPrefix):
         self.alignment = alignment
@@ -244,6 +289,9 @@ cdef class Mc3:
         self._cvgSampStride = 1
         self._cvgAlpha = 0.05
         self._cvgEpsilon = 0.01
+        self._cvgAsdsf = 0.0
+        self._asdsfMinFreq = 0.1
+        self._cvgEss = 0.0
         self._minStep = 100000
         self._maxStep = ULLONG_MAX
         self._stride = 100
@@ -251,10 +299,13 @@ cdef class Mc3:
         self._ncoupled = 1
         self._heatDelta = 0.05
         self._swapStride = 1
+        self._swapLag = 0
         self._nmodels = 1
         self._ncat = 1
         self._catMedian = False
         self._invar = False
+        self._summary = False
+        self._summaryBurnin = ULLONG_MAX
         self._weightLambda = 2.0 * log(1.6)
         self._freqLambda = 2.0 * log(1.6)
         self._rmultLambda = 2.0 * log(1.6)
@@ -264,6 +315,8 @@ cdef class Mc3:
         self._brlenLambda = 2.0 * log(1.6)
         self._etbrPExt = 0.8
         self._etbrLambda = 2.0 * log(1.6)
+        self._adaptStep = 0
+        self._adaptTarget = 0.3
         self._rateShapeInvPrior = 1.0
         self._invarPrior = 0.5
         self._brlenPrior = 10.0
@@ -302,6 +355,9 @@ cdef class Mc3:
         ret._cvgSampStride = self._cvgSampStride
         ret._cvgAlpha = self._cvgAlpha
         ret._cvgEpsilon = self._cvgEpsilon
+        ret._cvgAsdsf = self._cvgAsdsf
+        ret._asdsfMinFreq = self._asdsfMinFreq
+        ret._cvgEss = self._cvgEss
         ret._minStep = self._minStep
         ret._maxStep = self._maxStep
         ret._stride = self._stride
@@ -309,10 +365,13 @@ cdef class Mc3:
         ret._ncoupled = self._ncoupled
         ret._heatDelta = self._heatDelta
         ret._swapStride = self._swapStride
+        ret._swapLag = self._swapLag
         ret._nmodels = self._nmodels
         ret._ncat = self._ncat
         ret._catMedian = self._catMedian
         ret._invar = self._invar
+        ret._summary = self._summary
+        ret._summaryBurnin = self._summaryBurnin
         ret._weightLambda = self._weightLambda
         ret._freqLambda = self._freqLambda
         ret._rmultLambda = self._rmultLambda
@@ -322,6 +381,8 @@ cdef class Mc3:
         ret._brlenLambda = self._brlenLambda
         ret._etbrPExt = self._etbrPExt
         ret._etbrLambda = self._etbrLambda
+        ret._adaptStep = self._adaptStep
+        ret._adaptTarget = self._adaptTarget
         ret._rateShapeInvPrior = self._rateShapeInvPrior
         ret._invarPrior = self._invarPrior
         ret._brlenPrior = self._brlenPrior
@@ -364,6 +425,93 @@ cdef class Mc3:
                           mpi.MPI_UNSIGNED_LONG_LONG, mpi.MPI_SUM, 0, \
                           self.mpiLeaderComm)
 
+        cdef void storePropWork(self) except *:
+            cdef unsigned i, j
+            cdef Mc3PropWork *propWork
+            cdef Mc3PropWork w
+
+            if self.mpiLeaderRank >= 0:
+                for 0 <= i < PropCnt:
+                    for 0 <= j < self._nruns:
+                        propWork = &self.propWork[i][j]
+                        w = propWork[0]
+                        mpi.MPI_Reduce(&w.time, &propWork.time, 1, \
+                          mpi.MPI_DOUBLE, mpi.MPI_SUM, 0, \
+                          self.mpiLeaderComm)
+                        mpi.MPI_Reduce(&w.nlnL, &propWork.nlnL, 5, \
+                          mpi.MPI_UNSIGNED_LONG_LONG, mpi.MPI_SUM, 0, \
+                          self.mpiLeaderComm)
+
+        # Each chain's lambdas are only stored on the node that advances the
+        # chain, and are zero elsewhere, so summing gathers them all.
+        cdef void storeLambdas(self) except *:
+            cdef unsigned i, j
+            cdef double *row
+            cdef double lambdas[PropLambdaCnt]
+
+            if self.mpiLeaderRank >= 0:
+                for 0 <= i < self._nruns * self._ncoupled:
+                    row = &self.lambdas[i * PropLambdaCnt]
+                    for 0 <= j < PropLambdaCnt:
+                        lambdas[j] = row[j]
+                    mpi.MPI_Reduce(lambdas, row, PropLambdaCnt, \
+                      mpi.MPI_DOUBLE, mpi.MPI_SUM, 0, self.mpiLeaderComm)
+
+    # Update throughput statistics.  This must be called before updateDiags(),
+    # which may clear propStats.
+    cdef void updateRates(self, uint64_t step) except *:
+        cdef unsigned runInd, i
+        cdef uint64_t nprops
+        cdef double t
+
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        t = time.time()
+        if step == 0 or t <= self.rateTime:
+            self.stepRate = -1.0
+            self.lnLRate = -1.0
+        else:
+            # Every step evaluates one proposal, and thus lnL, for each chain.
+            # Only the unheated chains report proposal counts, but heated
+            # chains use the same proposal mix.
+            nprops = 0
+            for 0 <= runInd < self._nruns:
+                for 0 <= i < PropCnt:
+                    nprops += self.propStats[i][runInd].d
+            self.stepRate = <double>(step - self.rateStep) / \
+              (t - self.rateTime)
+            self.lnLRate = <double>(nprops * self._ncoupled) / \
+              (t - self.rateTime)
+        self.rateStep = step
+        self.rateTime = t
+
+    # Add the work done since the previous sample to propWorkTotals.
+    cdef void updatePropWork(self) except *:
+        cdef unsigned i, j
+        cdef Mc3PropWork *propWork, *total
+        cdef bint accum
+
+        IF @enable_mpi@:
+            # Only the master node has the totals for all chains.
+            accum = (self.mpiLeaderRank == 0)
+        ELSE:
+            accum = True
+
+        for 0 <= i < PropCnt:
+            for 0 <= j < self._nruns:
+                propWork = &self.propWork[i][j]
+                if accum:
+                    total = &self.propWorkTotals[i][j]
+                    total.time += propWork.time
+                    total.nlnL += propWork.nlnL
+                    total.nsteps += propWork.nsteps
+                    total.npmats += propWork.npmats
+                    total.nclones += propWork.nclones
+                    total.nallocs += propWork.nallocs
+                memset(propWork, 0, sizeof(Mc3PropWork))
+
     # Update diagnostics based on swapStats and propStats.
     cdef void updateDiags(self, uint64_t step) except *:
         cdef unsigned runInd, i
@@ -420,7 +568,7 @@ cdef class Mc3:
                 lnLsMax = 8 # Arbitrary starting size.
             else:
                 lnLsMax = self._minStep / self._stride
-            for 0 <= i < self._nruns+1:
+            for 0 <= i < self._nruns:
                 self.lnLs[i] = <double *>malloc(lnLsMax * sizeof(double))
                 if self.lnLs[i] == NULL:
                     for 0 <= j < i:
@@ -430,7 +578,7 @@ cdef class Mc3:
         elif self.lnLsMax <= samp:
             lnLsMax = self.lnLsMax + 4 + (self.lnLsMax >> 3) + \
               (self.lnLsMax >> 4)
-            for 0 <= i < self._nruns+1:
+            for 0 <= i < self._nruns:
                 lnLs = <double *>realloc(self.lnLs[i], lnLsMax * sizeof(double))
                 if lnLs == NULL:
                     raise MemoryError("Error reallocating lnLs[%d]" % i)
@@ -557,6 +705,45 @@ cdef class Mc3:
 
         self.cachedLnLs[runInd] = lnL
 
+    cdef void sendPropWork(self, unsigned runInd, unsigned propInd, \
+      double t, CxtLikStats *stats0) except *:
+        cdef Mc3PropWork *propWork
+
+        propWork = &self.propWork[propInd][runInd]
+        propWork.time += t
+        propWork.nlnL += CxLikStats.nlnL - stats0.nlnL
+        propWork.nsteps += CxLikStats.nsteps - stats0.nsteps
+        propWork.npmats += CxLikStats.npmats - stats0.npmats
+        propWork.nclones += CxLikStats.nclones - stats0.nclones
+        propWork.nallocs += CxLikStats.nallocs - stats0.nallocs
+
+    cdef void sendLambdas(self, unsigned runInd, unsigned chainInd, \
+      double *lambdas) except *:
+        cdef unsigned i
+        cdef double *row
+
+        row = &self.lambdas[(runInd*self._ncoupled + chainInd) * \
+          PropLambdaCnt]
+        for 0 <= i < PropLambdaCnt:
+            row[i] = lambdas[i]
+
+    # Write the lambdas that the chains adapted, once adaptation completes.
+    cdef void writeLambdas(self, uint64_t step) except *:
+        cdef unsigned i, j, k
+        cdef double *row
+
+        IF @enable_mpi@:
+            if self.mpiWorldSize > 1:
+                self.storeLambdas()
+
+        self.lWrite("Adapted proposal lambdas at step %d:\n" % step)
+        for 0 <= i < self._nruns:
+            for 0 <= j < self._ncoupled:
+                row = &self.lambdas[(i*self._ncoupled + j) * PropLambdaCnt]
+                self.lWrite("  run %d, chain %d:%s\n" % (i, j, \
+                  "".join([" %s=%.6g" % (_propNames[k], row[k]) \
+                  for k in xrange(PropLambdaCnt)])))
+
     cdef void sendSwapInfo(self, unsigned runInd, unsigned srcChainInd, \
       unsigned dstChainInd, uint64_t step, double heat, double lnL) except *:
         cdef Mc3SwapInfo *swapInfo
@@ -571,6 +758,10 @@ cdef class Mc3:
         swapInfo.heat = heat
         swapInfo.lnL = lnL
 
+        IF @enable_mpi@:
+            if self.mpiWorldSize > 1:
+                self.postSwapInfoMpi(runInd, srcChainInd, dstChainInd, step)
+
     cdef void recvSwapInfoUni(self, unsigned runInd, unsigned dstChainInd, \
       unsigned srcChainInd, uint64_t step, double *heat, double *lnL) except *:
         cdef Mc3SwapInfo *swapInfo
@@ -588,6 +779,46 @@ cdef class Mc3:
             swapInfo.step = 0
 
     IF @enable_mpi@:
+        # Initiate the exchange of swap info with the partner chain's leader,
+        # if it is on a different node.  The exchange is completed by
+        # recvSwapInfoMpi() when the swap is applied, later in the same step,
+        # so it overlaps with advancing the node's other chains.
+        # recvSwapInfoMpi() does block: on the exchange, if the partner chain
+        # has not yet reached the step, and in MPI_Bcast(), which distributes
+        # the swap info to the chain's follower nodes.  Each node posts
+        # exchanges in chain order, so MPI's non-overtaking guarantee pairs
+        # sends with the corresponding receives, even though they all use the
+        # same tag.
+        cdef void postSwapInfoMpi(self, unsigned runInd, \
+          unsigned srcChainInd, unsigned dstChainInd, uint64_t step) except *:
+            cdef Mc3SwapInfo *swapInfoSend, *swapInfoRecv
+            cdef mpi.MPI_Request *reqs
+            cdef int peerRank
+            cdef unsigned chain
+
+            if self.mpiLeaderRank < 0:
+                return
+            chain = runInd*self._ncoupled + srcChainInd
+            peerRank = (runInd*self._ncoupled + dstChainInd) % \
+              self.mpiLeaderSize
+            if peerRank == chain % self.mpiLeaderSize:
+                return
+            assert chain % self.mpiLeaderSize == self.mpiLeaderRank
+
+            swapInfoSend = &self.swapInfo[((runInd*self._ncoupled + \
+              srcChainInd)*self._ncoupled + dstChainInd)*2 + \
+              ((step/self._swapStride) % 2)]
+
+            swapInfoRecv = &self.swapInfo[((runInd*self._ncoupled + \
+              dstChainInd)*self._ncoupled + srcChainInd)*2 + \
+              ((step/self._swapStride) % 2)]
+
+            reqs = &self.mpiSwapReqs[chain*2]
+            mpi.MPI_Irecv(swapInfoRecv, sizeof(Mc3SwapInfo), mpi.MPI_BYTE, \
+              peerRank, TagHeatSwap, self.mpiLeaderComm, &reqs[0])
+            mpi.MPI_Isend(swapInfoSend, sizeof(Mc3SwapInfo), mpi.MPI_BYTE, \
+              peerRank, TagHeatSwap, self.mpiLeaderComm, &reqs[1])
+
         cdef void recvSwapInfoMpi(self, unsigned runInd, unsigned dstChainInd, \
           unsigned srcChainInd, uint64_t step, double *heat, double *lnL) \
           except *:
@@ -603,23 +834,20 @@ cdef class Mc3:
               srcChainInd)*self._ncoupled + dstChainInd)*2 + \
               ((step/self._swapStride) % 2)]
 
+            chain = runInd*self._ncoupled + dstChainInd
             peerRank = (runInd*self._ncoupled + srcChainInd) % \
               self.mpiLeaderSize
-            if peerRank != (runInd*self._ncoupled + dstChainInd) % \
-              self.mpiLeaderSize:
+            if peerRank != chain % self.mpiLeaderSize:
                 assert swapInfoSend.step == step
                 if self.mpiLeaderRank >= 0:
-                    assert (runInd*self._ncoupled + dstChainInd) % \
-                      self.mpiLeaderSize == self.mpiLeaderRank
-                    mpi.MPI_Sendrecv(swapInfoSend, sizeof(Mc3SwapInfo), \
-                      mpi.MPI_BYTE, peerRank, TagHeatSwap, swapInfoRecv, \
-                      sizeof(Mc3SwapInfo), mpi.MPI_BYTE, peerRank, \
-                      TagHeatSwap, self.mpiLeaderComm, mpi.MPI_STATUS_IGNORE)
+                    assert chain % self.mpiLeaderSize == self.mpiLeaderRank
+                    # Complete the exchange that postSwapInfoMpi() initiated.
+                    mpi.MPI_Waitall(2, &self.mpiSwapReqs[chain*2], \
+                      mpi.MPI_STATUSES_IGNORE)
                 IF @enable_debug@:
                     swapInfoSend.step = 0
 
             # Share swap info with follower nodes.
-            chain = runInd*self._ncoupled + dstChainInd
             mpi.MPI_Bcast(swapInfoRecv, sizeof(Mc3SwapInfo), mpi.MPI_BYTE,
               0, self.mpiChainComms[chain])
 
@@ -768,6 +996,9 @@ cdef class Mc3:
             f.write("  cvgSampStride: %r\n" % self._cvgSampStride)
             f.write("  cvgAlpha: %r\n" % self._cvgAlpha)
             f.write("  cvgEpsilon: %r\n" % self._cvgEpsilon)
+            f.write("  cvgAsdsf: %r\n" % self._cvgAsdsf)
+            f.write("  asdsfMinFreq: %r\n" % self._asdsfMinFreq)
+            f.write("  cvgEss: %r\n" % self._cvgEss)
             f.write("  minStep: %r\n" % self._minStep)
             f.write("  maxStep: %r\n" % self._maxStep)
             f.write("  stride: %r\n" % self._stride)
@@ -775,10 +1006,13 @@ cdef class Mc3:
             f.write("  ncoupled: %r\n" % self._ncoupled)
             f.write("  heatDelta: %r\n" % self._heatDelta)
             f.write("  swapStride: %r\n" % self._swapStride)
+            f.write("  swapLag: %r\n" % self._swapLag)
             f.write("  nmodels: %r\n" % self._nmodels)
             f.write("  ncat: %r\n" % self._ncat)
             f.write("  catMedian: %r\n" % self._catMedian)
             f.write("  invar: %r\n" % self._invar)
+            f.write("  summary: %r\n" % self._summary)
+            f.write("  summaryBurnin: %r\n" % self._summaryBurnin)
             f.write("  weightLambda: %r\n" % self._weightLambda)
             f.write("  freqLambda: %r\n" % self._freqLambda)
             f.write("  rmultLambda: %r\n" % self._rmultLambda)
@@ -788,6 +1022,8 @@ cdef class Mc3:
             f.write("  brlenLambda: %r\n" % self._brlenLambda)
             f.write("  etbrPExt: %r\n" % self._etbrPExt)
             f.write("  etbrLambda: %r\n" % self._etbrLambda)
+            f.write("  adaptStep: %r\n" % self._adaptStep)
+            f.write("  adaptTarget: %r\n" % self._adaptTarget)
             f.write("  rateShapeInvPrior: %r\n" % self._rateShapeInvPrior)
             f.write("  invarPrior: %r\n" % self._invarPrior)
             f.write("  brlenPrior: %r\n" % self._brlenPrior)
@@ -837,13 +1073,25 @@ cdef class Mc3:
           " [ brlenPropRates ] [ etbrPropRates ] [ rateJumpPropRates ]" \
           " [ polytomyJumpPropRates ] [ rateShapeInvJumpPropRates ]" \
           " [ invarJumpPropRates ] [ freqJumpPropRates ]" \
-          " [ mixtureJumpPropRates ] }\n")
+          " [ mixtureJumpPropRates ] } ASDSF ( lnLESS alphaESS pinvarESS" \
+          " rmultESS nmodelsESS treeLenESS ) stepRate lnLRate <" \
+          " [ weightPropWork ]" \
+          " [ freqPropWork ] [ rmultPropWork ] [ ratePropWork ]" \
+          " [ rateShapeInvPropWork ] [ invarPropWork ] [ brlenPropWork ]" \
+          " [ etbrPropWork ] [ rateJumpPropWork ] [ polytomyJumpPropWork ]" \
+          " [ rateShapeInvJumpPropWork ] [ invarJumpPropWork ]" \
+          " [ freqJumpPropWork ] [ mixtureJumpPropWork ] >\n")
         self.sFile.flush()
         if self.verbose:
-            sys.stdout.write("s\tstep\t[ lnLs ] Rcov\n")
+            sys.stdout.write("s\tstep\t[ lnLs ] Rcov ASDSF ( lnLESS alphaESS" \
+              " pinvarESS rmultESS nmodelsESS treeLenESS ) stepRate\n")
+
+        self.summ = None
 
     # Allocate swapInfo matrix.
     cdef void initSwapInfo(self) except *:
+        cdef unsigned i
+
         if self._ncoupled > 1:
             if self.swapInfo != NULL:
                 free(self.swapInfo)
@@ -851,6 +1099,17 @@ cdef class Mc3:
               self._ncoupled * self._ncoupled * 2, sizeof(Mc3SwapInfo))
             if self.swapInfo == NULL:
                 raise MemoryError("Error allocating swapInfo")
+            IF @enable_mpi@:
+                if self.mpiWorldSize > 1:
+                    if self.mpiSwapReqs != NULL:
+                        free(self.mpiSwapReqs)
+                    self.mpiSwapReqs = <mpi.MPI_Request *>malloc( \
+                      self._nruns * self._ncoupled * 2 * \
+                      sizeof(mpi.MPI_Request))
+                    if self.mpiSwapReqs == NULL:
+                        raise MemoryError("Error allocating mpiSwapReqs")
+                    for 0 <= i < self._nruns * self._ncoupled * 2:
+                        self.mpiSwapReqs[i] = mpi.MPI_REQUEST_NULL
 
     # Allocate swapStats vector.
     cdef void initSwapStats(self) except *:
@@ -873,6 +1132,33 @@ cdef class Mc3:
             if self.propStats[i] == NULL:
                 raise MemoryError("Error allocating propStats[%d]" % i)
 
+    cdef void initPropWork(self) except *:
+        cdef unsigned i
+
+        for 0 <= i < PropCnt:
+            if self.propWork[i] != NULL:
+                free(self.propWork[i])
+            self.propWork[i] = <Mc3PropWork *>calloc(self._nruns, \
+              sizeof(Mc3PropWork))
+            if self.propWork[i] == NULL:
+                raise MemoryError("Error allocating propWork[%d]" % i)
+            if self.propWorkTotals[i] != NULL:
+                free(self.propWorkTotals[i])
+            self.propWorkTotals[i] = <Mc3PropWork *>calloc(self._nruns, \
+              sizeof(Mc3PropWork))
+            if self.propWorkTotals[i] == NULL:
+                raise MemoryError("Error allocating propWorkTotals[%d]" % i)
+
+    # Allocate lambdas matrix.
+    cdef void initLambdas(self) except *:
+        if self._adaptStep > 0:
+            if self.lambdas != NULL:
+                free(self.lambdas)
+            self.lambdas = <double *>calloc(self._nruns * self._ncoupled * \
+              PropLambdaCnt, sizeof(double))
+            if self.lambdas == NULL:
+                raise MemoryError("Error allocating lambdas")
+
     cdef void initLiks(self) except *:
         self.liks = [None] * self._nruns
 
@@ -895,10 +1181,19 @@ cdef class Mc3:
         if self.cachedLnLs == NULL:
             raise MemoryError("Error allocating cachedLnLs")
 
-        self.lnLs = <double **>calloc(self._nruns+1, sizeof(double *))
+        self.lnLs = <double **>calloc(self._nruns, sizeof(double *))
         if self.lnLs == NULL:
             raise MemoryError("Error allocating lnLs")
 
+    cdef void initRcov(self) except *:
+        if self.rcovAlloced:
+            CxRcovDelete(&self.rcov)
+            self.rcovAlloced = False
+        if CxRcovNew(&self.rcov, self._nruns):
+            raise MemoryError("Error allocating Rcov trees")
+        self.rcovAlloced = True
+        self.rcovFirst = 0
+
     # Initialize props[PC]df, which are used to compute proposal ratios and
     # choose proposal types.
     cdef void initProps(self) except *:
@@ -1105,13 +1400,37 @@ cdef class Mc3:
         ELSE:
             self.advanceUni()
 
+    # Insert the current samples into the Rcov order statistic trees, and
+    # remove the samples that have fallen out of the window, so that the trees
+    # contain (at most) the last half of each chain.
+    cdef void updateRcov(self, uint64_t step) except *:
+        cdef unsigned i
+        cdef uint64_t j, rcovFirst
+        cdef uint64_t last = step / self._stride
+        cdef uint64_t first = (last/2)+1
+
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        if self._nruns == 1:
+            return
+
+        for 0 <= i < self._nruns:
+            if CxRcovInsert(&self.rcov, i, last, self.lnLs[i][last]):
+                raise MemoryError("Error growing Rcov trees")
+        rcovFirst = self.rcovFirst
+        for rcovFirst <= j < first:
+            for 0 <= i < self._nruns:
+                CxRcovRemove(&self.rcov, i, j, self.lnLs[i][j])
+        self.rcovFirst = first
+
     # Compute Rcov convergence diagnostic.
     cdef double computeRcovUni(self, uint64_t step) except *:
         cdef ret
-        cdef uint64_t first, past, lower, upper, i, j, n
-        cdef unsigned runInd
-        cdef double alphaEmp
-        cdef double *rcovScratch = self.lnLs[self._nruns]
+        cdef uint64_t first, past, lower, upper, n
+        cdef unsigned runInd, i
+        cdef double alphaEmp, minLnL, maxLnL
         cdef uint64_t last = step / self._stride
 
         # Utilize (at most) the last half of each chain.
@@ -1119,6 +1438,7 @@ cdef class Mc3:
         first = (last/2)+1
         if first == past:
             return 0.0
+        assert self.rcovFirst == first
 
         # Compute the lower and upper bounds for the credibility intervals.  In
         # cases of rounding, expand rather than contract the credibility
@@ -1131,20 +1451,15 @@ cdef class Mc3:
 
         ret = 0.0
         for 0 <= runInd < self._nruns:
-            # Copy one run's samples into rcovScratch, and sort to make the
-            # bounds of the credibility interval available.
-            memcpy(rcovScratch, &self.lnLs[runInd][first], \
-              (past-first)*sizeof(double))
-            qsort(rcovScratch, past - first, sizeof(double), _lnLCmp)
+            # Select the bounds of the credibility interval by rank.
+            minLnL = CxRcovSelect(&self.rcov, runInd, lower)
+            maxLnL = CxRcovSelect(&self.rcov, runInd, upper)
 
             # Compute the proportion of the relevant lnLs that fall within the
             # credibility interval.
             n = 0
             for 0 <= i < self._nruns:
-                for first <= j < past:
-                    if self.lnLs[i][j] >= rcovScratch[lower] and \
-                      self.lnLs[i][j] <= rcovScratch[upper]:
-                        n += 1
+                n += CxRcovCount(&self.rcov, i, minLnL, maxLnL)
             ret += <double>n / <double>(self._nruns * (past - first))
         ret /= <double>self._nruns
         # Compute the empirical alpha, based on the credibility interval
@@ -1173,6 +1488,168 @@ cdef class Mc3:
         ELSE:
             return self.computeRcovUni(step)
 
+    cdef void initAsdsf(self) except *:
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        if self.asdsfAlloced:
+            CxAsdsfDelete(&self.asdsf)
+            self.asdsfAlloced = False
+        if self._nruns == 1:
+            return
+        if CxAsdsfNew(&self.asdsf, self._nruns, self.alignment.ntaxa, \
+          self._asdsfMinFreq):
+            raise MemoryError("Error allocating ASDSF")
+        self.asdsfAlloced = True
+        self.asdsfSplits = Splits((<Lik>self.liks[0]).tree.getTaxa())
+
+    # Add the unheated chains' current trees to the ASDSF tracker, and slide
+    # its window to cover the same samples as Rcov.  Only the splits in the
+    # added and removed trees are touched.
+    cdef void updateAsdsf(self, uint64_t step) except *:
+        cdef unsigned i
+        cdef uint32_t j
+        cdef uint64_t last = step / self._stride
+        cdef Lik lik
+        cdef Splits splits
+
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        if not self.asdsfAlloced:
+            return
+
+        for 0 <= i < self._nruns:
+            lik = <Lik>self.liks[i]
+            if CxAsdsfSample(&self.asdsf, i):
+                raise MemoryError("Error growing ASDSF")
+            splits = self.asdsfSplits
+            splits.compute(lik.tree)
+            for 0 <= j < splits.nsplits:
+                if CxAsdsfSplit(&self.asdsf, i, splits.hashes[j], \
+                  &splits.words[j * splits.nWords]):
+                    raise MemoryError("Error growing ASDSF")
+        if CxAsdsfWindow(&self.asdsf, (last/2)+1):
+            raise MemoryError("Error growing ASDSF")
+
+    IF @enable_mpi@:
+        cdef double computeAsdsfMpi(self) except *:
+            cdef double asdsf
+
+            if self.mpiLeaderRank == 0:
+                asdsf = CxAsdsfGet(&self.asdsf)
+            mpi.MPI_Bcast(&asdsf, 1, mpi.MPI_DOUBLE, 0, mpi.MPI_COMM_WORLD)
+
+            return asdsf
+
+    # Compute ASDSF convergence diagnostic, or return -1.0 if it is undefined.
+    cdef double computeAsdsf(self) except *:
+        IF @enable_mpi@:
+            if self.mpiWorldSize == 1:
+                return CxAsdsfGet(&self.asdsf)
+            else:
+                return self.computeAsdsfMpi()
+        ELSE:
+            return CxAsdsfGet(&self.asdsf)
+
+    cdef void initEss(self) except *:
+        cdef unsigned i
+
+        if self.ess != NULL:
+            free(self.ess)
+            self.ess = NULL
+        self.ess = <CxtEss *>malloc(self._nruns * EssCnt * sizeof(CxtEss))
+        if self.ess == NULL:
+            raise MemoryError("Error allocating ESS estimators")
+        for 0 <= i < self._nruns * EssCnt:
+            CxEssNew(&self.ess[i])
+        for 0 <= i < EssCnt:
+            self.essTotals[i] = -1.0
+        self.rateStep = 0
+        self.rateTime = 0.0
+        self.stepRate = -1.0
+        self.lnLRate = -1.0
+
+    # Add the unheated chains' current states to the ESS estimators, slide
+    # their windows to cover the same samples as Rcov, and update essTotals.
+    # Model parameters are monitored for the first model only.
+    cdef void updateEss(self, uint64_t step) except *:
+        cdef unsigned runInd, i
+        cdef uint64_t last = step / self._stride
+        cdef double x[EssCnt]
+        cdef double wVar, wInvar, e
+        cdef CxtEss *ess
+        cdef Lik lik
+        cdef Edge edge
+
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        for 0 <= runInd < self._nruns:
+            lik = <Lik>self.liks[runInd]
+            x[EssLnL] = self.lnLs[runInd][last]
+            x[EssAlpha] = lik.getAlpha(0)
+            wVar = lik.getWVar(0)
+            wInvar = lik.getWInvar(0)
+            x[EssPinvar] = wInvar / (wVar+wInvar)
+            x[EssRmult] = lik.getRmult(0)
+            x[EssNmodels] = <double>lik.nmodels()
+            x[EssTreeLen] = 0.0
+            for edge in lik.tree.getEdges():
+                x[EssTreeLen] += edge.length
+
+            ess = &self.ess[runInd * EssCnt]
+            for 0 <= i < EssCnt:
+                CxEssAdd(&ess[i], x[i])
+                CxEssWindow(&ess[i], (last/2)+1)
+
+        # Total ESS is undefined unless it is defined for every run.
+        for 0 <= i < EssCnt:
+            self.essTotals[i] = 0.0
+            for 0 <= runInd < self._nruns:
+                e = CxEssGet(&self.ess[runInd * EssCnt + i])
+                if e == -1.0:
+                    self.essTotals[i] = -1.0
+                    break
+                self.essTotals[i] += e
+
+    # Compute the minimum total ESS among the monitored quantities, or return
+    # -1.0 if ESS is undefined for lnL.  Quantities with undefined ESS (e.g.
+    # parameters that are fixed by the model) are ignored.
+    cdef double computeEssUni(self) except *:
+        cdef double ret
+        cdef unsigned i
+
+        if self.essTotals[EssLnL] == -1.0:
+            return -1.0
+        ret = self.essTotals[EssLnL]
+        for 0 <= i < EssCnt:
+            if self.essTotals[i] != -1.0 and self.essTotals[i] < ret:
+                ret = self.essTotals[i]
+        return ret
+
+    IF @enable_mpi@:
+        cdef double computeEssMpi(self) except *:
+            cdef double ess
+
+            if self.mpiLeaderRank == 0:
+                ess = self.computeEssUni()
+            mpi.MPI_Bcast(&ess, 1, mpi.MPI_DOUBLE, 0, mpi.MPI_COMM_WORLD)
+
+            return ess
+
+    cdef double computeEss(self) except *:
+        IF @enable_mpi@:
+            if self.mpiWorldSize == 1:
+                return self.computeEssUni()
+            else:
+                return self.computeEssMpi()
+        ELSE:
+            return self.computeEssUni()
+
     cdef bint writeGraph(self, uint64_t step) except *:
         cdef file gfile
         cdef list cols0, cols1, lnLs0, lnLs1, colors
@@ -1343,6 +1820,48 @@ cdef class Mc3:
 
         return "".join(strs)
 
+    cdef str formatPropWork(self):
+        cdef list strs
+        cdef unsigned i, j
+        cdef Mc3PropWork *w
+
+        strs = []
+        strs.append("< ")
+        for 0 <= i < PropCnt:
+            if i > 0:
+                strs.append(" ")
+            strs.append("[ ")
+            for 0 <= j < self._nruns:
+                if j > 0:
+                    strs.append(" ")
+                if self.props[i] != 0.0:
+                    w = &self.propWorkTotals[i][j]
+                    strs.append("%.3f,%d,%d,%d,%d,%d" % (w.time, w.nlnL, \
+                      w.nsteps, w.npmats, w.nclones, w.nallocs))
+                else:
+                    strs.append("---")
+            strs.append(" ]")
+        strs.append(" >")
+
+        return "".join(strs)
+
+    cdef str formatEss(self):
+        cdef list strs
+        cdef unsigned i
+
+        strs = []
+        strs.append("( ")
+        for 0 <= i < EssCnt:
+            if i > 0:
+                strs.append(" ")
+            if self.essTotals[i] != -1.0:
+                strs.append("%.1f" % self.essTotals[i])
+            else:
+                strs.append("---")
+        strs.append(" )")
+
+        return "".join(strs)
+
     # Write to .l log file.
     cdef void lWrite(self, str s) except *:
         IF @enable_mpi@:
@@ -1408,47 +1927,126 @@ cdef class Mc3:
         self.pFile.flush()
 
     # Write to .s log file.
-    cdef void sWrite(self, uint64_t step, double rcov) \
+    cdef void sWrite(self, uint64_t step, double rcov, double asdsf) \
       except *:
-        cdef str swapStats, propStats, rcovStr
+        cdef str swapStats, propStats, rcovStr, asdsfStr, essStr, stepRateStr
+        cdef str lnLRateStr, propWork
 
         IF @enable_mpi@:
             if self.mpiLeaderRank != 0:
                 return
 
         rcovStr = ("%.6f" % rcov if rcov != -1.0 else "--------")
+        asdsfStr = ("%.6f" % asdsf if asdsf != -1.0 else "--------")
         swapStats = self.formatRateStats(self.swapStats)
         propStats = self.formatPropStats()
-        self.sFile.write("%d\t%s %s %s %s\n" % (step, \
-          self.formatLnLs(step, "%.11e"), rcovStr, swapStats, \
-          propStats))
+        propWork = self.formatPropWork()
+        essStr = self.formatEss()
+        stepRateStr = ("%.2f" % self.stepRate if self.stepRate != -1.0 \
+          else "--------")
+        lnLRateStr = ("%.2f" % self.lnLRate if self.lnLRate != -1.0 \
+          else "--------")
+        self.sFile.write("%d\t%s %s %s %s %s %s %s %s %s\n" % (step, \
+          self.formatLnLs(step, "%.11e"), rcovStr, swapStats, propStats, \
+          asdsfStr, essStr, stepRateStr, lnLRateStr, propWork))
         self.sFile.flush()
         if self.verbose:
-            sys.stdout.write("s\t%d\t%s %s\n" % (step, \
-              self.formatLnLs(step, "%.6f"), rcovStr))
+            sys.stdout.write("s\t%d\t%s %s %s %s %s\n" % (step, \
+              self.formatLnLs(step, "%.6f"), rcovStr, asdsfStr, essStr, \
+              stepRateStr))
+
+    # Incorporate the current samples into the running summary.
+    cdef void summarize(self, uint64_t step) except *:
+        cdef unsigned i
+        cdef uint64_t samp = step / self._stride
+        cdef uint64_t first, stepCvg
+        cdef Lik lik
+
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        for 0 <= i < self._nruns:
+            lik = <Lik>self.liks[i]
+            if self.summ is None:
+                # Samples are incorporated as they are taken, so the burn-in
+                # must be fixed in advance.  By default, discard the first
+                # half of the samples for a run that ends at the earliest step
+                # at which convergence can be claimed (as sample() defines
+                # it), which is how Post would treat such a run.
+                if self._summaryBurnin != ULLONG_MAX:
+                    first = self._summaryBurnin
+                else:
+                    stepCvg = self._minStep
+                    if stepCvg < 2 * self._adaptStep:
+                        stepCvg = 2 * self._adaptStep
+                    if stepCvg > self._maxStep:
+                        stepCvg = self._maxStep
+                    first = (stepCvg / self._stride) / 2 + 1
+                self.summ = Summary(self._nruns, lik.tree.getTaxa(), \
+                  lik.char_.nstates, first)
+            self.summ.observe(i, samp, lik, self.lnLs[i][samp])
+
+    # Write <outPrefix>.summary.
+    cdef void writeSummary(self) except *:
+        IF @enable_mpi@:
+            if self.mpiLeaderRank != 0:
+                return
+
+        if self.summ is not None:
+            if not self.summ.write("%s.summary" % self.outPrefix, \
+              self._stride, self._summaryBurnin, self._cvgAlpha):
+                self.lWrite("Summary not written: no samples follow the" \
+                  " summary burn-in\n")
 
     cdef bint sample(self, uint64_t step) except *:
         cdef bint converged
-        cdef double rcov
+        cdef double rcov, asdsf, ess
         cdef uint64_t samp = step / self._stride
 
         IF @enable_mpi@:
             self.storeSwapStats()
             self.storePropStats()
+            self.storePropWork()
+        self.updatePropWork()
+        self.updateRates(step)
         self.updateDiags(step)
         self.storeLiksLnLs(step)
+        self.updateRcov(step)
+        self.updateAsdsf(step)
+        self.updateEss(step)
 
-        if step < self._minStep or self._nruns == 1 or \
+        # Do not claim convergence until the diagnostics window (the last
+        # half of the samples) excludes the adaptation phase.
+        if step < self._minStep or step < 2 * self._adaptStep or \
           step % (self._stride * self._cvgSampStride) != 0:
             rcov = -1.0
+            asdsf = -1.0
             converged = False
         else:
-            rcov = self.computeRcov(step)
-            converged = (rcov + self._cvgAlpha + self._cvgEpsilon >= 1.0)
+            if self._nruns > 1:
+                rcov = self.computeRcov(step)
+                asdsf = self.computeAsdsf()
+                converged = (rcov + self._cvgAlpha + self._cvgEpsilon >= 1.0)
+                if self._cvgAsdsf > 0.0:
+                    converged = (converged and asdsf != -1.0 and asdsf <= \
+                      self._cvgAsdsf)
+            else:
+                # Rcov and ASDSF require multiple runs, so only the ESS
+                # criterion (if any) applies.
+                rcov = -1.0
+                asdsf = -1.0
+                converged = (self._cvgEss > 0.0)
+            if self._cvgEss > 0.0:
+                ess = self.computeEss()
+                converged = (converged and ess != -1.0 and ess >= \
+                  self._cvgEss)
 
         self.tWrite(step)
         self.pWrite(step)
-        self.sWrite(step, rcov)
+        self.sWrite(step, rcov, asdsf)
+        if self._summary:
+            self.summarize(step)
 
         self.resetLiks()
 
@@ -1669,10 +2267,15 @@ cdef class Mc3:
             self.initSwapInfo()
             self.initSwapStats()
             self.initPropStats()
+            self.initPropWork()
+            self.initLambdas()
             self.initLiks()
             self.initLnLs()
+            self.initRcov()
+            self.initEss()
             self.initProps()
             self.initRuns(liks)
+            self.initAsdsf()
 
             IF @enable_mpi@:
                 if self.mpiLeaderRank == 0:
@@ -1688,6 +2291,8 @@ cdef class Mc3:
             # Run the chains no further than than _maxStep.
             for 1 <= step <= self._maxStep:
                 self.advance()
+                if step == self._adaptStep:
+                    self.writeLambdas(step)
                 if step % self._stride == 0:
                     # sample() will not claim convergence until step is at
                     # least _minStep.
@@ -1708,6 +2313,8 @@ cdef class Mc3:
                     self.writeGraph(step)
             ELSE:
                 self.writeGraph(step)
+
+            self.writeSummary()
         except:
             error = sys.exc_info()
             IF @enable_mpi@:
@@ -1731,6 +2338,47 @@ cdef class Mc3:
               time.strftime("%Y/%m/%d %H:%M:%S (%Z)", \
               time.localtime(time.time())))
 
+    cdef dict getPropWork(self):
+        cdef dict ret
+        cdef list runs
+        cdef unsigned i, j
+        cdef Mc3PropWork *w
+
+        ret = {}
+        for 0 <= i < PropCnt:
+            if self.propWorkTotals[i] == NULL:
+                continue
+            runs = []
+            for 0 <= j < self._nruns:
+                w = &self.propWorkTotals[i][j]
+                runs.append({"time": w.time, "nlnL": w.nlnL, \
+                  "nsteps": w.nsteps, "npmats": w.npmats, \
+                  "nclones": w.nclones, "nallocs": w.nallocs})
+            ret[_propNames[i]] = runs
+        return ret
+    property propWork:
+        """
+            Cumulative work done by each proposal type, as of the most recent
+            sample, summed over all chains of each run.  This is a dict, keyed
+            by proposal name (e.g. "brlen", "mixtureJump"), of lists that
+            contain one dict per run, with the following keys:
+
+              time    : Wall time, in seconds.
+              nlnL    : Lik.lnL() calls.
+              nsteps  : Conditional likelihood execution plan steps.
+              npmats  : P matrices computed.
+              nclones : Lik.clone() calls.
+              nallocs : Conditional likelihood matrix allocations.
+
+            The same totals are appended to each line of the .s file, as
+            "< [ time,nlnL,nsteps,npmats,nclones,nallocs ... ] ... >", with one
+            bracketed group per proposal type and one entry per run.  With
+            MPI, only the master node has totals, and conditional likelihood
+            work is that of the chain leaders' data stripes.
+        """
+        def __get__(self):
+            return self.getPropWork()
+
     cdef double getGraphDelay(self):
         return self._graphDelay
     cdef void setGraphDelay(self, double graphDelay):
@@ -1825,6 +2473,60 @@ cdef class Mc3:
         def __set__(self, double cvgEpsilon):
             self.setCvgEpsilon(cvgEpsilon)
 
+    cdef double getCvgAsdsf(self):
+        return self._cvgAsdsf
+    cdef void setCvgAsdsf(self, double cvgAsdsf) except *:
+        if not cvgAsdsf >= 0.0:
+            raise ValueError("Validation failure: cvgAsdsf >= 0.0")
+        self._cvgAsdsf = cvgAsdsf
+    property cvgAsdsf:
+        """
+            If positive, convergence additionally requires that the average
+            standard deviation of split frequencies (ASDSF) among runs be no
+            greater than cvgAsdsf.  ASDSF is computed over the same samples as
+            Rcov, and is reported in <outPrefix>.s regardless of this setting.
+        """
+        def __get__(self):
+            return self.getCvgAsdsf()
+        def __set__(self, double cvgAsdsf):
+            self.setCvgAsdsf(cvgAsdsf)
+
+    cdef double getAsdsfMinFreq(self):
+        return self._asdsfMinFreq
+    cdef void setAsdsfMinFreq(self, double asdsfMinFreq) except *:
+        if not (0.0 <= asdsfMinFreq and asdsfMinFreq <= 1.0):
+            raise ValueError("Validation failure: 0.0 <= asdsfMinFreq <= 1.0")
+        self._asdsfMinFreq = asdsfMinFreq
+    property asdsfMinFreq:
+        """
+            Splits are only included in ASDSF if their frequency in at least
+            one run is at least asdsfMinFreq.
+        """
+        def __get__(self):
+            return self.getAsdsfMinFreq()
+        def __set__(self, double asdsfMinFreq):
+            self.setAsdsfMinFreq(asdsfMinFreq)
+
+    cdef double getCvgEss(self):
+        return self._cvgEss
+    cdef void setCvgEss(self, double cvgEss) except *:
+        if not cvgEss >= 0.0:
+            raise ValueError("Validation failure: cvgEss >= 0.0")
+        self._cvgEss = cvgEss
+    property cvgEss:
+        """
+            If positive, convergence additionally requires that the total
+            effective sample size (summed over runs, and computed over the same
+            samples as Rcov) be at least cvgEss for lnL and for every other
+            monitored parameter that varies (alpha, pinvar, rmult, nmodels, and
+            tree length).  If there is only one run, this is the sole
+            convergence criterion.
+        """
+        def __get__(self):
+            return self.getCvgEss()
+        def __set__(self, double cvgEss):
+            self.setCvgEss(cvgEss)
+
     cdef uint64_t getMinStep(self):
         return self._minStep
     cdef void setMinStep(self, uint64_t minStep) except *:
@@ -1921,6 +2623,8 @@ cdef class Mc3:
     cdef void setSwapStride(self, unsigned swapStride) except *:
         if not swapStride >= 1:
             raise ValueError("Validation failure: swapStride >= 1")
+        if not self._swapLag < swapStride:
+            raise ValueError("Validation failure: swapLag < swapStride")
         self._swapStride = swapStride
     property swapStride:
         """
@@ -1931,6 +2635,25 @@ cdef class Mc3:
         def __set__(self, unsigned swapStride):
             self.setSwapStride(swapStride)
 
+    cdef unsigned getSwapLag(self):
+        return self._swapLag
+    cdef void setSwapLag(self, unsigned swapLag) except *:
+        if not swapLag < self._swapStride:
+            raise ValueError("Validation failure: swapLag < swapStride")
+        self._swapLag = swapLag
+    property swapLag:
+        """
+            Number of steps between choosing a pair of chains for a heat swap
+            and attempting the swap (default 0).  The swap decision is based on
+            both chains' states at the step where the swap is attempted, so it
+            is a valid Metropolis-coupled swap for any swapLag.  Results do not
+            depend on the number of MPI nodes.
+        """
+        def __get__(self):
+            return self.getSwapLag()
+        def __set__(self, unsigned swapLag):
+            self.setSwapLag(swapLag)
+
     cdef unsigned getNmodels(self):
         return self._nmodels
     cdef void setNmodels(self, unsigned nmodels) except *:
@@ -1990,6 +2713,45 @@ cdef class Mc3:
         def __set__(self, bint invar):
             self.setInvar(invar)
 
+    cdef bint getSummary(self):
+        return self._summary
+    cdef void setSummary(self, bint summary):
+        self._summary = summary
+    property summary:
+        """
+            If true, maintain a running summary of the unheated chains'
+            samples (split frequencies and branch length moments, parameter
+            statistics, and Rcov), and write it to <outPrefix>.summary when
+            sampling ends.  Crux.Mc3.Post.loadSummary() can then compute
+            posterior statistics without re-reading the log files.  Memory
+            usage does not grow with the number of samples, but quantiles
+            are approximate.  Disabled by default.
+        """
+        def __get__(self):
+            return self.getSummary()
+        def __set__(self, bint summary):
+            self.setSummary(summary)
+
+    cdef uint64_t getSummaryBurnin(self):
+        return self._summaryBurnin
+    cdef void setSummaryBurnin(self, uint64_t summaryBurnin):
+        self._summaryBurnin = summaryBurnin
+    property summaryBurnin:
+        """
+            Number of samples (including sample 0) to discard as burn-in when
+            writing the running summary.  Samples are incorporated as they
+            are taken, so the default burn-in cannot follow the final sample
+            count as Crux.Mc3.Post's does.  Instead, it is the first half of
+            the samples up to the earliest step at which convergence can be
+            claimed (max(minStep, 2*adaptStep), but no more than maxStep).
+            This matches Post's default for runs that converge as early as
+            possible, and otherwise retains more samples than Post would.
+        """
+        def __get__(self):
+            return self.getSummaryBurnin()
+        def __set__(self, uint64_t summaryBurnin):
+            self.setSummaryBurnin(summaryBurnin)
+
     cdef double getWeightLambda(self):
         return self._weightLambda
     cdef void setWeightLambda(self, double weightLambda) except *:
@@ -2243,6 +3005,45 @@ cdef class Mc3:
         def __set__(self, double etbrLambda):
             self.setEtbrLambda(etbrLambda)
 
+    cdef uint64_t getAdaptStep(self):
+        return self._adaptStep
+    cdef void setAdaptStep(self, uint64_t adaptStep):
+        self._adaptStep = adaptStep
+    property adaptStep:
+        """
+            Final step of the proposal adaptation phase, or 0 to disable
+            adaptation.  During adaptation, each chain independently adjusts
+            its proposal lambdas (weightLambda, freqLambda, rmultLambda,
+            rateLambda, rateShapeInvLambda, invarLambda, and brlenLambda,
+            which serve as initial values) at every sample, such that
+            acceptance rates approach adaptTarget, within [0.01..20].  eTBR
+            proposals are not adapted.  The lambdas are then fixed for the
+            remainder of the run, and written to the .l file.
+
+            Adaptation invalidates the samples that precede adaptStep, so
+            convergence is not claimed before step 2*adaptStep, and
+            summaryBurnin should be at least adaptStep.
+        """
+        def __get__(self):
+            return self.getAdaptStep()
+        def __set__(self, uint64_t adaptStep):
+            self.setAdaptStep(adaptStep)
+
+    cdef double getAdaptTarget(self):
+        return self._adaptTarget
+    cdef void setAdaptTarget(self, double adaptTarget) except *:
+        if not (0.0 < adaptTarget and adaptTarget < 1.0):
+            raise ValueError("Validation failure: 0.0 < adaptTarget < 1.0")
+        self._adaptTarget = adaptTarget
+    property adaptTarget:
+        """
+            Target proposal acceptance rate for adaptation.
+        """
+        def __get__(self):
+            return self.getAdaptTarget()
+        def __set__(self, double adaptTarget):
+            self.setAdaptTarget(adaptTarget)
+
     cdef double getRateShapeInvPrior(self):
         return self._rateShapeInvPrior
     cdef void setRateShapeInvPrior(self, double rateShapeInvPrior) except *:
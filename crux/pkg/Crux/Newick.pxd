@@ -1,4 +1,7 @@
+from libc cimport *
 from CxNewickLexer cimport *
+from CxNewick cimport *
+from Crux.Taxa cimport Taxon
 cimport Crux.Taxa as Taxa
 from Crux.Tree cimport Tree, Node
 
@@ -22,3 +25,21 @@ cdef class Parser:
     cdef void parseTree(self) except *
 
     cpdef parse(self, input, int line=*)
+
+cdef class Trees:
+    cdef CxtNewickSet _set
+    cdef bint _setAlloced
+    cdef Taxa.Map _taxaMap
+    cdef list _labelTaxa # Label index-->Taxon, or None if not yet computed.
+    cdef list _taxa      # Alphabetized taxa, or None if not yet computed.
+    cdef uint32_t *_bits # Label index-->index into _taxa.
+
+    cdef void _raise(self) except *
+    cdef void parseBuf(self, char *s, size_t slen, unsigned line) except *
+    cpdef parse(self, input, int line=*)
+    cdef uint64_t getNtrees(self)
+    # property ntrees
+    cdef Taxon _labelTaxon(self, uint32_t label)
+    cdef list getTaxa(self)
+    # property taxa
+    cpdef Tree getTree(self, uint64_t i, bint rooted=*)
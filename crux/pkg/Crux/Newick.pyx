@@ -275,3 +275,211 @@ cdef class Parser:
             self.parseTree()
         finally:
             CxNewickLexer_lex_destroy(self.scanner);
+
+cdef class Trees:
+    """
+        Compact set of trees, as parsed by the native bulk Newick parser
+        (see CxNewick.h).  Topologies, branch lengths, and labels are stored
+        in flat arrays, and Tree instances are only created on demand, via
+        getTree().  Crux.Tree.Sumt can summarize a Trees instance directly.
+
+        input
+          Optional file or string to parse, as for parse().
+
+        taxaMap
+          If not None, labels are interpreted as indices into taxaMap.
+    """
+    def __cinit__(self):
+        self._setAlloced = False
+        self._bits = NULL
+
+    def __dealloc__(self):
+        if self._setAlloced:
+            CxNewickSetDelete(&self._set)
+            self._setAlloced = False
+        if self._bits != NULL:
+            free(self._bits)
+            self._bits = NULL
+
+    def __init__(self, input=None, Taxa.Map taxaMap=None):
+        if CxNewickSetNew(&self._set):
+            raise MemoryError("Error allocating tree set")
+        self._setAlloced = True
+        self._taxaMap = taxaMap
+        self._labelTaxa = None
+        self._taxa = None
+
+        if input is not None:
+            self.parse(input)
+
+    def __len__(self):
+        return self._set.ntrees
+
+    cdef void _raise(self) except *:
+        cdef str msg
+
+        if self._set.errMsg == NULL:
+            raise MemoryError("Error parsing trees")
+        msg = self._set.errMsg
+        if msg == "Unexpected token":
+            msg = "%s: %r" % (msg, PyString_FromStringAndSize( \
+              self._set.errTok, self._set.errTokLen))
+        raise SyntaxError(self._set.errLine, msg)
+
+    cdef void parseBuf(self, char *s, size_t slen, unsigned line) except *:
+        # New labels invalidate the taxa.
+        self._labelTaxa = None
+        self._taxa = None
+        if CxNewickSetParse(&self._set, s, slen, line):
+            self._raise()
+
+    cpdef parse(self, input, int line=1):
+        """
+            Parse all Newick trees in input (a file or string), and append
+            them to the set.  Files are memory-mapped rather than read.
+        """
+        cdef str s
+
+        assert type(input) in (file, str)
+
+        if type(input) == file:
+            self._labelTaxa = None
+            self._taxa = None
+            if CxNewickSetParseFd(&self._set, input.fileno(), line):
+                if self._set.errMsg == NULL:
+                    raise IOError("Error reading %r" % input.name)
+                self._raise()
+        else:
+            s = input
+            self.parseBuf(s, len(s), line)
+
+    cdef uint64_t getNtrees(self):
+        return self._set.ntrees
+    property ntrees:
+        """
+            Number of trees in the set.
+        """
+        def __get__(self):
+            return self.getNtrees()
+
+    cdef Taxon _labelTaxon(self, uint32_t label):
+        cdef uint32_t l
+        cdef str s
+
+        if self._labelTaxa is None:
+            self._labelTaxa = []
+            for 0 <= l < self._set.nlabels:
+                s = PyString_FromStringAndSize(self._set.labelStrs[l], \
+                  self._set.labelLens[l])
+                if self._taxaMap is not None:
+                    try:
+                        taxon = self._taxaMap.taxonGet(int(s))
+                    except:
+                        raise ValueError("No Taxa.Map index entry for %r" \
+                          % s)
+                else:
+                    taxon = Taxa.get(s)
+                self._labelTaxa.append(taxon)
+        return <Taxon>self._labelTaxa[label]
+
+    cdef list getTaxa(self):
+        cdef dict taxaX
+        cdef uint32_t l, nlabels
+        cdef Taxon taxon
+
+        if self._taxa is None:
+            nlabels = self._set.nlabels
+            taxaX = {}
+            for 0 <= l < nlabels:
+                taxaX[self._labelTaxon(l)] = None
+            self._taxa = taxaX.keys()
+            self._taxa.sort()
+            for 0 <= l < len(self._taxa):
+                taxaX[self._taxa[l]] = l
+
+            # Translate label indices to taxon indices, for use by
+            # CxNewickSplitsCompute().
+            if self._bits != NULL:
+                free(self._bits)
+            self._bits = <uint32_t *>malloc((nlabels + 1) * sizeof(uint32_t))
+            if self._bits == NULL:
+                self._taxa = None
+                raise MemoryError("Error allocating taxon indices")
+            for 0 <= l < nlabels:
+                self._bits[l] = taxaX[self._labelTaxon(l)]
+        return self._taxa
+    property taxa:
+        """
+            Alphabetized list of all taxa in the set's trees.
+        """
+        def __get__(self):
+            return self.getTaxa()
+
+    cpdef Tree getTree(self, uint64_t i, bint rooted=False):
+        """
+            Create a Tree instance for tree i, which is identical to the result
+            of parsing the tree's Newick string via Tree(input, taxaMap,
+            rooted).
+        """
+        cdef Tree tree
+        cdef Node root, node
+        cdef Edge edge
+        cdef list nodes
+        cdef uint64_t off
+        cdef uint32_t n, j, c
+        cdef int64_t k
+        cdef uint32_t *children, *sibs
+
+        if i >= self._set.ntrees:
+            raise IndexError("Tree index out of range")
+
+        tree = Tree(None, None, True)
+        root = Node(tree)
+        tree.base = root
+
+        off = self._set.offs[i]
+        n = <uint32_t>(self._set.offs[i+1] - off)
+        if n != 0:
+            nodes = [None] * n
+            for 0 <= j < n:
+                node = Node(tree)
+                if self._set.labels[off+j] != CxmNewickNone:
+                    node.taxon = self._labelTaxon(self._set.labels[off+j])
+                nodes[j] = node
+
+            # Thread per-node child lists, in input order.
+            children = <uint32_t *>malloc(2 * n * sizeof(uint32_t))
+            if children == NULL:
+                raise MemoryError("Error allocating child lists")
+            sibs = &children[n]
+            try:
+                for 0 <= j < n:
+                    children[j] = CxmNewickNone
+                for n > j >= 1:
+                    c = self._set.parents[off+j]
+                    sibs[j] = children[c]
+                    children[c] = j
+
+                # Attach edges in the same order as Parser, so that ring order
+                # is identical: each subtree is completed before it is
+                # attached to its parent.  Since nodes are in preorder, this
+                # means attaching children in reverse node order.
+                for n > k >= 0:
+                    node = <Node>nodes[k]
+                    c = children[k]
+                    while c != CxmNewickNone:
+                        edge = Edge(tree)
+                        edge.length = self._set.lengths[off+c]
+                        edge.attach(node, <Node>nodes[c])
+                        node.ring = node.ring.next # Re-order ring.
+                        c = sibs[c]
+            finally:
+                free(children)
+
+            edge = Edge(tree)
+            edge.length = self._set.lengths[off]
+            edge.attach(root, <Node>nodes[0])
+
+        if not rooted:
+            tree.deroot()
+        return tree
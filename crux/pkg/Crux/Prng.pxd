@@ -0,0 +1,10 @@
+from libc cimport *
+from SFMT cimport *
+
+cdef class Prng:
+    cdef sfmt_t *prng
+
+    cpdef Prng dup(self)
+    cpdef double res53(self)
+    cpdef list fillRes53(self, unsigned n)
+    cpdef list fillExp(self, unsigned n)
@@ -0,0 +1,89 @@
+"""
+    Pseudo-random number generation.
+
+    Prng wraps the SIMD-oriented Fast Mersenne Twister (SFMT) generator that
+    Crux uses internally, so that its bulk generation functions can be used
+    (and checked) from Python.
+"""
+
+import random
+
+cdef class Prng:
+    def __cinit__(self):
+        self.prng = NULL
+
+    def __dealloc__(self):
+        if self.prng != NULL:
+            fini_gen_rand(self.prng)
+            self.prng = NULL
+
+    def __init__(self, seed=None):
+        """
+            Seed the generator with seed, or with a value drawn from Python's
+            random module if seed is None.
+        """
+        if seed is None:
+            seed = random.randint(0, 0xffffffffU)
+        self.prng = init_gen_rand(seed)
+        if self.prng == NULL:
+            raise MemoryError("Error initializing prng")
+
+    cpdef Prng dup(self):
+        """
+            Return a generator with exactly the same state.
+        """
+        cdef Prng ret
+        cdef sfmt_t *prng
+
+        prng = dup_gen_rand(self.prng)
+        if prng == NULL:
+            raise MemoryError("Error duplicating prng")
+        ret = Prng(0)
+        fini_gen_rand(ret.prng)
+        ret.prng = prng
+
+        return ret
+
+    cpdef double res53(self):
+        """
+            Return a uniform variate on [0,1) with 53-bit resolution.
+        """
+        return genrand_res53(self.prng)
+
+    cpdef list fillRes53(self, unsigned n):
+        """
+            Return a list of n values, the same as n calls to res53().
+        """
+        cdef list ret
+        cdef double *array
+        cdef unsigned i
+
+        array = <double *>malloc(n * sizeof(double))
+        if array == NULL:
+            raise MemoryError("Error allocating array")
+        fill_res53(self.prng, array, n)
+        ret = []
+        for 0 <= i < n:
+            ret.append(array[i])
+        free(array)
+
+        return ret
+
+    cpdef list fillExp(self, unsigned n):
+        """
+            Return a list of n standard exponential variates.
+        """
+        cdef list ret
+        cdef double *array
+        cdef unsigned i
+
+        array = <double *>malloc(n * sizeof(double))
+        if array == NULL:
+            raise MemoryError("Error allocating array")
+        fill_exp(self.prng, array, n)
+        ret = []
+        for 0 <= i < n:
+            ret.append(array[i])
+        free(array)
+
+        return ret
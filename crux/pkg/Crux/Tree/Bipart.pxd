@@ -1,28 +1,69 @@
 # Forward declarations.
 cdef class Vec
 cdef class Bipart
+cdef class Splits
 
-from Crux.Tree cimport Tree, Edge, Ring
+from libc cimport uint32_t, uint64_t
+from Crux.Tree cimport Tree, Node, Edge, Ring
 
 cdef class Vec:
     cdef readonly Edge edge
     cdef readonly unsigned nBits
-    cdef unsigned nBytes
-    cdef unsigned char *bits
+    cdef unsigned nWords
+    cdef uint64_t *bits
+    cdef uint64_t _hash # Zobrist hash (see CxBipartKey()).
 
     cpdef int cmp(self, Vec other) except *
     cpdef reset(self)
     cpdef bint get(self, unsigned bit) except *
     cdef _set(self, unsigned bit, bint val)
     cpdef set(self, unsigned bit, bint val)
+    cpdef unsigned popcount(self)
+    cdef void _invert(self, uint64_t keysAll)
     cpdef invert(self)
+    cdef void _mergeDisjoint(self, Vec other)
     cpdef merge(self, Vec other)
 
 cdef class Bipart:
     cdef dict taxaX # taxon-->index translation
     cdef readonly list edgeVecs
+    cdef uint64_t _fp[2] # 128-bit topology fingerprint (see CxBipartFpAdd()).
 
     cpdef int cmp(Bipart self, Bipart other)
-    cdef Vec _bipartitionsRecurse(self, Ring ring, bint calcVec)
     cdef void _bipartitions(self, Tree tree) except *
     cpdef double rfDist(self, Bipart other) except -1.0
+
+cdef class Splits:
+    cdef dict taxaX # taxon-->index translation
+    cdef unsigned nBits
+    cdef unsigned nWords
+    cdef uint64_t keysAll # CxBipartKeysAll(nBits).
+
+    # Nodes of the most recently processed tree, in preorder from the base:
+    # node i's parent is parents[i], its taxon's bit index is bits[i] (or
+    # CxmBipartNone), and it is attached to its parent by nodeEdges[i].
+    cdef uint32_t maxNodes
+    cdef uint32_t nnodes
+    cdef uint32_t *parents
+    cdef uint32_t *bits
+    cdef list nodeEdges
+    cdef unsigned _ntaxa
+
+    # Splits of the most recently processed tree.  Split i's bit vector is
+    # words[i*nWords..(i+1)*nWords), its Zobrist hash is hashes[i], and its
+    # edge is edges[i].  Both arrays have room for maxNodes entries, which
+    # CxBipartSubtrees() uses as scratch space.
+    cdef uint64_t *words
+    cdef uint64_t *hashes
+    cdef list edges
+    cdef uint32_t nsplits
+    cdef uint64_t _fp[2]
+
+    cdef uint32_t _addNode(self, Node node, Edge edge, uint32_t parent) \
+      except *
+    cdef void _flatten(self, Ring ring, uint32_t parent) except *
+    cdef void compute(self, Tree tree) except *
+    # Return a string that identifies the topology of the most recently
+    # processed tree: the split vectors, concatenated in sorted byte order.
+    cdef str key(self)
+    cdef Vec getVec(self, uint32_t split)
@@ -2,9 +2,12 @@
     Edge-induced bipartitions.
 """
 from Crux.Tree cimport Tree, Node, Edge, Ring
+cimport Crux.Taxa as Taxa
+from Crux.DistMatrix cimport DistMatrix
 
 from Cx cimport CxCmp2Richcmp
 from libc cimport *
+from CxBipart cimport *
 
 cdef extern from "Python.h":
     cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
@@ -12,6 +15,8 @@ cdef extern from "Python.h":
 cdef class Vec:
     """
         Bit vector, used to represent an edge-induced bipartition of taxa.
+        Bits are packed into 64-bit words, and a Zobrist hash of the set bits
+        is maintained as bits are modified.
     """
     def __cinit__(self):
         self.bits = NULL
@@ -22,17 +27,13 @@ cdef class Vec:
             self.bits = NULL
 
     def __init__(self, Edge edge, unsigned nBits):
-        cdef unsigned nBytes
-
         self.edge = edge
         self.nBits = nBits
+        self.nWords = CxmBipartNWords(nBits)
+        self._hash = 0
 
-        self.nBytes = nBits >> 3
-        if (nBits & 0x7) != 0:
-            self.nBytes += 1
-
-        self.bits = <unsigned char *>calloc(1, self.nBytes)
-        if self.bits == NULL:
+        self.bits = <uint64_t *>calloc(self.nWords, sizeof(uint64_t))
+        if self.bits == NULL and self.nWords != 0:
             raise MemoryError("Error allocating %d-bit vector" % nBits)
 
     def __repr__(self):
@@ -45,78 +46,51 @@ cdef class Vec:
         return "".join(strs)
 
     def __hash__(self):
-        cdef Py_ssize_t len
-        cdef str s
+        cdef long hash
 
-        # Only hash the first VecHashMax bytes.
-        DEF VecHashMax = 16
-        len = (<Py_ssize_t>VecHashMax if \
-          self.nBytes > <Py_ssize_t>VecHashMax else \
-          self.nBytes)
-        s = PyString_FromStringAndSize(<char *>self.bits, len)
-        return hash(s)
+        hash = <long>(self._hash >> 1)
+        if hash == -1:
+            hash = -2
+        return hash
 
     def __richcmp__(Vec self, Vec other, int op):
         cdef int rel
 
         assert self.nBits == other.nBits
 
-        rel = memcmp(self.bits, other.bits, self.nBytes)
-        rel = (rel > 0) - (rel < 0)
+        rel = CxBipartCmp(self.bits, other.bits, self.nWords)
         return CxCmp2Richcmp(rel, op)
 
     cpdef int cmp(self, Vec other) except *:
         """
             Perform ordered comparison of the bit vectors for self and other.
         """
-        cdef int rel
-
         assert self.nBits == other.nBits
 
-        rel = memcmp(self.bits, other.bits, self.nBytes)
-        rel = (rel > 0) - (rel < 0)
-        return rel
+        return CxBipartCmp(self.bits, other.bits, self.nWords)
 
     cpdef reset(self):
         """
             Clear all bits.
         """
-        memset(self.bits, 0, self.nBytes)
+        memset(self.bits, 0, self.nWords * sizeof(uint64_t))
+        self._hash = 0
 
     cpdef bint get(self, unsigned bit) except *:
         """
             Get a bit.
         """
-        cdef bint ret
-        cdef unsigned byteOffset, bitOffset
-        cdef unsigned char byte
-
         assert bit < self.nBits
 
-        byteOffset = bit >> 3
-        bitOffset = 7 - (bit & 0x7)
-
-        byte = self.bits[byteOffset]
-        byte >>= bitOffset
-        byte &= 0x1
-        ret = <bint>byte
-
-        return ret
+        return (self.bits[bit >> 6] & CxBipartMask(bit)) != 0
 
     cdef _set(self, unsigned bit, bint val):
-        cdef unsigned byteOffset, bitOffset
-        cdef unsigned char byte, mask
-
-        byteOffset = bit >> 3
-        bitOffset = 7 - (bit & 0x7)
+        cdef uint64_t mask
 
-        byte = self.bits[byteOffset]
-
-        mask = (0xff ^ (0x1 << bitOffset))
-        byte &= mask
-        byte |= (val << bitOffset)
-
-        self.bits[byteOffset] = byte
+        mask = CxBipartMask(bit)
+        if ((self.bits[bit >> 6] & mask) != 0) != val:
+            self.bits[bit >> 6] ^= mask
+            self._hash ^= CxBipartKey(bit)
 
     cpdef set(self, unsigned bit, bint val):
         """
@@ -125,30 +99,40 @@ cdef class Vec:
         assert bit < self.nBits
         self._set(bit, val)
 
+    cpdef unsigned popcount(self):
+        """
+            Count the number of set bits.
+        """
+        return CxBipartPopcount(self.bits, self.nWords)
+
+    cdef void _invert(self, uint64_t keysAll):
+        # keysAll is CxBipartKeysAll(self.nBits), which callers that invert
+        # many vectors can compute only once.
+        CxBipartInvert(self.bits, self.nBits)
+        self._hash ^= keysAll
+
     cpdef invert(self):
         """
             Translate {0,1} to {1,0} for all bits.
         """
-        cdef unsigned i, nBytes
+        self._invert(CxBipartKeysAll(self.nBits))
 
-        for 0 <= i < self.nBytes:
-            self.bits[i] = (~self.bits[i])
+    cdef void _mergeDisjoint(self, Vec other):
+        cdef unsigned i
 
-        # Clear trailing bits in order to allow memcmp() to be used for
-        # comparison.
-        for self.nBits <= i < (self.nBytes << 3):
-            self._set(i, False)
+        # The bits set in self and other are known to be disjoint, so the
+        # hash of the union is the XOR of the hashes.
+        for 0 <= i < self.nWords:
+            self.bits[i] |= other.bits[i]
+        self._hash ^= other._hash
 
     cpdef merge(self, Vec other):
         """
             Perform bitwise union of self and other.
         """
-        cdef unsigned i, nBytes
-
         assert self.nBits == other.nBits
 
-        for 0 <= i < self.nBytes:
-            self.bits[i] |= other.bits[i]
+        self._hash ^= CxBipartMerge(self.bits, other.bits, self.nWords)
 
 cdef class Bipart:
     """
@@ -180,24 +164,35 @@ cdef class Bipart:
         return "\n".join(strs)
 
     def __hash__(self):
-        cdef unsigned i, lim, hash
+        cdef long hash
 
-        # Only hash the first BipartHashMax vectors.
-        DEF BipartHashMax = 16
-        lim = (BipartHashMax if len(self.edgeVecs) > BipartHashMax \
-          else len(self.edgeVecs))
-        hash = 0
-        for 0 <= i < lim:
-            hash = (hash + (<Vec>self.edgeVecs[i]).__hash__()) & 0x7fffffff
-        return <int>hash
+        hash = <long>(self._fp[0] >> 1)
+        if hash == -1:
+            hash = -2
+        return hash
 
     def __richcmp__(Bipart self, Bipart other, int op):
         cdef int rel
 
+        # Differing fingerprints imply differing topologies, which suffices
+        # for equality tests.
+        if (op == 2 or op == 3) and (self._fp[0] != other._fp[0] \
+          or self._fp[1] != other._fp[1]):
+            return (op == 3)
+
         rel = cmp(self.edgeVecs, other.edgeVecs)
         rel = (rel > 0) - (rel < 0)
         return CxCmp2Richcmp(rel, op)
 
+    property fingerprint:
+        """
+            128-bit topology fingerprint, which is independent of the order
+            of edgeVecs.  Identical topologies (on the same taxa) always have
+            identical fingerprints, and distinct topologies almost never do.
+        """
+        def __get__(self):
+            return (<object>self._fp[1] << 64) | self._fp[0]
+
     cpdef int cmp(Bipart self, Bipart other):
         """
             Perform ordered comparison of Vec's in self and other.
@@ -208,63 +203,18 @@ cdef class Bipart:
         rel = (rel > 0) - (rel < 0)
         return rel
 
-    cdef Vec _bipartitionsRecurse(self, Ring ring, bint calcVec):
-        cdef Vec ret, vec
-        cdef Node node
-
-        node = ring.node
-        if node.getDegree() <= 1:
-            # Leaf node.
-
-            ret = Vec(ring.edge, len(self.taxaX))
-            self.edgeVecs.append(ret)
-
-            # Mark this taxon as being in the set.
-            assert node._taxon is not None
-            ret.set(self.taxaX[node._taxon], True)
-        else:
-            if calcVec:
-                # Create a vector for this edge.
-                ret = Vec(ring.edge, len(self.taxaX))
-                self.edgeVecs.append(ret)
-
-                # Even internal nodes may have associated taxa.
-                if node._taxon is not None:
-                    ret.set(self.taxaX[node._taxon], True)
-            else:
-                # Avoid creating a vector, because the previous node is the
-                # tree base, and it's a leaf node.
-                ret = None
-
-            # Recurse.
-            for r in ring.siblings():
-                vec = self._bipartitionsRecurse(r.other, True)
-                if calcVec:
-                    ret.merge(vec)
-
-        return ret
-
     cdef void _bipartitions(self, Tree tree) except *:
-        cdef Node base
-        cdef Ring ring, r
-        cdef int baseDegree
-        cdef unsigned i
-        cdef Vec vec
-
-        base = tree.getBase()
-        if base is not None:
-            baseDegree = base.getDegree()
-            ring = base.ring
-            if ring is not None:
-                for r in ring:
-                    self._bipartitionsRecurse(r.other, (baseDegree != 1))
-
-        # Iterate through the bipartitions and make sure that bit 0 is never
-        # set.
-        for 0 <= i < len(self.edgeVecs):
-            vec = <Vec>self.edgeVecs[i]
-            if vec.get(0):
-                vec.invert()
+        cdef Splits splits
+        cdef uint32_t i
+
+        # Splits computes the bipartitions with bit 0 always clear, and
+        # accumulates the topology fingerprint.
+        splits = Splits(tree.getTaxa())
+        splits.compute(tree)
+        for 0 <= i < splits.nsplits:
+            self.edgeVecs.append(splits.getVec(i))
+        self._fp[0] = splits._fp[0]
+        self._fp[1] = splits._fp[1]
 
         # Sort the list of bipartitions, so that lists can be linearly scanned
         # for differences.
@@ -330,3 +280,262 @@ cdef class Bipart:
             falsePositiveRate = 0.0
 
         return (falseNegativeRate + falsePositiveRate) / 2.0
+
+cdef class Splits:
+    """
+        Splits of a tree, with bit 0 always clear, computed into flat arrays
+        that are reused from one tree to the next, rather than as Vec
+        instances, and in preorder rather than sorted.  Bipart is built on
+        Splits, and fingerprint matches Bipart.fingerprint.  All trees must
+        contain the taxa in taxa, which is alphabetized as Tree.getTaxa()
+        returns it.
+    """
+    def __cinit__(self):
+        self.parents = NULL
+        self.bits = NULL
+        self.words = NULL
+        self.hashes = NULL
+
+    def __dealloc__(self):
+        if self.parents != NULL:
+            free(self.parents)
+            self.parents = NULL
+        if self.bits != NULL:
+            free(self.bits)
+            self.bits = NULL
+        if self.words != NULL:
+            free(self.words)
+            self.words = NULL
+        if self.hashes != NULL:
+            free(self.hashes)
+            self.hashes = NULL
+
+    def __init__(self, list taxa):
+        cdef unsigned i
+
+        self.taxaX = {}
+        for 0 <= i < len(taxa):
+            self.taxaX[taxa[i]] = i
+        self.nBits = len(taxa)
+        self.nWords = CxmBipartNWords(self.nBits)
+        self.keysAll = CxBipartKeysAll(self.nBits)
+        self.maxNodes = 0
+        self.nnodes = 0
+        self.nodeEdges = []
+        self.nsplits = 0
+        self.edges = []
+
+    property fingerprint:
+        """
+            128-bit topology fingerprint of the most recently processed tree.
+        """
+        def __get__(self):
+            return (<object>self._fp[1] << 64) | self._fp[0]
+
+    # Append node, which is attached to its parent by edge, and return its
+    # index.
+    cdef uint32_t _addNode(self, Node node, Edge edge, uint32_t parent) \
+      except *:
+        cdef uint32_t ret, maxNodes
+        cdef uint32_t *parents, *bits
+        cdef uint64_t *words, *hashes
+
+        if self.nnodes == self.maxNodes:
+            maxNodes = (self.maxNodes * 2 if self.maxNodes != 0 else 64)
+            parents = <uint32_t *>realloc(self.parents, \
+              maxNodes * sizeof(uint32_t))
+            if parents == NULL:
+                raise MemoryError("Error allocating split nodes")
+            self.parents = parents
+            bits = <uint32_t *>realloc(self.bits, \
+              maxNodes * sizeof(uint32_t))
+            if bits == NULL:
+                raise MemoryError("Error allocating split nodes")
+            self.bits = bits
+            words = <uint64_t *>realloc(self.words, \
+              maxNodes * self.nWords * sizeof(uint64_t))
+            if words == NULL and self.nWords != 0:
+                raise MemoryError("Error allocating split vectors")
+            self.words = words
+            hashes = <uint64_t *>realloc(self.hashes, \
+              maxNodes * sizeof(uint64_t))
+            if hashes == NULL:
+                raise MemoryError("Error allocating split hashes")
+            self.hashes = hashes
+            self.maxNodes = maxNodes
+
+        ret = self.nnodes
+        self.nnodes += 1
+        self.parents[ret] = parent
+        if node._taxon is None:
+            self.bits[ret] = CxmBipartNone
+        else:
+            try:
+                self.bits[ret] = self.taxaX[node._taxon]
+            except KeyError:
+                raise ValueError("Trees must contain identical taxa")
+            self._ntaxa += 1
+        self.nodeEdges.append(edge)
+        return ret
+
+    # Number the nodes in ring's subtree in preorder.
+    cdef void _flatten(self, Ring ring, uint32_t parent) except *:
+        cdef Node node
+        cdef Ring r
+        cdef uint32_t ind
+
+        node = ring.node
+        if node.getDegree() <= 1:
+            # Leaf node.
+            assert node._taxon is not None
+        ind = self._addNode(node, ring.edge, parent)
+        for r in ring.siblings():
+            self._flatten(r.other, ind)
+
+    cdef void compute(self, Tree tree) except *:
+        cdef Node base
+        cdef Ring ring, r
+        cdef uint32_t i, skip
+        cdef uint64_t *words
+
+        self.nnodes = 0
+        self.nodeEdges = []
+        self.nsplits = 0
+        self.edges = []
+        self._fp[0] = self._fp[1] = 0
+        self._ntaxa = 0
+
+        # Node 0 is the base, which has no incoming edge, so it never has a
+        # split.  If the base is a leaf, and its neighbor is internal, both
+        # edges of the neighbor's split would be the same edge, so it is
+        # omitted as well.
+        skip = 0
+        base = tree.getBase()
+        if base is not None:
+            self._addNode(base, None, 0)
+            ring = base.ring
+            if ring is not None:
+                for r in ring:
+                    self._flatten(r.other, 0)
+                if base.getDegree() == 1 and ring.other.node.getDegree() > 1:
+                    skip = 1
+        if self._ntaxa != self.nBits:
+            raise ValueError("Trees must contain identical taxa")
+        if self.nnodes == 0:
+            return
+
+        CxBipartSubtrees(self.nnodes, self.parents, self.bits, self.nWords, \
+          self.words, self.hashes)
+
+        # Normalize, and compact the splits into the low end of words/hashes,
+        # which is safe because split k always comes from node i > k.
+        for 1 <= i < self.nnodes:
+            if i == skip:
+                continue
+            words = &self.words[i * self.nWords]
+            CxBipartNormalize(words, &self.hashes[i], self.nBits, \
+              self.keysAll)
+            memcpy(&self.words[self.nsplits * self.nWords], words, \
+              self.nWords * sizeof(uint64_t))
+            self.hashes[self.nsplits] = self.hashes[i]
+            self.edges.append(self.nodeEdges[i])
+            CxBipartFpAdd(self._fp, self.hashes[i])
+            self.nsplits += 1
+
+    cdef str key(self):
+        cdef list strs
+        cdef uint32_t i
+
+        strs = [PyString_FromStringAndSize( \
+          <char *>&self.words[i * self.nWords], \
+          self.nWords * sizeof(uint64_t)) for i in xrange(self.nsplits)]
+        strs.sort()
+        return "".join(strs)
+
+    cdef Vec getVec(self, uint32_t split):
+        cdef Vec ret
+
+        assert split < self.nsplits
+
+        ret = Vec(<Edge>self.edges[split], self.nBits)
+        memcpy(ret.bits, &self.words[split * self.nWords], \
+          self.nWords * sizeof(uint64_t))
+        ret._hash = self.hashes[split]
+        return ret
+
+cpdef DistMatrix rfMatrix(list trees):
+    """
+        Compute the Robinson-Foulds distances (as for Bipart.rfDist()) among
+        all pairs of trees, which must all contain identical taxa.  Return a
+        DistMatrix with one row per tree; its rows are labeled with the tree
+        indices "0", "1", etc.
+
+        Rather than comparing each pair of trees, every split of every tree is
+        hashed once into a shared table, and shared split counts are
+        accumulated for all pairs of trees that contain each split, as
+        described in:
+
+          Sul, S.-J., T.L. Williams.  2008.  An Experimental Analysis of
+          Robinson-Foulds Distance Matrix Algorithms.  Lecture Notes in
+          Computer Science 5193:793-804.
+    """
+    cdef DistMatrix ret
+    cdef unsigned ntrees, ntaxa, i, j
+    cdef list taxa, biparts
+    cdef Tree tree
+    cdef Bipart bipart
+    cdef Vec vec
+    cdef uint64_t nsplits, k
+    cdef uint64_t *hashes, *treeOffs
+    cdef uint64_t **words
+
+    ntrees = len(trees)
+    if ntrees < 2:
+        raise ValueError("At least two trees required")
+
+    taxa = (<Tree>trees[0]).getTaxa()
+    ntaxa = len(taxa)
+    biparts = []
+    nsplits = 0
+    for 0 <= i < ntrees:
+        tree = <Tree>trees[i]
+        if tree.getTaxa() != taxa:
+            raise ValueError("Trees must contain identical taxa")
+        bipart = tree.getBipart()
+        biparts.append(bipart)
+        nsplits += len(bipart.edgeVecs)
+
+    ret = DistMatrix(Taxa.Map([Taxa.get("%d" % i) for i in xrange(ntrees)]))
+
+    hashes = <uint64_t *>malloc(nsplits * sizeof(uint64_t))
+    words = <uint64_t **>malloc(nsplits * sizeof(uint64_t *))
+    treeOffs = <uint64_t *>malloc((ntrees + 1) * sizeof(uint64_t))
+    try:
+        if (hashes == NULL or words == NULL) and nsplits != 0:
+            raise MemoryError("Error allocating split vectors")
+        if treeOffs == NULL:
+            raise MemoryError("Error allocating tree offsets")
+
+        k = 0
+        for 0 <= i < ntrees:
+            treeOffs[i] = k
+            bipart = <Bipart>biparts[i]
+            for 0 <= j < len(bipart.edgeVecs):
+                vec = <Vec>bipart.edgeVecs[j]
+                hashes[k] = vec._hash
+                words[k] = vec.bits
+                k += 1
+        treeOffs[ntrees] = k
+
+        if CxBipartRfMatrix(ntrees, ntaxa, CxmBipartNWords(ntaxa), hashes, \
+          words, treeOffs, ret.dists):
+            raise MemoryError("Error allocating RF matrix temporaries")
+    finally:
+        if hashes != NULL:
+            free(hashes)
+        if words != NULL:
+            free(words)
+        if treeOffs != NULL:
+            free(treeOffs)
+
+    return ret
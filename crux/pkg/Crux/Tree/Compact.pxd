@@ -0,0 +1,47 @@
+from libc cimport *
+from CxTree cimport *
+from Crux.Taxa cimport Taxon
+from Crux.Tree cimport Tree, Ring
+
+cdef class Compact:
+    cdef CxtTree _tree
+    cdef bint _treeAlloced
+    cdef list _taxa # Taxon index-->Taxon.
+    cdef public bint rooted
+
+    cdef void _alloc(self, uint32_t maxNodes, uint32_t maxEdges) except *
+    cdef uint32_t _ringInd(self, dict edgeX, Ring ring) except *
+    cdef void _fromTree(self, Tree tree) except *
+    cpdef Tree getTree(self)
+    cpdef Compact dup(self)
+    cpdef assign(self, Compact other)
+
+    cdef uint64_t getSn(self)
+    # property sn
+    cdef uint32_t getNnodes(self)
+    # property nnodes
+    cdef uint32_t getNedges(self)
+    # property nedges
+    cdef uint32_t getNtaxa(self)
+    # property ntaxa
+    cdef int64_t getBase(self)
+    cdef void setBase(self, uint32_t base) except *
+    # property base
+    cdef list getPreorder(self)
+    # property preorder
+
+    cdef void _checkNode(self, uint32_t node) except *
+    cdef void _checkEdge(self, uint32_t edge) except *
+    cdef void _checkRing(self, uint32_t ring) except *
+    cpdef Taxon taxonGet(self, uint32_t node)
+    cpdef uint32_t degreeGet(self, uint32_t node) except *
+    cpdef double lengthGet(self, uint32_t edge) except *
+    cpdef lengthSet(self, uint32_t edge, double length)
+    cpdef int64_t nodeRing(self, uint32_t node) except -2
+    cpdef int64_t ringNode(self, uint32_t ring) except -2
+    cpdef uint32_t ringNext(self, uint32_t ring) except *
+    cpdef uint32_t ringPrev(self, uint32_t ring) except *
+
+    cpdef nni(self, uint32_t edge, uint32_t ringA, uint32_t ringB)
+    cpdef bint spr(self, uint32_t ring, uint32_t edge) except *
+    cpdef bint tbr(self, uint32_t edge, edgeX=*, edgeY=*) except *
@@ -0,0 +1,403 @@
+"""
+    Array-backed trees.
+
+    Compact stores the same node/edge/ring structure as Tree, but in
+    contiguous index-linked vectors (see CxTree.h), so that traversal and
+    topology rearrangement (NNI, SPR, and TBR) operate in place, without
+    creating or reference counting any Python objects.  Nodes, edges, and
+    rings are identified by integer indices: edge e owns rings 2*e and 2*e+1,
+    where ring 2*e corresponds to Edge.ring.
+"""
+
+from Crux.Taxa cimport Taxon
+from Crux.Tree cimport Tree, Node, Edge, Ring
+
+cdef class Compact:
+    """
+        Array-backed copy of tree (or an empty tree if tree is None).  Node
+        and edge indices follow the order of tree.nodes and tree.edges, so
+        node 0 is the base.
+    """
+    def __cinit__(self):
+        self._treeAlloced = False
+
+    def __dealloc__(self):
+        if self._treeAlloced:
+            CxTreeDelete(&self._tree)
+            self._treeAlloced = False
+
+    def __init__(self, Tree tree=None):
+        self._taxa = []
+        if tree is not None:
+            self.rooted = tree.rooted
+            self._fromTree(tree)
+        else:
+            self.rooted = True
+            self._alloc(0, 0)
+
+    cdef void _alloc(self, uint32_t maxNodes, uint32_t maxEdges) except *:
+        if self._treeAlloced:
+            CxTreeDelete(&self._tree)
+            self._treeAlloced = False
+        if CxTreeNew(&self._tree, maxNodes, maxEdges):
+            raise MemoryError("Error allocating compact tree")
+        self._treeAlloced = True
+
+    cdef uint32_t _ringInd(self, dict edgeX, Ring ring) except *:
+        cdef uint32_t e
+
+        e = edgeX[ring.edge]
+        if ring is ring.edge.ring:
+            return e << 1
+        else:
+            return (e << 1) | 1
+
+    cdef void _fromTree(self, Tree tree) except *:
+        cdef list nodes, edges
+        cdef dict nodeX, edgeX
+        cdef Node node
+        cdef Edge edge
+        cdef Ring ring, r
+        cdef uint32_t i, n, e, ri
+
+        nodes = tree.getNodes()
+        edges = tree.getEdges()
+        self._alloc(len(nodes), len(edges))
+
+        nodeX = {}
+        for 0 <= i < len(nodes):
+            node = <Node>nodes[i]
+            n = CxTreeNodeNew(&self._tree)
+            nodeX[node] = n
+            if node._taxon is not None:
+                self._tree.nodeTaxa[n] = len(self._taxa)
+                self._taxa.append(node._taxon)
+
+        edgeX = {}
+        for 0 <= i < len(edges):
+            edge = <Edge>edges[i]
+            e = CxTreeEdgeNew(&self._tree)
+            edgeX[edge] = e
+            self._tree.lengths[e] = edge.length
+
+        # Copy ring lists directly, rather than re-attaching edges, so that
+        # ring order is preserved.
+        for 0 <= i < len(nodes):
+            node = <Node>nodes[i]
+            ring = node.ring
+            if ring is None:
+                continue
+            self._tree.nodeRings[i] = self._ringInd(edgeX, ring)
+            for r in ring:
+                ri = self._ringInd(edgeX, r)
+                self._tree.ringNodes[ri] = i
+                self._tree.ringNext[ri] = self._ringInd(edgeX, r.next)
+                self._tree.ringPrev[ri] = self._ringInd(edgeX, r.prev)
+
+        if len(nodes) != 0:
+            self._tree.base = 0
+        self._tree.sn += 1
+
+    cpdef Tree getTree(self):
+        """
+            Create a Tree instance with the same topology, ring order, branch
+            lengths, and taxa.
+        """
+        cdef Tree tree
+        cdef list nodes, edges
+        cdef Node node
+        cdef Edge edge
+        cdef Ring ring
+        cdef uint32_t i, r, n
+
+        tree = Tree(None, None, self.rooted)
+
+        nodes = [None] * self._tree.nnodes
+        for 0 <= i < self._tree.nnodes:
+            node = Node(tree)
+            if self._tree.nodeTaxa[i] != CxmTreeNone:
+                node._taxon = <Taxon>self._taxa[self._tree.nodeTaxa[i]]
+            nodes[i] = node
+
+        edges = [None] * self._tree.nedges
+        for 0 <= i < self._tree.nedges:
+            edge = Edge(tree)
+            edge.length = self._tree.lengths[i]
+            edges[i] = edge
+
+        for 0 <= r < (self._tree.nedges << 1):
+            n = self._tree.ringNodes[r]
+            if n == CxmTreeNone:
+                continue
+            ring = (<Edge>edges[r >> 1]).ring
+            if r & 1:
+                ring = ring.other
+            ring.node = <Node>nodes[n]
+            i = self._tree.ringNext[r]
+            ring.next = (<Edge>edges[i >> 1]).ring
+            if i & 1:
+                ring.next = ring.next.other
+            i = self._tree.ringPrev[r]
+            ring.prev = (<Edge>edges[i >> 1]).ring
+            if i & 1:
+                ring.prev = ring.prev.other
+
+        for 0 <= i < self._tree.nnodes:
+            r = self._tree.nodeRings[i]
+            if r != CxmTreeNone:
+                node = <Node>nodes[i]
+                node.ring = (<Edge>edges[r >> 1]).ring
+                if r & 1:
+                    node.ring = node.ring.other
+
+        if self._tree.base != CxmTreeNone:
+            tree.setBase(<Node>nodes[self._tree.base])
+        return tree
+
+    cpdef Compact dup(self):
+        """
+            Create a copy of the tree.
+        """
+        cdef Compact ret
+
+        ret = Compact()
+        ret._alloc(self._tree.nnodes, self._tree.nedges)
+        CxTreeCopy(&ret._tree, &self._tree)
+        ret._taxa = self._taxa
+        ret.rooted = self.rooted
+        return ret
+
+    cpdef assign(self, Compact other):
+        """
+            Make the tree an exact copy of other, which must have no more
+            nodes and edges than the tree was created with.  No memory is
+            allocated, so this is an inexpensive way to restore a snapshot
+            (see dup()) after a rejected rearrangement.
+        """
+        if other._tree.nnodes > self._tree.maxNodes \
+          or other._tree.nedges > self._tree.maxEdges:
+            raise ValueError("Insufficient capacity")
+        CxTreeCopy(&self._tree, &other._tree)
+        self._taxa = other._taxa
+        self.rooted = other.rooted
+
+    cdef uint64_t getSn(self):
+        return self._tree.sn
+    property sn:
+        """
+            Sequence number, which is incremented every time the tree is
+            modified.
+        """
+        def __get__(self):
+            return self.getSn()
+
+    cdef uint32_t getNnodes(self):
+        return self._tree.nnodes
+    property nnodes:
+        """
+            The number of nodes in the tree.
+        """
+        def __get__(self):
+            return self.getNnodes()
+
+    cdef uint32_t getNedges(self):
+        return self._tree.nedges
+    property nedges:
+        """
+            The number of edges in the tree.
+        """
+        def __get__(self):
+            return self.getNedges()
+
+    cdef uint32_t getNtaxa(self):
+        CxTreeRecache(&self._tree)
+        return self._tree.ntaxa
+    property ntaxa:
+        """
+            The number of taxa that are reachable from the base.
+        """
+        def __get__(self):
+            return self.getNtaxa()
+
+    cdef int64_t getBase(self):
+        if self._tree.base == CxmTreeNone:
+            return -1
+        return self._tree.base
+    cdef void setBase(self, uint32_t base) except *:
+        self._checkNode(base)
+        self._tree.base = base
+        self._tree.sn += 1
+    property base:
+        """
+            The base node index (or -1).
+        """
+        def __get__(self):
+            return self.getBase()
+        def __set__(self, uint32_t base):
+            self.setBase(base)
+
+    cdef list getPreorder(self):
+        cdef list ret
+        cdef uint32_t i
+
+        CxTreeRecache(&self._tree)
+        ret = [None] * self._tree.norder
+        for 0 <= i < self._tree.norder:
+            ret[i] = self._tree.order[i]
+        return ret
+    property preorder:
+        """
+            A list of the rings that lead away from the base, in preorder
+            (children in ring order).  Each edge that is reachable from the
+            base is represented by its ring at the end that is farther from the
+            base, so the reverse of the list is a postorder.
+        """
+        def __get__(self):
+            return self.getPreorder()
+
+    cdef void _checkNode(self, uint32_t node) except *:
+        if node >= self._tree.nnodes:
+            raise IndexError("Node index out of range")
+
+    cdef void _checkEdge(self, uint32_t edge) except *:
+        if edge >= self._tree.nedges:
+            raise IndexError("Edge index out of range")
+
+    cdef void _checkRing(self, uint32_t ring) except *:
+        if ring >= (self._tree.nedges << 1):
+            raise IndexError("Ring index out of range")
+
+    cpdef Taxon taxonGet(self, uint32_t node):
+        """
+            Get the taxon associated with node (or None).
+        """
+        self._checkNode(node)
+        if self._tree.nodeTaxa[node] == CxmTreeNone:
+            return None
+        return <Taxon>self._taxa[self._tree.nodeTaxa[node]]
+
+    cpdef uint32_t degreeGet(self, uint32_t node) except *:
+        """
+            Get the number of edges attached to node.
+        """
+        self._checkNode(node)
+        return CxTreeDegree(&self._tree, node)
+
+    cpdef double lengthGet(self, uint32_t edge) except *:
+        """
+            Get the branch length of edge.
+        """
+        self._checkEdge(edge)
+        return self._tree.lengths[edge]
+
+    cpdef lengthSet(self, uint32_t edge, double length):
+        """
+            Set the branch length of edge.
+        """
+        self._checkEdge(edge)
+        self._tree.lengths[edge] = length
+        self._tree.sn += 1
+
+    cpdef int64_t nodeRing(self, uint32_t node) except -2:
+        """
+            Get the header of node's ring list (or -1).
+        """
+        self._checkNode(node)
+        if self._tree.nodeRings[node] == CxmTreeNone:
+            return -1
+        return self._tree.nodeRings[node]
+
+    cpdef int64_t ringNode(self, uint32_t ring) except -2:
+        """
+            Get the node that ring is attached to (or -1).
+        """
+        self._checkRing(ring)
+        if self._tree.ringNodes[ring] == CxmTreeNone:
+            return -1
+        return self._tree.ringNodes[ring]
+
+    cpdef uint32_t ringNext(self, uint32_t ring) except *:
+        """
+            Get the next ring in ring's list.
+        """
+        self._checkRing(ring)
+        return self._tree.ringNext[ring]
+
+    cpdef uint32_t ringPrev(self, uint32_t ring) except *:
+        """
+            Get the previous ring in ring's list.
+        """
+        self._checkRing(ring)
+        return self._tree.ringPrev[ring]
+
+    cpdef nni(self, uint32_t edge, uint32_t ringA, uint32_t ringB):
+        """
+            Swap the subtrees that are reached via ringA and ringB, which must
+            be attached to different ends of internal edge edge.  The
+            operation is its own inverse.
+        """
+        cdef uint32_t nodeA, nodeB
+
+        self._checkEdge(edge)
+        self._checkRing(ringA)
+        self._checkRing(ringB)
+        nodeA = self._tree.ringNodes[edge << 1]
+        nodeB = self._tree.ringNodes[(edge << 1) | 1]
+        if nodeA == CxmTreeNone or ringA >> 1 == edge or ringB >> 1 == edge:
+            raise ValueError("Invalid NNI")
+        if not ((self._tree.ringNodes[ringA] == nodeA \
+          and self._tree.ringNodes[ringB] == nodeB) \
+          or (self._tree.ringNodes[ringA] == nodeB \
+          and self._tree.ringNodes[ringB] == nodeA)):
+            raise ValueError("Invalid NNI")
+        CxTreeNni(&self._tree, edge, ringA, ringB)
+
+    cpdef bint spr(self, uint32_t ring, uint32_t edge) except *:
+        """
+            Prune the subtree that is reached via ring, along with ring's
+            node (which must have degree 3), and regraft by inserting ring's
+            node into edge, which must not be part of the pruned subtree.  The
+            node's two other edges are replaced by one of them, which is
+            reused to connect the regrafted node.  Branch lengths are not
+            modified.  Return True if the operation was a no-op (edge is
+            attached to ring's node).
+        """
+        self._checkRing(ring)
+        self._checkEdge(edge)
+        if self._tree.ringNodes[ring] == CxmTreeNone \
+          or self._tree.ringNodes[edge << 1] == CxmTreeNone \
+          or CxTreeDegree(&self._tree, self._tree.ringNodes[ring]) != 3 \
+          or CxTreeInSubtree(&self._tree, ring, edge):
+            raise ValueError("Invalid SPR")
+        return CxTreeSpr(&self._tree, ring, edge)
+
+    cpdef bint tbr(self, uint32_t edge, edgeX=None, edgeY=None) except *:
+        """
+            Bisect the tree at edge, and reconnect the subtrees by inserting
+            the ends of edge into edgeX (on the side of ring 2*edge) and edgeY
+            (on the side of ring 2*edge+1).  Either of edgeX and edgeY may be
+            None, in order to leave that side as is.  Return True if the
+            operation was a no-op.
+        """
+        cdef uint32_t eX, eY
+
+        self._checkEdge(edge)
+        if self._tree.ringNodes[edge << 1] == CxmTreeNone:
+            raise ValueError("Invalid TBR")
+        eX = eY = CxmTreeNone
+        if edgeX is not None:
+            eX = edgeX
+            self._checkEdge(eX)
+            if self._tree.ringNodes[eX << 1] == CxmTreeNone \
+              or CxTreeDegree(&self._tree, self._tree.ringNodes[edge << 1]) \
+              != 3 or CxTreeInSubtree(&self._tree, edge << 1, eX):
+                raise ValueError("Invalid TBR")
+        if edgeY is not None:
+            eY = edgeY
+            self._checkEdge(eY)
+            if self._tree.ringNodes[eY << 1] == CxmTreeNone \
+              or CxTreeDegree(&self._tree, \
+              self._tree.ringNodes[(edge << 1) | 1]) != 3 \
+              or CxTreeInSubtree(&self._tree, (edge << 1) | 1, eY):
+                raise ValueError("Invalid TBR")
+        return CxTreeTbr(&self._tree, edge, eX, eY)
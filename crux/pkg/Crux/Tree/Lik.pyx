@@ -8,13 +8,17 @@ import Crux.Config as Config
 from Crux.Character cimport Character
 from Crux.Taxa cimport Taxon
 from Crux.Tree cimport Tree, Node, Edge, Ring
+from Crux.Tree.Compact cimport Compact
 from Crux.CTMatrix cimport Alignment
 
 from Cx cimport CxNcpus
 from libc cimport *
 from libm cimport *
 from CxLik cimport *
+from CxSim cimport *
+from CxTree cimport CxtTree, CxTreeRecache
 from CxMath cimport *
+from CxPack cimport CxPackRowGet
 
 IF @enable_mpi@:
     from mpi4py import MPI
@@ -62,6 +66,7 @@ cdef class CL:
         assert polarity < 2
 
         if self.cLs[polarity].cLMat == NULL:
+            CxLikStats.nallocs += 1
             IF @have_posix_memalign@:
                 if posix_memalign(<void **>&self.cLs[polarity].cLMat, \
                   cacheLine, nchars * dim * ncomp * sizeof(double)):
@@ -659,144 +664,97 @@ cdef class Lik:
 
         return ret
 
-    cdef list _simulateRoot(self, list brks):
-        cdef list seq, cdf
-        cdef unsigned c, i, comp, brk
-        cdef double pCum
-
-        seq = []
-        c = 0
-        assert len(brks) == self.lik.compsLen
-        for 0 <= comp < self.lik.compsLen:
-            brk = brks[comp]
-            # Create a CDF for state frequencies.
-            cdf = []
-            pCum = 0.0
-            for 0 <= i < self.lik.dim-1:
-                pCum += self.lik.comps[comp].model.piDiagNorm[i]
-                if pCum > 1.0:
-                    pCum = 1.0
-                cdf.append(pCum)
-            cdf.append(1.0)
-            # Generate random characters, proportional to the state frequencies
-            # for this model component.
-            while c < brk:
-                u = random.random()
-                for 0 <= i < self.lik.dim:
-                    if cdf[i] >= u:
-                        seq.append(i)
-                        break
-                assert i < self.lik.dim
-                c += 1
-                assert len(seq) == c
-
-        return seq
-
-    cdef list _simulateChild(self, list brks, list parSeq, double brlen):
-        cdef list seq, cdfs, cdf
-        cdef double *P
-        cdef unsigned c, i, j, comp, brk
-        cdef double pCum
-
-        P = <double *>malloc(self.lik.dim * self.lik.dim * sizeof(double))
-        if P == NULL:
-            raise MemoryError("Error allocating P")
-        try:
-            seq = []
-            c = 0
-            assert len(brks) == self.lik.compsLen
-            for 0 <= comp < self.lik.compsLen:
-                brk = brks[comp]
-                # Create a list of CDFs for state transition probabilities,
-                # one for each starting state.
-                cdfs = []
-                CxLikPt(self.lik.dim, P, \
-                  self.lik.comps[comp].model.qEigVecCube,
-                  self.lik.comps[comp].model.qEigVals, brlen)
-                for 0 <= i < self.lik.dim:
-                    cdf = []
-                    pCum = 0.0
-                    for 0 <= j < self.lik.dim-1:
-                        pCum += P[i*self.lik.dim + j]
-                        if pCum > 1.0:
-                            pCum = 1.0
-                        cdf.append(pCum)
-                    cdf.append(1.0)
-                    cdfs.append(cdf)
-                # Generate random characters, based on starting state and
-                # transition probabilities.
-                while c < brk:
-                    u = random.random()
-                    cdf = cdfs[parSeq[c]]
-                    for 0 <= i < self.lik.dim:
-                        if cdf[i] >= u:
-                            seq.append(i)
-                            break
-                    assert i < self.lik.dim
-                    c += 1
-                    assert len(seq) == c
-        finally:
-            free(P)
-
-        return seq
-
-    cdef void _simulateRecurse(self, str i2c, list brks, list parSeq, \
-      Ring ring) except *:
-        cdef list seq
-        cdef Taxon taxon
-        cdef Ring r
-
-        seq = self._simulateChild(brks, parSeq, ring.edge.length)
-        taxon = ring.node.getTaxon()
-        if taxon is not None:
-            self.alignment.setSeq(self.alignment.taxaMap.indGet(taxon), 0, \
-              "".join([i2c[seq[i]] for i in xrange(len(seq))]))
-        for r in ring.siblings():
-            self._simulateRecurse(i2c, brks, seq, r.other)
-
     cdef void _simulate(self) except *:
-        cdef list brks, seq
-        cdef double wSum
-        cdef unsigned i
-        cdef Node base
+        cdef CxtSim sim
+        cdef CxtLikComp *comp
+        cdef CxtLikModel *modelP
+        cdef double *P, *weights
+        cdef Compact compact
+        cdef CxtTree *ctree
+        cdef uint32_t *inds
+        cdef unsigned nnodes, dim, i, j, n
+        cdef uint32_t r, node
         cdef Taxon taxon
-        cdef Ring ring, r
         cdef str i2c
 
+        assert self.alignment.rows != NULL
+
         # Create a lookup table from state index to character.  For DNA this is
         # "ACGT".
         i2c = "".join(self.char_.pcodes())
 
-        # Compute the breaks between characters simulated under each model
-        # component.  For example, given a 1000-character alignment and the
-        # following component weights, breaks will look like:
-        #
-        #   weightScaled:  0.25, 0.10, 0.00, 0.00, 0.60, 0.05
-        #   brks        : [   0,  250,  250,  250,  950, 1000]
         self.prep()
-        brks = []
-        wSum = 0.0
-        for 0 <= i < self.lik.compsLen-1:
-            wSum += self.lik.comps[i].weightScaled
-            if wSum > 1.0:
-                wSum = 1.0
-            brks.append(<int>ceil(wSum * \
-              <double>(self.alignment.nchars - self.alignment.npad)))
-        brks.append(self.alignment.nchars - self.alignment.npad)
-
-        seq = self._simulateRoot(brks)
-        base = self.tree.getBase()
-        taxon = base.getTaxon()
-        if taxon is not None:
-            self.alignment.setSeq(self.alignment.taxaMap.indGet(taxon), 0, \
-              "".join([i2c[seq[i]] for i in xrange(len(seq))]))
-        ring = base.ring
-        if ring is not None:
-            for r in ring:
-                self._simulateRecurse(i2c, brks, seq, r.other)
 
-        # Clean up.
-        self.alignment.deCol()
+        # Simulation nodes are numbered in preorder, starting at the base, which
+        # is the compact tree's cached traversal order: node n (n > 0) is at
+        # the far end of ring order[n-1].
+        compact = self.tree.compact()
+        ctree = &compact._tree
+        CxTreeRecache(ctree)
+        nnodes = ctree.norder + 1
+        dim = self.lik.dim
+
+        if CxSimNew(&sim, dim, self.lik.compsLen, nnodes):
+            raise MemoryError("Error allocating simulation tables")
+        P = weights = NULL
+        inds = NULL
+        try:
+            P = <double *>malloc(dim * dim * sizeof(double))
+            weights = <double *>malloc(self.lik.compsLen * sizeof(double))
+            inds = <uint32_t *>malloc(ctree.nnodes * sizeof(uint32_t))
+            if P == NULL or weights == NULL or inds == NULL:
+                raise MemoryError("Error allocating P")
+
+            # Map compact node indices to simulation node indices, in order to
+            # link each node to its parent.
+            node = ctree.base
+            inds[node] = 0
+            taxon = compact.taxonGet(node)
+            CxSimNode(&sim, 0, 0, self.alignment.taxaMap.indGet(taxon) \
+              if taxon is not None else -1)
+            for 1 <= n < nnodes:
+                r = ctree.order[n-1]
+                node = ctree.ringNodes[r]
+                inds[node] = n
+                taxon = compact.taxonGet(node)
+                CxSimNode(&sim, n, inds[ctree.ringNodes[r ^ 1]], \
+                  self.alignment.taxaMap.indGet(taxon) \
+                  if taxon is not None else -1)
+
+            # Sites are assigned to model components at random, in proportion
+            # to the component weights.  Branch lengths are scaled the same
+            # way as for likelihood computation.
+            for 0 <= i < self.lik.compsLen:
+                comp = &self.lik.comps[i]
+                modelP = comp.model
+                weights[i] = comp.weightScaled
+                CxSimRootFreqs(&sim, i, modelP.piDiagNorm)
+                for 1 <= n < nnodes:
+                    if comp.cmult == 0.0:
+                        # Invariable sites component.
+                        for 0 <= j < dim * dim:
+                            P[j] = 0.0
+                        for 0 <= j < dim:
+                            P[j*dim + j] = 1.0
+                    else:
+                        CxLikPt(dim, P, modelP.qEigVecCube, modelP.qEigVals, \
+                          ctree.lengths[ctree.order[n-1] >> 1] * comp.cmult \
+                          * modelP.rmult * self.lik.wNorm)
+                    CxSimEdgeP(&sim, n, i, P)
+            CxSimCompWeights(&sim, weights)
+
+            if CxSimRun(&sim, random.randint(0, 0xffffffffU), i2c, \
+              self.alignment.rows, self.alignment.nchars, \
+              self.alignment.nchars - self.alignment.npad):
+                raise MemoryError("Error simulating sequences")
+        finally:
+            if P != NULL:
+                free(P)
+            if weights != NULL:
+                free(weights)
+            if inds != NULL:
+                free(inds)
+            CxSimDelete(&sim)
 
     cpdef Lik simulate(self, unsigned nchars=0):
         """
@@ -817,7 +775,7 @@ cdef class Lik:
         if nchars == 0:
             nchars = self.alignment.nchars - self.alignment.npad
         alignment = Alignment(None, None, self.alignment.taxaMap, nchars, \
-          self.alignment.charType, True, True)
+          self.alignment.charType, True, False)
         # Pad the alignment if its width isn't a multiple of the stripe
         # width.
         npad = self._computeNpad(nchars, self._computeStripeWidth(nchars))
@@ -853,6 +811,7 @@ cdef class Lik:
         cdef CxtLikModel *modelP
         cdef bint resize
 
+        CxLikStats.nclones += 1
         if self.mate is not None:
             ret = self.mate
 
@@ -1430,6 +1389,7 @@ cdef class Lik:
         cdef Taxon taxon
         cdef unsigned degree, i, j
         cdef char *chars
+        cdef uint8_t *vals
         cdef double *cLMat
         cdef int ind, val
         cdef Ring r
@@ -1462,10 +1422,24 @@ cdef class Lik:
                     raise ValueError( \
                       "Taxon %r missing from alignment's taxa map" % \
                       taxon.label)
-                chars = self.alignment.getRow(ind)
+                # Read state sets directly from the packed matrix if there
+                # is one, rather than translating character codes.
+                vals = NULL
+                if self.alignment.packBits != 0:
+                    vals = <uint8_t *>malloc(self.lik.mschars)
+                    if vals == NULL:
+                        raise MemoryError("Error allocating vals")
+                    CxPackRowGet(&self.alignment.packed, ind, self.lik.cbase, \
+                      self.lik.mschars, vals)
+                else:
+                    chars = self.alignment.getRow(ind)
                 cLMat = cL.cLs[0].cLMat
                 for 0 <= i < self.lik.mschars:
-                    val = self.char_.code2val(chr(chars[self.lik.cbase + i]))
+                    if vals != NULL:
+                        val = vals[i]
+                    else:
+                        val = self.char_.code2val( \
+                          chr(chars[self.lik.cbase + i]))
                     if val == 0:
                         val = self.char_.any
                     for 0 <= j < self.lik.dim:
@@ -1473,6 +1447,8 @@ cdef class Lik:
                             cLMat[i*self.lik.dim + j] = 1.0
                         else:
                             cLMat[i*self.lik.dim + j] = 0.0
+                if vals != NULL:
+                    free(vals)
         else:
             if cL is None:
                 cL = CL()
@@ -1692,6 +1668,8 @@ cdef class Lik:
         cdef double ret
         cdef unsigned i
 
+        CxLikStats.nlnL += 1
+
         # Prepare data structures and compute the execution plan.
         self._prep(root)
 
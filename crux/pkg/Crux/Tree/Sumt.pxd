@@ -1,4 +1,6 @@
 from libc cimport *
+from CxNewick cimport CxtNewickSplits
+from Crux.Newick cimport Trees
 from Crux.Tree cimport Tree, Node, Edge
 from Crux.Tree.Bipart cimport Vec
 
@@ -6,8 +8,10 @@ cdef class Trprob:
     cdef Tree _tree
     cdef list _nobs          # Number of times observed in each run.
     cdef list _trees         # List of trees, used to compute mean brlens.
+    cdef Trees _set          # If not None, _trees contains indices into _set.
 
     cdef void _observe(self, unsigned run, Tree tree) except *
+    cdef void _observeInd(self, unsigned run, uint64_t ind) except *
 
     cdef uint64_t getNobs(self)
     # property nobs
@@ -21,7 +25,9 @@ cdef class Trprob:
 cdef class Part:
     cdef readonly Vec vec
     cdef list _nobs          # Number of times observed in each run.
-    cdef readonly list edges # List of edges, used to compute mean/variance.
+    cdef uint64_t _nobsTotal # Total number of times observed.
+    cdef readonly list edges # List of observed edges (Tree input only).
+    cdef list _lens          # Observed lengths, used to compute mean/variance.
 
     cdef double _mse
     cdef double _mean
@@ -29,6 +35,9 @@ cdef class Part:
     cdef double _var
 
     cdef void _observe(self, unsigned run, Edge edge) except *
+    cdef void _observeLen(self, unsigned run, double length) except *
+    cdef void _load(self, list nobs, double mean, double v2mean, double var) \
+      except *
 
     cdef uint64_t getNobs(self)
     # property nobs
@@ -45,17 +54,27 @@ cdef class Part:
 
 cdef class Sumt:
     cdef list _treeLists
+    cdef Trees _trees        # If not None, _treeLists contains indices.
+    cdef list _taxa
+    cdef uint64_t _ntrees
     cdef list _trprobs
     cdef list _parts
 
+    cdef list getTaxa(self)
+    # property taxa
+
+    cdef void _splits(self, CxtNewickSplits *splits, uint64_t ind, \
+      unsigned ntaxa) except *
+    cdef void _summarizeTrprobsSet(self) except *
     cdef void _summarizeTrprobs(self) except *
     cdef list getTrprobs(self)
     # property trprobs
 
+    cdef void _summarizePartsSet(self) except *
     cdef void _summarizeParts(self) except *
     cdef list getParts(self)
     # property parts
 
     cdef bint _incorpPart(self, Tree tree, unsigned ntaxa, Node node, \
-      dict e2v, Vec incorp, double support) except *
+      dict e2v, dict v2e, Vec incorp, double support) except *
     cpdef Tree getConTree(self, minSupport=*)
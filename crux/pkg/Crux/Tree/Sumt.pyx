@@ -2,24 +2,37 @@
     Tree distribution summary statistics.
 """
 from Crux.Taxa cimport Taxon
+from Crux.Newick cimport Trees
 from Crux.Tree cimport Tree, Node, Edge, Ring
-from Crux.Tree.Bipart cimport Vec, Bipart
+from Crux.Tree.Bipart cimport Vec, Bipart, Splits
+
+from CxBipart cimport *
+from CxNewick cimport *
+
+cdef extern from "Python.h":
+    cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
+    cdef char *PyString_AsString(object string)
 
 cdef class Trprob:
     """
         Summary statistics associated with a set of all trees within a Sumt
         instance that all have the same topology.
     """
-    def __init__(self, unsigned nruns):
+    def __init__(self, unsigned nruns, Trees trees=None):
         self._tree = None
 
         self._nobs = [0] * nruns
         self._trees = []
+        self._set = trees
 
     cdef void _observe(self, unsigned run, Tree tree) except *:
         self._nobs[run] += 1
         self._trees.append(tree)
 
+    cdef void _observeInd(self, unsigned run, uint64_t ind) except *:
+        self._nobs[run] += 1
+        self._trees.append(ind)
+
     cdef uint64_t getNobs(self):
         return len(self._trees)
     property nobs:
@@ -62,7 +75,10 @@ cdef class Trprob:
 
         if self._tree is None:
             # Create tree with 0-length branches.
-            self._tree = self._trees[0].dup()
+            if self._set is not None:
+                self._tree = self._set.getTree(self._trees[0])
+            else:
+                self._tree = self._trees[0].dup()
             for edge in self._tree.getEdges():
                 edge.length = 0.0
             bipart = self._tree.getBipart()
@@ -78,7 +94,11 @@ cdef class Trprob:
             # Iterate over sampled trees.
             ntrees = len(self._trees)
             for 0 <= i < ntrees:
-                treeI = <Tree>self._trees[i]
+                if self._set is not None:
+                    # Trees are only materialized here, one at a time.
+                    treeI = self._set.getTree(self._trees[i])
+                else:
+                    treeI = <Tree>self._trees[i]
                 bipartI = treeI.getBipart()
 
                 # Add internal branch lengths.
@@ -127,18 +147,38 @@ cdef class Part:
     def __init__(self, Vec vec, unsigned nruns):
         self.vec = vec
         self._nobs = [0] * nruns
+        self._nobsTotal = 0
         self.edges = []
+        self._lens = []
         self._mse = -1.0
         self._mean = -1.0
         self._v2mean = -1.0
         self._var = -1.0
 
     cdef void _observe(self, unsigned run, Edge edge) except *:
-        self._nobs[run] += 1
         self.edges.append(edge)
+        self._observeLen(run, edge.length)
+
+    cdef void _observeLen(self, unsigned run, double length) except *:
+        self._nobs[run] += 1
+        self._nobsTotal += 1
+        self._lens.append(length)
+
+    # Set precomputed statistics, in lieu of observing edges.
+    cdef void _load(self, list nobs, double mean, double v2mean, double var) \
+      except *:
+        cdef unsigned i
+
+        assert len(nobs) == len(self._nobs)
+        for 0 <= i < len(nobs):
+            self._nobs[i] = nobs[i]
+            self._nobsTotal += nobs[i]
+        self._mean = mean
+        self._v2mean = v2mean
+        self._var = var
 
     cdef uint64_t getNobs(self):
-        return len(self.edges)
+        return self._nobsTotal
     property nobs:
         """
             Total number of observations across all runs.
@@ -153,7 +193,7 @@ cdef class Part:
 
         if self._mse == -1.0:
             self._mse = 0.0
-            nobs = len(self.edges)
+            nobs = self._nobsTotal
             nruns = len(self._nobs)
             mean = <double>nobs / <double>nruns
             for 0 <= i < nruns:
@@ -169,14 +209,12 @@ cdef class Part:
 
     cdef double getMean(self):
         cdef uint64_t i, nobs
-        cdef Edge edge
 
         if self._mean == -1.0:
             self._mean = 0.0
-            nobs = len(self.edges)
+            nobs = len(self._lens)
             for 0 <= i < nobs:
-                edge = <Edge>self.edges[i]
-                self._mean += edge.length / <double>nobs
+                self._mean += <double>self._lens[i] / <double>nobs
         return self._mean
     property mean:
         """
@@ -187,14 +225,14 @@ cdef class Part:
 
     cdef double getV2Mean(self):
         cdef uint64_t i, nobs
-        cdef Edge edge
+        cdef double length
 
         if self._v2mean == -1.0:
             self._v2mean = 0.0
-            nobs = len(self.edges)
+            nobs = len(self._lens)
             for 0 <= i < nobs:
-                edge = <Edge>self.edges[i]
-                self._v2mean += (edge.length * edge.length) / <double>nobs
+                length = <double>self._lens[i]
+                self._v2mean += (length * length) / <double>nobs
         return self._v2mean
     property v2mean:
         """
@@ -206,15 +244,13 @@ cdef class Part:
     cdef double getVar(self):
         cdef double mean, diff
         cdef uint64_t i, nobs
-        cdef Edge edge
 
         if self._var == -1.0:
             self._var = 0.0
             mean = self.getMean()
-            nobs = len(self.edges)
+            nobs = len(self._lens)
             for 0 <= i < nobs:
-                edge = <Edge>self.edges[i]
-                diff = (edge.length - mean)
+                diff = (<double>self._lens[i] - mean)
                 self._var += (diff * diff) / <double>nobs
 
         return self._var
@@ -243,41 +279,231 @@ cdef class Part:
 cdef class Sumt:
     """
         Summary of a set of trees.
+
+        treeLists
+          List of per-run lists of trees.
+
+        trees
+          If not None, a Crux.Newick.Trees instance, in which case treeLists
+          contains indices into trees rather than Tree instances.  Splits and
+          topologies are then computed directly from the compact tree
+          representation, and Tree instances are only created for the trees
+          that Trprob.tree reports.
+
+        Alternatively, a Sumt can be constructed from precomputed parts (as
+        Crux.Mc3.Post.loadSummary() does), along with the alphabetized list of
+        taxa and the total number of trees they summarize.  Such a Sumt
+        supports parts and getConTree(), but not trprobs.
     """
-    def __init__(self, list treeLists):
+    def __init__(self, list treeLists=None, list parts=None, list taxa=None, \
+      uint64_t ntrees=0, Trees trees=None):
+        cdef list decos
+        cdef Part part
+        cdef unsigned i
+        cdef object deco
+
         self._treeLists = treeLists
+        self._trees = trees
         self._trprobs = None
-        self._parts = None
+        if treeLists is not None:
+            assert parts is None
+            self._taxa = None
+            self._ntrees = 0
+            for 0 <= i < len(treeLists):
+                self._ntrees += len(<list>treeLists[i])
+            self._parts = None
+        else:
+            assert parts is not None and taxa is not None
+            self._taxa = taxa
+            self._ntrees = ntrees
+            decos = [(part.getNobs(), part.vec, part) for part in parts]
+            decos.sort(reverse=True)
+            self._parts = [deco[2] for deco in decos]
+
+    cdef list getTaxa(self):
+        cdef object trees
+
+        if self._taxa is None:
+            if self._trees is not None:
+                self._taxa = self._trees.getTaxa()
+            else:
+                for trees in self._treeLists:
+                    if len(<list>trees) > 0:
+                        self._taxa = (<Tree>(<list>trees)[0]).getTaxa()
+                        break
+        return self._taxa
+    property taxa:
+        """
+            Alphabetized list of the taxa in the summarized trees.
+        """
+        def __get__(self):
+            return self.getTaxa()
+
+    # Compute the splits of tree ind in self._trees.
+    cdef void _splits(self, CxtNewickSplits *splits, uint64_t ind, \
+      unsigned ntaxa) except *:
+        if CxNewickSplitsCompute(splits, &self._trees._set, ind, \
+          self._trees._bits):
+            raise ValueError("Tree %d has an unlabeled leaf" % ind)
+        if splits.ntaxa != ntaxa:
+            raise ValueError("Trees must contain identical taxa")
+
+    # Equivalent to the Tree-based code path of _summarizeTrprobs().
+    # Topologies are represented by their sorted split vectors, stored as
+    # strings.  String order differs from word order, so for ordering, the
+    # strings are converted to lists of word tuples, which compare the same
+    # as Bipart.edgeVecs.
+    cdef void _summarizeTrprobsSet(self) except *:
+        cdef CxtNewickSplits splits
+        cdef CxtBipartTab tab
+        cdef dict collisions
+        cdef unsigned nruns, ntaxa, nWords, i
+        cdef uint64_t j, k, ind, t
+        cdef size_t keyLen
+        cdef list inds, fps, keys, trprobs, vecs, decos
+        cdef str fp, key
+        cdef uint64_t *words
+        cdef Trprob trprob
+        cdef object deco
+
+        ntaxa = len(self.getTaxa())
+        nWords = CxmBipartNWords(ntaxa)
+        if CxNewickSplitsNew(&splits, &self._trees._set, ntaxa):
+            raise MemoryError("Error allocating splits")
+        try:
+            # Map topology fingerprints to indices into trprobs/keys, as
+            # _summarizeTrprobs() does.  The table references the
+            # fingerprint strings stored in fps.
+            if CxBipartTabNew(&tab, 2):
+                raise MemoryError("Error allocating topology table")
+            try:
+                fps = []
+                keys = []
+                trprobs = []
+                collisions = {}
+                nruns = len(self._treeLists)
+                for 0 <= i < nruns:
+                    inds = self._treeLists[i]
+                    for 0 <= j < len(inds):
+                        t = inds[j]
+                        self._splits(&splits, t, ntaxa)
+                        keyLen = splits.nsplits * nWords * sizeof(uint64_t)
+                        fp = PyString_FromStringAndSize(<char *>splits.fp, \
+                          2 * sizeof(uint64_t))
+                        if CxBipartTabInsert(&tab, splits.fp[0], \
+                          <uint64_t *>PyString_AsString(fp), len(trprobs), \
+                          &ind):
+                            raise MemoryError("Error growing topology table")
+                        if ind == len(trprobs):
+                            trprob = Trprob(nruns, self._trees)
+                            fps.append(fp)
+                            keys.append(PyString_FromStringAndSize( \
+                              <char *>splits.words, keyLen))
+                            trprobs.append(trprob)
+                        elif len(<str>keys[ind]) == keyLen \
+                          and memcmp(PyString_AsString(keys[ind]), \
+                          splits.words, keyLen) == 0:
+                            trprob = <Trprob>trprobs[ind]
+                        else:
+                            key = PyString_FromStringAndSize( \
+                              <char *>splits.words, keyLen)
+                            if key in collisions:
+                                trprob = <Trprob>trprobs[collisions[key]]
+                            else:
+                                trprob = Trprob(nruns, self._trees)
+                                collisions[key] = len(trprobs)
+                                keys.append(key)
+                                trprobs.append(trprob)
+                        trprob._observeInd(i, t)
+            finally:
+                CxBipartTabDelete(&tab)
+        finally:
+            CxNewickSplitsDelete(&splits)
+
+        decos = []
+        for 0 <= ind < len(trprobs):
+            key = keys[ind]
+            words = <uint64_t *>PyString_AsString(key)
+            vecs = []
+            if nWords != 0:
+                for 0 <= k < len(key) / (nWords * sizeof(uint64_t)):
+                    vecs.append(tuple([words[k*nWords + i] \
+                      for i in xrange(nWords)]))
+            decos.append((len((<Trprob>trprobs[ind])._trees), vecs, \
+              trprobs[ind]))
+        decos.sort(reverse=True)
+        self._trprobs = [deco[2] for deco in decos]
 
     cdef void _summarizeTrprobs(self) except *:
-        cdef dict d
+        cdef CxtBipartTab tab
+        cdef dict collisions
         cdef unsigned nruns, i
-        cdef uint64_t j
-        cdef list trees, decos
+        cdef uint64_t j, ind
+        cdef list trees, fps, keys, biparts, trprobs, decos
+        cdef Splits splits
         cdef Tree tree
-        cdef Bipart bipart
+        cdef str fp, key
         cdef Trprob trprob
         cdef object deco
 
-        d = {}
-        nruns = len(self._treeLists)
-        for 0 <= i < nruns:
-            trees = self._treeLists[i]
-            for 0 <= j < len(trees):
-                tree = <Tree>trees[j]
-                bipart = tree.getBipart()
-                if bipart in d:
-                    trprob = <Trprob>d[bipart]
-                else:
-                    trprob = Trprob(nruns)
-                    d[bipart] = trprob
-                trprob._observe(i, tree)
-
-        decos = [(len((<Trprob>d[bipart])._trees), bipart, <Trprob>d[bipart]) \
-          for bipart in d]
+        if self._trees is not None:
+            self._summarizeTrprobsSet()
+            return
+
+        # Map topology fingerprints to indices into trprobs/keys/biparts, as
+        # _summarizeTrprobsSet() does.  The table references the fingerprint
+        # strings stored in fps.  Each fingerprint is computed by a single
+        # traversal, and a fingerprint match is confirmed by comparing split
+        # vectors, so that a Bipart is only created for the first tree with
+        # each topology (to order the results).
+        splits = Splits(self.getTaxa())
+        if CxBipartTabNew(&tab, 2):
+            raise MemoryError("Error allocating topology table")
+        try:
+            fps = []
+            keys = []
+            biparts = []
+            trprobs = []
+            collisions = {}
+            nruns = len(self._treeLists)
+            for 0 <= i < nruns:
+                trees = self._treeLists[i]
+                for 0 <= j < len(trees):
+                    tree = <Tree>trees[j]
+                    splits.compute(tree)
+                    key = splits.key()
+                    fp = PyString_FromStringAndSize(<char *>splits._fp, \
+                      2 * sizeof(uint64_t))
+                    if CxBipartTabInsert(&tab, splits._fp[0], \
+                      <uint64_t *>PyString_AsString(fp), len(trprobs), &ind):
+                        raise MemoryError("Error growing topology table")
+                    if ind == len(trprobs):
+                        trprob = Trprob(nruns)
+                        fps.append(fp)
+                        keys.append(key)
+                        biparts.append(tree.getBipart())
+                        trprobs.append(trprob)
+                    elif <str>keys[ind] == key:
+                        trprob = <Trprob>trprobs[ind]
+                    elif key in collisions:
+                        trprob = <Trprob>trprobs[collisions[key]]
+                    else:
+                        trprob = Trprob(nruns)
+                        collisions[key] = len(trprobs)
+                        keys.append(key)
+                        biparts.append(tree.getBipart())
+                        trprobs.append(trprob)
+                    trprob._observe(i, tree)
+        finally:
+            CxBipartTabDelete(&tab)
+
+        decos = [(len((<Trprob>trprobs[ind])._trees), biparts[ind], \
+          trprobs[ind]) for ind in xrange(len(trprobs))]
         decos.sort(reverse=True)
         self._trprobs = [deco[2] for deco in decos]
     cdef list getTrprobs(self):
+        if self._treeLists is None:
+            raise ValueError("Tree topologies were not summarized")
         if self._trprobs is None:
             self._summarizeTrprobs()
         return self._trprobs
@@ -289,36 +515,106 @@ cdef class Sumt:
         def __get__(self):
             return self.getTrprobs()
 
+    # Equivalent to the Tree-based code path of _summarizeParts().
+    cdef void _summarizePartsSet(self) except *:
+        cdef CxtNewickSplits splits
+        cdef CxtBipartTab tab
+        cdef unsigned nruns, ntaxa, nWords, i, k
+        cdef uint64_t j, ind
+        cdef uint64_t *words
+        cdef list inds, parts, decos
+        cdef Vec vec
+        cdef Part part
+        cdef object deco
+
+        ntaxa = len(self.getTaxa())
+        nWords = CxmBipartNWords(ntaxa)
+        if CxNewickSplitsNew(&splits, &self._trees._set, ntaxa):
+            raise MemoryError("Error allocating splits")
+        try:
+            # Map split vectors to indices into parts.  The table references
+            # the bit vectors of the Vec instances stored in parts.
+            if CxBipartTabNew(&tab, nWords):
+                raise MemoryError("Error allocating split table")
+            try:
+                parts = []
+                nruns = len(self._treeLists)
+                for 0 <= i < nruns:
+                    inds = self._treeLists[i]
+                    for 0 <= j < len(inds):
+                        self._splits(&splits, inds[j], ntaxa)
+                        for 0 <= k < splits.nsplits:
+                            words = &splits.words[k * nWords]
+                            if CxBipartTabSearch(&tab, splits.hashes[k], \
+                              words, &ind):
+                                vec = Vec(None, ntaxa)
+                                memcpy(vec.bits, words, \
+                                  nWords * sizeof(uint64_t))
+                                vec._hash = splits.hashes[k]
+                                if CxBipartTabInsert(&tab, vec._hash, \
+                                  vec.bits, len(parts), &ind):
+                                    raise MemoryError( \
+                                      "Error growing split table")
+                                part = Part(vec, nruns)
+                                parts.append(part)
+                            else:
+                                part = <Part>parts[ind]
+                            part._observeLen(i, splits.lens[k])
+            finally:
+                CxBipartTabDelete(&tab)
+        finally:
+            CxNewickSplitsDelete(&splits)
+
+        decos = [(part.getNobs(), part.vec, part) for part in parts]
+        decos.sort(reverse=True)
+        self._parts = [deco[2] for deco in decos]
+
     cdef void _summarizeParts(self) except *:
-        cdef dict d
+        cdef CxtBipartTab tab
         cdef unsigned nruns, i, k
-        cdef uint64_t j
-        cdef list trees, vecs, decos
+        cdef uint64_t j, ind
+        cdef list trees, parts, decos
+        cdef Splits splits
         cdef Tree tree
-        cdef Bipart bipart
-        cdef Vec vec
+        cdef Edge edge
         cdef Part part
         cdef object deco
 
-        d = {}
-        nruns = len(self._treeLists)
-        for 0 <= i < nruns:
-            trees = self._treeLists[i]
-            for 0 <= j < len(trees):
-                tree = <Tree>trees[j]
-                bipart = tree.getBipart()
-                vecs = bipart.edgeVecs
-                for 0 <= k < len(vecs):
-                    vec = <Vec>vecs[k]
-                    if vec in d:
-                        part = <Part>d[vec]
-                        assert vec.cmp(part.vec) == 0
-                    else:
-                        part = Part(vec, nruns)
-                        d[vec] = part
-                    part._observe(i, vec.edge)
-
-        decos = [(<Part>d[vec].nobs, vec, <Part>d[vec]) for vec in d]
+        if self._trees is not None:
+            self._summarizePartsSet()
+            return
+
+        # Map split vectors to indices into parts.  The table references the
+        # bit vectors of the Vec instances stored in parts, which keeps them
+        # alive.  Vec instances are only created for the first sighting of
+        # each split.
+        splits = Splits(self.getTaxa())
+        if CxBipartTabNew(&tab, splits.nWords):
+            raise MemoryError("Error allocating split table")
+        try:
+            parts = []
+            nruns = len(self._treeLists)
+            for 0 <= i < nruns:
+                trees = self._treeLists[i]
+                for 0 <= j < len(trees):
+                    tree = <Tree>trees[j]
+                    splits.compute(tree)
+                    for 0 <= k < splits.nsplits:
+                        if CxBipartTabSearch(&tab, splits.hashes[k], \
+                          &splits.words[k * splits.nWords], &ind):
+                            part = Part(splits.getVec(k), nruns)
+                            if CxBipartTabInsert(&tab, part.vec._hash, \
+                              part.vec.bits, len(parts), &ind):
+                                raise MemoryError("Error growing split table")
+                            parts.append(part)
+                        else:
+                            part = <Part>parts[ind]
+                        edge = <Edge>splits.edges[k]
+                        part._observe(i, edge)
+        finally:
+            CxBipartTabDelete(&tab)
+
+        decos = [(part.getNobs(), part.vec, part) for part in parts]
         decos.sort(reverse=True)
         self._parts = [deco[2] for deco in decos]
     cdef list getParts(self):
@@ -334,7 +630,7 @@ cdef class Sumt:
             return self.getParts()
 
     cdef bint _incorpPart(self, Tree tree, unsigned ntaxa, Node node, \
-      dict e2v, Vec incorp, double support) except *:
+      dict e2v, dict v2e, Vec incorp, double support) except *:
         cdef Ring ring
         cdef Edge edge
         cdef Vec vec, v
@@ -384,6 +680,11 @@ cdef class Sumt:
         edge = Edge(tree)
         edge.aux = support
         edge.attach(node, nodeCompat)
+
+        # Moving the compat edges leaves their bipartitions unchanged, so the
+        # lookup tables only need the new edge added.
+        e2v[edge] = incorp
+        v2e[incorp] = edge
         return True
 
     cpdef Tree getConTree(self, minSupport=0.0):
@@ -397,7 +698,8 @@ cdef class Sumt:
             majority-rule consensus tree, use minSupport=0.5.
 
             Compute each branch length by averaging the lengths across all
-            trees that include the branch.
+            trees that include the branch (i.e. the mean of the corresponding
+            Part).
 
             Store bipartition support values (commonly referred to as "node
             support values") in the edges' aux attributes.
@@ -406,22 +708,24 @@ cdef class Sumt:
         cdef Node base, node
         cdef Edge edge
         cdef uint64_t N
-        cdef list taxa, nodes, trees
-        cdef unsigned ntaxa, nruns, i, j
-        cdef uint64_t k
+        cdef list taxa, nodes
+        cdef unsigned ntaxa, i, j
         cdef Taxon taxon
         cdef Part part
         cdef double support
-        cdef dict e2v, v2e, v2nobs
-        cdef Bipart bipart
+        cdef dict e2v, v2e
         cdef Vec vec
 
-        # Create a star tree with 0-length branches.
+        # Create a star tree with 0-length branches, along with lookup tables
+        # of edge-->vec and vec-->edge, which are kept current as
+        # bipartitions are incorporated.
         tree = Tree(None, None, False)
         base = Node(tree)
         tree.setBase(base)
-        taxa = (<Tree>(<list>self._treeLists[0])[0]).getTaxa()
+        taxa = self.getTaxa()
         ntaxa = len(taxa)
+        e2v = {}
+        v2e = {}
         for 0 <= i < ntaxa:
             taxon = <Taxon>taxa[i]
             edge = Edge(tree)
@@ -430,23 +734,20 @@ cdef class Sumt:
             node.setTaxon(taxon)
             edge.attach(base, node)
 
-        N = 0
-        for 0 <= i < len(self._treeLists):
-            N += len(<list>self._treeLists[i])
+            # taxa is alphabetized, so this leaf is bit i.
+            vec = Vec(edge, ntaxa)
+            vec.set(i, True)
+            if i == 0:
+                vec.invert()
+            e2v[edge] = vec
+            v2e[vec] = edge
+
+        N = self._ntrees
 
         if self._parts is None:
             self._summarizeParts()
         # Iteratively incorporate bipartitions.
         for 0 <= i < len(self._parts):
-            # Create lookup tables of edge-->vec and vec-->edge.
-            bipart = tree.getBipart()
-            e2v = {}
-            v2e = {}
-            for 0 <= j < len(bipart.edgeVecs):
-                vec = <Vec>bipart.edgeVecs[j]
-                e2v[vec.edge] = vec
-                v2e[vec] = vec.edge
-
             part = <Part>self._parts[i]
             if part.vec in v2e:
                 # This is a leaf edge, which was incorporated when the star
@@ -464,8 +765,8 @@ cdef class Sumt:
             for 0 <= j < len(nodes):
                 node = <Node>nodes[j]
                 if node.getDegree() > 3:
-                    if self._incorpPart(tree, ntaxa, node, e2v, part.vec, \
-                      support):
+                    if self._incorpPart(tree, ntaxa, node, e2v, v2e, \
+                      part.vec, support):
                         # Success.
                         break
 
@@ -473,33 +774,12 @@ cdef class Sumt:
                 # Tree is fully resolved.
                 break
 
-        # Create a lookup tabel of vec-->edge for the final tree topology.
-        bipart = tree.getBipart()
-        v2e = {}
-        for 0 <= i < len(bipart.edgeVecs):
-            vec = <Vec>bipart.edgeVecs[i]
-            v2e[vec] = vec.edge
-
-        # Create a lookup table of vec-->nobs.
-        v2nobs = {}
+        # Set branch lengths.  Leaf edges that were never observed (possible
+        # only if every tree lacks the leaf's edge) keep 0 length.
         for 0 <= i < len(self._parts):
             part = <Part>self._parts[i]
-            v2nobs[part.vec] = part.getNobs()
-        # Leaf edges are in every tree.
-        for vec in v2e:
-            if vec not in v2nobs:
-                v2nobs[vec] = N
-
-        # Set branch lengths.
-        nruns = len(self._treeLists)
-        for 0 <= i < nruns:
-            trees = self._treeLists[i]
-            for 0 <= k < len(trees):
-                bipart = (<Tree>trees[k]).getBipart()
-                for 0 <= j < len(bipart.edgeVecs):
-                    vec = <Vec>bipart.edgeVecs[j]
-                    if vec in v2e:
-                        edge = <Edge>v2e[vec]
-                        edge.length += vec.edge.length / <double>v2nobs[vec]
+            if part.vec in v2e:
+                edge = <Edge>v2e[part.vec]
+                edge.length = part.getMean()
 
         return tree
@@ -9,10 +9,15 @@ from Crux.CTMatrix cimport CTMatrix
 from Crux.Taxa cimport Taxon
 cimport Crux.Taxa as Taxa
 from Crux.Tree.Bipart cimport Bipart
+from Crux.Tree.Compact cimport Compact
+from CxFmt cimport CxtFmt, CxtFmtSpec
 
 cdef class Tree:
     cdef Node _base
-    cdef list _renderList
+    # render() state.
+    cdef CxtFmt _renderFmt
+    cdef CxtFmtSpec _renderSpec
+    cdef bint _renderNative # Format lengths via CxFmtDouble().
     cdef file _renderFile
     # Incremented every time the tree is modified.
     cdef readonly uint64_t sn
@@ -27,6 +32,7 @@ cdef class Tree:
 
     cdef Node _dup(self, Tree newTree, Node node, Ring prevRing)
     cpdef Tree dup(self)
+    cpdef Compact compact(self)
     cpdef double rf(self, Tree other) except -1.0
     cpdef list rfs(self, list others)
     cdef void _resetCache(self) except *
@@ -56,9 +62,14 @@ cdef class Tree:
     cpdef deroot(self)
     cpdef canonize(self, Taxa.Map taxaMap)
     cpdef int collapse(self) except -1
+    cdef void _renderFlush(self, bint force) except *
     cdef void _renderAppend(self, str s) except *
+    cdef void _renderLabel(self, Taxon taxon, Taxa.Map taxaMap) except *
+    cdef void _renderLength(self, lengthFormat, double length) except *
     cpdef str render(self, bint lengths=*, lengthFormat=*, Taxa.Map taxaMap=*,
       file outFile=*)
+    cdef void _render(self, bint lengths, lengthFormat, Taxa.Map taxaMap) \
+      except *
 
 cdef class Node:
     cdef readonly Tree tree
@@ -2,13 +2,13 @@
     Classes related to phylogenetic trees.  Also see the documentation for the
     sub-modules:
 
-    * Crux.Tree.Bipart : Edge-induced bipartitions.
-    * Crux.Tree.Lik    : Models of molecular evolution and tree likelihoods.
-    * Crux.Tree.Sumt   : Tree distribution summary statistics.
+    * Crux.Tree.Bipart  : Edge-induced bipartitions.
+    * Crux.Tree.Compact : Array-backed trees.
+    * Crux.Tree.Lik     : Models of molecular evolution and tree likelihoods.
+    * Crux.Tree.Sumt    : Tree distribution summary statistics.
 """
 
 import random
-import re
 import sys
 
 from Crux.CTMatrix cimport CTMatrix
@@ -17,12 +17,23 @@ from Crux.Taxa cimport Taxon
 cimport Crux.Taxa as Taxa
 cimport Crux.Tree.Lik
 from Crux.Tree.Bipart cimport Bipart
+from Crux.Tree.Compact cimport Compact
 from Crux.Tree.Sumt cimport Trprob, Part, Sumt
 
 import Crux.Config
 
+from CxFmt cimport *
+
+cdef extern from "Python.h":
+    cdef object PyString_FromStringAndSize(char *s, Py_ssize_t len)
+
 DEF TreeDebugExpensive = False
 
+# render() accumulates output in a buffer, and writes it to the output file (if
+# any) whenever it exceeds _renderFlushLen bytes.
+cdef enum:
+    _renderFlushLen = 256 * 1024
+
 global __name__
 
 # Forward declarations.
@@ -171,6 +182,12 @@ cdef class Tree:
 
         return newTree
 
+    cpdef Compact compact(self):
+        """
+            Create an array-backed copy of the tree (see Crux.Tree.Compact).
+        """
+        return Compact(self)
+
     cpdef double rf(self, Tree other) except -1.0:
         """
             Compute the Robinson-Foulds distance between trees, precisely as
@@ -189,7 +206,9 @@ cdef class Tree:
 
     cpdef list rfs(self, list others):
         """
-            Compute the Robinson-Foulds distance to each tree in a list.
+            Compute the Robinson-Foulds distance to each tree in a list.  To
+            compute distances among all pairs of trees in a list, use
+            Crux.Tree.Bipart.rfMatrix() instead.
         """
         cdef list ret, taxaSelf
         cdef Bipart bipartSelf
@@ -516,11 +535,39 @@ cdef class Tree:
 
         return len(collapsable)
 
+    cdef void _renderFlush(self, bint force) except *:
+        if self._renderFile is not None \
+          and (force or self._renderFmt.len >= _renderFlushLen):
+            self._renderFile.write(PyString_FromStringAndSize(
+              self._renderFmt.buf, self._renderFmt.len))
+            self._renderFmt.len = 0
+
     cdef void _renderAppend(self, str s) except *:
-        if self._renderList is not None:
-            self._renderList.append(s)
+        if CxFmtStr(&self._renderFmt, s, len(s)):
+            raise MemoryError("Error rendering tree")
+        self._renderFlush(False)
+
+    cdef void _renderLabel(self, Taxon taxon, Taxa.Map taxaMap) except *:
+        cdef str label
+        cdef bint err
+
+        if taxaMap is not None:
+            err = CxFmtUint(&self._renderFmt, taxaMap.indGet(taxon))
+        else:
+            label = taxon.label
+            err = CxFmtLabel(&self._renderFmt, label, len(label))
+        if err:
+            raise MemoryError("Error rendering tree")
+        self._renderFlush(False)
+
+    cdef void _renderLength(self, lengthFormat, double length) except *:
+        if self._renderNative:
+            if CxFmtStr(&self._renderFmt, ":", 1) \
+              or CxFmtDouble(&self._renderFmt, &self._renderSpec, length):
+                raise MemoryError("Error rendering tree")
+            self._renderFlush(False)
         else:
-            self._renderFile.write(s)
+            self._renderAppend((":" + lengthFormat) % length)
 
     cpdef str render(self, bint lengths=False, lengthFormat="%.7e",
       Taxa.Map taxaMap=None, file outFile=None):
@@ -528,19 +575,40 @@ cdef class Tree:
             Render the tree in Newick format.  If the lengths parameter is
             True, use lengthFormat to print branch lengths.  Return a string if
             outFile is unspecified.
+
+            Output is formatted natively in bulk; branch lengths are too if
+            lengthFormat is of the form "%.<prec>e" or "%.<prec>f" (with the
+            same results as Python's formatting).
         """
         cdef str ret
+
+        self._renderNative = isinstance(lengthFormat, str) \
+          and not CxFmtSpecParse(&self._renderSpec, lengthFormat)
+        if CxFmtNew(&self._renderFmt, 4096):
+            raise MemoryError("Error allocating render buffer")
+        self._renderFile = outFile
+        try:
+            self._render(lengths, lengthFormat, taxaMap)
+            self._renderAppend(";")
+
+            if outFile is None:
+                ret = PyString_FromStringAndSize(self._renderFmt.buf,
+                  self._renderFmt.len)
+            else:
+                self._renderAppend("\n")
+                self._renderFlush(True)
+                ret = None
+        finally:
+            CxFmtDelete(&self._renderFmt)
+            self._renderFile = None
+        return ret
+
+    cdef void _render(self, bint lengths, lengthFormat, Taxa.Map taxaMap) \
+      except *:
         cdef Node n, neighbor
         cdef Ring ring
         cdef int degree
 
-        if outFile is None:
-            self._renderList = []
-            self._renderFile = None
-        else:
-            self._renderList = None
-            self._renderFile = outFile
-
         # Render.
         n = self._base
         if n is not None:
@@ -590,17 +658,6 @@ cdef class Tree:
                     # Internal node.
                     n.rrender(None, lengths, lengthFormat, taxaMap, False, True)
 
-        self._renderAppend(";")
-
-        if self._renderList is not None:
-            ret = "".join(self._renderList)
-            self._renderList = None
-        else:
-            self._renderFile.write("\n")
-            ret = None
-            self._renderFile = None
-        return ret
-
     # Callback method that is used by the render method for recursive rendering
     # of the tree in Newick format.
     def _stringRenderCallback(self, string):
@@ -711,8 +768,6 @@ cdef class Node:
     cdef rrender(self, Edge via, bint lengths, lengthFormat, Taxa.Map taxaMap,
       bint zeroLength, bint noLength):
         cdef bint did_paren = False
-        cdef str label
-        cdef object m
         cdef Ring ring, r
         cdef Edge e
         cdef Node neighbor
@@ -737,22 +792,10 @@ cdef class Node:
             if did_paren:
                 self.tree._renderAppend(")")
 
-        # Render label.
+        # Render label.  Special characters are protected by
+        # CxFmtLabel(), if necessary.
         if self._taxon is not None:
-            if taxaMap is not None:
-                self.tree._renderAppend("%d" %
-                  taxaMap.indGet(self._taxon))
-            else:
-                # Protect special characters, if necessary.
-                label = self._taxon.label
-                m = re.compile(r"[_()[\]':;,]").search(label)
-                if m:
-                    label = re.compile("'").sub("''", label)
-                    self.tree._renderAppend("'%s'" % label)
-                else:
-                    if label.find(" ") != -1:
-                        label = re.compile(" ").sub("_", label)
-                    self.tree._renderAppend("%s" % label)
+            self.tree._renderLabel(self._taxon, taxaMap)
 
         # Render branch length.
         degree = self._degreeGet()
@@ -762,9 +805,9 @@ cdef class Node:
             if zeroLength:
                 # This tree only has two taxa; take care not to double the
                 # branch length.
-                self.tree._renderAppend((":" + lengthFormat) % 0.0)
+                self.tree._renderLength(lengthFormat, 0.0)
             elif not noLength:
-                self.tree._renderAppend((":" + lengthFormat) % (via.length))
+                self.tree._renderLength(lengthFormat, via.length)
 
     cpdef int separation(self, Node other):
         """
@@ -37,6 +37,7 @@
     * Crux.Fasta      : FASTA character data format parser.
     * Crux.Mc3        : Metropolis-coupled Markov chain Monte Carlo sampler.
     * Crux.Newick     : Newick tree format parser.
+    * Crux.Prng       : Pseudo-random number generation.
     * Crux.Taxa       : Taxa and taxa map classes.
     * Crux.Tree       : Tree, node, edge, and ring classes.
 """
@@ -57,6 +58,7 @@ cimport Crux.DistMatrix as DistMatrix
 cimport Crux.Fasta as Fasta
 cimport Crux.Mc3 as Mc3
 cimport Crux.Newick as Newick
+cimport Crux.Prng as Prng
 cimport Crux.Taxa as Taxa
 cimport Crux.Tree as Tree
 